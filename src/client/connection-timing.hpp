@@ -0,0 +1,253 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   connection-timing.hpp
+ *
+ * @brief  Records the core library events of a connection attempt with
+ *         monotonic timestamps and splits the time spent into phases.
+ *
+ *         A connection attempt goes through these phases, each started
+ *         by a core library event:
+ *
+ *           resolve     RESOLVE            DNS lookup of the remote
+ *           wait        WAIT, WAIT_PROXY   Transport connection setup
+ *           tls_auth    CONNECTING         TLS handshake and authentication
+ *           get_config  GET_CONFIG         Pulling the configuration
+ *           tun_setup   ASSIGN_IP          Configuring the tun device
+ *
+ *         The attempt completes with the CONNECTED event.  The breakdown
+ *         of the last completed attempt is kept until the next one
+ *         completes.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <glib.h>
+
+
+enum class ConnectionPhase : uint8_t {
+    NONE,
+    RESOLVE,
+    WAIT,
+    TLS_AUTH,
+    GET_CONFIG,
+    TUN_SETUP
+};
+
+const uint8_t ConnectionPhaseCount = 6;
+
+const std::array<const std::string, ConnectionPhaseCount> ConnectionPhase_str = {{
+    "(none)",
+    "resolve",
+    "wait",
+    "tls_auth",
+    "get_config",
+    "tun_setup"
+}};
+
+
+/**
+ *  How an event affects the connection attempt being timed
+ */
+enum class TimelineAction : uint8_t {
+    NONE,       /**< Only recorded in the timeline */
+    BEGIN,      /**< A new connection attempt starts */
+    COMPLETE,   /**< The connection attempt succeeded */
+    ABORT       /**< The connection attempt failed */
+};
+
+
+class ConnectionTimeline
+{
+public:
+    /**
+     *  A single core library event in the timeline
+     */
+    struct Entry
+    {
+        std::string event;
+        int64_t offset_us;   /**< Time since the attempt started */
+    };
+
+
+    ConnectionTimeline()
+        : active(false),
+          current(ConnectionPhase::NONE),
+          completed(false)
+    {
+    }
+
+
+    /**
+     *  Records a core library event
+     *
+     * @param event   Core library event name
+     * @param phase   ConnectionPhase this event starts, NONE if the
+     *                event does not start a phase
+     * @param action  TimelineAction for this event
+     */
+    void Record(const std::string& event, const ConnectionPhase phase,
+                const TimelineAction action)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto now = std::chrono::steady_clock::now();
+
+        if (TimelineAction::BEGIN == action
+            || (!active && ConnectionPhase::NONE != phase))
+        {
+            begin(now);
+        }
+        if (!active)
+        {
+            return;
+        }
+
+        if (events.size() < MAX_EVENTS)
+        {
+            events.push_back({event, usec(now - attempt_start)});
+        }
+
+        if (ConnectionPhase::NONE != phase && phase != current)
+        {
+            close_phase(now);
+            current = phase;
+            phase_start = now;
+        }
+
+        if (TimelineAction::COMPLETE == action)
+        {
+            close_phase(now);
+            last_phases = phases;
+            last_total = usec(now - attempt_start);
+            last_events = events;
+            completed = true;
+            active = false;
+        }
+        else if (TimelineAction::ABORT == action)
+        {
+            active = false;
+        }
+    }
+
+
+    /**
+     *  Retrieves the phase breakdown of the last completed connection
+     *  attempt, in microseconds.  Phases which were not seen are left out.
+     *
+     * @return Returns a GVariant a{sx} dictionary, which is empty if no
+     *         connection attempt has completed yet.  The "total" key holds
+     *         the duration of the whole attempt.
+     */
+    GVariant * GetPhaseDurations()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{sx}"));
+        if (completed)
+        {
+            for (uint8_t i = 1; i < ConnectionPhaseCount; ++i)
+            {
+                if (last_phases[i] >= 0)
+                {
+                    g_variant_builder_add(b, "{sx}",
+                                          ConnectionPhase_str[i].c_str(),
+                                          (gint64) last_phases[i]);
+                }
+            }
+            g_variant_builder_add(b, "{sx}", "total", (gint64) last_total);
+        }
+        GVariant *ret = g_variant_builder_end(b);
+        g_variant_builder_unref(b);
+        return ret;
+    }
+
+
+    /**
+     *  Retrieves the core library events of the last completed connection
+     *  attempt
+     *
+     * @return Returns a GVariant a(sx) array with the event names and the
+     *         microseconds since the attempt started
+     */
+    GVariant * GetEvents()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a(sx)"));
+        for (const auto& e : last_events)
+        {
+            g_variant_builder_add(b, "(sx)", e.event.c_str(),
+                                  (gint64) e.offset_us);
+        }
+        GVariant *ret = g_variant_builder_end(b);
+        g_variant_builder_unref(b);
+        return ret;
+    }
+
+
+private:
+    static const size_t MAX_EVENTS = 64;
+
+    std::mutex mtx;
+    bool active;
+    std::chrono::steady_clock::time_point attempt_start;
+    std::chrono::steady_clock::time_point phase_start;
+    ConnectionPhase current;
+    std::array<int64_t, ConnectionPhaseCount> phases;
+    std::vector<Entry> events;
+
+    bool completed;
+    std::array<int64_t, ConnectionPhaseCount> last_phases;
+    int64_t last_total;
+    std::vector<Entry> last_events;
+
+
+    static int64_t usec(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    }
+
+
+    void begin(std::chrono::steady_clock::time_point now)
+    {
+        active = true;
+        attempt_start = now;
+        current = ConnectionPhase::NONE;
+        phases.fill(-1);
+        events.clear();
+    }
+
+
+    void close_phase(std::chrono::steady_clock::time_point now)
+    {
+        if (ConnectionPhase::NONE == current)
+        {
+            return;
+        }
+        int64_t &p = phases[(uint8_t) current];
+        p = (p < 0 ? 0 : p) + usec(now - phase_start);
+        current = ConnectionPhase::NONE;
+    }
+};
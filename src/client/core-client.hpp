@@ -32,6 +32,7 @@
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <unordered_map>
 
 #include <openvpn/common/platform.hpp>
 
@@ -50,7 +51,9 @@
 #include <openvpn/ssl/peerinfo.hpp>
 
 #include "common/core-extensions.hpp"
+#include "dbus/tracepoints.hpp"
 #include "backend-signals.hpp"
+#include "connection-timing.hpp"
 #include "statistics.hpp"
 
 using namespace openvpn;
@@ -75,11 +78,15 @@ public:
      * @param userinputq  Pointer to an existing RequiresQueue object which
      *                    will be used to process dynamic challenge
      *                    interactions and more.
+     * @param timeline    Pointer to the ConnectionTimeline of the session,
+     *                    which outlives this object.  Can be nullptr.
      */
-    CoreVPNClient(BackendSignals *signal, RequiresQueue *userinputq)
+    CoreVPNClient(BackendSignals *signal, RequiresQueue *userinputq,
+                  ConnectionTimeline *timeline = nullptr)
             : OpenVPNClient::OpenVPNClient(),
               signal(signal),
               userinputq(userinputq),
+              timeline(timeline),
               failed_signal_sent(false),
               run_status(StatusMinor::CONN_INIT)
     {
@@ -151,6 +158,7 @@ private:
     unsigned long evntcount = 0;
     BackendSignals *signal;
     RequiresQueue *userinputq;
+    ConnectionTimeline *timeline;
     std::mutex event_mutex;
     bool failed_signal_sent;
     StatusMinor run_status;
@@ -163,15 +171,18 @@ private:
 
     /**
      *  Whenever an event occurs within the core library, this method is
-     *  invoked as a kind of callback.  The provided information will be
-     *  evaluated and sent further as D-Bus signals to the session manager
-     *  whenever appropriate.
+     *  invoked as a kind of callback.  The event is recorded in the
+     *  connection timeline and the event handler from the event table is
+     *  called, which sends D-Bus signals to the session manager whenever
+     *  appropriate.
      *
      * @param ev  A ClientAPI::Event object with the current event.
      */
     virtual void event(const ClientAPI::Event& ev) override
     {
         evntcount++;
+        OPENVPN3_TRACE3(core_event, ev.name.c_str(), ev.info.c_str(),
+                        (int) ev.error);
 
 #ifdef DEBUG_CORE_EVENTS
         std::stringstream entry;
@@ -179,168 +190,299 @@ private:
         signal->Debug(entry.str());
 #endif
 
-        if ("DYNAMIC_CHALLENGE" == ev.name)
+        const EventType *evtype = lookup_event(ev.name);
+        if (nullptr == evtype)
         {
-            dc_cookie = ev.info;
-            signal->Debug("DYNAMIC_CHALLENGE: |" + dc_cookie + "|");
-
-            ClientAPI::DynamicChallenge dc;
-            if (ClientAPI::OpenVPNClient::parse_dynamic_challenge(dc_cookie, dc))
+            if (timeline)
             {
-                userinputq->RequireAdd(
-                                ClientAttentionType::CREDENTIALS,
-                                ClientAttentionGroup::CHALLENGE_DYNAMIC,
-                                "dynamic_challenge", dc.challenge,
-                                dc.echo == 0);
-
-                // Save the dynamic challenge cookie in the userinputq object.
-                // This is due to this object will be wiped after the
-                // disconnect, so we can't save any states in this object.
-                unsigned int dcrid = userinputq->RequireAdd(
-                                       ClientAttentionType::CREDENTIALS,
-                                       ClientAttentionGroup::CHALLENGE_DYNAMIC,
-                                       "dynamic_challenge_cookie", "",
-                                       true);
-                userinputq->UpdateEntry(ClientAttentionType::CREDENTIALS,
-                                        ClientAttentionGroup::CHALLENGE_DYNAMIC,
-                                        dcrid, dc_cookie);
-                signal->AttentionReq(ClientAttentionType::CREDENTIALS,
-                                     ClientAttentionGroup::CHALLENGE_DYNAMIC,
-                                     dc.challenge);
-                signal->StatusChange(StatusMajor::CONNECTION,
-                                     StatusMinor::CFG_REQUIRE_USER,
-                                     "Dynamic Challenge");
-                run_status = StatusMinor::CFG_REQUIRE_USER;
+                timeline->Record(ev.name, ConnectionPhase::NONE,
+                                 TimelineAction::NONE);
             }
+            ev_unhandled(ev);
+            return;
         }
-        else if ("WARN" == ev.name)
-        {
-            signal->LogWarn(ev.info);
-        }
-        else if ("INFO" == ev.name)
-        {
-            signal->LogInfo(ev.info);
-        }
-        else if ("GET_CONFIG" == ev.name)
-        {
-            signal->LogVerb2("Retrieving configuration from server");
-        }
-        else if ("TUN_SETUP_FAILED" == ev.name
-                 && "TUN_IFACE_CREATE" == ev.name
-                 && "TUN_IFACE_DISABLED" == ev.name)
+
+        // Recorded before the handler runs, so the timing is complete
+        // when the status change is signalled
+        if (timeline)
         {
-            failed_signal_sent = true;
-            signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_FAILED);
-            run_status = StatusMinor::CONN_FAILED;
-            signal->LogCritical("Failed configuring TUN device (" + ev.name + ")");
+            timeline->Record(ev.name, evtype->phase, evtype->action);
         }
-        else if ("CONNECTING" == ev.name)
-        {
-            // Don't log "Connecting" if we're in reconnect mode
-            if (StatusMinor::CONN_RECONNECTING != run_status)
+        (this->*(evtype->handler))(ev);
+    }
+
+
+    /**
+     *  Describes how a core library event is processed
+     */
+    struct EventType
+    {
+        const char *name;
+        ConnectionPhase phase;
+        TimelineAction action;
+        void (CoreVPNClient::*handler)(const ClientAPI::Event&);
+    };
+
+
+    /**
+     *  Looks up the processing of a core library event
+     *
+     * @param name  Core library event name
+     *
+     * @return Returns a pointer to the EventType in the event table, or
+     *         nullptr for events without a dedicated handler
+     */
+    static const EventType * lookup_event(const std::string& name)
+    {
+        static const EventType events[] = {
+            {"DYNAMIC_CHALLENGE",  ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_dynamic_challenge},
+            {"WARN",               ConnectionPhase::NONE,       TimelineAction::NONE,     &CoreVPNClient::ev_warn},
+            {"INFO",               ConnectionPhase::NONE,       TimelineAction::NONE,     &CoreVPNClient::ev_info},
+            {"RESOLVE",            ConnectionPhase::RESOLVE,    TimelineAction::NONE,     &CoreVPNClient::ev_resolve},
+            {"WAIT",               ConnectionPhase::WAIT,       TimelineAction::NONE,     &CoreVPNClient::ev_wait},
+            {"WAIT_PROXY",         ConnectionPhase::WAIT,       TimelineAction::NONE,     &CoreVPNClient::ev_wait_proxy},
+            {"CONNECTING",         ConnectionPhase::TLS_AUTH,   TimelineAction::NONE,     &CoreVPNClient::ev_connecting},
+            {"GET_CONFIG",         ConnectionPhase::GET_CONFIG, TimelineAction::NONE,     &CoreVPNClient::ev_get_config},
+            {"ASSIGN_IP",          ConnectionPhase::TUN_SETUP,  TimelineAction::NONE,     &CoreVPNClient::ev_unhandled},
+            {"ADD_ROUTES",         ConnectionPhase::TUN_SETUP,  TimelineAction::NONE,     &CoreVPNClient::ev_unhandled},
+            {"CONNECTED",          ConnectionPhase::NONE,       TimelineAction::COMPLETE, &CoreVPNClient::ev_connected},
+            {"RECONNECTING",       ConnectionPhase::NONE,       TimelineAction::BEGIN,    &CoreVPNClient::ev_reconnecting},
+            {"TUN_SETUP_FAILED",   ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_tun_failed},
+            {"TUN_IFACE_CREATE",   ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_tun_failed},
+            {"TUN_IFACE_DISABLED", ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_tun_failed},
+            {"AUTH_FAILED",        ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_auth_failed},
+            {"CERT_VERIFY_FAIL",   ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_cert_verify_fail},
+            {"TLS_VERSION_MIN",    ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_tls_version_min},
+            {"CONNECTION_TIMEOUT", ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_connection_timeout},
+            {"INACTIVE_TIMEOUT",   ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_inactive_timeout},
+            {"PROXY_ERROR",        ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_proxy_error},
+            {"PROXY_NEED_CREDS",   ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_proxy_need_creds},
+            {"DISCONNECTED",       ConnectionPhase::NONE,       TimelineAction::ABORT,    &CoreVPNClient::ev_disconnected},
+        };
+        static const std::unordered_map<std::string, const EventType *> index = []()
             {
-                signal->LogInfo("Connecting");
-                signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTING);
-                run_status = StatusMinor::CONN_CONNECTING;
-            }
-        }
-        else if ("WAIT" == ev.name)
-        {
-            signal->LogVerb1("Waiting for server response");
-        }
-        else if ("WAIT_PROXY" == ev.name)
-        {
-            signal->LogVerb1("Waiting for proxy server response");
-        }
-        else if ("CONNECTED" == ev.name)
-        {
-            signal->LogInfo("Connected: " + ev.info);
-            signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTED);
-            run_status = StatusMinor::CONN_CONNECTED;
-        }
-        else if ("RECONNECTING" == ev.name)
-        {
-            signal->LogInfo("Reconnecting");
-            signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_RECONNECTING);
-            run_status = StatusMinor::CONN_RECONNECTING;
-        }
-        else if ("RESOLVE" == ev.name)
-        {
-            signal->LogVerb2("Resolving");
-        }
-        else if ("AUTH_FAILED" == ev.name)
-        {
-            signal->LogVerb1("Authentication failed");
-            signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_AUTH_FAILED,
-                                 "Authentication failed");
-            run_status = StatusMinor::CONN_AUTH_FAILED;
-            failed_signal_sent = true;
-        }
-        else if ("CERT_VERIFY_FAIL" == ev.name)
-        {
-            signal->LogCritical("Certificate verification failed:" + ev.info);
-            signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_FAILED,
-                                 "Certificate verification failed");
-            run_status = StatusMinor::CONN_FAILED;
-            failed_signal_sent = true;
-        }
-        else if ("TLS_VERSION_MIN" == ev.name)
-        {
-            signal->LogCritical("TLS version is requested by server is too low:" + ev.info);
-            signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_FAILED,
-                                 "TLS version too low");
-            run_status = StatusMinor::CONN_FAILED;
-            failed_signal_sent = true;
-        }
-        else if ("CONNECTION_TIMEOUT" == ev.name)
+                std::unordered_map<std::string, const EventType *> idx;
+                for (const auto& e : events)
+                {
+                    idx[e.name] = &e;
+                }
+                return idx;
+            }();
+
+        auto it = index.find(name);
+        return (index.end() == it ? nullptr : it->second);
+    }
+
+
+    void ev_dynamic_challenge(const ClientAPI::Event& ev)
+    {
+        dc_cookie = ev.info;
+        signal->Debug("DYNAMIC_CHALLENGE: |" + dc_cookie + "|");
+
+        ClientAPI::DynamicChallenge dc;
+        if (ClientAPI::OpenVPNClient::parse_dynamic_challenge(dc_cookie, dc))
         {
-            signal->LogInfo("Connection timeout");
+            userinputq->RequireAdd(
+                            ClientAttentionType::CREDENTIALS,
+                            ClientAttentionGroup::CHALLENGE_DYNAMIC,
+                            "dynamic_challenge", dc.challenge,
+                            dc.echo == 0);
+
+            // Save the dynamic challenge cookie in the userinputq object.
+            // This is due to this object will be wiped after the
+            // disconnect, so we can't save any states in this object.
+            unsigned int dcrid = userinputq->RequireAdd(
+                                   ClientAttentionType::CREDENTIALS,
+                                   ClientAttentionGroup::CHALLENGE_DYNAMIC,
+                                   "dynamic_challenge_cookie", "",
+                                   true);
+            userinputq->UpdateEntry(ClientAttentionType::CREDENTIALS,
+                                    ClientAttentionGroup::CHALLENGE_DYNAMIC,
+                                    dcrid, dc_cookie);
+            signal->AttentionReq(ClientAttentionType::CREDENTIALS,
+                                 ClientAttentionGroup::CHALLENGE_DYNAMIC,
+                                 dc.challenge);
             signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_DISCONNECTING,
-                                 "Connection timeout");
-            run_status = StatusMinor::CONN_DISCONNECTING;
+                                 StatusMinor::CFG_REQUIRE_USER,
+                                 "Dynamic Challenge");
+            run_status = StatusMinor::CFG_REQUIRE_USER;
         }
-        else if ("INACTIVE_TIMEOUT" == ev.name)
+    }
+
+
+    void ev_warn(const ClientAPI::Event& ev)
+    {
+        signal->LogWarn(ev.info);
+    }
+
+
+    void ev_info(const ClientAPI::Event& ev)
+    {
+        signal->LogInfo(ev.info);
+    }
+
+
+    void ev_get_config(const ClientAPI::Event& ev)
+    {
+        signal->LogVerb2("Retrieving configuration from server");
+    }
+
+
+    void ev_tun_failed(const ClientAPI::Event& ev)
+    {
+        failed_signal_sent = true;
+        signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_FAILED);
+        run_status = StatusMinor::CONN_FAILED;
+        signal->LogCritical("Failed configuring TUN device (" + ev.name + ")");
+    }
+
+
+    void ev_connecting(const ClientAPI::Event& ev)
+    {
+        // Don't log "Connecting" if we're in reconnect mode
+        if (StatusMinor::CONN_RECONNECTING != run_status)
         {
-            signal->LogInfo("Connection closing due to inactivity");
-            signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_DISCONNECTING,
-                                 "Connection inactivity");
-            run_status = StatusMinor::CONN_DISCONNECTING;
+            signal->LogInfo("Connecting");
+            signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTING);
+            run_status = StatusMinor::CONN_CONNECTING;
         }
-        else if ("PROXY_ERROR" == ev.name)
+    }
+
+
+    void ev_wait(const ClientAPI::Event& ev)
+    {
+        signal->LogVerb1("Waiting for server response");
+    }
+
+
+    void ev_wait_proxy(const ClientAPI::Event& ev)
+    {
+        signal->LogVerb1("Waiting for proxy server response");
+    }
+
+
+    void ev_connected(const ClientAPI::Event& ev)
+    {
+        signal->LogInfo("Connected: " + ev.info);
+        signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTED);
+        run_status = StatusMinor::CONN_CONNECTED;
+    }
+
+
+    void ev_reconnecting(const ClientAPI::Event& ev)
+    {
+        signal->LogInfo("Reconnecting");
+        signal->StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_RECONNECTING);
+        run_status = StatusMinor::CONN_RECONNECTING;
+    }
+
+
+    void ev_resolve(const ClientAPI::Event& ev)
+    {
+        signal->LogVerb2("Resolving");
+    }
+
+
+    void ev_auth_failed(const ClientAPI::Event& ev)
+    {
+        signal->LogVerb1("Authentication failed");
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_AUTH_FAILED,
+                             "Authentication failed");
+        run_status = StatusMinor::CONN_AUTH_FAILED;
+        failed_signal_sent = true;
+    }
+
+
+    void ev_cert_verify_fail(const ClientAPI::Event& ev)
+    {
+        signal->LogCritical("Certificate verification failed:" + ev.info);
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_FAILED,
+                             "Certificate verification failed");
+        run_status = StatusMinor::CONN_FAILED;
+        failed_signal_sent = true;
+    }
+
+
+    void ev_tls_version_min(const ClientAPI::Event& ev)
+    {
+        signal->LogCritical("TLS version is requested by server is too low:" + ev.info);
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_FAILED,
+                             "TLS version too low");
+        run_status = StatusMinor::CONN_FAILED;
+        failed_signal_sent = true;
+    }
+
+
+    void ev_connection_timeout(const ClientAPI::Event& ev)
+    {
+        signal->LogInfo("Connection timeout");
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_DISCONNECTING,
+                             "Connection timeout");
+        run_status = StatusMinor::CONN_DISCONNECTING;
+    }
+
+
+    void ev_inactive_timeout(const ClientAPI::Event& ev)
+    {
+        signal->LogInfo("Connection closing due to inactivity");
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_DISCONNECTING,
+                             "Connection inactivity");
+        run_status = StatusMinor::CONN_DISCONNECTING;
+    }
+
+
+    void ev_proxy_error(const ClientAPI::Event& ev)
+    {
+        signal->LogCritical("Proxy connection error:" + ev.info);
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_FAILED,
+                             "Proxy connection error");
+        run_status = StatusMinor::CONN_FAILED;
+        failed_signal_sent = true;
+    }
+
+
+    void ev_proxy_need_creds(const ClientAPI::Event& ev)
+    {
+        signal->StatusChange(StatusMajor::CONNECTION,
+                             StatusMinor::CONN_FAILED,
+                             "Proxy connection error");
+        run_status = StatusMinor::CONN_FAILED;
+        failed_signal_sent = true;
+        signal->LogCritical("Proxy " + ev.info);
+    }
+
+
+    void ev_disconnected(const ClientAPI::Event& ev)
+    {
+        if (failed_signal_sent)
         {
-            signal->LogCritical("Proxy connection error:" + ev.info);
-            signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_FAILED,
-                                 "Proxy connection error");
-            run_status = StatusMinor::CONN_FAILED;
-            failed_signal_sent = true;
+            ev_unhandled(ev);
+            return;
         }
-        else if ("PROXY_NEED_CREDS" == ev.name)
+        if (StatusMinor::CONN_AUTH_FAILED != run_status
+            && StatusMinor::CFG_REQUIRE_USER != run_status)
         {
             signal->StatusChange(StatusMajor::CONNECTION,
-                                 StatusMinor::CONN_FAILED,
-                                 "Proxy connection error");
-            run_status = StatusMinor::CONN_FAILED;
-            failed_signal_sent = true;
-            signal->LogCritical("Proxy " + ev.info);
-        }
-        else if (!failed_signal_sent && "DISCONNECTED" == ev.name)
-        {
-            if (StatusMinor::CONN_AUTH_FAILED != run_status
-                && StatusMinor::CFG_REQUIRE_USER != run_status)
-            {
-                signal->StatusChange(StatusMajor::CONNECTION,
-                                     StatusMinor::CONN_DISCONNECTED);
-                run_status = StatusMinor::CONN_DISCONNECTED;
-                signal->LogInfo("Disconnected");
-            }
+                                 StatusMinor::CONN_DISCONNECTED);
+            run_status = StatusMinor::CONN_DISCONNECTED;
+            signal->LogInfo("Disconnected");
         }
-        else if (ev.fatal)
+    }
+
+
+    /**
+     *  Events without a dedicated handler only need attention if the
+     *  core library considers them fatal
+     */
+    void ev_unhandled(const ClientAPI::Event& ev)
+    {
+        if (ev.fatal)
         {
             std::string msgtag = "[" + ev.name + "] ";
             signal->LogFATAL(msgtag + ev.info);
@@ -28,20 +28,47 @@
  *         service is supposed to be automatically started by D-Bus, with
  *         root privileges.  This ensures the client process this service
  *         starts also runs with the appropriate privileges.
+ *
+ *         Client processes are started with posix_spawn() and tracked
+ *         until they exit, so the session manager can retrieve the reason
+ *         a client process stopped via the GetExitReason method.
+ *
+ *         Optionally, a pool of pre-started client processes can be kept
+ *         ready.  These processes are already connected to the D-Bus and
+ *         have initialized the VPN core library; StartClient then just
+ *         hands over the token to one of them.
+ *
+ *         In the multiplexed mode, a client process hosts several
+ *         sessions.  New sessions are handed over to a running client
+ *         process with spare capacity before a new one is started.
  */
 
+#include <deque>
 #include <iostream>
 
 #include "config.h"
 #include "common/cmdargparser.hpp"
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
+#include "dbus/tracepoints.hpp"
 #include "log/dbus-log.hpp"
 #include "log/proxy-log.hpp"
 #include "common/utils.hpp"
+#include "client/process-watcher.hpp"
 
 using namespace openvpn;
 
+/**
+ *  How long to wait for pre-started client processes to register in the
+ *  process pool before trying to start new ones
+ */
+#define POOL_START_TIMEOUT 30
+
+/**
+ *  Number of exit reasons of stopped client processes to keep
+ */
+#define EXIT_REASONS_KEEP 64
+
 
 /**
  * Helper class to tackle signals sent by the backend starter process
@@ -113,7 +140,19 @@ public:
         : DBusObject(objpath),
           BackendStarterSignals(dbuscon, objpath, log_level),
           dbuscon(dbuscon),
-          client_args(client_args)
+          client_args(client_args),
+          pool_size(0),
+          pool_starting(0),
+          pool_hits(0),
+          pool_misses(0),
+          pool_refill_source(0),
+          pool_start_timer(0),
+          start_source(0),
+          multiplex_max(0),
+          children([this](pid_t pid, const ProcessExitReason& reason)
+                   {
+                       client_exited(pid, reason);
+                   })
     {
         if (!signal_broadcast)
         {
@@ -128,11 +167,26 @@ public:
                           << "          <arg type='s' name='token' direction='in'/>"
                           << "          <arg type='u' name='pid' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='GetExitReason'>"
+                          << "          <arg type='u' name='pid' direction='in'/>"
+                          << "          <arg type='i' name='exit_code' direction='out'/>"
+                          << "          <arg type='i' name='signal' direction='out'/>"
+                          << "          <arg type='b' name='core_dumped' direction='out'/>"
+                          << "        </method>"
+                          << "        <method name='RegisterPooledClient'>"
+                          << "          <arg type='b' name='accepted' direction='out'/>"
+                          << "        </method>"
                           << "        <property type='s' name='version' access='read'/>"
+                          << "        <property type='b' name='idle' access='read'/>"
+                          << "        <property type='u' name='pool_size' access='read'/>"
+                          << "        <property type='u' name='pool_idle' access='read'/>"
+                          << "        <property type='t' name='pool_hits' access='read'/>"
+                          << "        <property type='t' name='pool_misses' access='read'/>"
                           << GetLogIntrospection()
                           << "    </interface>"
                           << "</node>";
         ParseIntrospectionXML(introspection_xml);
+        EnableDebugInterface();
 
         Debug("BackendStarterObject registered");
     }
@@ -140,10 +194,96 @@ public:
     ~BackendStarterObject()
     {
         LogInfo("Shutting down");
+        if (pool_refill_source > 0)
+        {
+            g_source_remove(pool_refill_source);
+        }
+        if (pool_start_timer > 0)
+        {
+            g_source_remove(pool_start_timer);
+        }
+        if (start_source > 0)
+        {
+            g_source_remove(start_source);
+        }
+        for (auto& req : start_queue)
+        {
+            GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.backend",
+                                                          "Backend starter is shutting down");
+            g_dbus_method_invocation_return_gerror(req.invoc, err);
+            g_error_free(err);
+        }
+        for (auto& w : exit_waiters)
+        {
+            for (auto& invoc : w.second)
+            {
+                GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.backend",
+                                                              "Backend starter is shutting down");
+                g_dbus_method_invocation_return_gerror(invoc, err);
+                g_error_free(err);
+            }
+        }
+        // The pooled client processes will exit by themselves when
+        // this service disappears from the bus
+        for (const auto& c : pool)
+        {
+            g_bus_unwatch_name(c.watch);
+        }
+        for (const auto& h : multiplex_hosts)
+        {
+            if (h.second.watch > 0)
+            {
+                g_bus_unwatch_name(h.second.watch);
+            }
+        }
         RemoveObject(dbuscon);
     }
 
 
+    /**
+     *  Lets each client process host up to max sessions.  This replaces
+     *  the pool of pre-started client processes.
+     *
+     * @param max  Maximum number of sessions per client process
+     */
+    void EnableMultiplexing(unsigned int max)
+    {
+        if (max < 2)
+        {
+            return;
+        }
+        multiplex_max = max;
+        LogVerb1("Hosting up to " + std::to_string(multiplex_max)
+                 + " sessions per client process");
+    }
+
+
+    /**
+     *  Enables the pool of pre-started client processes.  This must be
+     *  called after the IdleCheck has been registered, as the backend
+     *  starter will not exit on idle while the pool is enabled.
+     *
+     * @param size  Number of idle client processes to keep ready
+     */
+    void EnablePool(unsigned int size)
+    {
+        if (0 == size || pool_size > 0)
+        {
+            return;
+        }
+        if (multiplex_max > 0)
+        {
+            LogWarn("Process pool is not used with multiplexed client processes");
+            return;
+        }
+        pool_size = size;
+        IdleCheck_RefInc();
+        LogVerb1("Keeping a pool of " + std::to_string(pool_size)
+                 + " client processes ready");
+        schedule_pool_refill();
+    }
+
+
     /**
      *  Callback method called each time a method in the Backend Starter
      *  service is called over the D-Bus.
@@ -171,19 +311,48 @@ public:
             IdleCheck_UpdateTimestamp();
 
             // Retrieve the configuration path for the tunnel
-            // from the request
+            // from the request.  The client process is started and
+            // the response is sent from the main loop, so several
+            // StartClient calls arriving at once are handled together.
             gchar *token;
             g_variant_get (params, "(s)", &token);
-            pid_t backend_pid = start_backend_process(token);
-            if (-1 == backend_pid)
+            start_queue.push_back({std::string(token), invoc});
+            g_free(token);
+            if (0 == start_source)
+            {
+                start_source = g_idle_add(process_start_queue, this);
+            }
+        }
+        else if ("GetExitReason" == method_name)
+        {
+            guint pid = 0;
+            g_variant_get(params, "(u)", &pid);
+
+            auto reason = exit_reasons.find(pid);
+            if (exit_reasons.end() != reason)
+            {
+                g_dbus_method_invocation_return_value(invoc,
+                                                      exit_reason_variant(reason->second));
+            }
+            else if (children.Running(pid))
+            {
+                // The client process may have left the bus, but is not
+                // reaped yet.  Respond once it has been.
+                exit_waiters[pid].push_back(invoc);
+            }
+            else
             {
                 GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.backend",
-                                                              "Backend client process died");
+                                                              "Unknown client process");
                 g_dbus_method_invocation_return_gerror(invoc, err);
                 g_error_free(err);
-                return;
             }
-            g_dbus_method_invocation_return_value(invoc, g_variant_new("(u)", backend_pid));
+        }
+        else if ("RegisterPooledClient" == method_name)
+        {
+            g_dbus_method_invocation_return_value(invoc,
+                                                  g_variant_new("(b)",
+                                                                register_pooled_client(sender)));
         }
     };
 
@@ -192,9 +361,8 @@ public:
      *  Callback which is used each time a Backend Starter object's D-Bus
      *  property is being read.
      *
-     *  For the , this method will just return NULL
-     *  with an error set in the GError return pointer.  The
-     *  BackendStarterObject does not use properties at all.
+     *  Unknown properties will return NULL with an error set in the
+     *  GError return pointer.
      *
      * @param conn           D-Bus connection this event occurred on
      * @param sender         D-Bus bus name of the requester
@@ -203,8 +371,8 @@ public:
      * @param property_name  The property name being accessed
      * @param error          A GLib2 GError object if an error occurs
      *
-     * @return  Returns always NULL, as there are no properties in the
-     *          BackendStarterObject.
+     * @return  Returns a GVariant object with the property value, or NULL
+     *          on errors.
      */
     GVariant * callback_get_property(GDBusConnection *conn,
                                      const std::string sender,
@@ -220,6 +388,26 @@ public:
         {
             ret = g_variant_new_string(package_version);
         }
+        else if ("idle" == property_name)
+        {
+            ret = g_variant_new_boolean(IdleCheck_IsIdle());
+        }
+        else if ("pool_size" == property_name)
+        {
+            ret = g_variant_new_uint32(pool_size);
+        }
+        else if ("pool_idle" == property_name)
+        {
+            ret = g_variant_new_uint32(pool.size());
+        }
+        else if ("pool_hits" == property_name)
+        {
+            ret = g_variant_new_uint64(pool_hits);
+        }
+        else if ("pool_misses" == property_name)
+        {
+            ret = g_variant_new_uint64(pool_misses);
+        }
         else
         {
             g_set_error (error,
@@ -263,84 +451,482 @@ public:
 
 
 private:
+    /**
+     *  A pre-started client process waiting for a session token
+     */
+    struct PooledClient
+    {
+        std::string busname;
+        pid_t pid;
+        guint watch;
+    };
+
     GDBusConnection *dbuscon;
     const std::vector<std::string> client_args;
+    unsigned int pool_size;
+    unsigned int pool_starting;
+    std::deque<PooledClient> pool;
+    guint64 pool_hits;
+    guint64 pool_misses;
+    guint pool_refill_source;
+    guint pool_start_timer;
 
     /**
-     * Forks out a child thread which starts the openvpn3-service-client
-     * process with the provided backend start token.
+     *  A pending StartClient method call
+     */
+    struct StartRequest
+    {
+        std::string token;
+        GDBusMethodInvocation *invoc;
+    };
+    std::deque<StartRequest> start_queue;
+    guint start_source;
+
+    /**
+     *  A client process hosting several sessions.  The bus name is
+     *  known once the process has registered itself.
+     */
+    struct MultiplexHost
+    {
+        std::string busname;
+        guint watch;
+    };
+    unsigned int multiplex_max;
+    std::map<pid_t, MultiplexHost> multiplex_hosts;
+
+    ChildProcessWatcher children;
+    std::map<pid_t, ProcessExitReason> exit_reasons;
+    std::deque<pid_t> exit_order;
+    std::map<pid_t, std::vector<GDBusMethodInvocation *>> exit_waiters;
+
+
+    /**
+     *  Starts client processes for all the pending StartClient calls
+     *  and sends the responses.
+     */
+    void start_queued_clients()
+    {
+        start_source = 0;
+        std::deque<StartRequest> queue;
+        queue.swap(start_queue);
+        for (auto& req : queue)
+        {
+            pid_t backend_pid = -1;
+            if (multiplex_max > 0)
+            {
+                backend_pid = assign_multiplexed(req.token);
+            }
+            else
+            {
+                backend_pid = assign_pooled_client(req.token.c_str());
+                if (-1 == backend_pid)
+                {
+                    backend_pid = start_backend_process({req.token});
+                }
+            }
+            if (-1 == backend_pid)
+            {
+                GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.backend",
+                                                              "Backend client process died");
+                g_dbus_method_invocation_return_gerror(req.invoc, err);
+                g_error_free(err);
+                continue;
+            }
+            g_dbus_method_invocation_return_value(req.invoc,
+                                                  g_variant_new("(u)", backend_pid));
+        }
+    }
+
+
+    static gboolean process_start_queue(gpointer this_ptr)
+    {
+        BackendStarterObject *obj = (BackendStarterObject *) this_ptr;
+        obj->start_queued_clients();
+        return G_SOURCE_REMOVE;
+    }
+
+
+    static GVariant *exit_reason_variant(const ProcessExitReason& reason)
+    {
+        return g_variant_new("(iib)", reason.exit_code, reason.signal,
+                             reason.core_dumped);
+    }
+
+
+    /**
+     *  Called when a client process started by this service has exited.
+     *  The exit reason is kept for the session manager to retrieve.
      *
-     * @param token  String containing the start token identifying the session
-     *               object this process is tied to.
-     * @return Returns the process ID (pid) of the child process.
+     * @param pid     Process ID of the client process
+     * @param reason  ProcessExitReason describing why it exited
      */
-    pid_t start_backend_process(char * token)
-    {
-        pid_t backend_pid = fork();
-        if (0 == backend_pid)
-        {
-            //  Child process
-            //
-            //  In this process scope, we do not have any access
-            //  to the D-Bus connection.  So we avoid as much logging
-            //  as possible here - and only critical things are sent
-            //  to stdout, which will be picked up by other logs on the
-            //  system
-            //
-            char *args[client_args.size()+2];
-            unsigned int i = 0;
-
-            for (const auto& arg : client_args)
+    void client_exited(pid_t pid, const ProcessExitReason& reason)
+    {
+        std::string msg = "Client process pid " + std::to_string(pid)
+                          + " stopped: " + reason.str();
+        if (0 == reason.signal && 0 == reason.exit_code)
+        {
+            LogVerb2(msg);
+        }
+        else
+        {
+            LogWarn(msg);
+        }
+
+        exit_reasons[pid] = reason;
+        exit_order.push_back(pid);
+        while (exit_order.size() > EXIT_REASONS_KEEP)
+        {
+            exit_reasons.erase(exit_order.front());
+            exit_order.pop_front();
+        }
+
+        auto host = multiplex_hosts.find(pid);
+        if (multiplex_hosts.end() != host)
+        {
+            if (host->second.watch > 0)
             {
-                args[i++] = (char *) strdup(arg.c_str());
+                g_bus_unwatch_name(host->second.watch);
             }
-            args[i++] = token;
-            args[i++] = nullptr;
+            multiplex_hosts.erase(host);
+        }
 
-#ifdef DEBUG_OPTIONS
-            std::cout << "[openvpn3-service-backend] Command line to be started: ";
-            for (unsigned int j = 0; j < i; j++)
+        auto waiters = exit_waiters.find(pid);
+        if (exit_waiters.end() != waiters)
+        {
+            for (auto& invoc : waiters->second)
             {
-                std::cout << args[j] << " ";
+                g_dbus_method_invocation_return_value(invoc,
+                                                      exit_reason_variant(reason));
             }
-            std::cout << std::endl << std::endl;
-#endif
+            exit_waiters.erase(waiters);
+        }
+        IdleCheck_RefDec();
+    }
 
-            execve(args[0], args, NULL);
 
-            // If execve() succeedes, the line below will not be executed
-            // at all.  So if we come here, there must be an error.
-            std::cerr << "** Error starting " << args[0] << ": "
-                      << strerror(errno) << std::endl;
+    /**
+     *  Adds a pre-started client process to the process pool.  Only
+     *  processes running with the same privileges as this service
+     *  are accepted.
+     *
+     * @param sender  std::string with the unique bus name of the client
+     *
+     * @return Returns true if the client process was added to the pool.
+     *         Otherwise the client process is expected to exit.
+     */
+    bool register_pooled_client(const std::string& sender)
+    {
+        DBusConnectionCreds creds(dbuscon);
+        PooledClient client;
+        try
+        {
+            if (creds.GetUID(sender) != getuid())
+            {
+                LogWarn("Rejected pooled client process from " + sender);
+                return false;
+            }
+            client.pid = creds.GetPID(sender);
+        }
+        catch (DBusException& excp)
+        {
+            LogError("Could not register pooled client process: "
+                     + std::string(excp.what()));
+            return false;
+        }
+
+        auto host = multiplex_hosts.find(client.pid);
+        if (multiplex_hosts.end() != host)
+        {
+            // A multiplexed client process, ready for more sessions
+            host->second.busname = sender;
+            host->second.watch = g_bus_watch_name_on_connection(dbuscon,
+                                                                sender.c_str(),
+                                                                G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                                NULL,
+                                                                multiplex_host_vanished,
+                                                                this, NULL);
+            return true;
+        }
+
+        if (pool.size() >= pool_size)
+        {
+            return false;
+        }
+        client.busname = sender;
+        client.watch = g_bus_watch_name_on_connection(dbuscon,
+                                                      sender.c_str(),
+                                                      G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                      NULL,
+                                                      pooled_client_vanished,
+                                                      this, NULL);
+        pool.push_back(client);
+        if (pool_starting > 0)
+        {
+            --pool_starting;
+        }
+        LogVerb2("Pooled client process pid " + std::to_string(client.pid)
+                 + " ready (" + std::to_string(pool.size()) + "/"
+                 + std::to_string(pool_size) + ")");
+        PropertyChanged("pool_idle", g_variant_new_uint32(pool.size()));
+        return true;
+    }
+
+
+    /**
+     *  Hands over a session token to an idle pre-started client process.
+     *
+     * @param token  C string with the session start token
+     *
+     * @return Returns the process ID of the client process on success,
+     *         otherwise -1.  The caller must then start a new client
+     *         process.
+     */
+    pid_t assign_pooled_client(const char *token)
+    {
+        if (0 == pool_size)
+        {
+            return -1;
+        }
+
+        pid_t ret = -1;
+        while (-1 == ret && !pool.empty())
+        {
+            PooledClient client = pool.front();
+            pool.pop_front();
+            g_bus_unwatch_name(client.watch);
+            try
+            {
+                if (assign_token(client.busname, token))
+                {
+                    ret = client.pid;
+                }
+            }
+            catch (DBusException& excp)
+            {
+                LogWarn("Pooled client process pid " + std::to_string(client.pid)
+                        + " unavailable: " + std::string(excp.what()));
+            }
+        }
+
+        if (-1 == ret)
+        {
+            ++pool_misses;
+            PropertyChanged("pool_misses", g_variant_new_uint64(pool_misses));
+        }
+        else
+        {
+            ++pool_hits;
+            PropertyChanged("pool_hits", g_variant_new_uint64(pool_hits));
+        }
+        PropertyChanged("pool_idle", g_variant_new_uint32(pool.size()));
+        schedule_pool_refill();
+        return ret;
+    }
+
+
+    /**
+     *  Hands over a session token to a multiplexed client process with
+     *  spare capacity, or starts a new multiplexed client process.
+     *
+     * @param token  std::string with the session start token
+     *
+     * @return Returns the process ID of the client process hosting the
+     *         session, or -1 on errors.
+     */
+    pid_t assign_multiplexed(const std::string& token)
+    {
+        for (const auto& host : multiplex_hosts)
+        {
+            if (host.second.busname.empty())
+            {
+                // Not ready yet
+                continue;
+            }
+            try
+            {
+                if (assign_token(host.second.busname, token.c_str()))
+                {
+                    return host.first;
+                }
+            }
+            catch (DBusException& excp)
+            {
+                LogWarn("Multiplexed client process pid "
+                        + std::to_string(host.first)
+                        + " unavailable: " + std::string(excp.what()));
+            }
+        }
+
+        pid_t pid = start_backend_process({"--multiplex",
+                                           std::to_string(multiplex_max),
+                                           token});
+        if (-1 != pid)
+        {
+            multiplex_hosts[pid] = {"", 0};
+        }
+        return pid;
+    }
+
+
+    /**
+     *  Calls AssignToken in a client process waiting for sessions
+     *
+     * @param busname  std::string with the bus name of the client process
+     * @param token    C string with the session start token
+     *
+     * @return Returns true if the client process accepted the session.
+     *         Throws DBusException if the client process is unavailable.
+     */
+    bool assign_token(const std::string& busname, const char *token)
+    {
+        DBusProxy standby(dbuscon, busname,
+                          OpenVPN3DBus_interf_backends,
+                          OpenVPN3DBus_rootp_backends_standby);
+        standby.SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+        GVariant *res = standby.Call("AssignToken",
+                                     g_variant_new("(s)", token));
+        gboolean accepted = false;
+        g_variant_get(res, "(b)", &accepted);
+        g_variant_unref(res);
+        return accepted;
+    }
+
+
+    static void multiplex_host_vanished(GDBusConnection *conn,
+                                        const gchar *name,
+                                        gpointer this_ptr)
+    {
+        BackendStarterObject *obj = (BackendStarterObject *) this_ptr;
+        for (auto& h : obj->multiplex_hosts)
+        {
+            if (name == h.second.busname)
+            {
+                // Keep the entry until the process has exited, but
+                // do not assign new sessions to it any more
+                g_bus_unwatch_name(h.second.watch);
+                h.second.watch = 0;
+                h.second.busname.clear();
+                return;
+            }
+        }
+    }
+
+
+    /**
+     *  Starts new pre-started client processes in the background
+     *  until the pool is filled up again.
+     */
+    void schedule_pool_refill()
+    {
+        if (pool_size > 0 && 0 == pool_refill_source)
+        {
+            pool_refill_source = g_idle_add(pool_refill, this);
         }
-        else if( backend_pid > 0)
+    }
+
+
+    void refill_pool()
+    {
+        pool_refill_source = 0;
+        bool started = false;
+        while (pool.size() + pool_starting < pool_size)
         {
-            // Parent
-            std::stringstream cmdline;
-            cmdline << "Command line used: ";
-            for (auto const& c : client_args)
+            ++pool_starting;
+            if (-1 == start_backend_process({"--pooled"}))
             {
-                cmdline << c << " ";
+                --pool_starting;
+                break;
             }
-            cmdline << token;
-            LogVerb2(cmdline.str());
+            started = true;
+        }
+
+        // Processes which died before registering in the pool would
+        // otherwise block the pool from being refilled
+        if (started && 0 == pool_start_timer)
+        {
+            pool_start_timer = g_timeout_add_seconds(POOL_START_TIMEOUT,
+                                                     pool_start_timeout,
+                                                     this);
+        }
+    }
+
+
+    static gboolean pool_refill(gpointer this_ptr)
+    {
+        BackendStarterObject *obj = (BackendStarterObject *) this_ptr;
+        obj->refill_pool();
+        return G_SOURCE_REMOVE;
+    }
 
-            // Wait for the child process to exit, as the client process will fork again
-            int rc = -1;
-            int w = waitpid(backend_pid, &rc, 0);
-            if (-1 == w)
+
+    static gboolean pool_start_timeout(gpointer this_ptr)
+    {
+        BackendStarterObject *obj = (BackendStarterObject *) this_ptr;
+        obj->pool_start_timer = 0;
+        obj->pool_starting = 0;
+        obj->schedule_pool_refill();
+        return G_SOURCE_REMOVE;
+    }
+
+
+    static void pooled_client_vanished(GDBusConnection *conn,
+                                       const gchar *name,
+                                       gpointer this_ptr)
+    {
+        BackendStarterObject *obj = (BackendStarterObject *) this_ptr;
+        for (auto it = obj->pool.begin(); it != obj->pool.end(); ++it)
+        {
+            if (name == it->busname)
             {
-                std::stringstream msg;
-                msg << "Child process ("  << token
-                    << ") - pid " << backend_pid
-                    << " failed to start as expected (exit code: "
-                    << std::to_string(rc) << ")";
-                LogError(msg.str());
-                return -1;
+                g_bus_unwatch_name(it->watch);
+                obj->pool.erase(it);
+                obj->PropertyChanged("pool_idle",
+                                     g_variant_new_uint32(obj->pool.size()));
+                obj->schedule_pool_refill();
+                return;
             }
-            return backend_pid;
         }
-        throw std::runtime_error("Failed to fork() backend client process");
+    }
+
+
+    /**
+     * Starts the openvpn3-service-client process with the provided
+     * backend start token.  The process is tracked until it exits; the
+     * backend starter will not exit on idle while client processes runs.
+     *
+     * @param extra_args  Arguments to add to the client process command
+     *                    line; normally the start token identifying the
+     *                    session object this process is tied to.
+     * @return Returns the process ID (pid) of the child process, or -1 if
+     *         it could not be started.
+     */
+    pid_t start_backend_process(const std::vector<std::string>& extra_args)
+    {
+        TraceTimer trace;
+        std::vector<std::string> args(client_args);
+        args.insert(args.end(), extra_args.begin(), extra_args.end());
+
+        std::stringstream cmdline;
+        cmdline << "Command line used: ";
+        for (auto const& c : args)
+        {
+            cmdline << c << " ";
+        }
+        LogVerb2(cmdline.str());
+
+        pid_t backend_pid = children.Spawn(args);
+        OPENVPN3_TRACE3(backend_start,
+                        (extra_args.empty() ? "" : extra_args[0].c_str()),
+                        (int) backend_pid, trace.Elapsed());
+        if (-1 == backend_pid)
+        {
+            LogError("Failed to start " + args[0] + ": "
+                     + std::string(strerror(errno)));
+            return -1;
+        }
+        IdleCheck_RefInc();
+        return backend_pid;
     }
 };
 
@@ -370,7 +956,9 @@ public:
           log_level(log_level),
           signal_broadcast(signal_broadcast),
           procsig(nullptr),
-          client_args(cliargs)
+          client_args(cliargs),
+          pool_size(0),
+          multiplex(0)
     {
     };
 
@@ -404,10 +992,38 @@ public:
         if (idle_checker)
         {
             mainobj->IdleCheck_Register(idle_checker);
+            mainobj->IdleCheck_EnableIdleProperty();
         }
+        mainobj->EnableMultiplexing(multiplex);
+        mainobj->EnablePool(pool_size);
     };
 
 
+    /**
+     *  Sets how many pre-started client processes to keep ready.
+     *  Must be called before Setup().
+     *
+     * @param size  Number of idle client processes, 0 disables the pool
+     */
+    void SetPoolSize(unsigned int size)
+    {
+        pool_size = size;
+    }
+
+
+    /**
+     *  Sets how many sessions each client process may host.
+     *  Must be called before Setup().
+     *
+     * @param max  Maximum number of sessions per client process,
+     *             0 or 1 runs each session in its own process
+     */
+    void SetMultiplex(unsigned int max)
+    {
+        multiplex = max;
+    }
+
+
     /**
      *  This is called each time the well-known bus name is successfully
      *  acquired on the D-Bus.
@@ -444,6 +1060,8 @@ private:
     bool signal_broadcast = true;
     ProcessSignalProducer * procsig;
     std::vector<std::string> client_args;
+    unsigned int pool_size;
+    unsigned int multiplex;
 };
 
 
@@ -473,11 +1091,11 @@ int backend_starter(ParsedArgs args)
 #endif
 
     client_args.push_back(std::string(LIBEXEC_PATH) + "/openvpn3-service-client");
+
+    // The client process is tracked by this service, so it must not
+    // fork into the background
+    client_args.push_back("--no-fork");
 #ifdef DEBUG_OPTIONS
-    if (args.Present("client-no-fork"))
-    {
-        client_args.push_back("--no-fork");
-    }
     if (args.Present("client-no-setsid"))
     {
         client_args.push_back("--no-setsid");
@@ -527,13 +1145,20 @@ int backend_starter(ParsedArgs args)
 
     BackendStarterDBus backstart(dbus.GetConnection(), client_args,
                                  log_level, signal_broadcast);
+    if (args.Present("pool-size"))
+    {
+        backstart.SetPoolSize(std::atoi(args.GetValue("pool-size", 0).c_str()));
+    }
+    if (args.Present("multiplex"))
+    {
+        backstart.SetMultiplex(std::atoi(args.GetValue("multiplex", 0).c_str()));
+    }
 
     IdleCheck::Ptr idle_exit;
     if (idle_wait_sec > 0)
     {
         idle_exit.reset(new IdleCheck(main_loop,
                                       std::chrono::seconds(idle_wait_sec)));
-        idle_exit->SetPollTime(std::chrono::seconds(10));
         backstart.EnableIdleCheck(idle_exit);
     }
 #ifdef DEBUG_OPTIONS
@@ -564,7 +1189,6 @@ int backend_starter(ParsedArgs args)
     if (idle_wait_sec > 0)
     {
         idle_exit->Disable();
-        idle_exit->Join();
     }
 
     return 0;
@@ -583,13 +1207,17 @@ int main(int argc, char **argv)
     cmd.AddOption("idle-exit", "SECONDS", true,
                   "How long to wait before exiting if being idle. "
                   "0 disables it (Default: 10 seconds)");
+    cmd.AddOption("pool-size", "NUM", true,
+                  "Keep NUM pre-started client processes ready for new "
+                  "sessions (Default: 0, disabled)");
+    cmd.AddOption("multiplex", "MAX", true,
+                  "Let each client process host up to MAX sessions "
+                  "(Default: 1, one process per session)");
 #ifdef DEBUG_OPTIONS
     cmd.AddOption("run-via", 0, "DEBUG_PROGAM", true,
                   "Debug option: Run openvpn3-service-client via provided executable (full path required)");
     cmd.AddOption("debugger-arg", 0, "ARG", true,
                   "Debug option: Argument to pass to the DEBUG_PROGAM");
-    cmd.AddOption("client-no-fork", 0,
-                  "Debug option: Adds the --no-fork argument to openvpn3-service-client");
     cmd.AddOption("client-no-setsid", 0,
                   "Debug option: Adds the --no-setsid argument to openvpn3-service-client");
 #endif
@@ -33,9 +33,20 @@
  *         connection.
  */
 
+#include <functional>
+#include <map>
 #include <sstream>
 
+#include <gio/gunixfdlist.h>
+
 #define SHUTDOWN_NOTIF_PROCESS_NAME "openvpn3-service-client"
+
+// How often the statistics are sent to the session manager, in seconds
+#define STATISTICS_PUBLISH_INTERVAL 2
+
+// How often the shared memory statistics page is updated, in milliseconds
+#define STATISTICS_PAGE_INTERVAL_MS 250
+
 #include "common/requiresqueue.hpp"
 #include "common/utils.hpp"
 #include "common/cmdargparser.hpp"
@@ -43,15 +54,47 @@
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
 #include "dbus/path.hpp"
+#include "dbus/peer-link.hpp"
 #include "log/ansicolours.hpp"
 #include "log/dbus-log.hpp"
 #include "log/logwriter.hpp"
 #include "log/proxy-log.hpp"
 #include "backend-signals.hpp"
 #include "core-client.hpp"
+#include "stats-page.hpp"
 
 using namespace openvpn;
 
+static unsigned int vpn_core_users = 0;
+
+/**
+ *  Initializes the VPN core library, only once per process.  Backend
+ *  processes pre-started by the backend starter do this before they are
+ *  assigned to a session, and multiplexed backend processes share it
+ *  between all their sessions.  Each call must be paired with a
+ *  release_vpn_core() call.
+ */
+static void init_vpn_core()
+{
+    if (0 == vpn_core_users++)
+    {
+        CoreVPNClient::init_process();
+    }
+}
+
+
+/**
+ *  Releases the VPN core library when the last user is done with it
+ */
+static void release_vpn_core()
+{
+    if (vpn_core_users > 0 && 0 == --vpn_core_users)
+    {
+        CoreVPNClient::uninit_process();
+    }
+}
+
+
 /**
  *  Class managing a specific VPN client tunnel.  This object has its own
  *  unique D-Bus bus name and object path and is designed to only be
@@ -86,17 +129,38 @@ public:
           mainloop(nullptr),
           signal(conn, LogGroup::CLIENT, objpath, logwr),
           signal_broadcast(false),
+          peer_link(nullptr),
+          peer_link_closed_id(0),
           session_token(session_token),
           registered(false),
           paused(false),
           vpnclient(nullptr),
-          client_thread(nullptr)
+          client_thread(nullptr),
+          stats_timer(0),
+          stats_page_timer(0)
     {
         // Initialize the VPN Core
-        CoreVPNClient::init_process();
+        init_vpn_core();
 
         signal.SetLogLevel(default_log_level);
 
+        // Prepare the shared memory statistics page.  The counter layout
+        // is given by the core library and is identical for all sessions
+        try
+        {
+            std::vector<std::string> names;
+            for (int i = 0; i < CoreVPNClient::stats_n(); ++i)
+            {
+                names.push_back(CoreVPNClient::stats_name(i));
+            }
+            stats_page.reset(new StatsPageWriter(names));
+        }
+        catch (const DBusException& excp)
+        {
+            signal.LogWarn("Statistics page not available: "
+                           + std::string(excp.what()));
+        }
+
         std::stringstream introspection_xml;
         introspection_xml << "<node name='" << objpath << "'>"
                           << "    <interface name='" << OpenVPN3DBus_interf_backends << "'>"
@@ -105,9 +169,16 @@ public:
                           << "            <arg type='o' name='config_path' direction='in'/>"
                           << "            <arg type='b' name='response' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='Reattach'>"
+                          << "            <arg type='s' name='token' direction='in'/>"
+                          << "            <arg type='b' name='response' direction='out'/>"
+                          << "        </method>"
                           << "        <method name='Ping'>"
                           << "            <arg type='b' name='alive' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='OpenPeerLink'>"
+                          << "            <arg type='h' name='link_fd' direction='in'/>"
+                          << "        </method>"
                           << "        <method name='Ready'/>"
                           << "        <method name='Connect'/>"
                           << "        <method name='Pause'>"
@@ -117,6 +188,9 @@ public:
                           << "        <method name='Restart'/>"
                           << "        <method name='Disconnect'/>"
                           << "        <method name='ForceShutdown'/>"
+                          << "        <method name='GetStatisticsPage'>"
+                          << "            <arg type='h' name='page_fd' direction='out'/>"
+                          << "        </method>"
                           << userinputq.IntrospectionMethods("UserInputQueueGetTypeGroup",
                                                              "UserInputQueueFetch",
                                                              "UserInputQueueCheck",
@@ -135,6 +209,8 @@ public:
                           << "        </signal>"
                           << "        <property type='a{sx}' name='statistics' access='read'/>"
                           << "        <property type='(uus)' name='status' access='read'/>"
+                          << "        <property type='a{sx}' name='connection_timing' access='read'/>"
+                          << "        <property type='a(sx)' name='connection_timeline' access='read'/>"
                           <<  "    </interface>"
                           <<  "</node>";
         ParseIntrospectionXML(introspection_xml);
@@ -153,7 +229,16 @@ public:
 
     ~BackendClientObject()
     {
-        CoreVPNClient::uninit_process();
+        if (stats_timer > 0)
+        {
+            g_source_remove(stats_timer);
+        }
+        if (stats_page_timer > 0)
+        {
+            g_source_remove(stats_page_timer);
+        }
+        close_peer_link();
+        release_vpn_core();
     }
 
 
@@ -170,6 +255,19 @@ public:
     }
 
 
+    /**
+     *  Used by multiplexed backend processes hosting several sessions.
+     *  When the session is closed, the callback is called instead of
+     *  stopping the process.
+     *
+     * @param closed  Callback to call when this session has been closed
+     */
+    void SetSessionClosedCallback(std::function<void()> closed)
+    {
+        session_closed = closed;
+    }
+
+
     /**
      *  Broadcast all signals, instead of targeted signals.  This is
      *  disabled by default and must be enabled explicitly.  This is
@@ -212,7 +310,7 @@ public:
         try
         {
             // Only the session manager is allowed to call methods
-            validate_sender(sender);
+            validate_sender(conn, sender);
 
             // Ensure a vpnclient object is present only when we are
             // expected to be in an active connection.
@@ -252,7 +350,13 @@ public:
 
                 if (!signal_broadcast)
                 {
-                    signal.AddTargetBusName(sender); // Target signals to the session mgr
+                    if (conn != peer_link)
+                    {
+                        // Without a peer link, signals to the
+                        // session manager go via the bus
+                        SetPropertiesChangedTarget(sender);
+                        signal.AddTargetBusName(sender); // Target signals to the session mgr
+                    }
                     signal.AddTargetBusName(GetUniqueBusID(OpenVPN3DBus_name_log)); // Target log events to log service
                 }
                 else
@@ -286,8 +390,11 @@ public:
 
                     // Sets initial state, which also allows us to early
                     // report back back if more data is required to be
-                    // sent by the front-end interface.
-                    initialize_client();
+                    // sent by the front-end interface.  This uses the
+                    // profile evaluation done by the configuration manager,
+                    // the profile is only evaluated by the core library
+                    // when connecting.
+                    prepare_client();
                 }
                 else
                 {
@@ -298,6 +405,43 @@ public:
                 }
                 return;
             }
+            else if ("Reattach" == method_name)
+            {
+                // Called by a restarted session manager which takes over
+                // this session.  validate_sender() has already ensured
+                // the caller owns the session manager bus name, the token
+                // proves it is continuing the session this process was
+                // started for.  The connection itself is not touched.
+                gchar *token = NULL;
+                g_variant_get (params, "(s)", &token);
+                bool valid = registered && (session_token == std::string(token));
+                g_free(token);
+
+                if (!valid)
+                {
+                    GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.be-registration",
+                                                                  "Invalid registration token");
+                    g_dbus_method_invocation_return_gerror(invoc, err);
+                    g_error_free(err);
+                    return;
+                }
+
+                if (!signal_broadcast)
+                {
+                    // Signals must now go to the new session manager
+                    signal.ClearTargetBusNames();
+                    if (conn != peer_link)
+                    {
+                        SetPropertiesChangedTarget(sender);
+                        signal.AddTargetBusName(sender);
+                    }
+                    signal.AddTargetBusName(GetUniqueBusID(OpenVPN3DBus_name_log));
+                }
+                signal.LogVerb1("Session manager re-attached");
+                g_dbus_method_invocation_return_value(invoc,
+                                                      g_variant_new("(b)", true));
+                return;
+            }
             else if ("Ping" == method_name)
             {
                 // This is a more narrow Ping test than what the D-Bus
@@ -308,6 +452,26 @@ public:
                 g_dbus_method_invocation_return_value(invoc, g_variant_new("(b)", (bool) true));
                 return;
             }
+            else if ("OpenPeerLink" == method_name)
+            {
+                // The session manager hands over one end of a socket
+                // pair.  Once the link is up, this object and the
+                // signals to the session manager move to the link,
+                // keeping this traffic off the system bus.
+                if (conn == peer_link)
+                {
+                    THROW_DBUSEXCEPTION("BackendServiceObject",
+                                        "A peer link must be opened via the bus");
+                }
+                peer_link_owner = sender;
+                DBusPeerLink::Accept(invoc, params,
+                                     [this](GDBusConnection *link,
+                                            const std::string& error)
+                                     {
+                                         peer_link_ready(link, error);
+                                     });
+                return;
+            }
             else if ("Ready" == method_name)
             {
                 // This method should just exit without any result if everything is okay.
@@ -351,30 +515,28 @@ public:
                 // Disconnect from the server.  This will also shutdown this
                 // process.
 
-                if (!registered || !vpnclient)
+                if (!registered)
                 {
                     THROW_DBUSEXCEPTION("BackendServiceObject", "Backend service is not initialized");
                 }
 
                 signal.LogInfo("Stopping connection: " + to_string(obj_path));
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DISCONNECTING);
-                vpnclient->stop();
-                if (client_thread)
+
+                // The vpnclient object does not exist until Connect has
+                // been called, e.g. while waiting for user credentials
+                if (vpnclient)
                 {
-                    client_thread->join();
+                    vpnclient->stop();
+                    if (client_thread)
+                    {
+                        client_thread->join();
+                    }
                 }
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DONE);
 
                 // Shutting down our selves.
-                RemoveObject(dbusconn);
-                if (mainloop)
-                {
-                    g_main_loop_quit(mainloop);
-                }
-                else
-                {
-                    kill(getpid(), SIGTERM);
-                }
+                shutdown_session();
             }
             else if ("UserInputQueueGetTypeGroup"  == method_name)
             {
@@ -466,6 +628,7 @@ public:
                                     "Reason: " + reason);
                 vpnclient->pause(reason);
                 paused = true;
+                stop_statistics_timers();
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_PAUSED);
             }
             else if ("Resume" == method_name)
@@ -490,6 +653,7 @@ public:
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_RESUMING);
                 vpnclient->resume();
                 paused = false;
+                start_statistics_timers();
             }
             else if ("Restart" == method_name)
             {
@@ -517,15 +681,15 @@ public:
                 signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CONN_DONE);
 
                 // Shutting down our selves.
-                RemoveObject(dbusconn);
-                if (mainloop)
-                {
-                    g_main_loop_quit(mainloop);
-                }
-                else
-                {
-                    kill(getpid(), SIGTERM);
-                }
+                shutdown_session();
+            }
+            else if ("GetStatisticsPage" == method_name)
+            {
+                // Hands over a read-only file descriptor to the shared
+                // memory statistics page.  The session manager can then
+                // read the statistics without calling this process.
+                return_statistics_page(invoc);
+                return;
             }
             else
             {
@@ -583,7 +747,7 @@ public:
     {
         try {
             // Only the session manager is allowed to get properties
-            validate_sender(sender);
+            validate_sender(conn, sender);
 
             // Access to properties are controled by the D-Bus policy.
             // Normally only the session manager should have access to
@@ -595,20 +759,22 @@ public:
 
                 // Returns an array of a string (description) and an int64
                 // containing the statistics value.
-                GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{sx}"));
-                for (auto& sd : vpnclient->GetStats())
-                {
-                    g_variant_builder_add (b, "{sx}",
-                                           sd.key.c_str(), sd.value);
-                }
-                GVariant *ret = g_variant_builder_end(b);
-                g_variant_builder_unref(b);
-                return ret;
+                return get_statistics();
             }
             else if ("status" == property_name)
             {
                 return signal.GetLastStatusChange();
             }
+            else if ("connection_timing" == property_name)
+            {
+                // Time spent in each phase of the last completed
+                // connection attempt, in microseconds
+                return timeline.GetPhaseDurations();
+            }
+            else if ("connection_timeline" == property_name)
+            {
+                return timeline.GetEvents();
+            }
             else if ("log_level" == property_name)
             {
                 return g_variant_new_uint32(signal.GetLogLevel());
@@ -657,7 +823,7 @@ public:
         try
         {
             // Only the session manager is allowed to set properties
-            validate_sender(sender);
+            validate_sender(conn, sender);
 
             if ("log_level" == property_name)
             {
@@ -688,30 +854,278 @@ public:
 private:
     GDBusConnection *dbusconn;
     GMainLoop *mainloop;
+    std::function<void()> session_closed;
     BackendSignals signal;
     bool signal_broadcast;
+    GDBusConnection *peer_link;
+    std::string peer_link_owner;
+    gulong peer_link_closed_id;
     std::string session_token;
     bool registered;
     bool paused;
     std::string configpath;
+    ConnectionTimeline timeline;  // Must outlive vpnclient
     CoreVPNClient::Ptr vpnclient;
     std::unique_ptr<std::thread> client_thread;
+    guint stats_timer;
+    guint stats_page_timer;
+    std::unique_ptr<StatsPageWriter> stats_page;
     ClientAPI::Config vpnconfig;
     ClientAPI::EvalConfig cfgeval;
+    OpenVPN3ConfigurationEval profile_eval;
     ClientAPI::ProvideCreds creds;
     RequiresQueue userinputq;
     std::mutex guard;
 
 
+    /**
+     *  Called when the peer link opened by the session manager is
+     *  established.  Replaces any previous link.
+     *
+     * @param link   GDBusConnection of the new link, nullptr on errors
+     * @param error  std::string with the error message if it failed
+     */
+    void peer_link_ready(GDBusConnection *link, const std::string& error)
+    {
+        std::lock_guard<std::mutex> lg(guard);
+        if (!link)
+        {
+            signal.LogError("Could not establish the session manager link: "
+                            + error);
+            return;
+        }
+
+        close_peer_link();
+        try
+        {
+            RegisterPeerConnection(link);
+        }
+        catch (DBusException& excp)
+        {
+            signal.LogError("Could not provide the session on the "
+                            "session manager link: " + excp.err());
+            g_dbus_connection_close(link, NULL, NULL, NULL);
+            g_object_unref(link);
+            return;
+        }
+        peer_link = link;
+        signal.SetPeerConnection(peer_link, signal_broadcast);
+        signal.RemoveTargetBusName(peer_link_owner);
+        peer_link_closed_id = g_signal_connect(peer_link, "closed",
+                                               G_CALLBACK(peer_link_closed),
+                                               this);
+        signal.Debug("Session manager link established");
+    }
+
+
+    /**
+     *  Stops using the peer link.  If the session is registered, the
+     *  signals to the session manager are sent via the bus again.
+     */
+    void close_peer_link()
+    {
+        if (!peer_link)
+        {
+            return;
+        }
+        g_signal_handler_disconnect(peer_link, peer_link_closed_id);
+        peer_link_closed_id = 0;
+        UnregisterPeerConnection();
+        signal.SetPeerConnection(nullptr);
+        if (registered && !signal_broadcast && !peer_link_owner.empty())
+        {
+            SetPropertiesChangedTarget(peer_link_owner);
+            signal.AddTargetBusName(peer_link_owner);
+        }
+        g_dbus_connection_close(peer_link, NULL, NULL, NULL);
+        g_object_unref(peer_link);
+        peer_link = nullptr;
+    }
+
+
+    static void peer_link_closed(GDBusConnection *link,
+                                 gboolean remote_peer_vanished,
+                                 GError *error, gpointer this_ptr)
+    {
+        BackendClientObject *obj = (BackendClientObject *) this_ptr;
+        std::lock_guard<std::mutex> lg(obj->guard);
+        obj->close_peer_link();
+    }
+
+
+    /**
+     *  Removes this session from the D-Bus.  A process only hosting this
+     *  session is stopped, while a multiplexed backend process continues
+     *  running its other sessions.
+     */
+    void shutdown_session()
+    {
+        stop_statistics_timers();
+        RemoveObject(dbusconn);
+        if (session_closed)
+        {
+            if (vpnclient && client_thread && client_thread->joinable())
+            {
+                vpnclient->stop();
+                client_thread->join();
+            }
+            session_closed();
+        }
+        else if (mainloop)
+        {
+            g_main_loop_quit(mainloop);
+        }
+        else
+        {
+            kill(getpid(), SIGTERM);
+        }
+    }
+
+
+    /**
+     *  Retrieves the statistics of the running VPN session.  The vpnclient
+     *  object is not created until the connection is started, until then
+     *  the statistics are empty.
+     *
+     * @return Returns a GVariant object with the statistics as an
+     *         a{sx} dictionary.
+     */
+    GVariant * get_statistics()
+    {
+        GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{sx}"));
+        if (vpnclient)
+        {
+            for (auto& sd : vpnclient->GetStats())
+            {
+                g_variant_builder_add (b, "{sx}",
+                                       sd.key.c_str(), sd.value);
+            }
+        }
+        GVariant *ret = g_variant_builder_end(b);
+        g_variant_builder_unref(b);
+        return ret;
+    }
+
+
+    /**
+     *  Starts publishing the statistics to the session manager, which
+     *  is done while the connection is running and not paused
+     */
+    void start_statistics_timers()
+    {
+        if (0 == stats_timer)
+        {
+            stats_timer = g_timeout_add_seconds(STATISTICS_PUBLISH_INTERVAL,
+                                                publish_statistics, this);
+        }
+        if (stats_page && 0 == stats_page_timer)
+        {
+            stats_page_timer = g_timeout_add(STATISTICS_PAGE_INTERVAL_MS,
+                                             update_statistics_page, this);
+        }
+    }
+
+
+    /**
+     *  Stops publishing the statistics.  The last values are published
+     *  once more, so the session manager does not keep stale counters.
+     */
+    void stop_statistics_timers()
+    {
+        if (stats_timer > 0)
+        {
+            g_source_remove(stats_timer);
+            stats_timer = 0;
+            publish_statistics(this);
+        }
+        if (stats_page_timer > 0)
+        {
+            g_source_remove(stats_page_timer);
+            stats_page_timer = 0;
+            update_statistics_page(this);
+        }
+    }
+
+
+    /**
+     *  Sends the current statistics via a PropertiesChanged signal.  This
+     *  allows the session manager to provide the statistics without
+     *  querying this process.
+     */
+    static gboolean publish_statistics(gpointer this_ptr)
+    {
+        BackendClientObject *obj = (BackendClientObject *) this_ptr;
+        obj->PropertyChanged("statistics", obj->get_statistics());
+        return G_SOURCE_CONTINUE;
+    }
+
+
+    /**
+     *  Copies the current counters into the shared memory statistics page
+     */
+    static gboolean update_statistics_page(gpointer this_ptr)
+    {
+        BackendClientObject *obj = (BackendClientObject *) this_ptr;
+        if (obj->vpnclient)
+        {
+            obj->stats_page->Update(obj->vpnclient->stats_bundle());
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+
+    /**
+     *  Completes a GetStatisticsPage() method call, returning a new
+     *  read-only file descriptor to the statistics page.
+     *
+     * @param invoc  GDBusMethodInvocation to respond to
+     */
+    void return_statistics_page(GDBusMethodInvocation *invoc)
+    {
+        int fd = (stats_page ? stats_page->GetReadOnlyFD() : -1);
+        if (fd < 0)
+        {
+            GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.backend",
+                                                          "Statistics page not available");
+            g_dbus_method_invocation_return_gerror(invoc, err);
+            g_error_free(err);
+            return;
+        }
+
+        GUnixFDList *fdlist = g_unix_fd_list_new();
+        GError *error = nullptr;
+        gint idx = g_unix_fd_list_append(fdlist, fd, &error);
+        close(fd);  // g_unix_fd_list_append() keeps its own copy
+        if (idx < 0)
+        {
+            g_object_unref(fdlist);
+            g_dbus_method_invocation_return_gerror(invoc, error);
+            g_error_free(error);
+            return;
+        }
+        g_dbus_method_invocation_return_value_with_unix_fd_list(invoc,
+                                                                g_variant_new("(h)", idx),
+                                                                fdlist);
+        g_object_unref(fdlist);
+    }
+
+
     /**
      *  Validate that the sender is the session manager.  If the sender
      *  is not the session manager, a DBusCredentialsException is thrown.
      *
+     * @param conn    D-Bus connection the request arrived on
      * @param sender  String containing the unique bus ID of the sender
      */
 
-    void validate_sender(std::string sender)
+    void validate_sender(GDBusConnection *conn, std::string sender)
     {
+        // Only the session manager can open a peer link
+        if (peer_link && conn == peer_link)
+        {
+            return;
+        }
+
         // Only the session manager is susposed to talk to the
         // the backend VPN client service
         if (GetUniqueBusID(OpenVPN3DBus_name_sessions) != sender)
@@ -831,6 +1245,8 @@ private:
                 }
             }
 
+            start_statistics_timers();
+
             // Start client thread
             client_thread.reset(new std::thread([self=Ptr(this)]()
                                                 {
@@ -849,6 +1265,32 @@ private:
     }
 
 
+    /**
+     *  Prepares the client for a connection, based on the profile
+     *  evaluation done by the configuration manager when the profile was
+     *  imported.  This avoids evaluating the configuration profile before
+     *  it is really needed.
+     */
+    void prepare_client()
+    {
+        if (vpnconfig.content.empty())
+        {
+            THROW_DBUSEXCEPTION("BackendServiceObject",
+                                "No configuration profile has been parsed");
+        }
+
+        if (!profile_eval.valid)
+        {
+            config_error(profile_eval.message);
+        }
+        check_profile_requirements(profile_eval.autologin,
+                                   profile_eval.external_pki);
+
+        signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CFG_OK,
+                            "config_path=" + configpath);
+    }
+
+
     /**
      *   Initializes a new CoreVPNClient object
      */
@@ -862,34 +1304,54 @@ private:
 
         // Create a new VPN client object, which is handling the
         // tunnel itself.
-        vpnclient.reset(new CoreVPNClient(&signal, &userinputq));
+        vpnclient.reset(new CoreVPNClient(&signal, &userinputq, &timeline));
 
         // We need to provide a copy of the vpnconfig object, as vpnclient
         // seems to take ownership
         cfgeval = vpnclient->eval_config(ClientAPI::Config(vpnconfig));
         if (cfgeval.error)
         {
-            std::stringstream statusmsg;
-            statusmsg << "config_path=" << configpath << ", "
-                      << "eval_message='" << cfgeval.message << "'";
-            signal.LogError("Failed to parse configuration: " + cfgeval.message);
-            signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CFG_ERROR,
-                                statusmsg.str());
-            signal.Debug(statusmsg.str());
             vpnclient = nullptr;
-            THROW_DBUSEXCEPTION("BackendServiceObject",
-                                "Configuration parsing failed: " + cfgeval.message);
+            config_error(cfgeval.message);
         }
+        check_profile_requirements(cfgeval.autologin, cfgeval.externalPki);
 
-        if (cfgeval.externalPki)
-        {
-            std::string errmsg = "Failed to parse configuration: "
-                "Configuration requires external PKI which is not implemented yet.";
-            signal.LogError(errmsg);
-            THROW_DBUSEXCEPTION("BackendServiceObject", errmsg);
-        }
+        signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CFG_OK,
+                            "config_path=" + configpath);
+    }
 
-        if (cfgeval.externalPki)
+
+    /**
+     *  Reports a configuration profile error and throws a DBusException
+     *
+     * @param message  std::string with the error message from the
+     *                 configuration profile evaluation
+     */
+    void config_error(const std::string& message)
+    {
+        std::stringstream statusmsg;
+        statusmsg << "config_path=" << configpath << ", "
+                  << "eval_message='" << message << "'";
+        signal.LogError("Failed to parse configuration: " + message);
+        signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CFG_ERROR,
+                            statusmsg.str());
+        signal.Debug(statusmsg.str());
+        THROW_DBUSEXCEPTION("BackendServiceObject",
+                            "Configuration parsing failed: " + message);
+    }
+
+
+    /**
+     *  Checks if the configuration profile can be used by this client
+     *  and if user credentials will be needed to connect.
+     *
+     * @param autologin     Bool flag, if false username/password is needed
+     * @param external_pki  Bool flag, set if the profile requires
+     *                      external PKI support
+     */
+    void check_profile_requirements(bool autologin, bool external_pki)
+    {
+        if (external_pki)
         {
             std::string errmsg = "Failed to parse configuration: "
                 "Configuration requires external PKI which is not implemented yet.";
@@ -899,7 +1361,7 @@ private:
 
         // Do we need username/password?  Or does this configuration allow the
         // client to log in automatically?
-        if (!cfgeval.autologin
+        if (!autologin
             && userinputq.QueueCount(ClientAttentionType::CREDENTIALS,
                                      ClientAttentionGroup::USER_PASSWORD) == 0)
         {
@@ -914,9 +1376,6 @@ private:
                                 ClientAttentionGroup::USER_PASSWORD,
                                 "Username/password credentials needed");
         }
-
-        signal.StatusChange(StatusMajor::CONNECTION, StatusMinor::CFG_OK,
-                            "config_path=" + configpath);
     }
 
 
@@ -944,6 +1403,7 @@ private:
             // GetConfig() call.
             bool tunPersist = cfg_proxy.GetPersistTun();
             std::vector<OverrideValue> overrides = cfg_proxy.GetOverrides();
+            profile_eval = cfg_proxy.GetEvaluation();
 
             // Parse the configuration
             ProfileMergeFromString pm(cfg_proxy.GetConfig(), "",
@@ -972,58 +1432,7 @@ private:
     {
         for (const auto & override: overrides)
         {
-            if (override.override.key == "server-override")
-            {
-                vpnconfig.serverOverride = override.strValue;
-            }
-            else if (override.override.key == "port-override")
-            {
-                vpnconfig.serverOverride = override.strValue;
-            }
-            else if (override.override.key == "proto-override")
-            {
-                vpnconfig.protoOverride = override.strValue;
-            }
-            else if (override.override.key == "ipv6")
-            {
-                vpnconfig.ipv6 = override.strValue;
-            }
-            else if (override.override.key == "dns-fallback-google")
-            {
-                vpnconfig.googleDnsFallback = override.boolValue;
-            }
-            else if (override.override.key == "dns-sync-lookup")
-            {
-                vpnconfig.synchronousDnsLookup = override.boolValue;
-            }
-            else if (override.override.key == "no-client-cert")
-            {
-                vpnconfig.disableClientCert = override.boolValue;
-            }
-            else if (override.override.key == "auth-fail-retry")
-            {
-                vpnconfig.retryOnAuthFailed = override.boolValue;
-            }
-            else if (override.override.key == "force-cipher-aes-cbc")
-            {
-                vpnconfig.forceAesCbcCiphersuites = override.boolValue;
-            }
-            else if (override.override.key == "allow-compression")
-            {
-                vpnconfig.compressionMode = override.strValue;
-            }
-            else if (override.override.key == "tls-version-min")
-            {
-                vpnconfig.tlsVersionMinOverride = override.strValue;
-            }
-            else if (override.override.key == "tls-cert-profile")
-            {
-                vpnconfig.tlsCertProfileOverride = override.strValue;
-            }
-            else if (override.override.key == "proxy-auth-cleartext")
-            {
-                vpnconfig.proxyAllowCleartextAuth = override.boolValue;
-            }
+            override.Apply(vpnconfig);
         }
     }
 
@@ -1031,6 +1440,179 @@ private:
 
 
 
+/**
+ *  Object used by backend client processes started by the backend
+ *  starter without a fixed session.  Pre-started processes wait idle in
+ *  the backend starter's process pool until they get a session token via
+ *  the AssignToken method.  Multiplexed backend processes keep this object
+ *  to accept more sessions as long as they have capacity.
+ */
+class BackendStandbyObject : public DBusObject,
+                             public DBusConnectionCreds,
+                             public RC<thread_safe_refcount>
+{
+public:
+    typedef RCPtr<BackendStandbyObject> Ptr;
+    typedef std::function<void(const std::string& token)> AssignCallback;
+    typedef std::function<bool(size_t pending)> AcceptCallback;
+
+    /**
+     *  Initialize the BackendStandbyObject
+     *
+     * @param conn      D-Bus connection this object is tied to
+     * @param assign    Callback to call once a session token has been
+     *                  assigned to this process
+     * @param accepting Callback deciding if another session can be
+     *                  assigned, given the number of assigned tokens not
+     *                  yet passed to the assign callback
+     */
+    BackendStandbyObject(GDBusConnection *conn, AssignCallback assign,
+                         AcceptCallback accepting)
+        : DBusObject(OpenVPN3DBus_rootp_backends_standby),
+          DBusConnectionCreds(conn),
+          assign(assign),
+          accepting(accepting),
+          assign_source(0)
+    {
+        std::stringstream introspection_xml;
+        introspection_xml << "<node name='" << OpenVPN3DBus_rootp_backends_standby << "'>"
+                          << "    <interface name='" << OpenVPN3DBus_interf_backends << "'>"
+                          << "        <method name='AssignToken'>"
+                          << "            <arg type='s' name='token' direction='in'/>"
+                          << "            <arg type='b' name='accepted' direction='out'/>"
+                          << "        </method>"
+                          << "    </interface>"
+                          << "</node>";
+        ParseIntrospectionXML(introspection_xml);
+    }
+
+
+    ~BackendStandbyObject()
+    {
+        if (assign_source > 0)
+        {
+            g_source_remove(assign_source);
+        }
+    }
+
+
+    /**
+     *  Callback method which is called each time a D-Bus method call occurs
+     *  on this BackendStandbyObject.
+     *
+     * @param conn        D-Bus connection where the method call occurred
+     * @param sender      D-Bus bus name of the sender of the method call
+     * @param obj_path    D-Bus object path of the target object.
+     * @param intf_name   D-Bus interface of the method call
+     * @param method_name D-Bus method name to be executed
+     * @param params      GVariant Glib2 object containing the arguments for
+     *                    the method call
+     * @param invoc       GDBusMethodInvocation where the response/result of
+     *                    the method call will be returned.
+     */
+    void callback_method_call(GDBusConnection *conn,
+                              const std::string sender,
+                              const std::string obj_path,
+                              const std::string intf_name,
+                              const std::string method_name,
+                              GVariant *params,
+                              GDBusMethodInvocation *invoc)
+    {
+        // Only the backend starter is allowed to hand over sessions
+        if ("AssignToken" != method_name
+            || GetUniqueBusID(OpenVPN3DBus_name_backends) != sender)
+        {
+            GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.standby",
+                                                          "Access denied");
+            g_dbus_method_invocation_return_gerror(invoc, err);
+            g_error_free(err);
+            return;
+        }
+
+        if (!accepting(pending.size()))
+        {
+            g_dbus_method_invocation_return_value(invoc,
+                                                  g_variant_new("(b)", false));
+            return;
+        }
+
+        gchar *tok = NULL;
+        g_variant_get(params, "(s)", &tok);
+        pending.push_back(std::string(tok));
+        g_free(tok);
+        g_dbus_method_invocation_return_value(invoc,
+                                              g_variant_new("(b)", true));
+
+        // The session object cannot be set up from within a method
+        // call to this object, as this object may be removed in that process
+        if (0 == assign_source)
+        {
+            assign_source = g_idle_add(start_sessions, this);
+        }
+    }
+
+
+    GVariant * callback_get_property(GDBusConnection *conn,
+                                     const std::string sender,
+                                     const std::string obj_path,
+                                     const std::string intf_name,
+                                     const std::string property_name,
+                                     GError **error)
+    {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Unknown property");
+        return NULL;
+    }
+
+
+    GVariantBuilder * callback_set_property(GDBusConnection *conn,
+                                            const std::string sender,
+                                            const std::string obj_path,
+                                            const std::string intf_name,
+                                            const std::string property_name,
+                                            GVariant *value,
+                                            GError **error)
+    {
+        THROW_DBUSEXCEPTION("BackendStandbyObject",
+                            "set property not implemented");
+    }
+
+
+    /**
+     *  Retrieve the number of accepted session tokens not yet passed
+     *  to the assign callback
+     */
+    size_t Pending() const
+    {
+        return pending.size();
+    }
+
+
+private:
+    AssignCallback assign;
+    AcceptCallback accepting;
+    std::vector<std::string> pending;
+    guint assign_source;
+
+
+    static gboolean start_sessions(gpointer this_ptr)
+    {
+        BackendStandbyObject *obj = (BackendStandbyObject *) this_ptr;
+        obj->assign_source = 0;
+
+        // The callback may destroy this object, so copy what is needed
+        AssignCallback cb = obj->assign;
+        std::vector<std::string> tokens;
+        tokens.swap(obj->pending);
+        for (const auto& tok : tokens)
+        {
+            cb(tok);
+        }
+        return G_SOURCE_REMOVE;
+    }
+};
+
+
+
 /**
  *  Main Backend Client D-Bus service.  This registers this client process
  *  as a separate and unique D-Bus service
@@ -1046,7 +1628,9 @@ public:
      *                   registered on the system or session bus.
      * @param sesstoken  String containing the session token provided via the
      *                   command line.  This is used when signalling back
-     *                   to the session manager.
+     *                   to the session manager.  If empty, the process
+     *                   waits in the backend starter's pool until it
+     *                   gets a token assigned.
      */
     BackendClientDBus(pid_t start_pid, GBusType bus_type,
                       std::string sesstoken, LogWriter *logwr)
@@ -1057,22 +1641,33 @@ public:
           start_pid(start_pid),
           session_token(sesstoken),
           logwr(logwr),
-          procsig(nullptr),
-          be_obj(nullptr),
-          signal(nullptr),
-          signal_broadcast(false)
+          signal_broadcast(false),
+          max_sessions(1),
+          mainloop(nullptr),
+          backendstart_watch(0)
     {
     };
 
     ~BackendClientDBus()
     {
+        if (backendstart_watch > 0)
+        {
+            g_bus_unwatch_name(backendstart_watch);
+        }
         // If we do multicast (!broadcast), detach from the log service
         if (!signal_broadcast)
         {
             logservice->Detach(OpenVPN3DBus_interf_backends);
             logservice->Detach(OpenVPN3DBus_interf_sessions);
         }
-        procsig->ProcessChange(StatusMinor::PROC_STOPPED);
+        for (auto& s : sessions)
+        {
+            s.second.procsig->ProcessChange(StatusMinor::PROC_STOPPED);
+        }
+        if (standby)
+        {
+            release_vpn_core();
+        }
     }
 
 
@@ -1085,9 +1680,10 @@ public:
      */
     void SetMainLoop(GMainLoop *ml)
     {
-        if (be_obj)
+        mainloop = ml;
+        for (auto& s : sessions)
         {
-            be_obj->SetMainLoop(ml);
+            s.second.obj->SetMainLoop(ml);
         }
     }
 
@@ -1118,6 +1714,21 @@ public:
     }
 
 
+    /**
+     *  Lets this process host several VPN sessions, each with its own
+     *  VPN client thread.  The D-Bus connection and the VPN core library
+     *  initialization is shared between the sessions.  The process exits
+     *  when the last session has been closed.
+     *
+     * @param max  Maximum number of sessions this process will host
+     */
+    void SetMultiplexed(unsigned int max)
+    {
+        max_sessions = (max > 0 ? max : 1);
+        multiplexed = true;
+    }
+
+
     /**
      *  This callback is called when the service was successfully registered
      *  on the D-Bus.
@@ -1143,28 +1754,27 @@ public:
             }
         }
 
-        // Create a new OpenVPN3 client session object
-        object_path = generate_path_uuid(OpenVPN3DBus_rootp_backends_sessions, 'z');
-        be_obj.reset(new BackendClientObject(GetConnection(), GetBusName(),
-                                             object_path,
-                                             session_token,
-                                             default_log_level,
-                                             logwr));
-        be_obj->SetSignalBroadcast(signal_broadcast);
-        be_obj->RegisterObject(GetConnection());
-
-        // Setup a signal object of the backend
-        signal.reset(new BackendSignals(GetConnection(), LogGroup::BACKENDPROC,
-                                        object_path, logwr));
-        signal->SetLogLevel(default_log_level);
-        signal->LogVerb2("Backend client process started as pid " + std::to_string(start_pid)
-                         + " re-initiated as pid " + std::to_string(getpid()));
-        signal->Debug("BackendClientDBus registered on '" + GetBusName()
-                       + "': " + object_path);
-
-        procsig.reset(new ProcessSignalProducer(GetConnection(), OpenVPN3DBus_interf_backends,
-                                            object_path, "VPN-Client"));
-        procsig->ProcessChange(StatusMinor::PROC_STARTED);
+        if (session_token.empty() || multiplexed)
+        {
+            // Pre-started by the backend starter or hosting several
+            // sessions; get the expensive initialization done while
+            // waiting for a session
+            init_vpn_core();
+            standby.reset(new BackendStandbyObject(GetConnection(),
+                                                   [this](const std::string& token)
+                                                   {
+                                                       assign_session(token);
+                                                   },
+                                                   [this](size_t pending)
+                                                   {
+                                                       return sessions.size() + pending < max_sessions;
+                                                   }));
+            standby->RegisterObject(GetConnection());
+        }
+        if (!session_token.empty())
+        {
+            start_session(session_token);
+        }
     }
 
 
@@ -1172,14 +1782,49 @@ public:
      *  This is called each time the well-known bus name is successfully
      *  acquired on the D-Bus.
      *
-     *  This is not used, as the preparations already happens in
-     *  callback_bus_acquired()
+     *  Processes waiting for sessions register themselves in the backend
+     *  starter once the bus name is in place.  Otherwise this is not
+     *  used, as the preparations already happens in callback_bus_acquired()
      *
      * @param conn     Connection where this event happened
      * @param busname  A string of the acquired bus name
      */
     void callback_name_acquired(GDBusConnection *conn, std::string busname)
     {
+        if (!standby)
+        {
+            return;
+        }
+
+        // If the backend starter goes away, nobody will assign
+        // a session to this process any more.
+        backendstart_watch = g_bus_watch_name_on_connection(conn,
+                                                            OpenVPN3DBus_name_backends.c_str(),
+                                                            G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                            NULL,
+                                                            backendstart_vanished,
+                                                            this, NULL);
+        try
+        {
+            DBusProxy bstart(conn, OpenVPN3DBus_name_backends,
+                             OpenVPN3DBus_interf_backends,
+                             OpenVPN3DBus_rootp_backends);
+            bstart.SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+            GVariant *res = bstart.Call("RegisterPooledClient");
+            gboolean accepted = false;
+            g_variant_get(res, "(b)", &accepted);
+            g_variant_unref(res);
+            if (accepted)
+            {
+                return;
+            }
+        }
+        catch (DBusException& excp)
+        {
+            std::cout << "Could not register in the backend starter: "
+                      << excp.what() << std::endl;
+        }
+        close_standby();
     };
 
 
@@ -1200,22 +1845,179 @@ public:
 
 
 private:
+    /**
+     *  A VPN session hosted by this process
+     */
+    struct Session
+    {
+        BackendClientObject::Ptr obj;
+        BackendSignals::Ptr signal;
+        ProcessSignalProducer::Ptr procsig;
+    };
+
     unsigned int default_log_level = 6; // LogCategory::DEBUG messages
     pid_t start_pid;
     std::string session_token;
-    std::string object_path;
     LogWriter *logwr;
-    ProcessSignalProducer::Ptr procsig;
-    BackendClientObject::Ptr be_obj;
-    BackendSignals::Ptr signal;
+    std::map<std::string, Session> sessions;
+    std::vector<std::string> closed_sessions;
+    BackendStandbyObject::Ptr standby;
     bool signal_broadcast;
+    bool multiplexed = false;
+    unsigned int max_sessions;
     LogServiceProxy::Ptr logservice;
+    GMainLoop *mainloop;
+    guint backendstart_watch;
+
+
+    /**
+     *  Creates a BackendClientObject for a session and registers it
+     *  with the session manager.
+     *
+     * @param token  std::string with the session registration token
+     */
+    void start_session(const std::string& token)
+    {
+        // Create a new OpenVPN3 client session object
+        std::string object_path = generate_path_uuid(OpenVPN3DBus_rootp_backends_sessions, 'z');
+        Session sess;
+        sess.obj.reset(new BackendClientObject(GetConnection(), GetBusName(),
+                                               object_path,
+                                               token,
+                                               default_log_level,
+                                               logwr));
+        sess.obj->SetSignalBroadcast(signal_broadcast);
+        if (mainloop)
+        {
+            sess.obj->SetMainLoop(mainloop);
+        }
+        if (multiplexed)
+        {
+            sess.obj->SetSessionClosedCallback([this, object_path]()
+                                               {
+                                                   session_closed(object_path);
+                                               });
+        }
+        sess.obj->RegisterObject(GetConnection());
+
+        // Setup a signal object of the backend
+        sess.signal.reset(new BackendSignals(GetConnection(), LogGroup::BACKENDPROC,
+                                             object_path, logwr));
+        sess.signal->SetLogLevel(default_log_level);
+        sess.signal->LogVerb2("Backend client process started as pid " + std::to_string(start_pid)
+                              + " re-initiated as pid " + std::to_string(getpid()));
+        sess.signal->Debug("BackendClientDBus registered on '" + GetBusName()
+                           + "': " + object_path);
+
+        sess.procsig.reset(new ProcessSignalProducer(GetConnection(), OpenVPN3DBus_interf_backends,
+                                                     object_path, "VPN-Client"));
+        sess.procsig->ProcessChange(StatusMinor::PROC_STARTED);
+        sessions[object_path] = sess;
+    }
+
+
+    /**
+     *  Called when the backend starter has assigned a session token
+     *  to this process.
+     *
+     * @param token  std::string with the session registration token
+     */
+    void assign_session(const std::string& token)
+    {
+        start_session(token);
+        if (!multiplexed)
+        {
+            close_standby();
+        }
+    }
+
+
+    /**
+     *  Called when a session in a multiplexed backend process has been
+     *  closed.  The session object is removed from the main loop, as this
+     *  is called while the session object is handling a D-Bus method call.
+     *
+     * @param object_path  std::string with the D-Bus path of the session
+     */
+    void session_closed(const std::string& object_path)
+    {
+        closed_sessions.push_back(object_path);
+        g_idle_add(remove_closed_sessions, this);
+    }
+
+
+    static gboolean remove_closed_sessions(gpointer this_ptr)
+    {
+        BackendClientDBus *obj = (BackendClientDBus *) this_ptr;
+        for (const auto& path : obj->closed_sessions)
+        {
+            auto it = obj->sessions.find(path);
+            if (obj->sessions.end() != it)
+            {
+                it->second.procsig->ProcessChange(StatusMinor::PROC_STOPPED);
+                obj->sessions.erase(it);
+            }
+        }
+        obj->closed_sessions.clear();
+
+        if (obj->sessions.empty()
+            && (!obj->standby || 0 == obj->standby->Pending()))
+        {
+            // Nothing left to host; stop accepting new sessions first,
+            // so the backend starter starts a new process instead
+            obj->close_standby();
+        }
+        return G_SOURCE_REMOVE;
+    }
+
+
+    /**
+     *  Stops accepting new sessions from the backend starter.  If no
+     *  sessions are running, the process is stopped.
+     */
+    void close_standby()
+    {
+        if (backendstart_watch > 0)
+        {
+            g_bus_unwatch_name(backendstart_watch);
+            backendstart_watch = 0;
+        }
+        if (standby)
+        {
+            standby->RemoveObject(GetConnection());
+            standby.reset();
+            release_vpn_core();
+        }
+        if (sessions.empty())
+        {
+            stop_mainloop();
+        }
+    }
+
+
+    void stop_mainloop()
+    {
+        if (mainloop)
+        {
+            g_main_loop_quit(mainloop);
+        }
+    }
+
+
+    static void backendstart_vanished(GDBusConnection *conn,
+                                      const gchar *name,
+                                      gpointer this_ptr)
+    {
+        BackendClientDBus *obj = (BackendClientDBus *) this_ptr;
+        obj->close_standby();
+    }
 };
 
 
 void start_client_thread(pid_t start_pid, const std::string argv0,
                         const std::string sesstoken, int log_level,
-                        bool signal_broadcast, LogWriter *logwr)
+                        bool signal_broadcast, unsigned int multiplex,
+                        LogWriter *logwr)
 {
     std::cout << get_version(argv0) << std::endl;
 
@@ -1226,6 +2028,10 @@ void start_client_thread(pid_t start_pid, const std::string argv0,
         backend_service.SetDefaultLogLevel(log_level);
     }
     backend_service.SetSignalBroadcast(signal_broadcast);
+    if (multiplex > 0)
+    {
+        backend_service.SetMultiplexed(multiplex);
+    }
     backend_service.Setup();
 
     // Main loop
@@ -1243,6 +2049,13 @@ void start_client_thread(pid_t start_pid, const std::string argv0,
 int client_service(ParsedArgs args)
 {
     auto extra = args.GetAllExtraArgs();
+    bool pooled = args.Present("pooled");
+    if (pooled && extra.empty())
+    {
+        // Pre-started process, the token is provided later on
+        // by the backend starter
+        extra.push_back("");
+    }
     if (extra.size() != 1)
     {
         std::cout << "** ERROR ** Invalid usage: " << args.GetArgv0()
@@ -1302,15 +2115,22 @@ int client_service(ParsedArgs args)
         log_level = std::atoi(args.GetValue("log-level", 0).c_str());
     }
 
-#ifdef DEBUG_OPTIONS
-    // When debugging, we might not want to do a fork.
+    unsigned int multiplex = 0;
+    if (args.Present("multiplex"))
+    {
+        multiplex = std::atoi(args.GetValue("multiplex", 0).c_str());
+    }
+
+    // When started by openvpn3-service-backendstart, the process is
+    // tracked by the backend starter and must not fork.  When debugging,
+    // we might not want to do a fork either.
     if (args.Present("no-fork"))
     {
         try
         {
             start_client_thread(getpid(), args.GetArgv0(), extra[0],
                                 log_level, args.Present("signal-broadcast"),
-                                logwr.get());
+                                multiplex, logwr.get());
             return 0;
         }
         catch (std::exception& excp)
@@ -1323,7 +2143,6 @@ int client_service(ParsedArgs args)
                   << std::endl;
         return 8;
     }
-#endif
 
     //
     // This is the normal production code branch
@@ -1335,7 +2154,7 @@ int client_service(ParsedArgs args)
         {
             start_client_thread(getpid(), args.GetArgv0(), extra[0],
                                 log_level, args.Present("signal-broadcast"),
-                                logwr.get());
+                                multiplex, logwr.get());
             return 0;
         }
         catch (std::exception& excp)
@@ -1370,9 +2189,13 @@ int main(int argc, char **argv)
                         "Make the log lines colourful");
     argparser.AddOption("signal-broadcast", 0,
                         "Broadcast all D-Bus signals instead of targeted multicast");
-#if DEBUG_OPTIONS
+    argparser.AddOption("pooled", 0,
+                        "Start without a session token and wait in the backend starter's process pool");
+    argparser.AddOption("multiplex", "MAX", true,
+                        "Host up to MAX VPN sessions in this process, assigned by the backend starter");
     argparser.AddOption("no-fork", 0,
-                        "Debug option: Do not fork a child to be run in the background.");
+                        "Do not fork a child to be run in the background.");
+#if DEBUG_OPTIONS
     argparser.AddOption("no-setsid", 0,
                         "Debug option: Do not not call setsid(3) when forking process.");
 #endif
@@ -0,0 +1,273 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   process-watcher.hpp
+ *
+ * @brief  Starts child processes and tracks when they exit
+ *
+ *         Processes are started with posix_spawn(), which does not block
+ *         the caller while the new program is loaded.  Each child process
+ *         is watched via a pidfd from the GLib main loop, or via a GLib
+ *         child watch on kernels without pidfd support.  The exit reason
+ *         of the child process is reported once it has been reaped.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+
+/**
+ *  Describes why a child process exited
+ */
+struct ProcessExitReason
+{
+    int exit_code = -1;        /**< Exit code, -1 if killed by a signal */
+    int signal = 0;            /**< Signal killing the process, 0 if none */
+    bool core_dumped = false;  /**< Did the process dump core */
+
+
+    /**
+     *  Decodes a wait status value from waitpid()
+     *
+     * @param status  Wait status of the reaped process
+     */
+    void Parse(int status)
+    {
+        if (WIFEXITED(status))
+        {
+            exit_code = WEXITSTATUS(status);
+        }
+        else if (WIFSIGNALED(status))
+        {
+            signal = WTERMSIG(status);
+            core_dumped = WCOREDUMP(status);
+        }
+    }
+
+
+    /**
+     *  Makes the exit reason human readable
+     *
+     * @return Returns a std::string describing the exit reason
+     */
+    std::string str() const
+    {
+        if (signal > 0)
+        {
+            return "killed by signal " + std::to_string(signal)
+                   + " (" + std::string(strsignal(signal)) + ")"
+                   + (core_dumped ? ", core dumped" : "");
+        }
+        return "exit code " + std::to_string(exit_code);
+    }
+};
+
+
+
+class ChildProcessWatcher
+{
+public:
+    /**
+     *  Callback called when a child process has exited and been reaped.
+     */
+    typedef std::function<void(pid_t pid, const ProcessExitReason& reason)> ExitCallback;
+
+
+    ChildProcessWatcher(ExitCallback exited)
+        : exited(exited)
+    {
+    }
+
+
+    ~ChildProcessWatcher()
+    {
+        for (auto& c : children)
+        {
+            if (c.second.source > 0)
+            {
+                g_source_remove(c.second.source);
+            }
+            if (c.second.pidfd >= 0)
+            {
+                close(c.second.pidfd);
+            }
+            delete c.second.ctx;
+        }
+    }
+
+
+    /**
+     *  Starts a new child process and begins watching it
+     *
+     * @param args  std::vector<std::string> with the full path of the
+     *              program to start followed by its arguments
+     *
+     * @return Returns the process ID of the child process or -1 if
+     *         the program could not be started.  errno is set on errors.
+     */
+    pid_t Spawn(const std::vector<std::string>& args)
+    {
+        std::vector<char *> argv;
+        for (const auto& a : args)
+        {
+            argv.push_back((char *) a.c_str());
+        }
+        argv.push_back(nullptr);
+        char *envp[] = { nullptr };
+
+        pid_t pid = -1;
+        int ret = posix_spawn(&pid, argv[0], NULL, NULL, argv.data(), envp);
+        if (0 != ret)
+        {
+            errno = ret;
+            return -1;
+        }
+        watch(pid);
+        return pid;
+    }
+
+
+    /**
+     *  Checks if a process is a running child process of ours
+     *
+     * @param pid  Process ID to check
+     *
+     * @return Returns true if the process is still running
+     */
+    bool Running(pid_t pid) const
+    {
+        return children.find(pid) != children.end();
+    }
+
+
+    /**
+     *  Retrieve the number of running child processes
+     */
+    size_t Count() const
+    {
+        return children.size();
+    }
+
+
+private:
+    struct WatchContext
+    {
+        ChildProcessWatcher *watcher;
+        pid_t pid;
+    };
+
+    struct Child
+    {
+        int pidfd;
+        guint source;
+        WatchContext *ctx;
+    };
+
+    ExitCallback exited;
+    std::map<pid_t, Child> children;
+
+
+    void watch(pid_t pid)
+    {
+        Child child;
+        child.ctx = new WatchContext{this, pid};
+        child.pidfd = -1;
+#ifdef SYS_pidfd_open
+        child.pidfd = syscall(SYS_pidfd_open, pid, 0);
+#endif
+        if (child.pidfd >= 0)
+        {
+            child.source = g_unix_fd_add(child.pidfd, G_IO_IN,
+                                         pidfd_callback, child.ctx);
+        }
+        else
+        {
+            // Kernels older than 5.3 do not provide pidfd_open()
+            child.source = g_child_watch_add(pid, child_watch_callback,
+                                             child.ctx);
+        }
+        children[pid] = child;
+    }
+
+
+    void child_exited(pid_t pid, int status)
+    {
+        auto it = children.find(pid);
+        if (children.end() == it)
+        {
+            return;
+        }
+        if (it->second.pidfd >= 0)
+        {
+            close(it->second.pidfd);
+        }
+        delete it->second.ctx;
+        children.erase(it);
+
+        ProcessExitReason reason;
+        reason.Parse(status);
+        exited(pid, reason);
+    }
+
+
+    static gboolean pidfd_callback(gint fd, GIOCondition cond,
+                                   gpointer ctx_ptr)
+    {
+        WatchContext *ctx = (WatchContext *) ctx_ptr;
+        int status = 0;
+        pid_t ret = waitpid(ctx->pid, &status, WNOHANG);
+        if (0 == ret)
+        {
+            // Not exited yet; should not happen when the pidfd is readable
+            return G_SOURCE_CONTINUE;
+        }
+        if (ret < 0)
+        {
+            // Reaped elsewhere, the exit status is not available
+            status = W_EXITCODE(255, 0);
+        }
+        ctx->watcher->children[ctx->pid].source = 0;
+        ctx->watcher->child_exited(ctx->pid, status);
+        return G_SOURCE_REMOVE;
+    }
+
+
+    static void child_watch_callback(GPid pid, gint status, gpointer ctx_ptr)
+    {
+        WatchContext *ctx = (WatchContext *) ctx_ptr;
+        ctx->watcher->children[ctx->pid].source = 0;
+        ctx->watcher->child_exited(pid, status);
+    }
+};
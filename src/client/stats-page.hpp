@@ -0,0 +1,396 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   stats-page.hpp
+ *
+ * @brief  Connection statistics published in a shared memory page
+ *
+ *         Each VPN backend client process publishes the counters of the
+ *         core library statistics bundle in a memfd based memory area.
+ *         A read-only file descriptor to this area is passed over D-Bus,
+ *         after which the statistics can be sampled without any system
+ *         calls or D-Bus traffic.
+ *
+ *         Memory layout (all values in host byte order):
+ *
+ *           offset 0                   StatsPageHeader
+ *           StatsPageNamesOffset()     count * STATS_PAGE_NAME_LEN bytes,
+ *                                      NUL terminated counter names
+ *           StatsPageValuesOffset()    count * int64_t counter values
+ *
+ *         The counter index is the index in the core library statistics
+ *         bundle, which does not change while the process runs.  Updates
+ *         are protected by a sequence lock: the sequence number is odd
+ *         while the values are being updated, so a reader must retry if
+ *         the sequence number is odd or changed while reading.
+ *
+ *         The memfd is sealed against resizing and against new writable
+ *         mappings or writes (F_SEAL_FUTURE_WRITE), so a receiver of the
+ *         file descriptor cannot modify the page even by reopening it.
+ *         Read-only file descriptors are not handed out on kernels without
+ *         F_SEAL_FUTURE_WRITE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "dbus/core.hpp"
+
+using namespace openvpn;
+
+#define STATS_PAGE_MAGIC    0x5333564f  // "OV3S"
+#define STATS_PAGE_VERSION  1
+#define STATS_PAGE_NAME_LEN 32
+#define STATS_PAGE_READ_RETRIES 1000
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010  // Linux 5.1+, not in older headers
+#endif
+
+
+struct StatsPageHeader
+{
+    uint32_t magic;     /**< STATS_PAGE_MAGIC */
+    uint32_t version;   /**< STATS_PAGE_VERSION */
+    uint32_t count;     /**< Number of counters */
+    uint32_t seq;       /**< Sequence lock, odd while updating */
+    uint64_t updated;   /**< Last update, microseconds since the epoch */
+};
+
+
+inline size_t StatsPageNamesOffset()
+{
+    return 64;
+}
+
+
+inline size_t StatsPageValuesOffset(uint32_t count)
+{
+    size_t off = StatsPageNamesOffset() + count * STATS_PAGE_NAME_LEN;
+    return (off + 7) & ~((size_t) 7);
+}
+
+
+inline size_t StatsPageSize(uint32_t count)
+{
+    return StatsPageValuesOffset(count) + count * sizeof(int64_t);
+}
+
+
+
+/**
+ *  Creates and updates the statistics page in the VPN backend client
+ */
+class StatsPageWriter
+{
+public:
+    /**
+     *  Creates the shared memory area
+     *
+     * @param names  std::vector<std::string> with the counter names,
+     *               in the core library statistics bundle order
+     */
+    StatsPageWriter(const std::vector<std::string>& names)
+        : fd(-1),
+          page(nullptr),
+          size(StatsPageSize(names.size()))
+    {
+        fd = syscall(SYS_memfd_create, "openvpn3-stats",
+                     MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (fd < 0)
+        {
+            THROW_DBUSEXCEPTION("StatsPageWriter",
+                                "Could not create memfd: "
+                                + std::string(strerror(errno)));
+        }
+        if (ftruncate(fd, size) < 0)
+        {
+            int err = errno;
+            close(fd);
+            THROW_DBUSEXCEPTION("StatsPageWriter",
+                                "Could not size memfd: "
+                                + std::string(strerror(err)));
+        }
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == p)
+        {
+            int err = errno;
+            close(fd);
+            THROW_DBUSEXCEPTION("StatsPageWriter",
+                                "Could not map memfd: "
+                                + std::string(strerror(err)));
+        }
+        page = (char *) p;
+
+        char *namebuf = page + StatsPageNamesOffset();
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            strncpy(namebuf + i * STATS_PAGE_NAME_LEN, names[i].c_str(),
+                    STATS_PAGE_NAME_LEN - 1);
+        }
+        StatsPageHeader *hdr = header();
+        hdr->magic = STATS_PAGE_MAGIC;
+        hdr->version = STATS_PAGE_VERSION;
+        hdr->count = names.size();
+        hdr->seq = 0;
+
+        // The layout is fixed from now on.  F_SEAL_FUTURE_WRITE keeps
+        // the mapping above writable, but blocks any other write access.
+        if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW
+                  | F_SEAL_FUTURE_WRITE | F_SEAL_SEAL) < 0)
+        {
+            // Kernels older than 5.1; GetReadOnlyFD() will refuse
+            fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+        }
+    }
+
+
+    ~StatsPageWriter()
+    {
+        if (page)
+        {
+            munmap(page, size);
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+
+    /**
+     *  Publishes new counter values
+     *
+     * @param values  std::vector<long long> with the core library
+     *                statistics bundle
+     */
+    void Update(const std::vector<long long>& values)
+    {
+        StatsPageHeader *hdr = header();
+        int64_t *dest = (int64_t *) (page + StatsPageValuesOffset(hdr->count));
+        size_t n = std::min((size_t) hdr->count, values.size());
+
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        for (size_t i = 0; i < n; ++i)
+        {
+            __atomic_store_n(&dest[i], (int64_t) values[i], __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&hdr->updated,
+                         (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000,
+                         __ATOMIC_RELAXED);
+        __atomic_store_n(&hdr->seq, hdr->seq + 1, __ATOMIC_RELEASE);
+    }
+
+
+    /**
+     *  Opens a new read-only file descriptor to the statistics page.  The
+     *  caller is responsible for closing it.  The page cannot be modified
+     *  through this file descriptor, not even by reopening it.
+     *
+     * @return Returns a file descriptor, or -1 on errors or if the page
+     *         could not be sealed against writes.
+     */
+    int GetReadOnlyFD() const
+    {
+        int seals = fcntl(fd, F_GET_SEALS);
+        if (seals < 0 || !(seals & F_SEAL_FUTURE_WRITE))
+        {
+            return -1;
+        }
+
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%i", fd);
+        return open(path, O_RDONLY | O_CLOEXEC);
+    }
+
+
+private:
+    int fd;
+    char *page;
+    size_t size;
+
+
+    StatsPageHeader *header() const
+    {
+        return (StatsPageHeader *) page;
+    }
+};
+
+
+
+/**
+ *  Reads a statistics page received from a VPN backend client
+ */
+class StatsPageReader
+{
+public:
+    /**
+     *  Maps a statistics page
+     *
+     * @param pagefd  File descriptor to the statistics page.  The file
+     *                descriptor can be closed once this object exists.
+     */
+    StatsPageReader(int pagefd)
+        : page(nullptr),
+          size(0),
+          count(0)
+    {
+        // The page must not be able to shrink under the mapping, which
+        // would make reading it fail with SIGBUS
+        int seals = fcntl(pagefd, F_GET_SEALS);
+        if (seals < 0 || !(seals & F_SEAL_SHRINK))
+        {
+            THROW_DBUSEXCEPTION("StatsPageReader",
+                                "Statistics page is not sealed");
+        }
+
+        struct stat st;
+        if (fstat(pagefd, &st) < 0 || (size_t) st.st_size < StatsPageNamesOffset())
+        {
+            THROW_DBUSEXCEPTION("StatsPageReader", "Invalid statistics page");
+        }
+        size = st.st_size;
+        void *p = mmap(NULL, size, PROT_READ, MAP_SHARED, pagefd, 0);
+        if (MAP_FAILED == p)
+        {
+            THROW_DBUSEXCEPTION("StatsPageReader",
+                                "Could not map statistics page: "
+                                + std::string(strerror(errno)));
+        }
+        page = (const char *) p;
+
+        // The writer can still modify the header, so the counter count
+        // is only read once and validated here
+        const StatsPageHeader *hdr = header();
+        count = __atomic_load_n(&hdr->count, __ATOMIC_RELAXED);
+        if (STATS_PAGE_MAGIC != hdr->magic
+            || STATS_PAGE_VERSION != hdr->version
+            || count > (size - StatsPageNamesOffset()) / STATS_PAGE_NAME_LEN
+            || StatsPageSize(count) > size)
+        {
+            munmap((void *) page, size);
+            page = nullptr;
+            THROW_DBUSEXCEPTION("StatsPageReader",
+                                "Unsupported statistics page format");
+        }
+    }
+
+
+    ~StatsPageReader()
+    {
+        if (page)
+        {
+            munmap((void *) page, size);
+        }
+    }
+
+
+    /**
+     *  Retrieve the counter names, in the order of the values returned
+     *  by Read()
+     *
+     * @return Returns a std::vector<std::string> of the counter names
+     */
+    std::vector<std::string> GetNames() const
+    {
+        std::vector<std::string> ret;
+        const char *namebuf = page + StatsPageNamesOffset();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ret.push_back(std::string(namebuf + i * STATS_PAGE_NAME_LEN,
+                                      strnlen(namebuf + i * STATS_PAGE_NAME_LEN,
+                                              STATS_PAGE_NAME_LEN)));
+        }
+        return ret;
+    }
+
+
+    /**
+     *  Takes a consistent snapshot of all the counters
+     *
+     * @param values   std::vector<int64_t> which will be filled with the
+     *                 counter values
+     * @param updated  Set to the time of the last update, in microseconds
+     *                 since the epoch
+     *
+     *  A DBusException is thrown if no consistent snapshot could be taken
+     *  after STATS_PAGE_READ_RETRIES attempts, which happens if the writer
+     *  died while updating the page.
+     */
+    void Read(std::vector<int64_t>& values, uint64_t& updated) const
+    {
+        const StatsPageHeader *hdr = header();
+        const int64_t *src = (const int64_t *) (page + StatsPageValuesOffset(count));
+        values.resize(count);
+
+        for (unsigned int attempt = 0; attempt < STATS_PAGE_READ_RETRIES; ++attempt)
+        {
+            uint32_t seq_start = __atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE);
+            if (seq_start & 1)
+            {
+                sched_yield();
+                continue;
+            }
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                values[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+            }
+            updated = __atomic_load_n(&hdr->updated, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&hdr->seq, __ATOMIC_RELAXED) == seq_start)
+            {
+                return;
+            }
+        }
+        THROW_DBUSEXCEPTION("StatsPageReader",
+                            "Statistics page is not consistent");
+    }
+
+
+private:
+    const char *page;
+    size_t size;
+    uint32_t count;   /**< Validated number of counters */
+
+
+    const StatsPageHeader *header() const
+    {
+        return (const StatsPageHeader *) page;
+    }
+};
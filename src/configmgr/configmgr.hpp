@@ -21,16 +21,28 @@
 #define OPENVPN3_DBUS_CONFIGMGR_HPP
 
 #include <functional>
+#include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <ctime>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <openvpn/log/logsimple.hpp>
+#include <openvpn/client/cliopthelper.hpp>
 #include "common/core-extensions.hpp"
+#include "common/utils.hpp"
 #include "configmgr/overrides.hpp"
+#include "configmgr/profile-watcher.hpp"
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
+#include "dbus/dispatch.hpp"
 #include "dbus/exceptions.hpp"
 #include "dbus/object-property.hpp"
+#include "dbus/tracepoints.hpp"
 #include "log/ansicolours.hpp"
 #include "log/dbus-log.hpp"
 #include "log/logwriter.hpp"
@@ -155,12 +167,15 @@ public:
                                 "Specified alias is invalid");
         }
 
-        std::string introsp_xml ="<node name='" + new_obj_path + "'>"
-            "    <interface name='" + OpenVPN3DBus_interf_configuration + "'>"
-            "        <property  type='o' name='config_path' access='read'/>"
-            "    </interface>"
-            "</node>";
-        ParseIntrospectionXML(introsp_xml);
+        // The introspection document is the same for all aliases
+        SetSharedIntrospection("ConfigurationAlias", []()
+            {
+                return std::string("<node>"
+                    "    <interface name='" + OpenVPN3DBus_interf_configuration + "'>"
+                    "        <property  type='o' name='config_path' access='read'/>"
+                    "    </interface>"
+                    "</node>");
+            });
     }
 
 
@@ -386,7 +401,10 @@ public:
           persistent(false),
           persist_tun(false),
           alias(nullptr),
-          properties(this)
+          properties(this),
+          eval_autologin(false),
+          eval_external_pki(false),
+          eval_static_challenge_echo(false)
     {
         gchar *cfgstr;
         gchar *cfgname_c;
@@ -396,13 +414,7 @@ public:
         name = std::string(cfgname_c);
 
         // Parse the options from the imported configuration
-        OptionList::Limits limits("profile is too large",
-				  ProfileParseLimits::MAX_PROFILE_SIZE,
-				  ProfileParseLimits::OPT_OVERHEAD,
-				  ProfileParseLimits::TERM_OVERHEAD,
-				  ProfileParseLimits::MAX_LINE_SIZE,
-				  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
-        options.parse_from_config(cfgstr, &limits);
+        parse_profile(cfgstr);
 
         std::stringstream msg;
         msg << "Parsed "
@@ -412,10 +424,11 @@ public:
             << " configuration '" << name << "'"
             << ", owner: " << lookup_username(creator);
         LogInfo(msg.str());
-
-        // FIXME:  Validate the configuration file, ensure --ca/--key/--cert/--dh/--pkcs12
-        //         contains files
-        valid = true;
+        if (!valid)
+        {
+            LogWarn("Configuration '" + name + "' is not valid: "
+                    + eval_message);
+        }
 
         properties.AddBinding(new PropertyType<std::time_t>(this, "import_timestamp", "read", false, import_tstamp, "t"));
         properties.AddBinding(new PropertyType<std::time_t>(this, "last_used_timestamp", "read", false, last_use_tstamp, "t"));
@@ -425,45 +438,61 @@ public:
         properties.AddBinding(new PropertyType<bool>(this, "readonly", "read", false, readonly));
         properties.AddBinding(new PropertyType<bool>(this, "single_use", "read", false, single_use));
         properties.AddBinding(new PropertyType<unsigned int>(this, "used_count", "read", false, used_count));
-        properties.AddBinding(new PropertyType<bool>(this, "valid", "read", false, valid));
         properties.AddBinding(new PropertyType<decltype(override_list)>(this, "overrides", "read", true, override_list));
 
-        std::string introsp_xml ="<node name='" + objpath + "'>"
-            "    <interface name='net.openvpn.v3.configuration'>"
-            "        <method name='Fetch'>"
-            "            <arg direction='out' type='s' name='config'/>"
-            "        </method>"
-            "        <method name='FetchJSON'>"
-            "            <arg direction='out' type='s' name='config_json'/>"
-            "        </method>"
-            "        <method name='SetOption'>"
-            "            <arg direction='in' type='s' name='option'/>"
-            "            <arg direction='in' type='s' name='value'/>"
-            "        </method>"
-            "        <method name='SetOverride'>"
-            "            <arg direction='in' type='s' name='name'/>"
-            "            <arg direction='in' type='v' name='value'/>"
-            "        </method>"
-            "        <method name='UnsetOverride'>"
-            "            <arg direction='in' type='s' name='name'/>"
-            "        </method>"
-            "        <method name='AccessGrant'>"
-            "            <arg direction='in' type='u' name='uid'/>"
-            "        </method>"
-            "        <method name='AccessRevoke'>"
-            "            <arg direction='in' type='u' name='uid'/>"
-            "        </method>"
-            "        <method name='Seal'/>"
-            "        <method name='Remove'/>"
-            "        <property type='u' name='owner' access='read'/>"
-            "        <property type='au' name='acl' access='read'/>"
-            "        <property type='s' name='name' access='readwrite'/>"
-            "        <property type='b' name='public_access' access='readwrite'/>"
-            "        <property type='s' name='alias' access='readwrite'/>"
-            + properties.GetIntrospectionXML() +
-            "    </interface>"
-            "</node>";
-        ParseIntrospectionXML(introsp_xml);
+        // The profile evaluation is read by the VPN backend client, which
+        // runs as root, before it connects
+        properties.AddBinding(new PropertyType<bool>(this, "valid", "read", true, valid));
+        properties.AddBinding(new PropertyType<std::string>(this, "eval_message", "read", true, eval_message));
+        properties.AddBinding(new PropertyType<bool>(this, "autologin", "read", true, eval_autologin));
+        properties.AddBinding(new PropertyType<bool>(this, "external_pki", "read", true, eval_external_pki));
+        properties.AddBinding(new PropertyType<std::string>(this, "static_challenge", "read", true, eval_static_challenge));
+        properties.AddBinding(new PropertyType<bool>(this, "static_challenge_echo", "read", true, eval_static_challenge_echo));
+        properties.AddBinding(new PropertyType<std::vector<std::string>>(this, "remotes", "read", true, eval_remotes));
+
+        // All profile properties are restricted by the access control
+        // list, so PropertiesChanged signals must not carry the values
+        SetPropertiesChangedInvalidateOnly(true);
+
+        // The introspection document is the same for all configurations
+        SetSharedIntrospection("ConfigurationObject", [this]()
+            {
+                return std::string("<node>"
+                    "    <interface name='net.openvpn.v3.configuration'>"
+                    "        <method name='Fetch'>"
+                    "            <arg direction='out' type='s' name='config'/>"
+                    "        </method>"
+                    "        <method name='FetchJSON'>"
+                    "            <arg direction='out' type='s' name='config_json'/>"
+                    "        </method>"
+                    "        <method name='SetOption'>"
+                    "            <arg direction='in' type='s' name='option'/>"
+                    "            <arg direction='in' type='s' name='value'/>"
+                    "        </method>"
+                    "        <method name='SetOverride'>"
+                    "            <arg direction='in' type='s' name='name'/>"
+                    "            <arg direction='in' type='v' name='value'/>"
+                    "        </method>"
+                    "        <method name='UnsetOverride'>"
+                    "            <arg direction='in' type='s' name='name'/>"
+                    "        </method>"
+                    "        <method name='AccessGrant'>"
+                    "            <arg direction='in' type='u' name='uid'/>"
+                    "        </method>"
+                    "        <method name='AccessRevoke'>"
+                    "            <arg direction='in' type='u' name='uid'/>"
+                    "        </method>"
+                    "        <method name='Seal'/>"
+                    "        <method name='Remove'/>"
+                    "        <property type='u' name='owner' access='read'/>"
+                    "        <property type='au' name='acl' access='read'/>"
+                    "        <property type='s' name='name' access='readwrite'/>"
+                    "        <property type='b' name='public_access' access='readwrite'/>"
+                    "        <property type='s' name='alias' access='readwrite'/>"
+                    + properties.GetIntrospectionXML() +
+                    "    </interface>"
+                    "</node>");
+            });
 
         g_free(cfgname_c);
         g_free(cfgstr);
@@ -478,9 +507,38 @@ public:
     };
 
 
+    /**
+     *  Replaces the configuration profile with a new version of it.  The
+     *  D-Bus object path, overrides and access control list are preserved.
+     *
+     * @param cfgstr  std::string containing the new configuration profile
+     */
+    void UpdateProfile(const std::string& cfgstr)
+    {
+        parse_profile(cfgstr);
+        import_tstamp = std::time(nullptr);
+
+        LogInfo("Configuration '" + name + "' updated");
+        if (!valid)
+        {
+            LogWarn("Configuration '" + name + "' is not valid: "
+                    + eval_message);
+        }
+
+        for (const auto& p : {"import_timestamp", "valid", "eval_message",
+                              "autologin", "external_pki",
+                              "static_challenge", "static_challenge_echo",
+                              "remotes"})
+        {
+            properties.PropertyChanged(p);
+        }
+    }
+
+
     /**
      *  Callback method which is called each time a D-Bus method call occurs
-     *  on this ConfigurationObject.
+     *  on this ConfigurationObject.  The methods and their access levels
+     *  are listed in config_methods().
      *
      * @param conn        D-Bus connection where the method call occurred
      * @param sender      D-Bus bus name of the sender of the method call
@@ -492,294 +550,31 @@ public:
      * @param invoc       GDBusMethodInvocation where the response/result of
      *                    the method call will be returned.
      */
-    void callback_method_call(GDBusConnection *conn,
-                              const std::string sender,
-                              const std::string obj_path,
-                              const std::string intf_name,
-                              const std::string method_name,
-                              GVariant *params,
-                              GDBusMethodInvocation *invoc)
+    void callback_method_dispatch(GDBusConnection *conn,
+                                  const gchar *sender,
+                                  const gchar *obj_path,
+                                  const gchar *intf_name,
+                                  const gchar *method_name,
+                                  GVariant *params,
+                                  GDBusMethodInvocation *invoc)
     {
         IdleCheck_UpdateTimestamp();
-        if ("Fetch" == method_name)
-        {
-            try
-            {
-                if (!locked_down)
-                {
-                    CheckACL(sender, true);
-                }
-                else
-                {
-                    // If the configuration is locked down, restrict any
-                    // read-operations to anyone except the backend VPN client
-                    // process (root user) or the configuration profile owner
-                    CheckOwnerAccess(sender, true);
-                }
-                g_dbus_method_invocation_return_value(invoc,
-                                                      g_variant_new("(s)",
-                                                                    options.string_export().c_str()));
-
-                // If the fetching user is root, we consider this
-                // configuration to be "used"
-                if (GetUID(sender) == 0)
-                {
-                    // If this config is tagged as single-use only then we delete this
-                    // config from memory.
-                    if (single_use)
-                    {
-                        LogVerb2("Single-use configuration fetched");
-                        RemoveObject(conn);
-                        delete this;
-                        return;
-                    }
-                    used_count++;
-                    last_use_tstamp = std::time(nullptr);
-                }
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-        }
-        else if ("FetchJSON" == method_name)
-        {
-            try
-            {
-                if (!locked_down)
-                {
-                    CheckACL(sender);
-                }
-                else
-                {
-                    // If the configuration is locked down, restrict any
-                    // read-operations to the configuration profile owner
-                    CheckOwnerAccess(sender);
-                }
-                g_dbus_method_invocation_return_value(invoc,
-                                                      g_variant_new("(s)",
-                                                                    options.json_export().c_str()));
-
-                // Do not remove single-use object with this method.
-                // FetchJSON is only used by front-ends, never backends.  So
-                // it still needs to be available when the backend calls Fetch.
-                //
-                // single-use configurations are an automation convenience,
-                // not a security feature.  Security is handled via ACLs.
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-        }
-        else if ("SetOption" == method_name)
-        {
-            if (readonly)
-            {
-                g_dbus_method_invocation_return_dbus_error (invoc,
-                                                            "net.openvpn.v3.error.ReadOnly",
-                                                            "Configuration is sealed and readonly");
-                return;
-            }
-            try
-            {
-                CheckOwnerAccess(sender);
-                // TODO: Implement SetOption
-                g_dbus_method_invocation_return_value(invoc, NULL);
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-        }
-        else if ("SetOverride" == method_name)
-        {
-            if (readonly)
-            {
-                g_dbus_method_invocation_return_dbus_error(invoc,
-                                                           "net.openvpn.v3.error.ReadOnly",
-                                                           "Configuration is sealed and readonly");
-                return;
-            }
-            try
-            {
-                CheckOwnerAccess(sender);
-                gchar *key = nullptr;
-                GVariant *val = nullptr;
-                g_variant_get(params, "(sv)", &key, &val);
-
-                const OverrideValue vo = set_override(key, val);
-
-                std::string newValue = vo.strValue;
-                if (OverrideType::boolean == vo.override.type)
-                {
-                    newValue = vo.boolValue ? "true" : "false";
-                }
-
-                LogInfo("Setting configuration override '" + std::string(key)
-                            + "' to '" + newValue + "' by UID " + std::to_string(GetUID(sender)));
-
-                g_free(key);
-                //g_variant_unref(val);
-                g_dbus_method_invocation_return_value(invoc, NULL);
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-            catch (DBusException& excp)
-            {
-                LogWarn(excp.what());
-                excp.SetDBusError(invoc, "net.openvpn.v3.configmgr.error");
-            }
-        }
-        else if ("UnsetOverride" == method_name)
+        try
         {
-            if (readonly)
+            if (!config_methods().Dispatch(this, conn, sender, method_name,
+                                           params, invoc))
             {
+                std::string errmsg = "No method named " + std::string(method_name)
+                                     + " is available";
                 g_dbus_method_invocation_return_dbus_error(invoc,
-                                                           "net.openvpn.v3.error.ReadOnly",
-                                                           "Configuration is sealed and readonly");
-                return;
-            }
-            try
-            {
-                CheckOwnerAccess(sender);
-                gchar *key = nullptr;
-                g_variant_get(params, "(s)", &key);
-                if(remove_override(key))
-                {
-                    LogInfo("Unset configuration override '" + std::string(key)
-                                + "' by UID " + std::to_string(GetUID(sender)));
-
-                    g_dbus_method_invocation_return_value(invoc, NULL);
-                }
-                else
-                {
-                    std::stringstream err;
-                    err << "Override '" << std::string(key) << "' has "
-                        << "not been set";
-                    g_dbus_method_invocation_return_dbus_error (invoc,
-                                                                "net.openvpn.v3.error.OverrideNotSet",
-                                                                err.str().c_str());
-                }
-                g_free(key);
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
+                                                           "net.openvpn.v3.configmgr.error",
+                                                           errmsg.c_str());
             }
         }
-        else if ("AccessGrant" == method_name)
-        {
-            if (readonly)
-            {
-                g_dbus_method_invocation_return_dbus_error (invoc,
-                                                            "net.openvpn.v3.error.ReadOnly",
-                                                            "Configuration is sealed and readonly");
-                return;
-            }
-
-            try
-            {
-                CheckOwnerAccess(sender);
-
-                uid_t uid = -1;
-                g_variant_get(params, "(u)", &uid);
-                GrantAccess(uid);
-                g_dbus_method_invocation_return_value(invoc, NULL);
-
-                LogInfo("Access granted to UID " + std::to_string(uid)
-                         + " by UID " + std::to_string(GetUID(sender)));
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-        }
-        else if ("AccessRevoke" == method_name)
-        {
-            if (readonly)
-            {
-                g_dbus_method_invocation_return_dbus_error (invoc,
-                                                            "net.openvpn.v3.error.ReadOnly",
-                                                            "Configuration is sealed and readonly");
-                return;
-            }
-
-            try
-            {
-                CheckOwnerAccess(sender);
-
-                uid_t uid = -1;
-                g_variant_get(params, "(u)", &uid);
-                RevokeAccess(uid);
-                g_dbus_method_invocation_return_value(invoc, NULL);
-
-                LogInfo("Access revoked for UID " + std::to_string(uid)
-                         + " by UID " + std::to_string(GetUID(sender)));
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-        }
-        else if ("Seal" == method_name)
-        {
-            try
-            {
-                CheckOwnerAccess(sender);
-
-                if (valid) {
-                    readonly = true;
-                    g_dbus_method_invocation_return_value(invoc, NULL);
-                }
-                else
-                {
-                    g_dbus_method_invocation_return_dbus_error (invoc,
-                                                                "net.openvpn.v3.error.InvalidData",
-                                                                "Configuration is not currently valid");
-                }
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
-        }
-        else if ("Remove" == method_name)
+        catch (DBusCredentialsException& excp)
         {
-            try
-            {
-                CheckOwnerAccess(sender);
-                std::string sender_name = lookup_username(GetUID(sender));
-                LogInfo("Configuration '" + name + "' was removed by "
-                        + sender_name);
-                RemoveObject(conn);
-                g_dbus_method_invocation_return_value(invoc, NULL);
-                delete this;
-                return;
-            }
-            catch (DBusCredentialsException& excp)
-            {
-                LogWarn(excp.err());
-                excp.SetDBusError(invoc);
-            }
+            LogWarn(excp.err());
+            excp.SetDBusError(invoc);
         }
     };
 
@@ -911,8 +706,8 @@ public:
             {
                 if (nullptr != alias)
                 {
-                    alias->RemoveObject(conn);
-                    delete alias;
+                    // The alias is used from the GMainLoop
+                    alias->RemoveAndDelete(conn);
                     alias = nullptr;
                 }
 
@@ -989,7 +784,8 @@ public:
      * @param value  GVariant object of the override value to use
      *
      * @return  Returns the OverrideValue object added to the
-     *          array of override settings
+     *          array of override settings.  An invalid key, data type
+     *          or value throws DBusException.
      */
     OverrideValue set_override(const gchar *key, GVariant *value)
     {
@@ -1001,9 +797,6 @@ public:
                                 + "'");
         }
 
-        // Ensure that a previous override value is remove
-        (void) remove_override(key);
-
         if (OverrideType::string == vo.type)
         {
             std::string g_type(g_variant_get_type_string(value));
@@ -1016,6 +809,15 @@ public:
 
             gsize len = 0;
             std::string v(g_variant_get_string(value, &len));
+            if (!vo.ValidValue(v))
+            {
+                THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                    "Invalid value '" + v + "' for key '"
+                                    + std::string(key) + "'");
+            }
+
+            // Ensure that a previous override value is removed
+            (void) remove_override(vo.id);
             override_list.push_back(OverrideValue(vo, v));
 
         }
@@ -1030,6 +832,7 @@ public:
             }
 
             bool v = g_variant_get_boolean(value);
+            (void) remove_override(vo.id);
             override_list.push_back(OverrideValue(vo, v));
         }
         return override_list.back();
@@ -1045,9 +848,26 @@ public:
      */
     bool remove_override(const gchar *key)
     {
+        return remove_override(GetConfigOverride(key).id);
+    }
+
+
+    /**
+     *  Removes and override from the std::vector<OverrideValue> array
+     *
+     * @param id  OverrideID of the override to remove
+     *
+     * @return Returns true on successful removal, otherwise false.
+     */
+    bool remove_override(const OverrideID id)
+    {
+        if (OverrideID::invalid == id)
+        {
+            return false;
+        }
         for (auto it = override_list.begin(); it != override_list.end(); it++)
         {
-            if ((*it).override.key == key)
+            if ((*it).override.id == id)
             {
                 override_list.erase(it);
                 return true;
@@ -1058,6 +878,362 @@ public:
 
 
 private:
+    /**
+     *  D-Bus methods of a configuration profile and the access level they
+     *  require.  Fetch and FetchJSON do their own access checks, as these
+     *  depend on the locked_down flag.
+     */
+    static const DBusMethodTable<ConfigurationObject>& config_methods()
+    {
+        static const DBusMethodTable<ConfigurationObject> methods =
+            DBusMethodTable<ConfigurationObject>()
+            .Add("Fetch", DBusAccess::ANY, &ConfigurationObject::method_fetch)
+            .Add("FetchJSON", DBusAccess::ANY, &ConfigurationObject::method_fetch_json)
+            .Add("SetOption", DBusAccess::OWNER, &ConfigurationObject::method_set_option)
+            .Add("SetOverride", DBusAccess::OWNER,
+                 &ConfigurationObject::method_set_override)
+            .Add("UnsetOverride", DBusAccess::OWNER,
+                 &ConfigurationObject::method_unset_override)
+            .Add("AccessGrant", DBusAccess::OWNER,
+                 &ConfigurationObject::method_access_grant)
+            .Add("AccessRevoke", DBusAccess::OWNER,
+                 &ConfigurationObject::method_access_revoke)
+            .Add("Seal", DBusAccess::OWNER, &ConfigurationObject::method_seal)
+            .Add("Remove", DBusAccess::OWNER, &ConfigurationObject::method_remove);
+        return methods;
+    }
+
+
+    /**
+     *  Returns an error to the caller if the configuration is sealed
+     *
+     * @return Returns true if the configuration is read-only
+     */
+    bool return_if_readonly(GDBusMethodInvocation *invoc)
+    {
+        if (readonly)
+        {
+            g_dbus_method_invocation_return_dbus_error(invoc,
+                                                       "net.openvpn.v3.error.ReadOnly",
+                                                       "Configuration is sealed and readonly");
+        }
+        return readonly;
+    }
+
+
+    void method_fetch(GDBusConnection *conn, const gchar *sender,
+                      GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        TraceTimer trace;
+        if (!locked_down)
+        {
+            CheckACL(sender, true);
+        }
+        else
+        {
+            // If the configuration is locked down, restrict any
+            // read-operations to anyone except the backend VPN client
+            // process (root user) or the configuration profile owner
+            CheckOwnerAccess(sender, true);
+        }
+        std::string cfgstr = options.string_export();
+        OPENVPN3_TRACE3(config_fetch, GetObjectPath().c_str(), sender,
+                        trace.Elapsed());
+        g_dbus_method_invocation_return_value(invoc,
+                                              g_variant_new("(s)",
+                                                            cfgstr.c_str()));
+
+        // If the fetching user is root, we consider this
+        // configuration to be "used"
+        if (GetUID(sender) == 0)
+        {
+            // If this config is tagged as single-use only then we delete this
+            // config from memory.
+            if (single_use)
+            {
+                LogVerb2("Single-use configuration fetched");
+                RemoveAndDelete(conn);
+                return;
+            }
+            used_count++;
+            last_use_tstamp = std::time(nullptr);
+            properties.PropertyChanged("used_count");
+            properties.PropertyChanged("last_used_timestamp");
+        }
+    }
+
+
+    void method_fetch_json(GDBusConnection *conn, const gchar *sender,
+                           GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (!locked_down)
+        {
+            CheckACL(sender);
+        }
+        else
+        {
+            // If the configuration is locked down, restrict any
+            // read-operations to the configuration profile owner
+            CheckOwnerAccess(sender);
+        }
+        g_dbus_method_invocation_return_value(invoc,
+                                              g_variant_new("(s)",
+                                                            options.json_export().c_str()));
+
+        // Do not remove single-use object with this method.
+        // FetchJSON is only used by front-ends, never backends.  So
+        // it still needs to be available when the backend calls Fetch.
+        //
+        // single-use configurations are an automation convenience,
+        // not a security feature.  Security is handled via ACLs.
+    }
+
+
+    void method_set_option(GDBusConnection *conn, const gchar *sender,
+                           GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (return_if_readonly(invoc))
+        {
+            return;
+        }
+        // TODO: Implement SetOption
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    void method_set_override(GDBusConnection *conn, const gchar *sender,
+                             GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (return_if_readonly(invoc))
+        {
+            return;
+        }
+        gchar *key = nullptr;
+        GVariant *val = nullptr;
+        g_variant_get(params, "(sv)", &key, &val);
+        try
+        {
+            const OverrideValue vo = set_override(key, val);
+            properties.PropertyChanged("overrides");
+
+            std::string newValue = vo.strValue;
+            if (OverrideType::boolean == vo.override.type)
+            {
+                newValue = vo.boolValue ? "true" : "false";
+            }
+
+            LogInfo("Setting configuration override '" + std::string(key)
+                        + "' to '" + newValue + "' by UID " + std::to_string(GetUID(sender)));
+
+            g_dbus_method_invocation_return_value(invoc, NULL);
+        }
+        catch (DBusException& excp)
+        {
+            LogWarn(excp.what());
+            excp.SetDBusError(invoc, "net.openvpn.v3.configmgr.error");
+        }
+        g_free(key);
+        g_variant_unref(val);
+    }
+
+
+    void method_unset_override(GDBusConnection *conn, const gchar *sender,
+                               GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (return_if_readonly(invoc))
+        {
+            return;
+        }
+        gchar *key = nullptr;
+        g_variant_get(params, "(s)", &key);
+        if(remove_override(key))
+        {
+            properties.PropertyChanged("overrides");
+            LogInfo("Unset configuration override '" + std::string(key)
+                        + "' by UID " + std::to_string(GetUID(sender)));
+
+            g_dbus_method_invocation_return_value(invoc, NULL);
+        }
+        else
+        {
+            std::stringstream err;
+            err << "Override '" << std::string(key) << "' has "
+                << "not been set";
+            g_dbus_method_invocation_return_dbus_error (invoc,
+                                                        "net.openvpn.v3.error.OverrideNotSet",
+                                                        err.str().c_str());
+        }
+        g_free(key);
+    }
+
+
+    void method_access_grant(GDBusConnection *conn, const gchar *sender,
+                             GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (return_if_readonly(invoc))
+        {
+            return;
+        }
+        uid_t uid = -1;
+        g_variant_get(params, "(u)", &uid);
+        GrantAccess(uid);
+        PropertyChanged("acl");
+        g_dbus_method_invocation_return_value(invoc, NULL);
+
+        LogInfo("Access granted to UID " + std::to_string(uid)
+                 + " by UID " + std::to_string(GetUID(sender)));
+    }
+
+
+    void method_access_revoke(GDBusConnection *conn, const gchar *sender,
+                              GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (return_if_readonly(invoc))
+        {
+            return;
+        }
+        uid_t uid = -1;
+        g_variant_get(params, "(u)", &uid);
+        RevokeAccess(uid);
+        PropertyChanged("acl");
+        g_dbus_method_invocation_return_value(invoc, NULL);
+
+        LogInfo("Access revoked for UID " + std::to_string(uid)
+                 + " by UID " + std::to_string(GetUID(sender)));
+    }
+
+
+    void method_seal(GDBusConnection *conn, const gchar *sender,
+                     GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        if (valid) {
+            readonly = true;
+            properties.PropertyChanged("readonly");
+            g_dbus_method_invocation_return_value(invoc, NULL);
+        }
+        else
+        {
+            g_dbus_method_invocation_return_dbus_error (invoc,
+                                                        "net.openvpn.v3.error.InvalidData",
+                                                        "Configuration is not currently valid");
+        }
+    }
+
+
+    void method_remove(GDBusConnection *conn, const gchar *sender,
+                       GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        std::string sender_name = lookup_username(GetUID(sender));
+        LogInfo("Configuration '" + name + "' was removed by "
+                + sender_name);
+        g_dbus_method_invocation_return_value(invoc, NULL);
+        RemoveAndDelete(conn);
+    }
+
+
+    /**
+     *  Parses a configuration profile into the option list and
+     *  evaluates it.
+     *
+     * @param cfgstr  std::string containing the configuration profile
+     */
+    void parse_profile(const std::string& cfgstr)
+    {
+        OptionList::Limits limits("profile is too large",
+				  ProfileParseLimits::MAX_PROFILE_SIZE,
+				  ProfileParseLimits::OPT_OVERHEAD,
+				  ProfileParseLimits::TERM_OVERHEAD,
+				  ProfileParseLimits::MAX_LINE_SIZE,
+				  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+        options.clear();
+        options.parse_from_config(cfgstr, &limits);
+
+        // Evaluate the profile once, the results are provided
+        // as properties to both the backend and front-ends
+        evaluate_profile();
+    }
+
+
+    /**
+     *  Evaluates the parsed configuration profile.  This is done only once,
+     *  when the profile is imported or updated.  The results are stored in this object
+     *  and is provided via D-Bus properties, which allows the VPN client
+     *  backend and front-ends to use them without parsing the profile again.
+     *
+     *  This also ensures the --ca, --cert, --key, --dh and --pkcs12 options
+     *  contains the embedded file contents.  File references cannot be
+     *  resolved by the backend, as the profile is merged without following
+     *  any file references.
+     */
+    void evaluate_profile()
+    {
+        options.update_map();
+        ParseClientConfig cc(options);
+
+        valid = !cc.error();
+        eval_message = cc.message();
+        eval_autologin = cc.autologin();
+        eval_external_pki = cc.externalPki();
+        eval_static_challenge = cc.staticChallenge();
+        eval_static_challenge_echo = cc.staticChallengeEcho();
+
+        eval_remotes.clear();
+        const OptionList::IndexList *remotes = options.get_index_ptr("remote");
+        if (remotes)
+        {
+            for (const auto& idx : *remotes)
+            {
+                const Option& o = options[idx];
+                std::string remote = o.get(1, 256);
+                for (size_t i = 2; i < o.size(); i++)
+                {
+                    remote += " " + o.get(i, 16);
+                }
+                eval_remotes.push_back(remote);
+            }
+        }
+
+        if (!valid)
+        {
+            return;
+        }
+
+        for (const auto& optname : {"ca", "cert", "key", "dh", "pkcs12"})
+        {
+            const Option *o = options.get_ptr(optname);
+            if (o && is_file_reference(*o))
+            {
+                valid = false;
+                eval_message = "--" + std::string(optname)
+                               + " refers to a file which is not embedded";
+                return;
+            }
+        }
+    }
+
+
+    /**
+     *  Checks if the value of an option is a reference to a file, instead
+     *  of the file content being embedded in the profile.  Values such as
+     *  'dh none' are not file references.
+     *
+     * @param o  Option to check
+     *
+     * @return Returns true if the option value is a file name
+     */
+    static bool is_file_reference(const Option& o)
+    {
+        if (o.size() < 2)
+        {
+            return false;
+        }
+        const std::string& value = o.ref(1);
+        return std::string::npos == value.find('\n')
+               && "none" != value
+               && "[inline]" != value;
+    }
+
+
     std::function<void()> remove_callback;
     std::string name;
     std::time_t import_tstamp;
@@ -1073,6 +1249,12 @@ private:
     PropertyCollection properties;
     OptionListJSON options;
     std::vector<OverrideValue> override_list;
+    std::string eval_message;
+    bool eval_autologin;
+    bool eval_external_pki;
+    std::string eval_static_challenge;
+    bool eval_static_challenge_echo;
+    std::vector<std::string> eval_remotes;
 };
 
 
@@ -1131,10 +1313,12 @@ public:
                           << "          <arg type='ao' name='paths' direction='out'/>"
                           << "        </method>"
                           << "        <property type='s' name='version' access='read'/>"
+                          << "        <property type='b' name='idle' access='read'/>"
                           << GetLogIntrospection()
                           << "    </interface>"
                           << "</node>";
         ParseIntrospectionXML(introspection_xml);
+        EnableDebugInterface();
 
         Debug("ConfigManagerObject registered on '" + OpenVPN3DBus_interf_configuration + "':" + objpath);
     }
@@ -1146,6 +1330,43 @@ public:
     }
 
 
+    /**
+     *  Watches a directory for configuration profiles.  All .ovpn and
+     *  .json profiles in the directory are imported.  Profiles added or
+     *  modified later on are imported or updated in place, and the
+     *  configuration objects are removed when the files are removed.
+     *
+     *  The owner of the configuration object is the owner of the file.
+     *  Only regular files are imported, see read_profile_file() for
+     *  how file references in the profiles are handled.
+     *
+     * @param dir  std::string with the directory to watch
+     */
+    void WatchDirectory(const std::string& dir)
+    {
+        if (!watcher)
+        {
+            // Reading and parsing the profiles is done in the strand
+            // of this object, not in the main loop
+            watcher.reset(new ProfileDirWatcher(
+                              [this](const std::string& fname)
+                              {
+                                  RunInStrand([this, fname]()
+                                              {
+                                                  profile_file_changed(fname);
+                                              });
+                              },
+                              std::chrono::milliseconds(500)));
+
+            // Don't stop the service when idling, as new profiles
+            // may appear at any time
+            IdleCheck_RefInc();
+        }
+        watcher->AddDirectory(dir);
+        LogInfo("Watching '" + dir + "' for configuration profiles");
+    }
+
+
     /**
      *  Callback method called each time a method in the
      *  ConfigurationManagerObject is called over the D-Bus.
@@ -1172,33 +1393,22 @@ public:
         if ("Import" == method_name)
         {
             // Import the configuration
-            std::string cfgpath = generate_path_uuid(OpenVPN3DBus_rootp_configuration, 'x');
-
-            auto *cfgobj = new ConfigurationObject(dbuscon,
-                                                   [self=Ptr(this), cfgpath]()
-                                                   {
-                                                       self->remove_config_object(cfgpath);
-                                                   },
-                                                   cfgpath,
-                                                   GetLogLevel(),
-                                                   GetLogWriterPtr(),
-                                                   GetSignalBroadcast(),
-                                                   creds.GetUID(sender),
-                                                   params);
-            IdleCheck_RefInc();
-            cfgobj->IdleCheck_Register(IdleCheck_Get());
-            cfgobj->RegisterObject(conn);
-            config_objects[cfgpath] = cfgobj;
-
-            Debug(std::string("ConfigurationObject registered on '")
-                         + intf_name + "': " + cfgpath
-                         + " (owner uid " + std::to_string(creds.GetUID(sender)) + ")");
+            TraceTimer trace;
+            std::string cfgpath = create_config_object(creds.GetUID(sender),
+                                                       params);
+#ifdef ENABLE_USDT
+            const gchar *name = nullptr;
+            g_variant_get_child(params, 0, "&s", &name);
+            OPENVPN3_TRACE3(config_import, cfgpath.c_str(), name,
+                            trace.Elapsed());
+#endif
             g_dbus_method_invocation_return_value(invoc, g_variant_new("(o)", cfgpath.c_str()));
         }
         else if ("FetchAvailableConfigs" == method_name)
         {
             // Build up an array of object paths to available config objects
             GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("ao"));
+            std::lock_guard<std::recursive_mutex> guard(config_objects_mtx);
             for (auto& item : config_objects)
             {
                 try {
@@ -1261,6 +1471,10 @@ public:
         {
             ret = g_variant_new_string(package_version);
         }
+        else if ("idle" == property_name)
+        {
+            ret = g_variant_new_boolean(IdleCheck_IsIdle());
+        }
         else
         {
             g_set_error (error,
@@ -1303,9 +1517,232 @@ public:
 
 
 private:
+    /**
+     *  Configuration profile imported from a watched directory
+     */
+    struct WatchedProfile
+    {
+        std::string cfgpath;
+        std::string profile;
+    };
+
     GDBusConnection *dbuscon;
     DBusConnectionCreds creds;
+
+    /**
+     *  Protects config_objects, which is also modified by the
+     *  configuration objects when they are removed.  It is recursive,
+     *  as removing an object calls remove_config_object().
+     */
+    std::recursive_mutex config_objects_mtx;
     std::map<std::string, ConfigurationObject *> config_objects;
+    std::unique_ptr<ProfileDirWatcher> watcher;
+    std::map<std::string, WatchedProfile> watched_profiles;
+
+
+    /**
+     *  Creates a new configuration object and registers it on the D-Bus
+     *
+     * @param owner   uid_t of the owner of the new configuration object
+     * @param params  GVariant object with the Import method arguments
+     *
+     * @return Returns the D-Bus object path of the new configuration object
+     */
+    std::string create_config_object(uid_t owner, GVariant *params)
+    {
+        std::string cfgpath = generate_path_uuid(OpenVPN3DBus_rootp_configuration, 'x');
+
+        auto *cfgobj = new ConfigurationObject(dbuscon,
+                                               [self=Ptr(this), cfgpath]()
+                                               {
+                                                   self->remove_config_object(cfgpath);
+                                               },
+                                               cfgpath,
+                                               GetLogLevel(),
+                                               GetLogWriterPtr(),
+                                               GetSignalBroadcast(),
+                                               owner,
+                                               params);
+        IdleCheck_RefInc();
+        cfgobj->IdleCheck_Register(IdleCheck_Get());
+        cfgobj->SetExecutor(GetExecutor());
+
+        std::lock_guard<std::recursive_mutex> guard(config_objects_mtx);
+        cfgobj->RegisterObject(dbuscon);
+        config_objects[cfgpath] = cfgobj;
+
+        Debug(std::string("ConfigurationObject registered on '")
+              + OpenVPN3DBus_interf_configuration + "': " + cfgpath
+              + " (owner uid " + std::to_string(owner) + ")");
+        return cfgpath;
+    }
+
+
+    /**
+     *  Reads a configuration profile file from a watched directory.
+     *  Files in the .json format are converted to the .ovpn format.
+     *
+     *  Symbolic links and anything else not being a regular file are
+     *  rejected.  As the configuration manager runs with more privileges
+     *  than the file owners, file references in .ovpn files are only
+     *  embedded if both the file and the directory are owned by root and
+     *  the directory is not writable by others.  Otherwise the file
+     *  references are kept as-is, which makes the profile invalid.
+     *
+     * @param fname  std::string with the file name of the profile
+     * @param owner  uid_t which will contain the owner of the file
+     *
+     * @return Returns the configuration profile as a string
+     */
+    std::string read_profile_file(const std::string& fname, uid_t& owner)
+    {
+        // O_NONBLOCK avoids hanging on a FIFO before it is rejected below
+        int fd = open(fname.c_str(),
+                      O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                "Could not open the file: "
+                                + std::string(strerror(errno)));
+        }
+
+        struct stat st;
+        if (0 != fstat(fd, &st) || !S_ISREG(st.st_mode))
+        {
+            close(fd);
+            THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                "Not a regular file");
+        }
+        if ((size_t) st.st_size > ProfileParseLimits::MAX_PROFILE_SIZE)
+        {
+            close(fd);
+            THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                "The file is too large");
+        }
+
+        std::string content;
+        char buf[4096];
+        ssize_t len = 0;
+        while ((len = read(fd, buf, sizeof(buf))) > 0
+               && content.size() <= ProfileParseLimits::MAX_PROFILE_SIZE)
+        {
+            content.append(buf, len);
+        }
+        close(fd);
+        if (len < 0)
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject",
+                                "Could not read the file: "
+                                + std::string(strerror(errno)));
+        }
+        owner = st.st_uid;
+
+        if (ProfileDirWatcher::HasExtension(fname, ".json"))
+        {
+            ProfileMergeJSON pm(content);
+            return pm.profile_content();
+        }
+
+        std::string dir = fname.substr(0, fname.rfind('/'));
+        struct stat dirst;
+        bool trusted = (0 == st.st_uid
+                        && 0 == stat(dir.c_str(), &dirst)
+                        && 0 == dirst.st_uid
+                        && 0 == (dirst.st_mode & (S_IWGRP | S_IWOTH)));
+
+        ProfileMergeFromString pm(content, dir,
+                                  (trusted ? ProfileMerge::FOLLOW_FULL
+                                           : ProfileMerge::FOLLOW_NONE),
+                                  ProfileParseLimits::MAX_LINE_SIZE,
+                                  ProfileParseLimits::MAX_PROFILE_SIZE);
+        if (ProfileMerge::MERGE_SUCCESS != pm.status())
+        {
+            THROW_DBUSEXCEPTION("ConfigManagerObject", pm.error());
+        }
+        return pm.profile_content();
+    }
+
+
+    /**
+     *  Called by the ProfileDirWatcher when a file in a watched
+     *  directory has been added, modified or removed.
+     *
+     * @param fname  std::string with the file name of the profile
+     */
+    void profile_file_changed(const std::string& fname)
+    {
+        // Holding the lock ensures the configuration object is not
+        // removed via D-Bus before the work below is queued in its strand
+        std::lock_guard<std::recursive_mutex> guard(config_objects_mtx);
+
+        // Find the configuration object this file was imported into,
+        // unless it has been removed via D-Bus in the mean time
+        auto wp = watched_profiles.find(fname);
+        if (watched_profiles.end() != wp
+            && config_objects.end() == config_objects.find(wp->second.cfgpath))
+        {
+            watched_profiles.erase(wp);
+            wp = watched_profiles.end();
+        }
+
+        struct stat st;
+        if (0 != lstat(fname.c_str(), &st) || !S_ISREG(st.st_mode))
+        {
+            if (watched_profiles.end() != wp)
+            {
+                ConfigurationObject *cfgobj = config_objects[wp->second.cfgpath];
+                LogInfo("Configuration profile '" + fname + "' removed");
+                watched_profiles.erase(wp);
+                cfgobj->RemoveAndDelete(dbuscon);
+            }
+            return;
+        }
+
+        try
+        {
+            uid_t owner = -1;
+            std::string profile = read_profile_file(fname, owner);
+
+            if (watched_profiles.end() != wp)
+            {
+                if (wp->second.profile != profile)
+                {
+                    ConfigurationObject *cfgobj = config_objects[wp->second.cfgpath];
+                    cfgobj->RunInStrand([cfgobj, fname, profile]()
+                        {
+                            try
+                            {
+                                cfgobj->UpdateProfile(profile);
+                            }
+                            catch (std::exception& excp)
+                            {
+                                cfgobj->LogError("Could not update configuration profile '"
+                                                 + fname + "': " + excp.what());
+                            }
+                        });
+                    wp->second.profile = profile;
+                }
+                return;
+            }
+
+            std::string cfgname = simple_basename(fname);
+            cfgname = cfgname.substr(0, cfgname.rfind('.'));
+            GVariant *params = g_variant_ref_sink(g_variant_new("(ssbb)",
+                                                                cfgname.c_str(),
+                                                                profile.c_str(),
+                                                                false, true));
+            std::string cfgpath = create_config_object(owner, params);
+            g_variant_unref(params);
+
+            watched_profiles[fname] = {cfgpath, profile};
+        }
+        catch (std::exception& excp)
+        {
+            LogError("Could not import configuration profile '" + fname
+                     + "': " + excp.what());
+        }
+    }
+
 
     /**
      * Callback function used by ConfigurationObject instances to remove
@@ -1317,6 +1754,7 @@ private:
      */
     void remove_config_object(const std::string cfgpath)
     {
+        std::lock_guard<std::recursive_mutex> guard(config_objects_mtx);
         config_objects.erase(cfgpath);
     }
 };
@@ -1349,6 +1787,7 @@ public:
                OpenVPN3DBus_interf_configuration),
           logwr(logwr),
           signal_broadcast(signal_broadcast),
+          worker_threads(0),
           cfgmgr(nullptr),
           procsig(nullptr)
     {
@@ -1356,6 +1795,12 @@ public:
 
     ~ConfigManagerDBus()
     {
+        // Complete the D-Bus calls still running before the
+        // objects they use are destroyed
+        if (executor)
+        {
+            executor->Shutdown();
+        }
         procsig->ProcessChange(StatusMinor::PROC_STOPPED);
         delete procsig;
     }
@@ -1374,6 +1819,32 @@ public:
     }
 
 
+    /**
+     *  Runs the D-Bus method calls on a pool of worker threads instead
+     *  of the main loop.  Calls to the same object are still handled
+     *  one at a time, in order.
+     *
+     * @param threads  Number of worker threads; 0 runs everything in
+     *                 the main loop
+     */
+    void SetWorkerThreads(unsigned int threads)
+    {
+        worker_threads = threads;
+    }
+
+
+    /**
+     *  Adds a directory the configuration manager will watch for
+     *  configuration profiles once the service is registered on the D-Bus.
+     *
+     * @param dir  std::string with the directory to watch
+     */
+    void AddWatchDirectory(const std::string& dir)
+    {
+        watch_dirs.push_back(dir);
+    }
+
+
     /**
      *  This callback is called when the service was successfully registered
      *  on the D-Bus.
@@ -1383,6 +1854,17 @@ public:
         cfgmgr.reset(new ConfigManagerObject(GetConnection(), GetRootPath(),
                                              default_log_level, logwr,
                                              signal_broadcast));
+        if (worker_threads > 0)
+        {
+            // The executor is shut down before cfgmgr is destroyed
+            ConfigManagerObject *mgr = cfgmgr.get();
+            executor.reset(new DBusExecutor(worker_threads,
+                                            [mgr](const std::string& msg)
+                                            {
+                                                mgr->LogCritical(msg);
+                                            }));
+            cfgmgr->SetExecutor(executor);
+        }
         cfgmgr->RegisterObject(GetConnection());
 
         procsig = new ProcessSignalProducer(GetConnection(),
@@ -1393,6 +1875,12 @@ public:
         if (nullptr != idle_checker)
         {
             cfgmgr->IdleCheck_Register(idle_checker);
+            cfgmgr->IdleCheck_EnableIdleProperty();
+        }
+
+        for (const auto& dir : watch_dirs)
+        {
+            cfgmgr->WatchDirectory(dir);
         }
     };
 
@@ -1431,8 +1919,11 @@ private:
     unsigned int default_log_level = 6; // LogCategory::DEBUG
     LogWriter *logwr = nullptr;
     bool signal_broadcast = true;
+    unsigned int worker_threads;
+    DBusExecutor::Ptr executor;
     ConfigManagerObject::Ptr cfgmgr;
     ProcessSignalProducer * procsig;
+    std::vector<std::string> watch_dirs;
 };
 
 #endif // OPENVPN3_DBUS_CONFIGMGR_HPP
@@ -97,12 +97,24 @@ static int config_manager(ParsedArgs args)
     }
     cfgmgr.SetLogLevel(log_level);
 
+    if (args.Present("worker-threads"))
+    {
+        cfgmgr.SetWorkerThreads(std::atoi(args.GetValue("worker-threads", 0).c_str()));
+    }
+
+    if (args.Present("watch-dir"))
+    {
+        for (const auto& dir : args.GetAllValues("watch-dir"))
+        {
+            cfgmgr.AddWatchDirectory(dir);
+        }
+    }
+
     IdleCheck::Ptr idle_exit;
     if (idle_wait_min > 0)
     {
         idle_exit.reset(new IdleCheck(main_loop,
                                       std::chrono::minutes(idle_wait_min)));
-        idle_exit->SetPollTime(std::chrono::seconds(30));
         cfgmgr.EnableIdleCheck(idle_exit);
     }
     cfgmgr.Setup();
@@ -122,7 +134,6 @@ static int config_manager(ParsedArgs args)
     if (idle_wait_min > 0)
     {
         idle_exit->Disable();
-        idle_exit->Join();
     }
 
     return 0;
@@ -145,6 +156,13 @@ int main(int argc, char **argv)
     argparser.AddOption("idle-exit", "MINUTES", true,
                         "How long to wait before exiting if being idle. "
                         "0 disables it (Default: 3 minutes)");
+    argparser.AddOption("watch-dir", "DIRECTORY", true,
+                        "Import configuration profiles from DIRECTORY and "
+                        "keep them updated when the files change.  "
+                        "Can be used multiple times.");
+    argparser.AddOption("worker-threads", "NUM", true,
+                        "Handle D-Bus method calls in NUM worker threads.  "
+                        "0 handles them in the main thread (Default: 0)");
 
 
     try
@@ -21,10 +21,27 @@
  * @file   overrides.hpp
  *
  * @brief  Code needed to handle configuration overrides
+ *
+ *         All valid overrides are defined in the configProfileOverrides[]
+ *         registry.  Each entry binds the override name to its data type,
+ *         the ClientAPI::Config member it modifies and the valid values
+ *         the front-ends may suggest.  The configuration manager, the
+ *         VPN client backend and the openvpn3 command line tool all use
+ *         this registry, so adding a new override only requires a new
+ *         OverrideID and a new line in configProfileOverrides[].
  */
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include <client/ovpncli.hpp>
+
 enum class OverrideType
 {
     string,
@@ -32,18 +49,71 @@ enum class OverrideType
     invalid
 };
 
+
+/**
+ *  Identifies each valid override.  Each ID must be used by exactly one
+ *  entry in the configProfileOverrides[] registry.
+ */
+enum class OverrideID : unsigned int
+{
+    server_override,
+    port_override,
+    proto_override,
+    ipv6,
+    dns_fallback_google,
+    dns_sync_lookup,
+    auth_fail_retry,
+    no_client_cert,
+    allow_compression,
+    force_cipher_aes_cbc,
+    tls_version_min,
+    tls_cert_profile,
+    proxy_auth_cleartext,
+    invalid   // Must be the last element; used to count valid overrides
+};
+
+
 /**
  * Helper classes to store the list of overrides
  */
 struct ValidOverride {
-    ValidOverride(std::string key, OverrideType type, std::string help)
-        : key(key), type(type), help(help)
+    /**
+     *  Declares a string based override
+     *
+     * @param id               OverrideID of this override
+     * @param key              Override name, as used on the D-Bus
+     * @param member           ClientAPI::Config member this override sets
+     * @param help             Help text used by front-ends
+     * @param argument_helper  Optional function returning a space separated
+     *                         list of valid values
+     */
+    ValidOverride(OverrideID id, std::string key,
+                  std::string openvpn::ClientAPI::Config::*member,
+                  std::string help,
+                  std::string (*argument_helper)() = nullptr)
+        : id(id), key(key), type(OverrideType::string), help(help),
+          argument_helper(argument_helper), str_member(member)
+    {
+    }
+
+    /**
+     *  Declares a boolean override
+     *
+     * @param id               OverrideID of this override
+     * @param key              Override name, as used on the D-Bus
+     * @param member           ClientAPI::Config member this override sets
+     * @param help             Help text used by front-ends
+     */
+    ValidOverride(OverrideID id, std::string key,
+                  bool openvpn::ClientAPI::Config::*member,
+                  std::string help)
+        : id(id), key(key), type(OverrideType::boolean), help(help),
+          bool_member(member)
     {
     }
 
-    ValidOverride(std::string key, OverrideType type,
-                  std::string help, std::string (*argument_helper)())
-        : key(key), type(type), help(help), argument_helper(argument_helper)
+    ValidOverride(std::string key, OverrideType type, std::string help)
+        : id(OverrideID::invalid), key(key), type(type), help(help)
     {
     }
 
@@ -54,10 +124,46 @@ struct ValidOverride {
     }
 
 
+    /**
+     *  Checks if a string value is acceptable for this override.  If the
+     *  override provides an argument helper, the value must be one of
+     *  the values it lists.  Otherwise any non-empty string is accepted.
+     *
+     * @param value  std::string with the value to check
+     *
+     * @return Returns true if the value can be used with this override
+     */
+    bool ValidValue(const std::string& value) const
+    {
+        if (OverrideType::string != type || value.empty())
+        {
+            return false;
+        }
+        if (!argument_helper)
+        {
+            return true;
+        }
+
+        std::istringstream valid_values(argument_helper());
+        std::string v;
+        while (valid_values >> v)
+        {
+            if (v == value)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+
+    OverrideID id;
     std::string key;
     OverrideType type;
     std::string help;
     std::string (*argument_helper)()=nullptr;
+    std::string openvpn::ClientAPI::Config::*str_member = nullptr;
+    bool openvpn::ClientAPI::Config::*bool_member = nullptr;
 };
 
 
@@ -74,81 +180,156 @@ struct OverrideValue {
     }
 
 
+    /**
+     *  Applies this override value to a VPN client configuration
+     *
+     * @param cfg  ClientAPI::Config object to modify
+     */
+    void Apply(openvpn::ClientAPI::Config& cfg) const
+    {
+        switch (override.type)
+        {
+        case OverrideType::string:
+            cfg.*(override.str_member) = strValue;
+            break;
+        case OverrideType::boolean:
+            cfg.*(override.bool_member) = boolValue;
+            break;
+        default:
+            break;
+        }
+    }
+
+
     ValidOverride override;
-    bool boolValue;
+    bool boolValue = false;
     std::string strValue;
 };
 
 
+using ClientConfig = openvpn::ClientAPI::Config;
+
 const ValidOverride configProfileOverrides[] = {
-    {"server-override", OverrideType::string,
+    {OverrideID::server_override, "server-override", &ClientConfig::serverOverride,
      "Replace the remote, connecting to this server instead the server specified in the configuration"},
 
-    {"port-override", OverrideType::string,
+    {OverrideID::port_override, "port-override", &ClientConfig::portOverride,
      "Replace the remote port, connecting to this port instead of the configuration value"},
 
-    {"proto-override", OverrideType::string,
+    {OverrideID::proto_override, "proto-override", &ClientConfig::protoOverride,
      "Overrides the protocol being used",
      [] {return std::string("tcp udp");}},
 
-    {"ipv6", OverrideType::string,
+    {OverrideID::ipv6, "ipv6", &ClientConfig::ipv6,
      "Sets the IPv6 policy of the client",
      [] { return std::string("yes no default");}},
 
-    {"dns-fallback-google", OverrideType::boolean,
+    {OverrideID::dns_fallback_google, "dns-fallback-google", &ClientConfig::googleDnsFallback,
      "Uses Google DNS servers (8.8.8.8/8.8.4.4) if no DNS server are provided"},
 
-    {"dns-sync-lookup", OverrideType::boolean,
+    {OverrideID::dns_sync_lookup, "dns-sync-lookup", &ClientConfig::synchronousDnsLookup,
      "Use synchronous DNS Lookups"},
 
-    {"auth-fail-retry", OverrideType::boolean,
+    {OverrideID::auth_fail_retry, "auth-fail-retry", &ClientConfig::retryOnAuthFailed,
      "Should failed authentication be considered a temporary error"},
 
-    {"no-client-cert", OverrideType::boolean,
+    {OverrideID::no_client_cert, "no-client-cert", &ClientConfig::disableClientCert,
      "Disables using cient certificates"},
 
-    {"allow-compression", OverrideType::string,
+    {OverrideID::allow_compression, "allow-compression", &ClientConfig::compressionMode,
      "Set compression mode",
      [] {return std::string("no asym yes");}},
 
-    {"force-cipher-aes-cbc", OverrideType::boolean,
+    {OverrideID::force_cipher_aes_cbc, "force-cipher-aes-cbc", &ClientConfig::forceAesCbcCiphersuites,
      "Forces AES-CBC ciphersuites for control channel and disables AES-GCM data channel support"},
 
-    {"tls-version-min", OverrideType::string,
+    {OverrideID::tls_version_min, "tls-version-min", &ClientConfig::tlsVersionMinOverride,
      "Sets the minimal TLS version for the control channel",
      [] {return std::string("tls_1_0 tls_1_1 tls_1_2 tls_1_3");}},
 
-    {"tls-cert-profile", OverrideType::string,
+    {OverrideID::tls_cert_profile, "tls-cert-profile", &ClientConfig::tlsCertProfileOverride,
      "Sets the control channel tls profile",
      [] {return std::string("insecure legacy preferred suiteb");}},
 
-    {"proxy-auth-cleartext", OverrideType::boolean,
+    {OverrideID::proxy_auth_cleartext, "proxy-auth-cleartext", &ClientConfig::proxyAllowCleartextAuth,
      "Allows clear text HTTP authentication"}
 };
 
+static_assert(sizeof(configProfileOverrides) / sizeof(ValidOverride)
+              == static_cast<unsigned int>(OverrideID::invalid),
+              "configProfileOverrides[] does not match OverrideID");
+
 
 const ValidOverride invalidOverride(std::string("invalid"),
                                     OverrideType::invalid, "Invalid override");
 
 
-const ValidOverride & GetConfigOverride(const std::string & key, bool ignoreCase=false)
+/**
+ *  Retrieve an override definition by its OverrideID.  The entries are
+ *  looked up by their id, so the order of configProfileOverrides[] does
+ *  not matter.
+ *
+ * @param id  OverrideID of the override to look up
+ *
+ * @return Returns a reference to the ValidOverride.  If the ID is not
+ *         valid, invalidOverride is returned.
+ */
+const ValidOverride & GetConfigOverride(const OverrideID id)
 {
-    for (const auto& vo: configProfileOverrides)
-    {
-        if (vo.key==key)
+    typedef std::array<const ValidOverride *,
+                       static_cast<unsigned int>(OverrideID::invalid)> IDIndex;
+    static const IDIndex index = [] {
+        IDIndex idx{};
+        for (const auto& vo : configProfileOverrides)
         {
-           return vo;
+            idx[static_cast<unsigned int>(vo.id)] = &vo;
         }
+        return idx;
+    }();
 
-        // This is appearently the best way to do a case insenstive
-        // comparision in C++
-        if (ignoreCase && std::equal(vo.key.begin(), vo.key.end(), key.begin(),
-            [](char a, char b) { return std::tolower(a) == std::tolower(b);} ))
+    if (id >= OverrideID::invalid)
+    {
+        return invalidOverride;
+    }
+    const ValidOverride *vo = index[static_cast<unsigned int>(id)];
+    return (vo ? *vo : invalidOverride);
+}
+
+
+/**
+ *  Retrieve an override definition by its name.  The name index is
+ *  built once on the first lookup, each lookup is a single hash lookup.
+ *
+ * @param key         std::string of the override name
+ * @param ignoreCase  If true, the name is matched case insensitive
+ *
+ * @return Returns a reference to the ValidOverride.  If the name is not
+ *         found, invalidOverride is returned.
+ */
+const ValidOverride & GetConfigOverride(const std::string & key, bool ignoreCase=false)
+{
+    static const std::unordered_map<std::string, OverrideID> index = [] {
+        std::unordered_map<std::string, OverrideID> idx;
+        for (const auto& vo : configProfileOverrides)
         {
-            return vo;
+            idx[vo.key] = vo.id;
         }
+        return idx;
+    }();
+
+    std::string lookup(key);
+    if (ignoreCase)
+    {
+        // All override names are declared in lower case
+        std::transform(lookup.begin(), lookup.end(), lookup.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
     }
 
-    // Override not found
-    return invalidOverride;
+    auto it = index.find(lookup);
+    if (index.end() == it)
+    {
+        // Override not found
+        return invalidOverride;
+    }
+    return GetConfigOverride(it->second);
 }
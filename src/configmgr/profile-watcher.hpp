@@ -0,0 +1,304 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   profile-watcher.hpp
+ *
+ * @brief  Watches directories for configuration profile changes
+ *
+ *         Uses inotify to detect configuration profiles (.ovpn and .json
+ *         files) being added, modified or removed.  Changes are collected
+ *         and reported once no more changes have been seen for the
+ *         debounce period, so a burst of writes to the same file is only
+ *         reported once.  If the inotify event queue overflows, all
+ *         the watched directories are scanned again.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <cerrno>
+#include <cstring>
+
+#include <dirent.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib-unix.h>
+
+#include "dbus/exceptions.hpp"
+
+
+class ProfileDirWatcher
+{
+public:
+    /**
+     *  Callback called for each changed profile file.  The file may have
+     *  been removed, so it needs to be checked by the callback.
+     */
+    typedef std::function<void(const std::string& filename)> Callback;
+
+
+    /**
+     *  Prepares a new inotify based directory watcher
+     *
+     * @param changed   Callback to call for each changed profile file
+     * @param debounce  How long to wait after the last change before
+     *                  reporting the changes
+     */
+    ProfileDirWatcher(Callback changed, std::chrono::milliseconds debounce)
+        : changed(changed),
+          debounce(debounce),
+          inotify_fd(-1),
+          inotify_source(0),
+          debounce_source(0)
+    {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0)
+        {
+            THROW_DBUSEXCEPTION("ProfileDirWatcher",
+                                "Could not initialize inotify: "
+                                + std::string(strerror(errno)));
+        }
+        inotify_source = g_unix_fd_add(inotify_fd, G_IO_IN,
+                                       inotify_callback, this);
+    }
+
+
+    ~ProfileDirWatcher()
+    {
+        if (debounce_source > 0)
+        {
+            g_source_remove(debounce_source);
+        }
+        if (inotify_source > 0)
+        {
+            g_source_remove(inotify_source);
+        }
+        if (inotify_fd >= 0)
+        {
+            close(inotify_fd);
+        }
+    }
+
+
+    /**
+     *  Starts watching a directory.  All the profiles already present in
+     *  the directory are reported as changed.
+     *
+     * @param dir  std::string with the directory to watch
+     */
+    void AddDirectory(const std::string& dir)
+    {
+        int wd = inotify_add_watch(inotify_fd, dir.c_str(),
+                                   IN_CLOSE_WRITE | IN_MOVED_TO
+                                   | IN_MOVED_FROM | IN_DELETE
+                                   | IN_DELETE_SELF);
+        if (wd < 0)
+        {
+            THROW_DBUSEXCEPTION("ProfileDirWatcher",
+                                "Could not watch '" + dir + "': "
+                                + std::string(strerror(errno)));
+        }
+        directories[wd] = dir;
+        scan_directory(dir);
+    }
+
+
+    /**
+     *  Checks if a file name has a file extension of a supported
+     *  configuration profile format
+     *
+     * @param filename  std::string with the file name to check
+     * @param ext       std::string with the file extension to look for
+     *
+     * @return Returns true if the file name ends with the extension
+     */
+    static bool HasExtension(const std::string& filename,
+                             const std::string& ext)
+    {
+        return filename.size() > ext.size()
+               && 0 == filename.compare(filename.size() - ext.size(),
+                                        ext.size(), ext);
+    }
+
+
+private:
+    Callback changed;
+    std::chrono::milliseconds debounce;
+    int inotify_fd;
+    guint inotify_source;
+    guint debounce_source;
+    std::map<int, std::string> directories;
+    std::set<std::string> pending;
+    std::set<std::string> reported;
+
+
+    /**
+     *  Queues all the profiles found in a directory as changed
+     *
+     * @param dir  std::string with the directory to scan
+     */
+    void scan_directory(const std::string& dir)
+    {
+        DIR *dirp = opendir(dir.c_str());
+        if (!dirp)
+        {
+            return;
+        }
+        struct dirent *entry = nullptr;
+        while ((entry = readdir(dirp)))
+        {
+            queue_change(dir, entry->d_name);
+        }
+        closedir(dirp);
+    }
+
+
+    /**
+     *  Called when inotify events have been lost.  All the watched
+     *  directories are scanned again, and all the files reported
+     *  earlier are reported again, so removed files are noticed too.
+     */
+    void rescan()
+    {
+        for (const auto& dir : directories)
+        {
+            scan_directory(dir.second);
+        }
+        for (const auto& f : reported)
+        {
+            pending.insert(f);
+        }
+        if (!pending.empty())
+        {
+            restart_debounce();
+        }
+    }
+
+
+    /**
+     *  Adds a file to the list of changed files and (re)starts the
+     *  debounce timer.  Files not being configuration profiles are ignored.
+     *
+     * @param dir    std::string with the directory of the file
+     * @param fname  std::string with the file name within the directory
+     */
+    void queue_change(const std::string& dir, const std::string& fname)
+    {
+        if (!HasExtension(fname, ".ovpn") && !HasExtension(fname, ".json"))
+        {
+            return;
+        }
+        pending.insert(dir + "/" + fname);
+        restart_debounce();
+    }
+
+
+    void restart_debounce()
+    {
+        if (debounce_source > 0)
+        {
+            g_source_remove(debounce_source);
+        }
+        debounce_source = g_timeout_add(debounce.count(),
+                                        debounce_callback, this);
+    }
+
+
+    void process_inotify()
+    {
+        alignas(struct inotify_event) char buf[4096];
+        ssize_t len = 0;
+        while ((len = read(inotify_fd, buf, sizeof(buf))) > 0)
+        {
+            for (char *ptr = buf; ptr < buf + len;
+                 ptr += sizeof(struct inotify_event) + ((struct inotify_event *) ptr)->len)
+            {
+                const struct inotify_event *ev = (struct inotify_event *) ptr;
+                if (ev->mask & IN_Q_OVERFLOW)
+                {
+                    rescan();
+                    continue;
+                }
+                auto dir = directories.find(ev->wd);
+                if (directories.end() == dir)
+                {
+                    continue;
+                }
+                if (ev->mask & (IN_DELETE_SELF | IN_IGNORED))
+                {
+                    directories.erase(dir);
+                    continue;
+                }
+                if (ev->len > 0)
+                {
+                    queue_change(dir->second, ev->name);
+                }
+            }
+        }
+    }
+
+
+    void process_pending()
+    {
+        debounce_source = 0;
+        std::set<std::string> files;
+        files.swap(pending);
+        for (const auto& f : files)
+        {
+            changed(f);
+
+            // Keep track of the files still present, for rescan()
+            struct stat st;
+            if (0 == lstat(f.c_str(), &st))
+            {
+                reported.insert(f);
+            }
+            else
+            {
+                reported.erase(f);
+            }
+        }
+    }
+
+
+    static gboolean inotify_callback(gint fd, GIOCondition cond,
+                                     gpointer this_ptr)
+    {
+        ProfileDirWatcher *obj = (ProfileDirWatcher *) this_ptr;
+        obj->process_inotify();
+        return G_SOURCE_CONTINUE;
+    }
+
+
+    static gboolean debounce_callback(gpointer this_ptr)
+    {
+        ProfileDirWatcher *obj = (ProfileDirWatcher *) this_ptr;
+        obj->process_pending();
+        return G_SOURCE_REMOVE;
+    }
+};
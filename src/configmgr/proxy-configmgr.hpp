@@ -27,6 +27,23 @@
 
 using namespace openvpn;
 
+
+/**
+ *  Results of the configuration profile evaluation, which is done by the
+ *  configuration manager when the profile is imported.
+ */
+struct OpenVPN3ConfigurationEval
+{
+    bool valid = false;
+    std::string message;
+    bool autologin = false;
+    bool external_pki = false;
+    std::string static_challenge;
+    bool static_challenge_echo = false;
+    std::vector<std::string> remotes;
+};
+
+
 class OpenVPN3ConfigurationProxy : public DBusProxy {
 public:
     OpenVPN3ConfigurationProxy(GBusType bus_type, std::string target)
@@ -36,12 +53,7 @@ public:
                     "", true)
     {
         std::string object_path = get_object_path(bus_type, target);
-        proxy = SetupProxy(OpenVPN3DBus_name_configuration,
-                           OpenVPN3DBus_interf_configuration,
-                           object_path);
-        property_proxy = SetupProxy(OpenVPN3DBus_name_configuration,
-                                    "org.freedesktop.DBus.Properties",
-                                    object_path);
+        SetObjectPath(object_path);
 
         // Only try to ensure the configuration manager service is available
         // when accessing the main management object
@@ -58,12 +70,7 @@ public:
                     "", true)
     {
         std::string object_path = get_object_path(GetBusType(), target);
-        proxy = SetupProxy(OpenVPN3DBus_name_configuration,
-                           OpenVPN3DBus_interf_configuration,
-                           object_path);
-        property_proxy = SetupProxy(OpenVPN3DBus_name_configuration,
-                                    "org.freedesktop.DBus.Properties",
-                                    object_path);
+        SetObjectPath(object_path);
         // Only try to ensure the configuration manager service is available
         // when accessing the main management object
         if (OpenVPN3DBus_rootp_configuration == object_path)
@@ -320,6 +327,44 @@ public:
         return GetUIntProperty("owner");
     }
 
+    /**
+     *  Retrieve the results of the configuration profile evaluation done
+     *  by the configuration manager when the profile was imported.
+     *
+     * @return Returns a populated OpenVPN3ConfigurationEval object
+     */
+    OpenVPN3ConfigurationEval GetEvaluation()
+    {
+        OpenVPN3ConfigurationEval ret;
+        ret.valid = GetBoolProperty("valid");
+        ret.message = GetStringProperty("eval_message");
+        ret.autologin = GetBoolProperty("autologin");
+        ret.external_pki = GetBoolProperty("external_pki");
+        ret.static_challenge = GetStringProperty("static_challenge");
+        ret.static_challenge_echo = GetBoolProperty("static_challenge_echo");
+
+        GVariant *res = GetProperty("remotes");
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
+                                "GetProperty(\"remotes\") call failed");
+        }
+        GVariantIter *remotes = NULL;
+        g_variant_get(res, "as", &remotes);
+
+        GVariant *r = NULL;
+        while ((r = g_variant_iter_next_value(remotes)))
+        {
+            gsize len;
+            ret.remotes.push_back(std::string(g_variant_get_string(r, &len)));
+            g_variant_unref(r);
+        }
+        g_variant_unref(res);
+        g_variant_iter_free(remotes);
+        return ret;
+    }
+
+
     /**
      *  Retrieve the list of overrides for this object. The overrides
      *  are key, value pairs
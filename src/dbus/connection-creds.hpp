@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <mutex>
 #include <sys/types.h>
 
 #include "proxy.hpp"
@@ -60,7 +61,6 @@ namespace openvpn
                         "/net/freedesktop/DBus", true)
         {
             SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
-            proxy = SetupProxy();
         }
 
 
@@ -226,6 +226,7 @@ namespace openvpn
             GError *dbuserr = g_dbus_error_new_for_dbus_error(qdom.c_str(), error.c_str());
             g_dbus_method_invocation_return_gerror(invocation, dbuserr);
             g_error_free(dbuserr);
+            DBusCallStats::MarkError();
         }
 
 
@@ -260,6 +261,9 @@ private:
      *  users allowed to get access.  If SetPublicAccess(true) is called,
      *  then the ACL check is skipped and everyone have access.  An owner
      *  will always have access, regardless of the ACL lists contents.
+     *
+     *  The ACL may be checked by other objects, running in other
+     *  D-Bus worker threads, while it is being modified.
      */
     class DBusCredentials : public DBusConnectionCreds
     {
@@ -290,6 +294,39 @@ private:
         }
 
 
+        /**
+         *  Returns this objects owner's UID
+         *
+         * @return uid_t of the owner
+         */
+        uid_t GetOwnerUID() const
+        {
+            return owner;
+        }
+
+
+        /**
+         *  Retrieve the UIDs granted access, the owner UID not included
+         *
+         * @return Returns a std::vector of uid_t values
+         */
+        std::vector<uid_t> GetAccessListUIDs() const
+        {
+            std::lock_guard<std::mutex> guard(acl_mtx);
+            return acl_list;
+        }
+
+
+        /**
+         *  Checks if the public access attribute is set
+         */
+        bool IsPublicAccess() const
+        {
+            std::lock_guard<std::mutex> guard(acl_mtx);
+            return acl_public;
+        }
+
+
         /**
          *  Sets the public access attribute.  If set to true,
          *  the ACL check is effectively disabled - unless a
@@ -300,6 +337,7 @@ private:
          */
         void SetPublicAccess(bool public_access)
         {
+            std::lock_guard<std::mutex> guard(acl_mtx);
             acl_public = public_access;
         }
 
@@ -311,7 +349,7 @@ private:
          */
         GVariant * GetPublicAccess()
         {
-            return g_variant_new_boolean(acl_public);
+            return g_variant_new_boolean(IsPublicAccess());
         }
 
 
@@ -325,7 +363,7 @@ private:
         {
             GVariant *ret = NULL;
             GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("au"));
-            for (auto& e : acl_list)
+            for (auto& e : GetAccessListUIDs())
             {
                 g_variant_builder_add(bld, "u", e);
             }
@@ -343,6 +381,7 @@ private:
          */
         void GrantAccess(uid_t uid)
         {
+            std::lock_guard<std::mutex> guard(acl_mtx);
             for (auto& acl_uid : acl_list)
             {
                 if (acl_uid == uid)
@@ -364,6 +403,7 @@ private:
          */
         void RevokeAccess(uid_t uid)
         {
+            std::lock_guard<std::mutex> guard(acl_mtx);
             for (auto& acl_uid : acl_list)
             {
                 if (acl_uid == uid)
@@ -421,6 +461,7 @@ private:
 
     private:
         uid_t owner;
+        mutable std::mutex acl_mtx;
         bool acl_public;
         std::vector<uid_t> acl_list;
 
@@ -444,7 +485,7 @@ private:
          */
         void check_acl(const std::string sender, bool owner_only, bool allow_root)
         {
-            if (acl_public && !owner_only)
+            if (!owner_only && IsPublicAccess())
             {
                 return;
             }
@@ -469,7 +510,7 @@ private:
                                                );
             }
 
-            for (auto& acl_uid : acl_list)
+            for (auto& acl_uid : GetAccessListUIDs())
             {
                 if (acl_uid == sender_uid)
                 {
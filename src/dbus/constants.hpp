@@ -58,6 +58,7 @@ const std::string OpenVPN3DBus_interf_backends_manager = OpenVPN3DBus_interf_bac
 const std::string OpenVPN3DBus_name_backends_be = "net.openvpn.v3.backends.be";
 const std::string OpenVPN3DBus_rootp_backends_sessions =  OpenVPN3DBus_rootp_backends + "/sessions";
 const std::string OpenVPN3DBus_rootp_backends_manager = OpenVPN3DBus_rootp_backends + "/manager";
+const std::string OpenVPN3DBus_rootp_backends_standby = OpenVPN3DBus_rootp_backends + "/standby";
 
 
 /* Network Configuration Service
@@ -69,6 +70,10 @@ const std::string OpenVPN3DBus_rootp_netcfg = "/net/openvpn/v3/netcfg";
 const std::string OpenVPN3DBus_interf_netcfg = "net.openvpn.v3.netcfg";
 
 
+/* Debug interface, provided by the main object of each service */
+const std::string OpenVPN3DBus_interf_debug = "net.openvpn.v3.debug";
+
+
 /**
  *  Status - major codes
  *  These codes represents a type of master group
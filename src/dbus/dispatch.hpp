@@ -0,0 +1,273 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   dispatch.hpp
+ *
+ * @brief  Lookup tables binding D-Bus method and property names to member
+ *         functions of a DBusObject implementation, together with the
+ *         access level required to call them, read or modify them.
+ *
+ *         Names are interned as GQuarks when the table is built.  A lookup
+ *         is a single g_quark_try_string() call and a hash table lookup on
+ *         the C string provided by GDBus, without creating any std::string
+ *         objects.  The tables are meant to be built once per class, in a
+ *         function local static variable.
+ */
+
+#ifndef OPENVPN3_DBUS_DISPATCH_HPP
+#define OPENVPN3_DBUS_DISPATCH_HPP
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <gio/gio.h>
+
+
+namespace openvpn
+{
+    /**
+     *  Access level required to call a method or read a property.  The
+     *  checks are done via the DBusCredentials methods of the object.
+     */
+    enum class DBusAccess : uint8_t {
+        ANY,        /**< No access check; the handler does its own checks */
+        ACL,        /**< Owner and users granted access, CheckACL() */
+        ACL_ROOT,   /**< As ACL, but root is always granted access */
+        OWNER,      /**< Only the owner, CheckOwnerAccess() */
+        OWNER_ROOT  /**< Only the owner and root */
+    };
+
+
+    /**
+     *  Runs the access check for the given access level.  The class T
+     *  must provide the CheckACL() and CheckOwnerAccess() methods from
+     *  DBusCredentials; a failing check throws DBusCredentialsException.
+     */
+    template <class T>
+    inline void DBusAccessCheck(T *obj, const DBusAccess access,
+                                const gchar *sender)
+    {
+        switch (access)
+        {
+        case DBusAccess::ANY:
+            return;
+        case DBusAccess::ACL:
+            obj->CheckACL(sender);
+            return;
+        case DBusAccess::ACL_ROOT:
+            obj->CheckACL(sender, true);
+            return;
+        case DBusAccess::OWNER:
+            obj->CheckOwnerAccess(sender);
+            return;
+        case DBusAccess::OWNER_ROOT:
+            obj->CheckOwnerAccess(sender, true);
+            return;
+        }
+    }
+
+
+    /**
+     *  Binds D-Bus method names to member functions of T.  A handler
+     *  is responsible for completing the GDBusMethodInvocation.
+     */
+    template <class T>
+    class DBusMethodTable
+    {
+    public:
+        typedef void (T::*Handler)(GDBusConnection *conn,
+                                   const gchar *sender,
+                                   GVariant *params,
+                                   GDBusMethodInvocation *invoc);
+
+        /**
+         *  Adds a method to the table
+         *
+         * @param name     D-Bus method name, must be a static string
+         * @param access   DBusAccess level required to call this method
+         * @param handler  Member function handling the method call
+         *
+         * @return Returns a reference to this table, for chaining
+         */
+        DBusMethodTable& Add(const char *name, const DBusAccess access,
+                             Handler handler)
+        {
+            methods[g_quark_from_static_string(name)] = {access, handler};
+            return *this;
+        }
+
+
+        /**
+         *  Calls the handler of a method, after the access check.
+         *
+         * @return Returns false if the method is not in this table.
+         *         Exceptions from the access check and from the handler
+         *         are passed on to the caller.
+         */
+        bool Dispatch(T *obj, GDBusConnection *conn, const gchar *sender,
+                      const gchar *method_name, GVariant *params,
+                      GDBusMethodInvocation *invoc) const
+        {
+            auto it = methods.find(g_quark_try_string(method_name));
+            if (methods.end() == it)
+            {
+                return false;
+            }
+            DBusAccessCheck(obj, it->second.access, sender);
+            (obj->*(it->second.handler))(conn, sender, params, invoc);
+            return true;
+        }
+
+
+    private:
+        struct Entry
+        {
+            DBusAccess access;
+            Handler handler;
+        };
+
+        std::unordered_map<GQuark, Entry> methods;
+    };
+
+
+    /**
+     *  Binds D-Bus property names to getter and setter member functions
+     *  of T
+     */
+    template <class T>
+    class DBusPropertyTable
+    {
+    public:
+        typedef GVariant * (T::*Getter)(GError **error);
+        typedef GVariantBuilder * (T::*Setter)(const gchar *sender,
+                                               GVariant *value);
+
+        /**
+         *  Adds a property to the table
+         *
+         * @param name     D-Bus property name, must be a static string
+         * @param access   DBusAccess level required to read this property
+         * @param getter   Member function returning the property value.
+         *                 On errors, it returns NULL and sets the GError.
+         *
+         * @return Returns a reference to this table, for chaining
+         */
+        DBusPropertyTable& Add(const char *name, const DBusAccess access,
+                               Getter getter)
+        {
+            properties[g_quark_from_static_string(name)] = {access, getter,
+                                                            access, nullptr};
+            return *this;
+        }
+
+
+        /**
+         *  Adds a property which can be modified to the table
+         *
+         * @param name        D-Bus property name, must be a static string
+         * @param access      DBusAccess level required to read this property
+         * @param getter      Member function returning the property value
+         * @param set_access  DBusAccess level required to modify it
+         * @param setter      Member function storing the new value.  It
+         *                    returns the PropertiesChanged response from
+         *                    build_set_property_response(), or NULL if the
+         *                    property cannot be modified right now.  On
+         *                    errors, it throws DBusException.
+         *
+         * @return Returns a reference to this table, for chaining
+         */
+        DBusPropertyTable& Add(const char *name, const DBusAccess access,
+                               Getter getter, const DBusAccess set_access,
+                               Setter setter)
+        {
+            properties[g_quark_from_static_string(name)] = {access, getter,
+                                                            set_access, setter};
+            return *this;
+        }
+
+
+        /**
+         *  Checks if a property is in this table
+         */
+        bool Exists(const gchar *property_name) const
+        {
+            return properties.end()
+                != properties.find(g_quark_try_string(property_name));
+        }
+
+
+        /**
+         *  Retrieves a property value, after the access check.
+         *
+         * @return Returns the property value.  If the property is not in
+         *         this table, NULL is returned and the error is set.
+         *         Exceptions from the access check are passed on.
+         */
+        GVariant * Get(T *obj, const gchar *sender,
+                       const gchar *property_name, GError **error) const
+        {
+            auto it = properties.find(g_quark_try_string(property_name));
+            if (properties.end() == it)
+            {
+                g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                            "Unknown property");
+                return NULL;
+            }
+            DBusAccessCheck(obj, it->second.access, sender);
+            return (obj->*(it->second.getter))(error);
+        }
+
+
+        /**
+         *  Modifies a property value, after the access check.
+         *
+         * @return Returns the response from the setter.  If the property is
+         *         not in this table or is read-only, NULL is returned.
+         *         Exceptions from the access check and from the setter
+         *         are passed on.
+         */
+        GVariantBuilder * Set(T *obj, const gchar *sender,
+                              const gchar *property_name,
+                              GVariant *value) const
+        {
+            auto it = properties.find(g_quark_try_string(property_name));
+            if (properties.end() == it || nullptr == it->second.setter)
+            {
+                return NULL;
+            }
+            DBusAccessCheck(obj, it->second.set_access, sender);
+            return (obj->*(it->second.setter))(sender, value);
+        }
+
+
+    private:
+        struct Entry
+        {
+            DBusAccess access;
+            Getter getter;
+            DBusAccess set_access;
+            Setter setter;
+        };
+
+        std::unordered_map<GQuark, Entry> properties;
+    };
+};
+
+#endif // OPENVPN3_DBUS_DISPATCH_HPP
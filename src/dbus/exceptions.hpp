@@ -24,6 +24,7 @@
 #include <sstream>
 
 #include "config.h"
+#include "stats.hpp"
 
 namespace openvpn
 {
@@ -87,6 +88,7 @@ namespace openvpn
             GError *dbuserr = g_dbus_error_new_for_dbus_error(qdom.c_str(), errorstr.c_str());
             g_dbus_method_invocation_return_gerror(invocation, dbuserr);
             g_error_free(dbuserr);
+            DBusCallStats::MarkError();
         }
 
 
@@ -0,0 +1,360 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   executor.hpp
+ *
+ * @brief  A pool of worker threads running D-Bus method calls outside
+ *         of the GMainLoop.
+ *
+ *         Tasks are posted to a DBusStrand.  Each DBusObject using the
+ *         executor has its own strand, which runs the tasks of that object
+ *         one at a time, in the order they were posted.  Tasks of different
+ *         strands run in parallel.
+ *
+ *         Only the configuration manager uses this.  The other services
+ *         keep their calls on the GMainLoop, as their objects share state
+ *         with signal callbacks, timers and child process watches bound to
+ *         the main context:
+ *
+ *          - session manager: signal subscriptions, timers and
+ *            asynchronous calls to the backend processes per session
+ *          - log service: the LogWriter and Logger objects are used by the
+ *            Log signal callbacks for every log event; Attach and Detach
+ *            only update the Logger map
+ *          - backend starter: the process pool is refilled from timers and
+ *            bus name watches, and StartClient only spawns a process
+ */
+
+#ifndef OPENVPN3_DBUS_EXECUTOR_HPP
+#define OPENVPN3_DBUS_EXECUTOR_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <openvpn/common/rc.hpp>
+
+using namespace openvpn;
+
+
+typedef std::function<void()> DBusTask;
+typedef std::function<void(const std::string&)> DBusExecutorErrorLog;
+
+class DBusExecutor;
+
+
+/**
+ *  Runs tasks posted to it in order, one at a time, on the worker
+ *  threads of a DBusExecutor
+ */
+class DBusStrand : public std::enable_shared_from_this<DBusStrand>
+{
+public:
+    typedef std::shared_ptr<DBusStrand> Ptr;
+
+    DBusStrand(DBusExecutor *executor)
+        : executor(executor),
+          scheduled(false),
+          closed(false),
+          running_thread()
+    {
+    }
+
+
+    /**
+     *  Queues a task.  Tasks posted after Close() are dropped.
+     */
+    inline void Post(DBusTask task);
+
+
+    /**
+     *  Drops all queued tasks and refuses new ones.  This is used when
+     *  the object owning this strand is destroyed.
+     */
+    void Close()
+    {
+        std::deque<DBusTask> dropped;
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            closed = true;
+            dropped.swap(tasks);
+        }
+        // The tasks are destroyed here, outside the lock, as
+        // destroying them may complete pending D-Bus calls
+    }
+
+
+    /**
+     *  Closes the strand like Close() and waits until the task running
+     *  right now, if any, has completed.  Must not be called from a
+     *  task of this strand.
+     */
+    void Drain()
+    {
+        std::deque<DBusTask> dropped;
+        std::unique_lock<std::mutex> lock(mtx);
+        closed = true;
+        dropped.swap(tasks);
+        idle.wait(lock, [this]()
+                  {
+                      return std::thread::id() == running_thread;
+                  });
+    }
+
+
+    /**
+     *  Checks if the calling thread is the one running a task of
+     *  this strand right now
+     */
+    bool RunningInThisThread()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        return running_thread == std::this_thread::get_id();
+    }
+
+
+private:
+    friend class DBusExecutor;
+
+    DBusExecutor *executor;
+    std::mutex mtx;
+    std::condition_variable idle;
+    std::deque<DBusTask> tasks;
+    bool scheduled;
+    bool closed;
+    std::thread::id running_thread;
+
+
+    /**
+     *  Runs the first queued task, then hands the strand back to the
+     *  executor if more tasks are waiting.  Only one worker runs a
+     *  strand at any time.
+     */
+    inline void run_next();
+};
+
+
+
+class DBusExecutor : public RC<thread_safe_refcount>
+{
+public:
+    typedef RCPtr<DBusExecutor> Ptr;
+
+    /**
+     * @param threads  Number of worker threads to start
+     * @param errlog   DBusExecutorErrorLog reporting exceptions escaping
+     *                 a task, typically to a LogSender.  It is called from
+     *                 the worker threads.
+     */
+    DBusExecutor(unsigned int threads, DBusExecutorErrorLog errlog = nullptr)
+        : errlog(errlog),
+          active(0),
+          stopping(false)
+    {
+        for (unsigned int i = 0; i < std::max(threads, 1u); i++)
+        {
+            workers.emplace_back([this]()
+                                 {
+                                     worker_loop();
+                                 });
+        }
+    }
+
+
+    ~DBusExecutor()
+    {
+        Shutdown();
+    }
+
+
+    /**
+     *  Creates a new strand running its tasks on this executor
+     */
+    DBusStrand::Ptr NewStrand()
+    {
+        return std::make_shared<DBusStrand>(this);
+    }
+
+
+    unsigned int GetThreadCount() const
+    {
+        return workers.size();
+    }
+
+
+    /**
+     *  Completes the queued tasks and stops all worker threads.  Tasks
+     *  posted afterwards are never run.  Must not be called from a
+     *  worker thread.
+     */
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (stopping)
+            {
+                return;
+            }
+            stopping = true;
+        }
+        cond.notify_all();
+        for (auto& w : workers)
+        {
+            if (w.joinable())
+            {
+                w.join();
+            }
+        }
+    }
+
+
+private:
+    friend class DBusStrand;
+
+    DBusExecutorErrorLog errlog;
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::deque<DBusStrand::Ptr> ready;
+    std::vector<std::thread> workers;
+    unsigned int active;
+    bool stopping;
+
+
+    void report_error(const std::string& msg)
+    {
+        if (errlog)
+        {
+            errlog(msg);
+        }
+    }
+
+
+    void schedule(DBusStrand::Ptr strand)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            ready.push_back(strand);
+        }
+        cond.notify_one();
+    }
+
+
+    void worker_loop()
+    {
+        for (;;)
+        {
+            DBusStrand::Ptr strand;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                // When stopping, wait until no other worker can
+                // reschedule a strand before leaving
+                cond.wait(lock, [this]()
+                          {
+                              return !ready.empty() || (stopping && 0 == active);
+                          });
+                if (ready.empty())
+                {
+                    return;
+                }
+                strand = ready.front();
+                ready.pop_front();
+                ++active;
+            }
+            strand->run_next();
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                --active;
+            }
+            cond.notify_all();
+        }
+    }
+};
+
+
+
+inline void DBusStrand::Post(DBusTask task)
+{
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (closed)
+        {
+            return;
+        }
+        tasks.push_back(std::move(task));
+        if (scheduled)
+        {
+            return;
+        }
+        scheduled = true;
+    }
+    executor->schedule(shared_from_this());
+}
+
+
+inline void DBusStrand::run_next()
+{
+    DBusTask task;
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (tasks.empty())
+        {
+            scheduled = false;
+            return;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        running_thread = std::this_thread::get_id();
+    }
+
+    try
+    {
+        task();
+    }
+    catch (std::exception& excp)
+    {
+        executor->report_error("Unhandled exception in D-Bus worker: "
+                               + std::string(excp.what()));
+    }
+    catch (...)
+    {
+        executor->report_error("Unhandled exception in D-Bus worker");
+    }
+
+    bool more = false;
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        running_thread = std::thread::id();
+        more = !tasks.empty();
+        scheduled = more;
+    }
+    idle.notify_all();
+    if (more)
+    {
+        executor->schedule(shared_from_this());
+    }
+}
+
+#endif // OPENVPN3_DBUS_EXECUTOR_HPP
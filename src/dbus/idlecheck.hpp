@@ -20,121 +20,243 @@
 #ifndef OPENVPN3_DBUS_IDLECHECK_HPP
 #define OPENVPN3_DBUS_IDLECHECK_HPP
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
-#include <memory>
-#include <thread>
+#include <mutex>
+
+#include <unistd.h>
 
 #include <openvpn/common/rc.hpp>
 
 using namespace openvpn;
 
+/**
+ *  Stops the main loop of a service once it has been idle for a while.
+ *  The service is idle when no references are held via RefCountInc()
+ *  and no activity has been reported via UpdateTimestamp() during the
+ *  idle time.
+ *
+ *  The check runs as a timer source in the GMainContext of the main
+ *  loop, which wakes up exactly when the idle time would have passed
+ *  since the last activity.  If more activity happened meanwhile, the
+ *  timer is re-armed for the new deadline.  While references are held,
+ *  the timer is not armed at all.
+ */
 class IdleCheck : public RC<thread_safe_refcount>
 {
 public:
     typedef RCPtr<IdleCheck> Ptr;
+    typedef std::function<void(bool idle)> StateCallback;
 
     IdleCheck(GMainLoop *mainloop, std::chrono::duration<double> idle_time)
         : mainloop(mainloop),
-          idle_time(idle_time),
-          poll_time(idle_time),
+          idle_time(std::chrono::duration_cast<std::chrono::microseconds>(idle_time).count()),
           enabled(false),
-          running(false),
-          refcount(0)
+          idle_exit(false),
+          refcount(0),
+          timer(nullptr)
     {
-            UpdateTimestamp();
+        UpdateTimestamp();
     }
 
 
-    void UpdateTimestamp()
+    ~IdleCheck()
     {
-        last_operation = std::chrono::system_clock::now();
+        Disable();
     }
 
 
-    void SetPollTime(std::chrono::duration<double> pollt)
+    void UpdateTimestamp()
     {
-        poll_time = pollt;
+        last_operation = g_get_monotonic_time();
     }
 
 
     void Enable()
     {
-        if (running)
-        {
-            return;
-        }
-
+        std::lock_guard<std::mutex> guard(timer_mtx);
         if (enabled)
         {
             return;
         }
 
+        // A GSource with only a ready time set is a timer
+        // which can be re-armed from any thread
+        static GSourceFuncs timer_funcs = {
+            NULL,              // prepare
+            NULL,              // check
+            timer_dispatch,
+            NULL               // finalize
+        };
+        timer = g_source_new(&timer_funcs, sizeof(GSource));
+        g_source_set_callback(timer, _cb_idle_timer, this, NULL);
+        g_source_attach(timer, g_main_loop_get_context(mainloop));
         enabled = true;
-        idle_checker.reset(new std::thread([self=Ptr(this)]()
-                           {
-                               self->_cb_idlechecker__loop();
-                           }));
+        arm_timer();
     }
 
 
     void Disable()
     {
+        std::lock_guard<std::mutex> guard(timer_mtx);
         enabled = false;
+        if (timer)
+        {
+            g_source_destroy(timer);
+            g_source_unref(timer);
+            timer = nullptr;
+        }
+    }
+
+
+    /**
+     *  Sets a function which is called each time IsIdle() changes; when
+     *  the first reference is taken and when the last one is released.
+     *  It is called on the thread changing the reference count.
+     *
+     * @param cb  StateCallback to call, or nullptr to remove it
+     */
+    void SetStateCallback(StateCallback cb)
+    {
+        std::lock_guard<std::mutex> guard(timer_mtx);
+        state_callback = cb;
     }
 
 
     void RefCountInc()
     {
-        refcount++;
+        // The idle timer notices the reference when it expires
+        if (1 == ++refcount)
+        {
+            notify_state();
+        }
     }
 
 
     void RefCountDec()
     {
-        refcount--;
+        if (0 == --refcount)
+        {
+            // The idle time starts when the last reference is gone
+            UpdateTimestamp();
+            {
+                std::lock_guard<std::mutex> guard(timer_mtx);
+                arm_timer();
+            }
+            notify_state();
+        }
     }
 
 
-    void Join()
+    /**
+     *  Checks if the service is currently idle, which is when no
+     *  references are held.  The service stops when it has been idle
+     *  for the idle time without any activity.
+     *
+     * @return Returns true if no references are held
+     */
+    bool IsIdle() const
     {
-        idle_checker->join();
+        return 0 == refcount;
     }
 
 
-    void _cb_idlechecker__loop()
+    /**
+     *  Checks if the main loop was stopped due to the service being idle
+     *
+     * @return Returns true if the idle time expired
+     */
+    bool IdleExit() const
     {
-        running = true;
-        while( enabled )
-        {
-            // FIXME: Consider to swap sleep_for() with
-            // std::condition_variable::wait_for() which can
-            // unlock on cv.notify_one() call.
-            std::this_thread::sleep_for(poll_time);
-            auto now = std::chrono::system_clock::now();
-            if (0 == refcount && (last_operation + idle_time) < now)
-            {
-                // We timed out, start the main loop shutdown
-#ifdef SHUTDOWN_NOTIF_PROCESS_NAME
-            std::cout << SHUTDOWN_NOTIF_PROCESS_NAME
-                      << " starting idle shutdown "
-                      << "(pid: " << std::to_string(getpid()) << ")"
-                      << std::endl;
-#endif
-                g_main_loop_quit(mainloop);
-                enabled = false;
-            }
-        }
-        running = false;
+        return idle_exit;
     }
 
+
 private:
     GMainLoop *mainloop;
-    std::chrono::duration<double> idle_time;
-    std::chrono::duration<double> poll_time;
+    const gint64 idle_time;
     bool enabled;
-    bool running;
-    uint16_t refcount;
-    std::chrono::time_point<std::chrono::system_clock> last_operation;
-    std::unique_ptr<std::thread> idle_checker;
+    std::atomic<bool> idle_exit;
+    std::atomic<int> refcount;
+    std::atomic<gint64> last_operation;
+    std::mutex timer_mtx;
+    GSource *timer;
+    StateCallback state_callback;
+
+
+    /**
+     *  Reports the current idle state to the state callback, if set
+     */
+    void notify_state()
+    {
+        StateCallback cb;
+        {
+            std::lock_guard<std::mutex> guard(timer_mtx);
+            cb = state_callback;
+        }
+        if (cb)
+        {
+            cb(IsIdle());
+        }
+    }
+
+
+    /**
+     *  Sets the timer to expire when the idle time has passed since the
+     *  last activity.  The caller must hold timer_mtx.
+     */
+    void arm_timer()
+    {
+        if (timer)
+        {
+            g_source_set_ready_time(timer, last_operation + idle_time);
+        }
+    }
+
+
+    static gboolean timer_dispatch(GSource *source, GSourceFunc callback,
+                                   gpointer data)
+    {
+        return callback(data);
+    }
+
+
+    static gboolean _cb_idle_timer(gpointer data)
+    {
+        IdleCheck *self = (IdleCheck *) data;
+        std::lock_guard<std::mutex> guard(self->timer_mtx);
+        if (!self->enabled)
+        {
+            return G_SOURCE_CONTINUE;
+        }
+
+        if (self->refcount > 0)
+        {
+            // Re-armed when the last reference is released
+            g_source_set_ready_time(self->timer, -1);
+            return G_SOURCE_CONTINUE;
+        }
+
+        if (g_get_monotonic_time() < self->last_operation + self->idle_time)
+        {
+            // There has been activity since the timer was armed
+            self->arm_timer();
+            return G_SOURCE_CONTINUE;
+        }
+
+        // We timed out, start the main loop shutdown
+#ifdef SHUTDOWN_NOTIF_PROCESS_NAME
+        std::cout << SHUTDOWN_NOTIF_PROCESS_NAME
+                  << " starting idle shutdown "
+                  << "(pid: " << std::to_string(getpid()) << ")"
+                  << std::endl;
+#endif
+        self->idle_exit = true;
+        g_source_set_ready_time(self->timer, -1);
+        g_main_loop_quit(self->mainloop);
+        return G_SOURCE_CONTINUE;
+    }
 };
 #endif // OPENVPN3_DBUS_IDLECHECK_HPP
@@ -232,11 +232,44 @@ private:
 };
 
 
+/**
+ *  std::string values cannot be passed directly to the GLib variadic
+ *  functions, they must be handled as C strings.
+ */
+template <>
+inline GVariant *PropertyType<std::string>::GetValue() const
+{
+    return g_variant_new_string(PropertyTypeBase<std::string>::value.c_str());
+}
+
+
+template <>
+inline GVariantBuilder *PropertyType<std::string>::SetValue(GVariant *value_arg)
+{
+    gsize len = 0;
+    PropertyTypeBase<std::string>::value = std::string(g_variant_get_string(value_arg, &len));
+    return PropertyTypeBase<std::string>::obj->build_set_property_response(PropertyTypeBase<std::string>::name, PropertyTypeBase<std::string>::value);
+}
+
+
+template <>
+inline GVariantBuilder *PropertyType<std::vector<std::string>>::get_builder() const
+{
+    GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE(dbus_array_type.c_str()));
+    for (const auto &e : this->value)
+    {
+        g_variant_builder_add(bld, "s", e.c_str());
+    }
+    return bld;
+}
+
+
 
 class PropertyCollection
 {
   public:
     PropertyCollection(DBusObject *obj)
+        : obj(obj)
     {
     }
 
@@ -288,6 +321,22 @@ class PropertyCollection
         return prop->second->SetValue(value);
     }
 
+    /**
+     *  Signals to D-Bus clients that a property value has been
+     *  modified by the service itself, not via a D-Bus Set call.
+     *
+     * @param property_name  std::string with the property name
+     */
+    void PropertyChanged(const std::string& property_name)
+    {
+        auto prop = properties.find(property_name);
+        if (prop == properties.end())
+            return;
+
+        obj->PropertyChanged(property_name, prop->second->GetValue());
+    }
+
   private:
+    DBusObject *obj;
     std::map<std::string, Property::Ptr> properties;
 };
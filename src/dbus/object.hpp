@@ -20,7 +20,16 @@
 #ifndef OPENVPN3_DBUS_OBJECT_HPP
 #define OPENVPN3_DBUS_OBJECT_HPP
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
 #include "idlecheck.hpp"
+#include "executor.hpp"
+#include "stats.hpp"
+#include "tracepoints.hpp"
 
 namespace openvpn
 {
@@ -56,7 +65,18 @@ namespace openvpn
             registered(false),
             object_path(obj_path),
             object_id(0),
-            idle_checker(nullptr)
+            idle_checker(nullptr),
+            idle_property(false),
+            introspection(nullptr),
+            object_conn(nullptr),
+            peer_conn(nullptr),
+            peer_object_id(0),
+            propchg_source(0),
+            propchg_invalidate_only(false),
+            debug_interface(false),
+            debug_object_id(0),
+            removal_conn(nullptr),
+            removal_scheduled(false)
         {
             ParseIntrospectionXML(introspection_xml);
         }
@@ -67,13 +87,32 @@ namespace openvpn
             object_path(obj_path),
             object_id(0),
             idle_checker(nullptr),
-            introspection(nullptr)
+            idle_property(false),
+            introspection(nullptr),
+            object_conn(nullptr),
+            peer_conn(nullptr),
+            peer_object_id(0),
+            propchg_source(0),
+            propchg_invalidate_only(false),
+            debug_interface(false),
+            debug_object_id(0),
+            removal_conn(nullptr),
+            removal_scheduled(false)
         {
         }
 
 
         virtual ~DBusObject()
         {
+            if (strand)
+            {
+                strand->Close();
+            }
+            if (idle_property && idle_checker)
+            {
+                idle_checker->SetStateCallback(nullptr);
+            }
+            discard_property_changes();
             if (introspection)
             {
                 g_dbus_node_info_unref(introspection);
@@ -123,7 +162,251 @@ namespace openvpn
                 err << (error != NULL ? error->message : "(unknown)");
                 THROW_DBUSEXCEPTION("DBusObject", err.str());
             }
+            object_conn = dbuscon;
             registered = true;
+
+            if (debug_interface)
+            {
+                debug_object_id = g_dbus_connection_register_object(dbuscon,
+                                                                    object_path.c_str(),
+                                                                    DBusDebugInterface::Info(),
+                                                                    DBusDebugInterface::VTable(),
+                                                                    NULL, NULL,
+                                                                    NULL);
+            }
+        }
+
+
+        /**
+         *  Adds the net.openvpn.v3.debug interface to this object when it
+         *  is registered.  This provides the D-Bus call statistics of the
+         *  whole process, and is meant for the main object of a service.
+         */
+        void EnableDebugInterface()
+        {
+            if (registered)
+            {
+                THROW_DBUSEXCEPTION("DBusObject", "Object is already registered in D-Bus");
+            }
+            debug_interface = true;
+        }
+
+
+        /**
+         *  Provides this object on a private peer-to-peer link as well,
+         *  in addition to the bus it is registered on.  Any previous peer
+         *  registration is removed.  PropertiesChanged signals are then
+         *  sent over the link instead of the bus.
+         *
+         *  @param link  GDBusConnection of the peer-to-peer link
+         */
+        void RegisterPeerConnection(GDBusConnection *link)
+        {
+            if (!registered)
+            {
+                THROW_DBUSEXCEPTION("DBusObject", "Object have not been registered to D-Bus yet");
+            }
+            UnregisterPeerConnection();
+
+            GError *error = NULL;
+            guint id = g_dbus_connection_register_object(link,
+                                                         object_path.c_str(),
+                                                         introspection->interfaces[0],
+                                                         &dbusobj_interface_vtable,
+                                                         this,
+                                                         NULL, // destruct function
+                                                         &error);
+            if (id < 1)
+            {
+                std::stringstream err;
+                err << "RegisterPeerConnection(" + object_path + ") failed: ";
+                err << (error != NULL ? error->message : "(unknown)");
+                THROW_DBUSEXCEPTION("DBusObject", err.str());
+            }
+            std::lock_guard<std::mutex> guard(propchg_mtx);
+            peer_conn = (GDBusConnection *) g_object_ref(link);
+            peer_object_id = id;
+        }
+
+
+        /**
+         *  Removes this object from the peer-to-peer link set up by
+         *  RegisterPeerConnection(), if any.
+         */
+        void UnregisterPeerConnection()
+        {
+            GDBusConnection *link = nullptr;
+            guint id = 0;
+            {
+                std::lock_guard<std::mutex> guard(propchg_mtx);
+                std::swap(link, peer_conn);
+                std::swap(id, peer_object_id);
+            }
+            if (link)
+            {
+                g_dbus_connection_unregister_object(link, id);
+                g_object_unref(link);
+            }
+        }
+
+
+        /**
+         *  Sends the PropertiesChanged signals only to a specific bus name
+         *  instead of broadcasting them.
+         *
+         *  @param busname  std::string with the unique bus name of the
+         *                  receiver.  If empty, the signals are broadcast.
+         */
+        void SetPropertiesChangedTarget(const std::string& busname)
+        {
+            propchg_target = busname;
+        }
+
+
+        /**
+         *  Only flags modified properties as invalidated in the
+         *  PropertiesChanged signals, without including the new values.
+         *  This is needed by objects where property access is restricted,
+         *  as the signals can be received by anyone on the bus.
+         *
+         *  @param inv_only  bool, if true no property values are sent
+         */
+        void SetPropertiesChangedInvalidateOnly(bool inv_only)
+        {
+            propchg_invalidate_only = inv_only;
+        }
+
+
+        /**
+         *  Queues a PropertiesChanged signal for a property which has been
+         *  modified by the service itself.  All changes queued before the
+         *  main loop becomes idle are coalesced into a single
+         *  PropertiesChanged signal.
+         *
+         *  @param property  std::string with the property name
+         *  @param value     GVariant object with the new value.  If NULL,
+         *                   the property is only flagged as invalidated and
+         *                   clients need to retrieve the new value.  The
+         *                   value is discarded if the object only sends
+         *                   invalidations.
+         */
+        void PropertyChanged(const std::string& property, GVariant *value = NULL)
+        {
+            if (value)
+            {
+                g_variant_ref_sink(value);
+            }
+            if (value && propchg_invalidate_only)
+            {
+                g_variant_unref(value);
+                value = NULL;
+            }
+            if (!registered)
+            {
+                if (value)
+                {
+                    g_variant_unref(value);
+                }
+                return;
+            }
+
+            std::lock_guard<std::mutex> guard(propchg_mtx);
+            auto it = propchg_pending.find(property);
+            if (propchg_pending.end() != it && it->second)
+            {
+                g_variant_unref(it->second);
+            }
+            propchg_pending[property] = value;
+
+            if (0 == propchg_source)
+            {
+                propchg_source = g_idle_add(dbusobject_emit_properties_changed,
+                                            this);
+            }
+        }
+
+
+        /**
+         *  Runs the method calls and property access of this object on
+         *  the worker threads of a DBusExecutor instead of the GMainLoop.
+         *  The calls are run one at a time, in the order they arrived.
+         *  Must be called before the object is registered.
+         *
+         *  Method handlers may complete the GDBusMethodInvocation from
+         *  the worker thread, but must not depend on the GMainLoop
+         *  running while they are busy.  The object must be removed and
+         *  deleted via RemoveAndDelete().
+         *
+         *  @param exec  DBusExecutor::Ptr to the executor to use
+         */
+        void SetExecutor(DBusExecutor::Ptr exec)
+        {
+            if (registered)
+            {
+                THROW_DBUSEXCEPTION("DBusObject", "Object is already registered in D-Bus. "
+                                    "Cannot change the executor.");
+            }
+            executor = exec;
+            strand = (exec ? exec->NewStrand() : nullptr);
+        }
+
+
+        /**
+         *  Retrieve the DBusExecutor set via SetExecutor()
+         *
+         *  @return Returns a DBusExecutor::Ptr, which is empty if the
+         *          D-Bus calls are run on the GMainLoop
+         */
+        DBusExecutor::Ptr GetExecutor() const
+        {
+            return executor;
+        }
+
+
+        /**
+         *  Runs a task serialized with the D-Bus calls of this object.
+         *  Without an executor, the task is run immediately.
+         *
+         *  @param task  DBusTask to run
+         */
+        void RunInStrand(DBusTask task)
+        {
+            if (!strand || strand->RunningInThisThread())
+            {
+                task();
+                return;
+            }
+            strand->Post(std::move(task));
+        }
+
+
+        /**
+         *  Removes the object from the D-Bus and deletes it.  This is
+         *  done later on from the GMainLoop, once the task of the strand
+         *  running right now has completed; the calls still queued in the
+         *  strand are answered with an error.  The GDBus callbacks and
+         *  the PropertiesChanged source run in the GMainLoop as well, so
+         *  they never see a deleted object.
+         *
+         *  Can be called from any thread, including the method handlers
+         *  of the object itself.  The object must have been created with
+         *  new, and must not be used by the caller afterwards.
+         *
+         *  @param conn  GDBusConnection the object is registered on
+         */
+        void RemoveAndDelete(GDBusConnection *conn)
+        {
+            if (removal_scheduled.exchange(true))
+            {
+                return;
+            }
+            if (strand)
+            {
+                // Don't start any further calls
+                strand->Close();
+            }
+            removal_conn = conn;
+            g_idle_add(dbusobject_remove_and_delete, this);
         }
 
 
@@ -138,6 +421,26 @@ namespace openvpn
         }
 
 
+        /**
+         *  Sends a PropertiesChanged signal for the 'idle' property of
+         *  this object each time the idle state of the registered
+         *  IdleCheck object changes.  Only one object per IdleCheck
+         *  object can do this.
+         */
+        void IdleCheck_EnableIdleProperty()
+        {
+            if (!idle_checker)
+            {
+                return;
+            }
+            idle_checker->SetStateCallback([this](bool idle)
+                {
+                    PropertyChanged("idle", g_variant_new_boolean(idle));
+                });
+            idle_property = true;
+        }
+
+
         void RemoveObject(GDBusConnection *dbuscon)
         {
             if (!registered)
@@ -145,6 +448,8 @@ namespace openvpn
                 THROW_DBUSEXCEPTION("DBusObject", "Object have not been registered to D-Bus yet");
             }
             registered = false;
+            discard_property_changes();
+            UnregisterPeerConnection();
 
             GError *err = nullptr;
             if (!g_dbus_connection_flush_sync(dbuscon, NULL, &err))
@@ -158,6 +463,11 @@ namespace openvpn
 
             // Remove the object from the D-Bus
             g_dbus_connection_unregister_object(dbuscon, object_id);
+            if (debug_object_id > 0)
+            {
+                g_dbus_connection_unregister_object(dbuscon, debug_object_id);
+                debug_object_id = 0;
+            }
 
             // Allow the implementor to add more cleaning up
             callback_destructor();
@@ -177,7 +487,38 @@ namespace openvpn
                                           const std::string intf_name,
                                           const std::string meth_name,
                                           GVariant *params,
-                                          GDBusMethodInvocation *invoc) = 0;
+                                          GDBusMethodInvocation *invoc)
+        {
+            std::string errmsg = "No method named " + meth_name + " is available";
+            GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.error.undefined",
+                                                          errmsg.c_str());
+            g_dbus_method_invocation_return_gerror(invoc, err);
+            g_error_free(err);
+            DBusCallStats::MarkError();
+        }
+
+
+        /**
+         *  Called by the GDBus library for each method call, with the
+         *  strings as provided by GDBus.  The default implementation calls
+         *  callback_method_call().  Objects using a DBusMethodTable
+         *  override this to avoid copying the strings on each call.
+         */
+        virtual void callback_method_dispatch(GDBusConnection *conn,
+                                              const gchar *sender,
+                                              const gchar *obj_path,
+                                              const gchar *intf_name,
+                                              const gchar *meth_name,
+                                              GVariant *params,
+                                              GDBusMethodInvocation *invoc)
+        {
+            callback_method_call(conn,
+                                 std::string(sender ? sender : ""),
+                                 std::string(obj_path),
+                                 std::string(intf_name),
+                                 std::string(meth_name),
+                                 params, invoc);
+        }
 
 
         GVariant * _dbus_get_property_internal(GDBusConnection *conn,
@@ -208,7 +549,34 @@ namespace openvpn
                                                  const std::string obj_path,
                                                  const std::string intf_name,
                                                  const std::string property_name,
-                                                 GError **error) = 0;
+                                                 GError **error)
+        {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                        "Unknown property");
+            return NULL;
+        }
+
+
+        /**
+         *  Called by the GDBus library for each property read, with the
+         *  strings as provided by GDBus.  The default implementation calls
+         *  callback_get_property().  Objects using a DBusPropertyTable
+         *  override this to avoid copying the strings on each call.
+         */
+        virtual GVariant * callback_property_dispatch(GDBusConnection *conn,
+                                                      const gchar *sender,
+                                                      const gchar *obj_path,
+                                                      const gchar *intf_name,
+                                                      const gchar *property_name,
+                                                      GError **error)
+        {
+            return _dbus_get_property_internal(conn,
+                                               std::string(sender ? sender : ""),
+                                               std::string(obj_path),
+                                               std::string(intf_name),
+                                               std::string(property_name),
+                                               error);
+        }
 
 
         /**
@@ -228,13 +596,13 @@ namespace openvpn
         {
             try
             {
-                GVariantBuilder *ret = callback_set_property(conn,
-                                                             std::string(sender),
-                                                             std::string(obj_path),
-                                                             std::string(intf_name),
-                                                             std::string(property_name),
-                                                             value,
-                                                             error);
+                GVariantBuilder *ret = callback_set_property_dispatch(conn,
+                                                                      sender,
+                                                                      obj_path,
+                                                                      intf_name,
+                                                                      property_name,
+                                                                      value,
+                                                                      error);
 
                 // If ret != NULL, we have a valid response which contains
                 // information about what has changed.  This is further
@@ -242,6 +610,12 @@ namespace openvpn
                 // have been modified; which is the signal being emitted below.
                 if (NULL != ret)
                 {
+                    GVariantBuilder *invalidated = NULL;
+                    if (propchg_invalidate_only)
+                    {
+                        invalidated = move_to_invalidated(ret);
+                    }
+
                     GError *local_err = NULL;
                     g_dbus_connection_emit_signal (conn,
                                                    NULL,
@@ -250,10 +624,14 @@ namespace openvpn
                                                    "PropertiesChanged",
                                                    g_variant_new ("(sa{sv}as)",
                                                                   intf_name,
-                                                                  ret,
-                                                                  NULL),
+                                                                  (invalidated ? NULL : ret),
+                                                                  invalidated),
                                                    &local_err);
                     g_variant_builder_unref(ret);
+                    if (invalidated)
+                    {
+                        g_variant_builder_unref(invalidated);
+                    }
 
                     if (local_err)
                     {
@@ -304,7 +682,36 @@ namespace openvpn
                                                const std::string intf_name,
                                                const std::string property_name,
                                                GVariant *value,
-                                               GError **error) = 0;
+                                               GError **error)
+        {
+            throw DBusPropertyException(G_IO_ERROR, G_IO_ERROR_FAILED,
+                                        obj_path, intf_name, property_name,
+                                        "Invalid property");
+        }
+
+
+        /**
+         *  Called by the GDBus library for each property change, with the
+         *  strings as provided by GDBus.  The default implementation calls
+         *  callback_set_property().  Objects using a DBusPropertyTable
+         *  with setters override this to avoid copying the strings on
+         *  each call.
+         */
+        virtual GVariantBuilder * callback_set_property_dispatch(GDBusConnection *conn,
+                                                                 const gchar *sender,
+                                                                 const gchar *obj_path,
+                                                                 const gchar *intf_name,
+                                                                 const gchar *property_name,
+                                                                 GVariant *value,
+                                                                 GError **error)
+        {
+            return callback_set_property(conn,
+                                         std::string(sender ? sender : ""),
+                                         std::string(obj_path),
+                                         std::string(intf_name),
+                                         std::string(property_name),
+                                         value, error);
+        }
 
 
         /**
@@ -472,6 +879,60 @@ namespace openvpn
         }
 
 
+        /**
+         *  Uses an introspection document shared by all objects of the
+         *  same kind.  The document is only generated and parsed the first
+         *  time a class_name is seen; later objects take a reference to the
+         *  already parsed document.  The XML must therefore not depend on
+         *  the object path or any other per-object data.
+         *
+         *  @param class_name  Unique name identifying the introspection
+         *                     document, usually the C++ class name
+         *  @param generator   Function returning the introspection XML
+         *                     document.  Only called when the document is
+         *                     not cached yet.
+         */
+        void SetSharedIntrospection(const std::string& class_name,
+                                    std::function<std::string()> generator)
+        {
+            if (registered)
+            {
+                THROW_DBUSEXCEPTION("DBusObject", "Object is already registered in D-Bus. "
+                                    "Cannot modify the introspection document.");
+            }
+
+            IntrospectionCache& cache = introspection_cache();
+            std::lock_guard<std::mutex> guard(cache.mtx);
+            auto it = cache.nodes.find(class_name);
+            if (cache.nodes.end() == it)
+            {
+                GError *error = nullptr;
+                GDBusNodeInfo *node = g_dbus_node_info_new_for_xml(generator().c_str(),
+                                                                   &error);
+                if (NULL == node || NULL != error)
+                {
+                    std::string errmsg = (error ? error->message : "(unknown)");
+                    if (error)
+                    {
+                        g_error_free(error);
+                    }
+                    THROW_DBUSEXCEPTION("DBusObject",
+                                        "Failed to parse introspection XML for "
+                                        + class_name + ": " + errmsg);
+                }
+                it = cache.nodes.insert(std::make_pair(class_name, node)).first;
+            }
+
+            if (introspection)
+            {
+                g_dbus_node_info_unref(introspection);
+            }
+            // The cache keeps its own reference for the life time
+            // of the process
+            introspection = g_dbus_node_info_ref(it->second);
+        }
+
+
         /**
          *  Updates the IdleCheck timer's timestamp to indicate this object have been accessed.
          *  If the IdleCheck object times out, the process is stopped.
@@ -513,20 +974,246 @@ namespace openvpn
         }
 
 
+        /**
+         *  Checks if the registered IdleCheck object holds no references
+         *  which prevents the idle timer from running.
+         *
+         * @return Returns true if idle, false if busy or no IdleCheck
+         *         object is registered.
+         */
+        bool IdleCheck_IsIdle() const
+        {
+            return idle_checker && idle_checker->IsIdle();
+        }
+
+
     private:
+        /**
+         *  Parsed introspection documents shared between objects,
+         *  indexed by the class name given to SetSharedIntrospection()
+         */
+        struct IntrospectionCache
+        {
+            std::mutex mtx;
+            std::map<std::string, GDBusNodeInfo *> nodes;
+        };
+
+        static IntrospectionCache& introspection_cache()
+        {
+            static IntrospectionCache cache;
+            return cache;
+        }
+
         bool registered;
         std::string object_path;
         guint object_id;
         IdleCheck *idle_checker;
+        bool idle_property;
         GDBusNodeInfo *introspection;
+        GDBusConnection *object_conn;
+        GDBusConnection *peer_conn;
+        guint peer_object_id;
+        std::mutex propchg_mtx;
+        std::map<std::string, GVariant *> propchg_pending;
+        guint propchg_source;
+        std::string propchg_target;
+        bool propchg_invalidate_only;
+        DBusExecutor::Ptr executor;
+        DBusStrand::Ptr strand;
+        bool debug_interface;
+        guint debug_object_id;
+        GDBusConnection *removal_conn;
+        std::atomic<bool> removal_scheduled;
+
 
         /**
-         *  Callback loook-up table for D-Bus
+         *  Keeps a method call alive while it waits in the strand.  If
+         *  the call is never dispatched because the object went away,
+         *  the caller gets an error instead of a timeout.
+         */
+        struct PendingCall
+        {
+            PendingCall(GVariant *params, GDBusMethodInvocation *invoc)
+                : params(g_variant_ref(params)),
+                  invoc((GDBusMethodInvocation *) g_object_ref(invoc)),
+                  dispatched(false)
+            {
+            }
+
+            ~PendingCall()
+            {
+                if (!dispatched)
+                {
+                    g_dbus_method_invocation_return_dbus_error(invoc,
+                                                               "net.openvpn.v3.error.undefined",
+                                                               "Object was removed");
+                }
+                g_variant_unref(params);
+                g_object_unref(invoc);
+            }
+
+            GVariant *params;
+            GDBusMethodInvocation *invoc;
+            bool dispatched;
+        };
+
+
+        /**
+         *  Sends a single PropertiesChanged signal for all queued
+         *  property changes.
+         */
+        void emit_properties_changed()
+        {
+            std::map<std::string, GVariant *> pending;
+            GDBusConnection *link = nullptr;
+            {
+                std::lock_guard<std::mutex> guard(propchg_mtx);
+                pending.swap(propchg_pending);
+                propchg_source = 0;
+                if (peer_conn)
+                {
+                    link = (GDBusConnection *) g_object_ref(peer_conn);
+                }
+            }
+            if (pending.empty())
+            {
+                return;
+            }
+
+            GVariantBuilder *changed = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
+            GVariantBuilder *invalidated = g_variant_builder_new(G_VARIANT_TYPE("as"));
+            for (auto& p : pending)
+            {
+                if (p.second)
+                {
+                    g_variant_builder_add(changed, "{sv}",
+                                          p.first.c_str(), p.second);
+                    g_variant_unref(p.second);
+                }
+                else
+                {
+                    g_variant_builder_add(invalidated, "s", p.first.c_str());
+                }
+            }
+
+            if (registered && introspection)
+            {
+                // On a peer-to-peer link there is only one receiver
+                g_dbus_connection_emit_signal((link ? link : object_conn),
+                                              ((link || propchg_target.empty())
+                                               ? NULL : propchg_target.c_str()),
+                                              object_path.c_str(),
+                                              "org.freedesktop.DBus.Properties",
+                                              "PropertiesChanged",
+                                              g_variant_new("(sa{sv}as)",
+                                                            introspection->interfaces[0]->name,
+                                                            changed,
+                                                            invalidated),
+                                              NULL);
+            }
+            g_variant_builder_unref(changed);
+            g_variant_builder_unref(invalidated);
+            if (link)
+            {
+                g_object_unref(link);
+            }
+        }
+
+
+        /**
+         *  Ends a set property response from a property setter and
+         *  returns the names of the modified properties, to be sent as
+         *  invalidated properties instead.
+         *
+         *  @param changed  GVariantBuilder with the property response.
+         *                  It can only be unreferenced afterwards.
+         *
+         *  @return Returns a new GVariantBuilder with an array of the
+         *          property names.  Must be freed with
+         *          g_variant_builder_unref().
+         */
+        GVariantBuilder * move_to_invalidated(GVariantBuilder *changed)
+        {
+            GVariant *values = g_variant_ref_sink(g_variant_builder_end(changed));
+
+            GVariantBuilder *invalidated = g_variant_builder_new(G_VARIANT_TYPE("as"));
+            GVariantIter iter;
+            g_variant_iter_init(&iter, values);
+            gchar *name = nullptr;
+            GVariant *val = nullptr;
+            while (g_variant_iter_next(&iter, "{sv}", &name, &val))
+            {
+                g_variant_builder_add(invalidated, "s", name);
+                g_free(name);
+                g_variant_unref(val);
+            }
+            g_variant_unref(values);
+            return invalidated;
+        }
+
+
+        /**
+         *  Removes all queued property changes, used when the object
+         *  is removed from the D-Bus
+         */
+        void discard_property_changes()
+        {
+            std::lock_guard<std::mutex> guard(propchg_mtx);
+            if (propchg_source > 0)
+            {
+                g_source_remove(propchg_source);
+                propchg_source = 0;
+            }
+            for (auto& p : propchg_pending)
+            {
+                if (p.second)
+                {
+                    g_variant_unref(p.second);
+                }
+            }
+            propchg_pending.clear();
+        }
+
+
+        static gboolean dbusobject_emit_properties_changed(gpointer this_ptr)
+        {
+            class DBusObject *obj = (class DBusObject *) this_ptr;
+            obj->emit_properties_changed();
+            return G_SOURCE_REMOVE;
+        }
+
+
+        /**
+         *  Completes RemoveAndDelete() in the GMainLoop.  While the strand
+         *  is drained, no GDBus callback can run for this object, as they
+         *  are all called from the GMainLoop too.
+         */
+        static gboolean dbusobject_remove_and_delete(gpointer this_ptr)
+        {
+            class DBusObject *obj = (class DBusObject *) this_ptr;
+            if (obj->strand)
+            {
+                obj->strand->Drain();
+            }
+            if (obj->registered)
+            {
+                obj->RemoveObject(obj->removal_conn);
+            }
+            delete obj;
+            return G_SOURCE_REMOVE;
+        }
+
+        /**
+         *  Callback loook-up table for D-Bus.  Without get_property and
+         *  set_property callbacks, GDBus delivers the
+         *  org.freedesktop.DBus.Properties calls to the method_call
+         *  callback, which allows completing them from the strand without
+         *  blocking the GMainLoop.
          */
         GDBusInterfaceVTable dbusobj_interface_vtable = {
             dbusobject_callback_method_call,
-            dbusobject_callback_get_property,
-            dbusobject_callback_set_property
+            NULL,
+            NULL
         };
 
 
@@ -540,47 +1227,298 @@ namespace openvpn
                                                      gpointer this_ptr)
         {
             class DBusObject *obj = (class DBusObject *) this_ptr;
-            obj->callback_method_call(conn,
-                                      std::string(sender),
-                                      std::string(obj_path),
-                                      std::string(intf_name),
-                                      std::string(meth_name),
-                                      params, invoc);
+            if (!obj->strand)
+            {
+                call_dispatch(obj, conn, sender, obj_path, intf_name,
+                              meth_name, params, invoc);
+                return;
+            }
+
+            // The strings passed to this callback are only valid until
+            // it returns; the task retrieves them from the invocation
+            auto call = std::make_shared<PendingCall>(params, invoc);
+            obj->strand->Post([obj, call]()
+                {
+                    call->dispatched = true;
+                    GDBusMethodInvocation *inv = call->invoc;
+                    // The handler may delete obj, it must not be
+                    // accessed once this call returns
+                    call_dispatch(obj,
+                                  g_dbus_method_invocation_get_connection(inv),
+                                  g_dbus_method_invocation_get_sender(inv),
+                                  g_dbus_method_invocation_get_object_path(inv),
+                                  g_dbus_method_invocation_get_interface_name(inv),
+                                  g_dbus_method_invocation_get_method_name(inv),
+                                  call->params, inv);
+                });
         }
 
 
-        static GVariant * dbusobject_callback_get_property(GDBusConnection *conn,
-                                                           const gchar *sender,
-                                                           const gchar *obj_path,
-                                                           const gchar *intf_name,
-                                                           const gchar *property_name,
-                                                           GError **error,
-                                                           gpointer this_ptr)
+        /**
+         *  Sends a call either to the property handlers or to the
+         *  method handler of the object
+         */
+        static void call_dispatch(DBusObject *obj,
+                                  GDBusConnection *conn,
+                                  const gchar *sender,
+                                  const gchar *obj_path,
+                                  const gchar *intf_name,
+                                  const gchar *meth_name,
+                                  GVariant *params,
+                                  GDBusMethodInvocation *invoc)
         {
-            class DBusObject *obj = (class DBusObject *) this_ptr;
-            return obj->_dbus_get_property_internal(conn,
-                                                    std::string(sender),
-                                                    std::string(obj_path),
-                                                    std::string(intf_name),
-                                                    std::string(property_name),
-                                                    error);
+            if (0 == g_strcmp0(intf_name, "org.freedesktop.DBus.Properties"))
+            {
+                properties_call(obj, conn, sender, obj_path, meth_name,
+                                params, invoc);
+                return;
+            }
+            method_dispatch(obj, conn, sender, obj_path, intf_name,
+                            meth_name, params, invoc);
         }
 
 
-        static gboolean dbusobject_callback_set_property(GDBusConnection *conn,
-                                                         const gchar *sender,
-                                                         const gchar *obj_path,
-                                                         const gchar *intf_name,
-                                                         const gchar *property_name,
-                                                         GVariant *value,
-                                                         GError **error,
-                                                         gpointer this_ptr)
+        /**
+         *  Calls the method handler, recording the call in DBusCallStats
+         *  and the dbus_method_entry/dbus_method_return tracepoints
+         */
+        static void method_dispatch(DBusObject *obj,
+                                    GDBusConnection *conn,
+                                    const gchar *sender,
+                                    const gchar *obj_path,
+                                    const gchar *intf_name,
+                                    const gchar *meth_name,
+                                    GVariant *params,
+                                    GDBusMethodInvocation *invoc)
         {
-            class DBusObject *obj = (class DBusObject *) this_ptr;
-            return obj->_dbus_set_property_internal(conn, sender,
-                                                    obj_path, intf_name,
-                                                    property_name, value,
-                                                    error);
+            DBusCallStats::Timer timer(DBusCallStats::Kind::METHOD,
+                                       intf_name, meth_name);
+#ifdef ENABLE_USDT
+            // Returning the reply releases the invocation, which owns
+            // the strings given to the return tracepoint
+            g_object_ref(invoc);
+            TraceTimer trace;
+            OPENVPN3_TRACE3(dbus_method_entry, obj_path, intf_name, meth_name);
+            auto trace_return = [&]()
+                {
+                    OPENVPN3_TRACE4(dbus_method_return, obj_path, intf_name,
+                                    meth_name, trace.Elapsed());
+                    g_object_unref(invoc);
+                };
+#else
+            auto trace_return = []() {};
+#endif
+            try
+            {
+                obj->callback_method_dispatch(conn, sender, obj_path, intf_name,
+                                              meth_name, params, invoc);
+            }
+            catch (...)
+            {
+                trace_return();
+                timer.Finish(true);
+                throw;
+            }
+            trace_return();
+            timer.Finish();
+        }
+
+
+        /**
+         *  Completes a org.freedesktop.DBus.Properties Get, GetAll or Set
+         *  call.  GDBus has already checked that the property exists, is
+         *  accessible and, for Set, that the value has the right type.
+         */
+        static void properties_call(DBusObject *obj,
+                                    GDBusConnection *conn,
+                                    const gchar *sender,
+                                    const gchar *obj_path,
+                                    const gchar *meth_name,
+                                    GVariant *params,
+                                    GDBusMethodInvocation *invoc)
+        {
+            GError *error = NULL;
+            try
+            {
+                if (0 == g_strcmp0(meth_name, "Get"))
+                {
+                    const gchar *intf_name = nullptr;
+                    const gchar *property_name = nullptr;
+                    g_variant_get(params, "(&s&s)", &intf_name, &property_name);
+                    GVariant *value = get_property_internal(obj, conn, sender,
+                                                            obj_path, intf_name,
+                                                            property_name, &error);
+                    if (value)
+                    {
+                        g_variant_take_ref(value);
+                        g_dbus_method_invocation_return_value(invoc,
+                                                              g_variant_new("(v)", value));
+                        g_variant_unref(value);
+                        return;
+                    }
+                }
+                else if (0 == g_strcmp0(meth_name, "GetAll"))
+                {
+                    const gchar *intf_name = nullptr;
+                    g_variant_get(params, "(&s)", &intf_name);
+                    g_dbus_method_invocation_return_value(invoc,
+                                                          get_all_properties(obj, conn, sender,
+                                                                             obj_path, intf_name));
+                    return;
+                }
+                else if (0 == g_strcmp0(meth_name, "Set"))
+                {
+                    const gchar *intf_name = nullptr;
+                    const gchar *property_name = nullptr;
+                    GVariant *value = nullptr;
+                    g_variant_get(params, "(&s&sv)", &intf_name, &property_name, &value);
+                    gboolean ret = set_property_internal(obj, conn, sender,
+                                                         obj_path, intf_name,
+                                                         property_name, value,
+                                                         &error);
+                    g_variant_unref(value);
+                    if (ret)
+                    {
+                        g_dbus_method_invocation_return_value(invoc, NULL);
+                        return;
+                    }
+                }
+            }
+            catch (DBusException& excp)
+            {
+                if (error)
+                {
+                    g_clear_error(&error);
+                }
+                excp.SetDBusError(&error, G_IO_ERROR, G_IO_ERROR_FAILED);
+            }
+            catch (std::exception& excp)
+            {
+                if (error)
+                {
+                    g_clear_error(&error);
+                }
+                g_set_error(&error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                            "%s", excp.what());
+            }
+
+            if (error)
+            {
+                g_dbus_method_invocation_return_gerror(invoc, error);
+                g_error_free(error);
+            }
+            else
+            {
+                g_dbus_method_invocation_return_dbus_error(invoc,
+                                                           "org.freedesktop.DBus.Error.Failed",
+                                                           "Property access failed");
+            }
+        }
+
+
+        /**
+         *  Builds the reply to a org.freedesktop.DBus.Properties GetAll
+         *  call.  Properties which cannot be read by the caller are left
+         *  out, like GDBus does.
+         *
+         * @return Returns a GVariant object containing an (a{sv}) tuple
+         */
+        static GVariant * get_all_properties(DBusObject *obj,
+                                             GDBusConnection *conn,
+                                             const gchar *sender,
+                                             const gchar *obj_path,
+                                             const gchar *intf_name)
+        {
+            GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
+            GDBusInterfaceInfo *intf = (obj->introspection
+                                        ? g_dbus_node_info_lookup_interface(obj->introspection,
+                                                                            intf_name)
+                                        : NULL);
+            for (unsigned int i = 0; intf && intf->properties && intf->properties[i]; ++i)
+            {
+                GDBusPropertyInfo *prop = intf->properties[i];
+                if (!(prop->flags & G_DBUS_PROPERTY_INFO_FLAGS_READABLE))
+                {
+                    continue;
+                }
+                GError *error = NULL;
+                GVariant *value = get_property_internal(obj, conn, sender,
+                                                        obj_path, intf_name,
+                                                        prop->name, &error);
+                if (value)
+                {
+                    g_variant_take_ref(value);
+                    g_variant_builder_add(bld, "{sv}", prop->name, value);
+                    g_variant_unref(value);
+                }
+                if (error)
+                {
+                    g_error_free(error);
+                }
+            }
+            GVariant *ret = g_variant_new("(a{sv})", bld);
+            g_variant_builder_unref(bld);
+            return ret;
+        }
+
+
+        static GVariant * get_property_internal(DBusObject *obj,
+                                                GDBusConnection *conn,
+                                                const gchar *sender,
+                                                const gchar *obj_path,
+                                                const gchar *intf_name,
+                                                const gchar *property_name,
+                                                GError **error)
+        {
+            DBusCallStats::Timer timer(DBusCallStats::Kind::GET_PROPERTY,
+                                       intf_name, property_name);
+            try
+            {
+                GVariant *ret = obj->callback_property_dispatch(conn, sender, obj_path,
+                                                                intf_name, property_name,
+                                                                error);
+                timer.Finish(NULL == ret);
+                return ret;
+            }
+            catch (DBusPropertyException& err)
+            {
+                timer.Finish(true);
+                err.SetDBusError(error);
+                return NULL;
+            }
+            catch (...)
+            {
+                timer.Finish(true);
+                throw;
+            }
+        }
+
+
+        static gboolean set_property_internal(DBusObject *obj,
+                                              GDBusConnection *conn,
+                                              const gchar *sender,
+                                              const gchar *obj_path,
+                                              const gchar *intf_name,
+                                              const gchar *property_name,
+                                              GVariant *value,
+                                              GError **error)
+        {
+            DBusCallStats::Timer timer(DBusCallStats::Kind::SET_PROPERTY,
+                                       intf_name, property_name);
+            try
+            {
+                gboolean ret = obj->_dbus_set_property_internal(conn, sender,
+                                                                obj_path, intf_name,
+                                                                property_name, value,
+                                                                error);
+                timer.Finish(!ret && error && *error);
+                return ret;
+            }
+            catch (...)
+            {
+                timer.Finish(true);
+                throw;
+            }
         }
     };
 };
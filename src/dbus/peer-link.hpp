@@ -0,0 +1,339 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   peer-link.hpp
+ *
+ * @brief  Private peer-to-peer D-Bus connections between two processes
+ *         which already know each other via the system bus.
+ *
+ *         One side creates a socket pair and hands one end over to an
+ *         object on the bus via a method call carrying the file
+ *         descriptor.  Both ends then run a D-Bus connection directly on
+ *         the socket.  Messages on such a link never pass the D-Bus
+ *         daemon, and there are no bus names; method calls and signals
+ *         have no sender or destination.
+ */
+
+#ifndef OPENVPN3_DBUS_PEERLINK_HPP
+#define OPENVPN3_DBUS_PEERLINK_HPP
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+#include <gio/gunixfdlist.h>
+
+#include "dbus/exceptions.hpp"
+
+
+namespace openvpn
+{
+    class DBusPeerLink
+    {
+    public:
+        /**
+         *  Called when a link opened via Open() or accepted via Accept()
+         *  is ready
+         *
+         * @param link   The new GDBusConnection, owned by the callee.
+         *               nullptr if the link could not be established.
+         * @param error  std::string describing the error when the link
+         *               could not be established
+         */
+        typedef std::function<void(GDBusConnection *link,
+                                   const std::string& error)> ReadyCallback;
+
+
+        /**
+         *  Opens a peer link to an object on the bus.  The method called
+         *  must take a single file handle argument and complete the
+         *  call by passing it to Accept().  The link is set up in the
+         *  background; nothing here blocks the main loop.
+         *
+         *  The link is given to the ready callback before it starts
+         *  processing messages, so signal subscriptions can be moved to
+         *  the link first.
+         *
+         * @param busconn     GDBusConnection to the bus the object is on
+         * @param busname     Bus name of the object
+         * @param objpath     D-Bus object path of the object
+         * @param interf      D-Bus interface of the method
+         * @param method      Name of the method taking the file descriptor
+         * @param cancel      GCancellable the caller can use to abort the
+         *                    setup.  It is also cancelled on timeouts.
+         * @param timeout_ms  Time in milliseconds the whole setup may take
+         * @param ready       ReadyCallback called from the main loop when
+         *                    the link is established or has failed.  The
+         *                    callback is not called if the caller
+         *                    cancelled the setup.
+         */
+        static void Open(GDBusConnection *busconn,
+                         const std::string& busname,
+                         const std::string& objpath,
+                         const std::string& interf,
+                         const std::string& method,
+                         GCancellable *cancel,
+                         int timeout_ms,
+                         ReadyCallback ready)
+        {
+            int fds[2];
+            if (0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds))
+            {
+                THROW_DBUSEXCEPTION("DBusPeerLink",
+                                    "Could not create socket pair: "
+                                    + std::string(strerror(errno)));
+            }
+
+            OpenRequest *req = new OpenRequest(fds[0], cancel, ready);
+            req->timer = g_timeout_add(timeout_ms, open_timeout, req);
+
+            // The fd list takes over the remote end of the socket pair
+            GUnixFDList *fdlist = g_unix_fd_list_new_from_array(&fds[1], 1);
+            g_dbus_connection_call_with_unix_fd_list(busconn,
+                                                     busname.c_str(),
+                                                     objpath.c_str(),
+                                                     interf.c_str(),
+                                                     method.c_str(),
+                                                     g_variant_new("(h)", 0),
+                                                     NULL,
+                                                     G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                                     timeout_ms,
+                                                     fdlist,
+                                                     cancel,
+                                                     open_call_done,
+                                                     req);
+            g_object_unref(fdlist);
+        }
+
+
+        /**
+         *  Accepts a peer link handed over by Open().  The method call is
+         *  completed right away, while the link is established in the
+         *  background.  Messages arriving on the link are not processed
+         *  before the ready callback has returned, so it can register
+         *  the objects to provide on the link first.
+         *
+         * @param invoc   GDBusMethodInvocation of the method call
+         * @param params  GVariant with the method arguments, a single
+         *                file handle
+         * @param ready   ReadyCallback called from the main loop when the
+         *                link is established or has failed
+         */
+        static void Accept(GDBusMethodInvocation *invoc, GVariant *params,
+                           ReadyCallback ready)
+        {
+            gint idx = -1;
+            g_variant_get(params, "(h)", &idx);
+
+            GError *error = nullptr;
+            GDBusMessage *msg = g_dbus_method_invocation_get_message(invoc);
+            GUnixFDList *fdlist = g_dbus_message_get_unix_fd_list(msg);
+            int fd = (fdlist ? g_unix_fd_list_get(fdlist, idx, &error) : -1);
+            GSocket *sock = (fd >= 0 ? g_socket_new_from_fd(fd, &error) : NULL);
+            if (!sock)
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                if (error)
+                {
+                    g_dbus_method_invocation_return_gerror(invoc, error);
+                    g_error_free(error);
+                }
+                else
+                {
+                    g_dbus_method_invocation_return_dbus_error(invoc,
+                                                               "net.openvpn.v3.error.peerlink",
+                                                               "No file descriptor received");
+                }
+                return;
+            }
+            GSocketConnection *stream = g_socket_connection_factory_create_connection(sock);
+            g_object_unref(sock);
+
+            g_dbus_connection_new(G_IO_STREAM(stream),
+                                  NULL,
+                                  (GDBusConnectionFlags) (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+                                                          | G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING),
+                                  NULL,
+                                  NULL,
+                                  link_established,
+                                  new ReadyCallback(ready));
+            g_object_unref(stream);
+            g_dbus_method_invocation_return_value(invoc, NULL);
+        }
+
+
+    private:
+        /**
+         *  State of a link being set up by Open()
+         */
+        struct OpenRequest
+        {
+            OpenRequest(int fd, GCancellable *cancel, ReadyCallback ready)
+                : fd(fd),
+                  cancel(G_CANCELLABLE(g_object_ref(cancel))),
+                  ready(ready)
+            {
+            }
+
+            ~OpenRequest()
+            {
+                if (timer > 0)
+                {
+                    g_source_remove(timer);
+                }
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+                g_object_unref(cancel);
+            }
+
+            int fd;
+            GCancellable *cancel;
+            ReadyCallback ready;
+            guint timer = 0;
+            bool timed_out = false;
+        };
+
+
+        static gboolean open_timeout(gpointer data)
+        {
+            OpenRequest *req = (OpenRequest *) data;
+            req->timer = 0;
+            req->timed_out = true;
+            g_cancellable_cancel(req->cancel);
+            return G_SOURCE_REMOVE;
+        }
+
+
+        static void open_call_done(GObject *source, GAsyncResult *res,
+                                   gpointer data)
+        {
+            OpenRequest *req = (OpenRequest *) data;
+            GError *error = nullptr;
+            GVariant *ret = g_dbus_connection_call_with_unix_fd_list_finish(G_DBUS_CONNECTION(source),
+                                                                            NULL,
+                                                                            res,
+                                                                            &error);
+            if (!ret)
+            {
+                open_complete(req, nullptr, "Peer link request failed", error);
+                return;
+            }
+            g_variant_unref(ret);
+
+            GSocket *sock = g_socket_new_from_fd(req->fd, &error);
+            if (!sock)
+            {
+                open_complete(req, nullptr, "Invalid socket", error);
+                return;
+            }
+            req->fd = -1;  // Now owned by sock
+            GSocketConnection *stream = g_socket_connection_factory_create_connection(sock);
+            g_object_unref(sock);
+
+            gchar *guid = g_dbus_generate_guid();
+            g_dbus_connection_new(G_IO_STREAM(stream),
+                                  guid,
+                                  (GDBusConnectionFlags) (G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_SERVER
+                                                          | G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING),
+                                  NULL,
+                                  req->cancel,
+                                  open_link_done,
+                                  req);
+            g_free(guid);
+            g_object_unref(stream);
+        }
+
+
+        static void open_link_done(GObject *source, GAsyncResult *res,
+                                   gpointer data)
+        {
+            OpenRequest *req = (OpenRequest *) data;
+            GError *error = nullptr;
+            GDBusConnection *link = g_dbus_connection_new_finish(res, &error);
+            open_complete(req, link, "Could not establish the link", error);
+        }
+
+
+        static void open_complete(OpenRequest *req, GDBusConnection *link,
+                                  const std::string& msg, GError *error)
+        {
+            if (g_cancellable_is_cancelled(req->cancel) && !req->timed_out)
+            {
+                // The caller has given up on this link
+                if (link)
+                {
+                    g_dbus_connection_close(link, NULL, NULL, NULL);
+                    g_object_unref(link);
+                }
+            }
+            else if (link)
+            {
+                req->ready(link, "");
+                g_dbus_connection_start_message_processing(link);
+            }
+            else
+            {
+                req->ready(nullptr,
+                           msg + ": " + (req->timed_out ? "Timed out"
+                                         : (error ? error->message : "(unknown)")));
+            }
+            if (error)
+            {
+                g_error_free(error);
+            }
+            delete req;
+        }
+
+
+        static void link_established(GObject *source, GAsyncResult *res,
+                                     gpointer data)
+        {
+            ReadyCallback *ready = (ReadyCallback *) data;
+            GError *error = nullptr;
+            GDBusConnection *link = g_dbus_connection_new_finish(res, &error);
+            if (link)
+            {
+                (*ready)(link, "");
+                g_dbus_connection_start_message_processing(link);
+            }
+            else
+            {
+                (*ready)(nullptr, (error ? error->message : "(unknown)"));
+            }
+            if (error)
+            {
+                g_error_free(error);
+            }
+            delete ready;
+        }
+    };
+};
+
+#endif // OPENVPN3_DBUS_PEERLINK_HPP
@@ -20,6 +20,16 @@
 #ifndef OPENVPN3_DBUS_PROXY_HPP
 #define OPENVPN3_DBUS_PROXY_HPP
 
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "readiness.hpp"
+#include "signal-router.hpp"
+
 namespace openvpn
 {
     class DBusProxyAccessDeniedException: std::exception
@@ -49,6 +59,19 @@ namespace openvpn
     };
 
 
+    /**
+     *  Client side access to a D-Bus object.  The GDBusProxy used for
+     *  method calls is only created on the first call, and properties are
+     *  read and written by calling the org.freedesktop.DBus.Properties
+     *  methods directly on the connection.  Creating a DBusProxy object is
+     *  therefore cheap; it does not cause any D-Bus traffic by itself.
+     *
+     *  All DBusProxy objects created from a GBusType share the same
+     *  process-wide connection to that bus, as provided by g_bus_get_sync().
+     *
+     *  The hold_setup_proxy constructor argument is kept for compatibility
+     *  only; proxies are always prepared when needed.
+     */
     class DBusProxy : public DBus
     {
     public:
@@ -57,19 +80,18 @@ namespace openvpn
                   std::string const & interf,
                   std::string const & objpath)
             : DBus(bus_type),
-              proxy(nullptr),
-              property_proxy(nullptr),
               bus_name(busname),
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
-              proxy_init(false),
-              property_proxy_init(false)
+              proxy(nullptr),
+              property_cache_subscr(0),
+              property_cache_all(false),
+              property_cache_ttl(0),
+              property_cache_ctx(nullptr),
+              property_snapshot_valid(false)
         {
-            proxy = SetupProxy(bus_name, interface, object_path);
-            property_proxy = SetupProxy(bus_name,
-                                        "org.freedesktop.DBus.Properties",
-                                        object_path);
+            Connect();
         }
 
 
@@ -79,22 +101,18 @@ namespace openvpn
                   std::string const & objpath,
                   bool hold_setup_proxy)
             : DBus(bus_type),
-              proxy(nullptr),
-              property_proxy(nullptr),
               bus_name(busname),
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
-              proxy_init(false),
-              property_proxy_init(false)
+              proxy(nullptr),
+              property_cache_subscr(0),
+              property_cache_all(false),
+              property_cache_ttl(0),
+              property_cache_ctx(nullptr),
+              property_snapshot_valid(false)
         {
-            if (!hold_setup_proxy)
-            {
-                proxy = SetupProxy(bus_name, interface, object_path);
-                property_proxy = SetupProxy(bus_name,
-                                            "org.freedesktop.DBus.Properties",
-                                            object_path);
-            }
+            Connect();
         }
 
 
@@ -103,19 +121,18 @@ namespace openvpn
                   std::string const & interf,
                   std::string const & objpath)
             : DBus(dbusconn),
-              proxy(nullptr),
-              property_proxy(nullptr),
               bus_name(busname),
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
-              proxy_init(false),
-              property_proxy_init(false)
+              proxy(nullptr),
+              property_cache_subscr(0),
+              property_cache_all(false),
+              property_cache_ttl(0),
+              property_cache_ctx(nullptr),
+              property_snapshot_valid(false)
         {
-            proxy = SetupProxy(bus_name, interface, object_path);
-            property_proxy = SetupProxy(bus_name,
-                                        "org.freedesktop.DBus.Properties",
-                                        object_path);
+            Connect();
         }
 
 
@@ -125,22 +142,18 @@ namespace openvpn
                   std::string const & objpath,
                   bool hold_setup_proxy)
             : DBus(dbusconn),
-              proxy(nullptr),
-              property_proxy(nullptr),
               bus_name(busname),
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
-              proxy_init(false),
-              property_proxy_init(false)
+              proxy(nullptr),
+              property_cache_subscr(0),
+              property_cache_all(false),
+              property_cache_ttl(0),
+              property_cache_ctx(nullptr),
+              property_snapshot_valid(false)
         {
-            if (!hold_setup_proxy)
-            {
-                proxy = SetupProxy(bus_name, interface, object_path);
-                property_proxy = SetupProxy(bus_name,
-                                            "org.freedesktop.DBus.Properties",
-                                            object_path);
-            }
+            Connect();
         }
 
 
@@ -149,19 +162,18 @@ namespace openvpn
                   std::string const & interf,
                   std::string const & objpath)
             : DBus(dbusobj),
-              proxy(nullptr),
-              property_proxy(nullptr),
               bus_name(busname),
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
-              proxy_init(false),
-              property_proxy_init(false)
+              proxy(nullptr),
+              property_cache_subscr(0),
+              property_cache_all(false),
+              property_cache_ttl(0),
+              property_cache_ctx(nullptr),
+              property_snapshot_valid(false)
         {
-            proxy = SetupProxy(bus_name, interface, object_path);
-            property_proxy = SetupProxy(bus_name,
-                                        "org.freedesktop.DBus.Properties",
-                                        object_path);
+            Connect();
         }
 
 
@@ -171,44 +183,31 @@ namespace openvpn
                   std::string const & objpath,
                   bool hold_setup_proxy)
             : DBus(dbusobj),
-              proxy(nullptr),
-              property_proxy(nullptr),
               bus_name(busname),
               interface(interf),
               object_path(objpath),
               call_flags(G_DBUS_CALL_FLAGS_NONE),
-              proxy_init(false),
-              property_proxy_init(false)
+              proxy(nullptr),
+              property_cache_subscr(0),
+              property_cache_all(false),
+              property_cache_ttl(0),
+              property_cache_ctx(nullptr),
+              property_snapshot_valid(false)
         {
-            if( !hold_setup_proxy )
-            {
-                proxy = SetupProxy(bus_name, interface, object_path);
-                property_proxy = SetupProxy(bus_name,
-                                            "org.freedesktop.DBus.Properties",
-                                            object_path);
-            }
+            Connect();
         }
 
 
         virtual ~DBusProxy()
         {
-            // If this object is using an existing connection;
-            // don't trigger a disconnect.  This variable is
-            // defined and set in the DBus class.
-            if (keep_connection)
-            {
-                return;
-            }
+            DisablePropertyCache();
 
-            if (proxy_init)
+            // The proxy is owned by this object, regardless of
+            // whether the D-Bus connection is shared or not
+            if (proxy)
             {
                 g_object_unref(proxy);
             }
-
-            if (property_proxy_init)
-            {
-                g_object_unref(property_proxy);
-            }
         }
 
 
@@ -218,18 +217,57 @@ namespace openvpn
         }
 
 
+        /**
+         *  Retrieve the D-Bus object path this proxy accesses
+         *
+         * @return  Returns std::string with the object path
+         */
+        std::string GetObjectPath() const
+        {
+            return object_path;
+        }
+
+
+        /**
+         *  Waits until the service providing the object is available on
+         *  the bus, starting it via D-Bus activation if needed.  This
+         *  returns as soon as the bus name of the service has an owner.
+         *
+         * @param timeout  std::chrono::milliseconds how long to wait
+         *
+         * @return Returns true if the service is available, false if the
+         *         timeout expired first.
+         */
+        bool WaitForService(std::chrono::milliseconds timeout
+                                = std::chrono::seconds(10))
+        {
+            if (bus_name.empty())
+            {
+                // Peer-to-peer links have no bus names; the
+                // other end is there as long as the link is
+                return true;
+            }
+            return DBusNameWait::WaitFor(GetConnection(), bus_name, timeout,
+                                         !(call_flags & G_DBUS_CALL_FLAGS_NO_AUTO_START));
+        }
+
+
         /**
          *  Some service expose a 'version' property in the main manager
-         *  object.  This retrieves this but has a retry logic in case the
-         *  service did not start up quickly enough.
+         *  object.  This retrieves this.  If the service is not available
+         *  yet, it waits for the service to appear on the bus first.
+         *
+         * @param timeout  std::chrono::milliseconds how long to wait
+         *                 for the service
          *
          * @return  Returns a string containing the version of the service
          *
          */
-        std::string GetServiceVersion()
+        std::string GetServiceVersion(std::chrono::milliseconds timeout
+                                          = std::chrono::seconds(10))
         {
-            int delay = 1;
-            for (int attempts = 10; attempts > 0; --attempts)
+            std::chrono::milliseconds delay(10);
+            for (int attempts = 5; attempts > 0; --attempts)
             {
                 try
                 {
@@ -238,80 +276,164 @@ namespace openvpn
                 catch (DBusException& excp)
                 {
                     std::string err(excp.what());
-                    if (err.find("GDBus.Error:org.freedesktop.DBus.Error.UnknownMethod:") == std::string::npos)
+                    if (err.find("DBus.Error.InvalidArgs: No such property 'version'") != std::string::npos)
+                    {
+                        return std::string("");  // Consider this as an unkwown version but not an error
+                    }
+                    if (!service_unavailable(err) || 1 == attempts)
                     {
-                        if (err.find("DBus.Error.InvalidArgs: No such property 'version'") != std::string::npos)
-                        {
-                            return std::string("");  // Consider this as an unkwown version but not an error
-                        }
                         throw;
                     }
-                    sleep(delay);
-                    ++delay;
                 }
+
+                if (!WaitForService(timeout))
+                {
+                    break;
+                }
+
+                // Services register their objects right after requesting
+                // the bus name, so an object may be missing for a brief
+                // moment after the name appeared
+                std::this_thread::sleep_for(delay);
+                delay *= 2;
             }
-            THROW_DBUSEXCEPTION("OpenVPN3ConfigurationProxy",
-                                "Could not establish connection with the "
-                                "Configuration Manager");
+            THROW_DBUSEXCEPTION("DBusProxy",
+                                "Could not establish connection with "
+                                "the D-Bus service '" + bus_name + "'");
         }
 
 
         /**
-         *  Tries to ping a the destination service.  This is used to
-         *  activate auto-start of services and give it time to settle.
-         *  It will try 3 times with a sleep of 1 second in between.
+         *  Checks that the destination service responds.  This is used to
+         *  activate auto-start of services.  If the service does not
+         *  respond right away, it waits for the service to appear on the
+         *  bus and tries once more.
          *
-         *  If it does not repsond after three attempts, it will
+         *  If it does not respond within the timeout, it will
          *  throw a DBusException.
+         *
+         * @param timeout  std::chrono::milliseconds how long to wait
+         *                 for the service
          */
-        void Ping()
+        void Ping(std::chrono::milliseconds timeout = std::chrono::seconds(10))
         {
-            GDBusProxy *peer_proxy = SetupProxy(bus_name,
-                                               "org.freedesktop.DBus.Peer",
-                                               "/");
-
-            for (int i=0; i < 3; i++)
+            std::string err;
+            if (peer_ping(timeout, err))
             {
-                try
-                {
-                    // The Ping() request does not give any response, but
-                    // we want to make this call synchronous and wait for
-                    // this call to truly have happened.  Then we just
-                    // throw away the empty response, to avoid a memleak.
-                    GVariant *empty = dbus_proxy_call(peer_proxy, "Ping",
-                                                      NULL, false, call_flags);
-                    g_variant_unref(empty);
-                    usleep(400); // Add some additional gracetime
-                    return;
-                }
-                catch (DBusException& excp)
-                {
-                    if (2 == i)
-                    {
-                        THROW_DBUSEXCEPTION("DBusProxy",
-                                            "D-Bus service '"
-                                            + bus_name + "' did not respond");
-                    }
-                    sleep(1);
-                }
+                return;
+            }
+            if (!WaitForService(timeout) || !peer_ping(timeout, err))
+            {
+                THROW_DBUSEXCEPTION("DBusProxy",
+                                    "D-Bus service '" + bus_name
+                                    + "' did not respond"
+                                    + (!err.empty() ? ": " + err : ""));
             }
         }
 
 
         GVariant * Call(std::string method, GVariant *params, bool noresponse = false)
         {
-            return dbus_proxy_call(proxy, method, params, noresponse,
+            return dbus_proxy_call(get_proxy(), method, params, noresponse,
                                    call_flags);
         }
 
 
         GVariant * Call(std::string method, bool noresponse = false)
         {
-            return dbus_proxy_call(proxy, method, NULL, noresponse,
+            return dbus_proxy_call(get_proxy(), method, NULL, noresponse,
                                    call_flags);
         }
 
 
+        /**
+         *  Enables a local cache of the given properties.  Cached values
+         *  are kept up-to-date by the PropertiesChanged signals sent by the
+         *  service, so only properties the service signals changes for
+         *  may be cached.
+         *
+         *  The signals are only processed while a GLib main loop is
+         *  running in the thread-default main context used when this
+         *  method is called.  Whenever no main loop is running there, the
+         *  cache is not used and the properties are read from the service.
+         *
+         * @param props  std::vector<std::string> of property names to cache
+         */
+        void EnablePropertyCache(const std::vector<std::string>& props)
+        {
+            std::lock_guard<std::mutex> guard(property_cache_mtx);
+            for (const auto& p : props)
+            {
+                cached_properties.insert(p);
+            }
+            subscribe_property_changes();
+        }
+
+
+        /**
+         *  Enables a local cache of all the properties of the object.  On
+         *  the first property read, all properties are retrieved with a
+         *  single org.freedesktop.DBus.Properties.GetAll() call and the
+         *  following reads are served from this snapshot until it is
+         *  older than ttl.  Property changes made by others are not
+         *  tracked, as services do not signal changes for all properties.
+         *  This suits short-lived users reading many properties at once,
+         *  like the command line tools.
+         *
+         *  Properties the service did not include in the snapshot, such as
+         *  properties the caller lacks access to, are still retrieved
+         *  one by one.
+         *
+         * @param ttl  std::chrono::milliseconds how long a snapshot is used
+         */
+        void EnablePropertyCacheAll(std::chrono::milliseconds ttl)
+        {
+            if (ttl.count() <= 0)
+            {
+                THROW_DBUSEXCEPTION("DBusProxy",
+                                    "Property snapshots require a ttl");
+            }
+            std::lock_guard<std::mutex> guard(property_cache_mtx);
+            property_cache_all = true;
+            property_cache_ttl = ttl;
+        }
+
+
+        /**
+         *  Discards the local property cache, so the next property read
+         *  retrieves fresh values from the service.  The properties to
+         *  cache remain enabled.
+         */
+        void InvalidatePropertyCache()
+        {
+            std::lock_guard<std::mutex> guard(property_cache_mtx);
+            clear_property_cache();
+        }
+
+
+        /**
+         *  Stops tracking property changes and empties the local
+         *  property cache.
+         */
+        void DisablePropertyCache()
+        {
+            std::lock_guard<std::mutex> guard(property_cache_mtx);
+            if (property_cache_subscr > 0)
+            {
+                DBusSignalRouter::Unsubscribe(property_cache_subscr);
+                property_cache_subscr = 0;
+            }
+            if (property_cache_ctx)
+            {
+                g_main_context_unref(property_cache_ctx);
+                property_cache_ctx = nullptr;
+            }
+            clear_property_cache();
+            cached_properties.clear();
+            property_cache_all = false;
+        }
+
+
         GVariant * GetProperty(std::string property)
         {
             if (property.empty())
@@ -319,41 +441,68 @@ namespace openvpn
                 THROW_DBUSEXCEPTION("DBusProxy", "Property cannot be empty");
             }
 
-            // Use the org.freedesktop.DBus.Properties.Get() method directly
-            // instead of going via a list of cached properties.  The cache
-            // might not be updated and we get the wrong values.
-
-            GError *error = NULL;
-            GVariant *response = g_dbus_proxy_call_sync(property_proxy,
-                                                        "Get",
-                                                        g_variant_new("(ss)",
-                                                                      interface.c_str(),
-                                                                      property.c_str()),
-                                                        G_DBUS_CALL_FLAGS_NONE,
-                                                        -1,          // timeout, -1 == default
-                                                        NULL,        // GCancellable
-                                                        &error);
-            if (!response && !error)
+            bool cacheable = false;
+            bool fetch_all = false;
             {
-                THROW_DBUSEXCEPTION("DBusProxy", "Unspecified error");
+                std::lock_guard<std::mutex> guard(property_cache_mtx);
+                if (property_cache_all)
+                {
+                    cacheable = true;
+                    fetch_all = !property_snapshot_valid
+                                || (std::chrono::steady_clock::now()
+                                    - property_snapshot_time
+                                    >= property_cache_ttl);
+                }
+                else if (cached_properties.find(property)
+                         != cached_properties.end())
+                {
+                    // Changes may have been missed while no main loop
+                    // processed the PropertiesChanged signals
+                    cacheable = property_changes_processed();
+                    if (!cacheable)
+                    {
+                        clear_property_cache();
+                    }
+                }
+                if (cacheable && !fetch_all)
+                {
+                    auto it = property_cache.find(property);
+                    if (property_cache.end() != it)
+                    {
+                        return g_variant_ref(it->second);
+                    }
+                }
             }
-            else if (!response && error)
+
+            if (fetch_all)
             {
-                std::string dbuserr(error->message);
+                fetch_all_properties();
 
-                if (dbuserr.find("GDBus.Error:org.freedesktop.DBus.Error.AccessDenied:") != std::string::npos)
+                std::lock_guard<std::mutex> guard(property_cache_mtx);
+                auto it = property_cache.find(property);
+                if (property_cache.end() != it)
                 {
-                    throw DBusProxyAccessDeniedException(property + " property",
-                                                         dbuserr);
+                    return g_variant_ref(it->second);
                 }
+            }
 
-                std::stringstream errmsg;
-                errmsg << "Failed retrieveing property value for "
-                       << "'" << property << "': " << error->message;
-                THROW_DBUSEXCEPTION("DBusProxy", errmsg.str());
-            }            GVariant * ret = NULL;
+            // Use the org.freedesktop.DBus.Properties.Get() method directly
+            // instead of going via a list of cached properties.  The cache
+            // might not be updated and we get the wrong values.
+            GVariant *response = properties_call("Get",
+                                                 g_variant_new("(ss)",
+                                                               interface.c_str(),
+                                                               property.c_str()),
+                                                 property,
+                                                 "Failed retrieveing property value for");
+            GVariant * ret = NULL;
             g_variant_get(response, "(v)", &ret);
             g_variant_unref(response);
+
+            if (cacheable)
+            {
+                update_property_cache(property, ret);
+            }
             return ret;
         }
 
@@ -401,43 +550,21 @@ namespace openvpn
             {
                 THROW_DBUSEXCEPTION("DBusProxy", "Property cannot be empty");
             }
+            update_property_cache(property, NULL);
 
             // NOTE:
             // It is tempting to consider using g_dbus_proxy_set_cached_property()
             // instead calling org.freedesktop.DBus.Properties.Set() on its own
             // proxy connection.  But that only updates the local cache, the
             // change is never sent to the backend service.
-
-            GError *error = NULL;
-            GVariant *ret = g_dbus_proxy_call_sync(property_proxy,
-                                                   "Set",
-                                                   g_variant_new("(ssv)",
-                                                                 interface.c_str(),
-                                                                 property.c_str(),
-                                                                 value),
-                                                   G_DBUS_CALL_FLAGS_NONE,
-                                                   -1,          // timeout, -1 == default
-                                                   NULL,        // GCancellable
-                                                   &error);
-            if (!ret && !error)
-            {
-                THROW_DBUSEXCEPTION("DBusProxy", "Unspecified error");
-            }
-            else if (!ret && error)
-            {
-                std::string dbuserr(error->message);
-
-                if (dbuserr.find("GDBus.Error:org.freedesktop.DBus.Error.AccessDenied:") != std::string::npos)
-                {
-                    throw DBusProxyAccessDeniedException(property + " property",
-                                                         dbuserr);
-                }
-
-                std::stringstream errmsg;
-                errmsg << "Failed setting new property value on "
-                       << "'" << property << "': " << error->message;
-                THROW_DBUSEXCEPTION("DBusProxy", errmsg.str());
-            }            g_variant_unref(ret);
+            GVariant *ret = properties_call("Set",
+                                            g_variant_new("(ssv)",
+                                                          interface.c_str(),
+                                                          property.c_str(),
+                                                          value),
+                                            property,
+                                            "Failed setting new property value on");
+            g_variant_unref(ret);
         }
 
 
@@ -460,12 +587,36 @@ namespace openvpn
 
 
     protected:
-        GDBusProxy *proxy;
-        GDBusProxy *property_proxy;
+        /**
+         *  Changes the object this proxy accesses.  This is used by
+         *  subclasses which need to look up the object path first.  It
+         *  must be called before the proxy is used.
+         *
+         * @param objpath  std::string with the new D-Bus object path
+         */
+        void SetObjectPath(const std::string& objpath)
+        {
+            std::lock_guard<std::mutex> guard(proxy_mtx);
+            if (proxy)
+            {
+                THROW_DBUSEXCEPTION("DBusProxy",
+                                    "Object path cannot be changed "
+                                    "on a proxy in use");
+            }
+            object_path = objpath;
+        }
+
 
         GDBusProxy * SetupProxy(std::string busn, std::string intf, std::string objp)
         {
-            if (busn.empty()) {
+            // Connect do the D-Bus without a bus name
+            // This is safe to call, multiple times - as DBus::Connect()
+            // checks if a connection is already established
+            Connect();
+
+            // Peer-to-peer connections have no bus names
+            bool peer_link = (NULL == g_dbus_connection_get_unique_name(GetConnection()));
+            if (busn.empty() && !peer_link) {
                 THROW_DBUSEXCEPTION("DBusProxy", "Bus name cannot be empty");
             }
 
@@ -477,11 +628,6 @@ namespace openvpn
                 THROW_DBUSEXCEPTION("DBusProxy", "Object path cannot be empty");
             }
 
-            // Connect do the D-Bus without a bus name
-            // This is safe to call, multiple times - as DBus::Connect()
-            // checks if a connection is already established
-            Connect();
-
             /*
               std::cout << "[DBusProxy::SetupProxy] bus_name=" << busn
                       << ", interface=" << intf
@@ -492,11 +638,14 @@ namespace openvpn
             // Prepare a new D-Bus proxy, which the
             // client side uses when communicating with
             // a D-Bus service
+            // Properties are not cached by GDBus and signals are
+            // subscribed to separately, so neither needs to be set up
             GError *error = NULL;
             GDBusProxy *retprx = g_dbus_proxy_new_sync(GetConnection(),
-                                                       G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES,
+                                                       (GDBusProxyFlags) (G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES
+                                                                          | G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS),
                                                        NULL,             // GDBusInterfaceInfo
-                                                       busn.c_str(),     // aka. destination
+                                                       (busn.empty() ? NULL : busn.c_str()), // aka. destination
                                                        objp.c_str(),
                                                        intf.c_str(),
                                                        NULL,             // GCancellable
@@ -511,14 +660,6 @@ namespace openvpn
                 }
                 THROW_DBUSEXCEPTION("DBusProxy", errmsg.str());
             }
-            if ("org.freedesktop.DBus.Properties" == intf)
-            {
-                property_proxy_init = true;
-            }
-            else
-            {
-                proxy_init = true;
-            }
             return retprx;
         }
 
@@ -534,8 +675,323 @@ namespace openvpn
         std::string interface;
         std::string object_path;
         GDBusCallFlags call_flags;
-        bool proxy_init;
-        bool property_proxy_init;
+        std::mutex proxy_mtx;
+        GDBusProxy *proxy;
+        std::mutex property_cache_mtx;
+        std::set<std::string> cached_properties;
+        std::map<std::string, GVariant *> property_cache;
+        guint property_cache_subscr;
+        bool property_cache_all;
+        std::chrono::milliseconds property_cache_ttl;
+        GMainContext *property_cache_ctx;
+        bool property_snapshot_valid;
+        std::chrono::steady_clock::time_point property_snapshot_time;
+
+
+        /**
+         *  Calls org.freedesktop.DBus.Peer.Ping() in the service.  The
+         *  call does not give any response, but we want to make this
+         *  call synchronous and wait for this call to truly have happened.
+         *
+         * @param timeout  std::chrono::milliseconds to wait for a response
+         * @param err      std::string which will contain the error
+         *                 message on failures
+         *
+         * @return Returns true if the service responded
+         */
+        bool peer_ping(std::chrono::milliseconds timeout, std::string& err)
+        {
+            GError *error = NULL;
+            GVariant *empty = g_dbus_connection_call_sync(GetConnection(),
+                                                          (bus_name.empty() ? NULL : bus_name.c_str()),
+                                                          "/",
+                                                          "org.freedesktop.DBus.Peer",
+                                                          "Ping",
+                                                          NULL,
+                                                          NULL,
+                                                          call_flags,
+                                                          (gint) timeout.count(),
+                                                          NULL,  // GCancellable
+                                                          &error);
+            if (!empty)
+            {
+                err = (error ? error->message : "");
+                if (error)
+                {
+                    g_error_free(error);
+                }
+                return false;
+            }
+            // Throw away the empty response, to avoid a memleak
+            g_variant_unref(empty);
+            return true;
+        }
+
+
+        /**
+         *  Checks if a D-Bus error message indicates that the service
+         *  or its object is not available (yet)
+         */
+        static bool service_unavailable(const std::string& err)
+        {
+            return (err.find("GDBus.Error:org.freedesktop.DBus.Error.ServiceUnknown:") != std::string::npos
+                    || err.find("GDBus.Error:org.freedesktop.DBus.Error.NameHasNoOwner:") != std::string::npos
+                    || err.find("GDBus.Error:org.freedesktop.DBus.Error.UnknownMethod:") != std::string::npos);
+        }
+
+
+        /**
+         *  Retrieves the GDBusProxy used for method calls, which is
+         *  prepared on the first call.
+         */
+        GDBusProxy * get_proxy()
+        {
+            std::lock_guard<std::mutex> guard(proxy_mtx);
+            if (!proxy)
+            {
+                proxy = SetupProxy();
+            }
+            return proxy;
+        }
+
+
+        /**
+         *  Calls a method in the org.freedesktop.DBus.Properties interface
+         *  of the object.
+         *
+         * @param method    std::string with the method to call
+         * @param params    GVariant with the method arguments
+         * @param property  std::string with the property name, used in
+         *                  error messages
+         * @param errprefix std::string prefixing error messages
+         *
+         * @return Returns the GVariant response, which the caller must
+         *         release.  On errors a DBusException or
+         *         DBusProxyAccessDeniedException is thrown.
+         */
+        GVariant * properties_call(const std::string& method, GVariant *params,
+                                   const std::string& property,
+                                   const std::string& errprefix)
+        {
+            if (object_path.empty())
+            {
+                g_variant_unref(g_variant_ref_sink(params));
+                THROW_DBUSEXCEPTION("DBusProxy", "Object path cannot be empty");
+            }
+
+            GError *error = NULL;
+            GVariant *response = g_dbus_connection_call_sync(GetConnection(),
+                                                             (bus_name.empty() ? NULL : bus_name.c_str()),
+                                                             object_path.c_str(),
+                                                             "org.freedesktop.DBus.Properties",
+                                                             method.c_str(),
+                                                             params,
+                                                             NULL,        // reply type, not checked
+                                                             G_DBUS_CALL_FLAGS_NONE,
+                                                             -1,          // timeout, -1 == default
+                                                             NULL,        // GCancellable
+                                                             &error);
+            if (!response && !error)
+            {
+                THROW_DBUSEXCEPTION("DBusProxy", "Unspecified error");
+            }
+            else if (!response && error)
+            {
+                std::string dbuserr(error->message);
+                g_error_free(error);
+
+                if (dbuserr.find("GDBus.Error:org.freedesktop.DBus.Error.AccessDenied:") != std::string::npos)
+                {
+                    throw DBusProxyAccessDeniedException(property + " property",
+                                                         dbuserr);
+                }
+
+                std::stringstream errmsg;
+                errmsg << errprefix << " "
+                       << "'" << property << "': " << dbuserr;
+                THROW_DBUSEXCEPTION("DBusProxy", errmsg.str());
+            }
+            return response;
+        }
+
+
+        /**
+         *  Replaces the local property cache with a snapshot of all the
+         *  properties, retrieved with org.freedesktop.DBus.Properties.GetAll().
+         *  If that fails, the snapshot is left empty and the properties
+         *  are retrieved one by one until it expires.
+         */
+        void fetch_all_properties()
+        {
+            GVariant *response = nullptr;
+            try
+            {
+                response = properties_call("GetAll",
+                                           g_variant_new("(s)",
+                                                         interface.c_str()),
+                                           interface,
+                                           "Failed retrieveing properties of");
+            }
+            catch (DBusException&)
+            {
+            }
+            catch (DBusProxyAccessDeniedException&)
+            {
+            }
+
+            std::lock_guard<std::mutex> guard(property_cache_mtx);
+            clear_property_cache();
+            if (response)
+            {
+                GVariantIter *props = nullptr;
+                g_variant_get(response, "(a{sv})", &props);
+
+                gchar *prop = nullptr;
+                GVariant *value = nullptr;
+                while (g_variant_iter_next(props, "{sv}", &prop, &value))
+                {
+                    // The reference from g_variant_iter_next() is
+                    // handed over to the cache
+                    property_cache[prop] = value;
+                    g_free(prop);
+                }
+                g_variant_iter_free(props);
+                g_variant_unref(response);
+            }
+
+            property_snapshot_valid = true;
+            property_snapshot_time = std::chrono::steady_clock::now();
+        }
+
+
+        /**
+         *  Empties the local property cache.  The caller must
+         *  hold property_cache_mtx.
+         */
+        void clear_property_cache()
+        {
+            for (auto& c : property_cache)
+            {
+                g_variant_unref(c.second);
+            }
+            property_cache.clear();
+            property_snapshot_valid = false;
+        }
+
+
+        /**
+         *  Subscribes to the PropertiesChanged signals of the object,
+         *  unless already done.  The caller must hold property_cache_mtx.
+         */
+        void subscribe_property_changes()
+        {
+            if (0 == property_cache_subscr)
+            {
+                // The signals are processed in this main context
+                property_cache_ctx = g_main_context_ref_thread_default();
+                property_cache_subscr = DBusSignalRouter::Subscribe(
+                                            GetConnection(),
+                                            (bus_name.empty() ? NULL : bus_name.c_str()),
+                                            "org.freedesktop.DBus.Properties",
+                                            "PropertiesChanged",
+                                            object_path.c_str(),
+                                            interface.c_str(),  // arg0
+                                            property_cache_signal,
+                                            this);
+            }
+        }
+
+
+        /**
+         *  Checks if a GLib main loop is running in the main context
+         *  processing the PropertiesChanged signals, which is required
+         *  to keep the property cache up-to-date.  The caller must hold
+         *  property_cache_mtx.
+         */
+        bool property_changes_processed()
+        {
+            if (!property_cache_ctx)
+            {
+                return false;
+            }
+            if (g_main_context_is_owner(property_cache_ctx))
+            {
+                // Called from within the main loop
+                return true;
+            }
+            if (g_main_context_acquire(property_cache_ctx))
+            {
+                // Nobody is running the main loop
+                g_main_context_release(property_cache_ctx);
+                return false;
+            }
+            return true;
+        }
+
+
+        /**
+         *  Updates or removes a value in the local property cache.  Only
+         *  properties enabled via EnablePropertyCache() are stored, unless
+         *  all properties are cached via EnablePropertyCacheAll().
+         *
+         * @param property  std::string with the property name
+         * @param value     GVariant with the new value.  If NULL, the
+         *                  cached value is removed.
+         */
+        void update_property_cache(const std::string& property, GVariant *value)
+        {
+            std::lock_guard<std::mutex> guard(property_cache_mtx);
+            if (!property_cache_all
+                && cached_properties.find(property) == cached_properties.end())
+            {
+                return;
+            }
+
+            auto it = property_cache.find(property);
+            if (property_cache.end() != it)
+            {
+                g_variant_unref(it->second);
+                property_cache.erase(it);
+            }
+            if (value)
+            {
+                property_cache[property] = g_variant_ref(value);
+            }
+        }
+
+
+        static void property_cache_signal(GDBusConnection *conn,
+                                          const gchar *sender,
+                                          const gchar *obj_path,
+                                          const gchar *intf_name,
+                                          const gchar *signal_name,
+                                          GVariant *params,
+                                          gpointer this_ptr)
+        {
+            DBusProxy *prx = (DBusProxy *) this_ptr;
+
+            gchar *intf = nullptr;
+            GVariantIter *changed = nullptr;
+            GVariantIter *invalidated = nullptr;
+            g_variant_get(params, "(sa{sv}as)", &intf, &changed, &invalidated);
+
+            gchar *prop = nullptr;
+            GVariant *value = nullptr;
+            while (g_variant_iter_next(changed, "{sv}", &prop, &value))
+            {
+                prx->update_property_cache(prop, value);
+                g_free(prop);
+                g_variant_unref(value);
+            }
+            while (g_variant_iter_next(invalidated, "s", &prop))
+            {
+                prx->update_property_cache(prop, NULL);
+                g_free(prop);
+            }
+            g_variant_iter_free(changed);
+            g_variant_iter_free(invalidated);
+            g_free(intf);
+        }
 
         GVariant * dbus_proxy_call(GDBusProxy *prx, std::string method,
                                    GVariant *params, bool noresponse,
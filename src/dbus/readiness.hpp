@@ -0,0 +1,183 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   readiness.hpp
+ *
+ * @brief  Helpers for synchronous code which needs to wait for D-Bus
+ *         events, like a service appearing on the bus or a signal
+ *         arriving.  The wait ends as soon as the event is processed,
+ *         bounded by a timeout.
+ */
+
+#ifndef OPENVPN3_DBUS_READINESS_HPP
+#define OPENVPN3_DBUS_READINESS_HPP
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+#include <gio/gio.h>
+
+
+namespace openvpn
+{
+    /**
+     *  A private GMainContext, which is the thread-default context of the
+     *  creating thread while this object exists.  D-Bus signal
+     *  subscriptions and bus name watches set up meanwhile deliver their
+     *  events to this context.  This allows waiting for them without a
+     *  running main loop, and without processing events belonging to
+     *  other contexts.
+     *
+     *  Objects of this class must be destroyed on the thread which
+     *  created them, in the reverse order of their creation.
+     */
+    class DBusWaitContext
+    {
+    public:
+        DBusWaitContext()
+            : ctx(g_main_context_new())
+        {
+            g_main_context_push_thread_default(ctx);
+        }
+
+        ~DBusWaitContext()
+        {
+            // Let GDBus complete any cleanup queued up in this context
+            Flush();
+            g_main_context_pop_thread_default(ctx);
+            g_main_context_unref(ctx);
+        }
+
+        DBusWaitContext(const DBusWaitContext&) = delete;
+        DBusWaitContext& operator=(const DBusWaitContext&) = delete;
+
+
+        /**
+         *  Processes events in this context until the done function
+         *  returns true or the timeout expires.
+         *
+         * @param done     Function checking if the wait is over, called
+         *                 after each processed event
+         * @param timeout  std::chrono::milliseconds how long to wait
+         *
+         * @return Returns true if done returned true, otherwise false
+         */
+        bool Wait(std::function<bool()> done,
+                  std::chrono::milliseconds timeout)
+        {
+            if (done())
+            {
+                return true;
+            }
+
+            bool expired = false;
+            GSource *timer = g_timeout_source_new(timeout.count());
+            g_source_set_callback(timer, timer_expired, &expired, NULL);
+            g_source_attach(timer, ctx);
+
+            bool ret = false;
+            while (!(ret = done()) && !expired)
+            {
+                g_main_context_iteration(ctx, TRUE);
+            }
+            g_source_destroy(timer);
+            g_source_unref(timer);
+            return ret;
+        }
+
+
+        /**
+         *  Processes all events already queued up in this context,
+         *  without waiting for more.
+         */
+        void Flush()
+        {
+            while (g_main_context_iteration(ctx, FALSE))
+            {
+            }
+        }
+
+
+    private:
+        GMainContext *ctx;
+
+        static gboolean timer_expired(gpointer data)
+        {
+            *((bool *) data) = true;
+            return G_SOURCE_REMOVE;
+        }
+    };
+
+
+
+    /**
+     *  Waits for a bus name to get an owner
+     */
+    class DBusNameWait
+    {
+    public:
+        /**
+         *  Waits until a bus name has an owner on the bus.  This returns
+         *  right away if the name is already owned.
+         *
+         * @param conn       GDBusConnection to the bus
+         * @param busname    Bus name to wait for
+         * @param timeout    std::chrono::milliseconds how long to wait
+         * @param autostart  If true, the service owning the name is
+         *                   started via D-Bus activation if needed
+         *
+         * @return Returns true if the name is owned, false if the timeout
+         *         expired first.
+         */
+        static bool WaitFor(GDBusConnection *conn, const std::string& busname,
+                            std::chrono::milliseconds timeout,
+                            bool autostart = true)
+        {
+            // Declared before the wait context, which is flushed
+            // when destroyed
+            bool appeared = false;
+
+            DBusWaitContext waitctx;
+            guint watch = g_bus_watch_name_on_connection(conn,
+                                                         busname.c_str(),
+                                                         (autostart ? G_BUS_NAME_WATCHER_FLAGS_AUTO_START
+                                                                    : G_BUS_NAME_WATCHER_FLAGS_NONE),
+                                                         name_appeared,
+                                                         NULL,
+                                                         &appeared,
+                                                         NULL);
+            bool ret = waitctx.Wait([&appeared]() { return appeared; },
+                                    timeout);
+            g_bus_unwatch_name(watch);
+            return ret;
+        }
+
+
+    private:
+        static void name_appeared(GDBusConnection *conn, const gchar *name,
+                                  const gchar *name_owner, gpointer data)
+        {
+            *((bool *) data) = true;
+        }
+    };
+};
+
+#endif // OPENVPN3_DBUS_READINESS_HPP
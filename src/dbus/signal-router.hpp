@@ -0,0 +1,631 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   signal-router.hpp
+ *
+ * @brief  Routes D-Bus signals to their subscribers in-process.
+ *
+ *         Each GDBus signal subscription installs a match rule in the
+ *         D-Bus daemon, which is checked for every message passing the
+ *         bus.  The DBusSignalRouter instead subscribes once per D-Bus
+ *         interface on each connection, and finds the subscribers of a
+ *         signal via a hash table lookup on the sender, object path and
+ *         signal name.  Adding and removing a subscription is then a
+ *         local operation.
+ *
+ *         Subscriptions to well-known bus names are matched against the
+ *         current owner of the name, which the router tracks with one
+ *         NameOwnerChanged match rule per name.
+ */
+
+#ifndef OPENVPN3_DBUS_SIGNALROUTER_HPP
+#define OPENVPN3_DBUS_SIGNALROUTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <gio/gio.h>
+
+#include <openvpn/common/rc.hpp>
+
+
+namespace openvpn
+{
+    /**
+     *  The subscriptions of a single D-Bus interface, indexed on the
+     *  sender, object path and signal name.  Empty strings in a
+     *  subscription match any value.
+     */
+    class DBusSignalRouteTable
+    {
+    public:
+        struct Route
+        {
+            std::string sender;
+            std::string path;
+            std::string member;
+            std::string arg0;
+            GDBusSignalCallback callback;
+            gpointer user_data;
+        };
+
+
+        void Add(guint id, const Route& route)
+        {
+            index[make_key(route.sender, route.path, route.member)].push_back(id);
+            routes[id] = route;
+        }
+
+
+        /**
+         *  Removes a subscription
+         *
+         * @return Returns true if the subscription was found
+         */
+        bool Remove(guint id)
+        {
+            auto r = routes.find(id);
+            if (routes.end() == r)
+            {
+                return false;
+            }
+            auto it = index.find(make_key(r->second.sender,
+                                          r->second.path,
+                                          r->second.member));
+            if (index.end() != it)
+            {
+                auto& ids = it->second;
+                ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+                if (ids.empty())
+                {
+                    index.erase(it);
+                }
+            }
+            routes.erase(r);
+            return true;
+        }
+
+
+        bool Get(guint id, Route& route) const
+        {
+            auto r = routes.find(id);
+            if (routes.end() == r)
+            {
+                return false;
+            }
+            route = r->second;
+            return true;
+        }
+
+
+        bool Empty() const
+        {
+            return routes.empty();
+        }
+
+
+        /**
+         *  Finds the subscriptions matching a signal
+         *
+         * @param senders  All the names of the sender; its unique bus name
+         *                 and the well-known names it owns
+         * @param path     Object path of the signal
+         * @param member   Signal name
+         * @param arg0     First argument of the signal, if it is a string
+         *
+         * @return Returns the subscription IDs in the order they were
+         *         subscribed
+         */
+        std::vector<guint> Match(const std::vector<std::string>& senders,
+                                 const std::string& path,
+                                 const std::string& member,
+                                 const std::string& arg0) const
+        {
+            std::vector<guint> ret;
+            std::vector<std::string> snd(senders);
+            snd.push_back("");
+
+            for (const auto& s : snd)
+            {
+                for (const auto& p : {path, std::string()})
+                {
+                    for (const auto& m : {member, std::string()})
+                    {
+                        auto it = index.find(make_key(s, p, m));
+                        if (index.end() == it)
+                        {
+                            continue;
+                        }
+                        for (const auto& id : it->second)
+                        {
+                            const Route& r = routes.at(id);
+                            if (r.arg0.empty() || r.arg0 == arg0)
+                            {
+                                ret.push_back(id);
+                            }
+                        }
+                    }
+                }
+            }
+
+            // An empty path or signal name is looked up twice
+            std::sort(ret.begin(), ret.end());
+            ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+            return ret;
+        }
+
+
+    private:
+        std::unordered_map<std::string, std::vector<guint>> index;
+        std::map<guint, Route> routes;
+
+        static std::string make_key(const std::string& sender,
+                                    const std::string& path,
+                                    const std::string& member)
+        {
+            // A newline is not valid in any of these names
+            return sender + '\n' + path + '\n' + member;
+        }
+    };
+
+
+
+    /**
+     *  Signal router for one D-Bus connection and one GMainContext.  The
+     *  callbacks are run in the thread-default main context of the thread
+     *  subscribing, as with g_dbus_connection_signal_subscribe().
+     */
+    class DBusSignalRouter : public RC<thread_safe_refcount>
+    {
+    public:
+        typedef RCPtr<DBusSignalRouter> Ptr;
+
+
+        /**
+         *  Subscribes to a signal.  The arguments are the same as for
+         *  g_dbus_connection_signal_subscribe(); NULL matches any value.
+         *
+         * @return Returns the subscription ID, to be passed to
+         *         Unsubscribe()
+         */
+        static guint Subscribe(GDBusConnection *conn,
+                               const gchar *sender,
+                               const gchar *interf,
+                               const gchar *member,
+                               const gchar *path,
+                               const gchar *arg0,
+                               GDBusSignalCallback callback,
+                               gpointer user_data)
+        {
+            Ptr router = get_router(conn);
+            guint id = router->add(sender, interf, member, path, arg0,
+                                   callback, user_data);
+
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg.mtx);
+            reg.owners[id] = router;
+            return id;
+        }
+
+
+        /**
+         *  Removes a subscription.  Once this returns, the callback is
+         *  not called for this subscription any more.
+         */
+        static void Unsubscribe(guint id)
+        {
+            Ptr router;
+            {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> guard(reg.mtx);
+                auto it = reg.owners.find(id);
+                if (reg.owners.end() == it)
+                {
+                    return;
+                }
+                router = it->second;
+                reg.owners.erase(it);
+            }
+            router->remove(id);
+        }
+
+
+        ~DBusSignalRouter()
+        {
+            g_main_context_unref(context);
+            g_object_unref(conn);
+        }
+
+
+    private:
+        typedef std::pair<GDBusConnection *, GMainContext *> RouterKey;
+
+        struct Registry
+        {
+            std::mutex mtx;
+            std::map<RouterKey, Ptr> routers;
+            std::map<guint, Ptr> owners;
+        };
+
+        /**
+         *  Passed to the GDBus subscriptions of the router, and released
+         *  by GDBus once the subscription is gone
+         */
+        struct RuleData
+        {
+            Ptr router;
+            std::string name;
+        };
+
+        struct Interface
+        {
+            guint rule_id = 0;
+            DBusSignalRouteTable table;
+        };
+
+        struct NameOwner
+        {
+            guint rule_id = 0;
+            unsigned int refs = 0;
+            std::string owner;
+            bool updated = false;
+        };
+
+        GDBusConnection *conn;
+        GMainContext *context;
+        std::mutex mtx;
+        std::map<std::string, Interface> interfaces;
+        std::map<guint, std::string> route_interfaces;
+        std::map<std::string, NameOwner> names;
+
+
+        DBusSignalRouter(GDBusConnection *c, GMainContext *ctx)
+            : conn((GDBusConnection *) g_object_ref(c)),
+              context(g_main_context_ref(ctx))
+        {
+        }
+
+
+        static Registry& registry()
+        {
+            static Registry reg;
+            return reg;
+        }
+
+
+        static guint next_id()
+        {
+            static std::atomic<guint> id(0);
+            return ++id;
+        }
+
+
+        static std::string str(const gchar *s)
+        {
+            return (s ? std::string(s) : "");
+        }
+
+
+        static Ptr get_router(GDBusConnection *conn)
+        {
+            GMainContext *ctx = g_main_context_ref_thread_default();
+            Ptr router;
+            {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> guard(reg.mtx);
+                auto it = reg.routers.find(RouterKey(conn, ctx));
+                if (reg.routers.end() != it)
+                {
+                    router = it->second;
+                }
+                else
+                {
+                    router.reset(new DBusSignalRouter(conn, ctx));
+                    reg.routers[RouterKey(conn, ctx)] = router;
+                }
+            }
+            g_main_context_unref(ctx);
+            return router;
+        }
+
+
+        /**
+         *  Well-known bus names are resolved to the unique bus name of
+         *  the owner before matching.  Peer-to-peer connections have no
+         *  bus names at all.
+         */
+        bool is_well_known(const std::string& name) const
+        {
+            return !name.empty() && ':' != name[0]
+                   && "org.freedesktop.DBus" != name
+                   && NULL != g_dbus_connection_get_unique_name(conn);
+        }
+
+
+        guint add(const gchar *sender, const gchar *interf,
+                  const gchar *member, const gchar *path, const gchar *arg0,
+                  GDBusSignalCallback callback, gpointer user_data)
+        {
+            DBusSignalRouteTable::Route route;
+            route.sender = str(sender);
+            route.path = str(path);
+            route.member = str(member);
+            route.arg0 = str(arg0);
+            route.callback = callback;
+            route.user_data = user_data;
+            std::string intf = str(interf);
+
+            if (is_well_known(route.sender))
+            {
+                watch_name(route.sender);
+            }
+
+            guint id = next_id();
+            std::lock_guard<std::mutex> guard(mtx);
+            Interface& iface = interfaces[intf];
+            if (0 == iface.rule_id)
+            {
+                iface.rule_id = g_dbus_connection_signal_subscribe(conn,
+                                                                   NULL,
+                                                                   (intf.empty() ? NULL : intf.c_str()),
+                                                                   NULL,
+                                                                   NULL,
+                                                                   NULL,
+                                                                   G_DBUS_SIGNAL_FLAGS_NONE,
+                                                                   route_signal,
+                                                                   new RuleData{Ptr(this), intf},
+                                                                   release_rule_data);
+            }
+            iface.table.Add(id, route);
+            route_interfaces[id] = intf;
+            return id;
+        }
+
+
+        void remove(guint id)
+        {
+            std::string sender;
+            bool empty = false;
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                auto ri = route_interfaces.find(id);
+                if (route_interfaces.end() == ri)
+                {
+                    return;
+                }
+                auto it = interfaces.find(ri->second);
+                route_interfaces.erase(ri);
+
+                DBusSignalRouteTable::Route route;
+                it->second.table.Get(id, route);
+                sender = route.sender;
+                it->second.table.Remove(id);
+                if (it->second.table.Empty())
+                {
+                    g_dbus_connection_signal_unsubscribe(conn, it->second.rule_id);
+                    interfaces.erase(it);
+                }
+            }
+
+            if (is_well_known(sender))
+            {
+                unwatch_name(sender);
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                empty = interfaces.empty() && names.empty();
+            }
+            if (empty)
+            {
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> guard(reg.mtx);
+                auto it = reg.routers.find(RouterKey(conn, context));
+                if (reg.routers.end() != it && it->second.get() == this)
+                {
+                    reg.routers.erase(it);
+                }
+            }
+        }
+
+
+        void watch_name(const std::string& name)
+        {
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                NameOwner& no = names[name];
+                if (no.refs++ > 0)
+                {
+                    return;
+                }
+                no.rule_id = g_dbus_connection_signal_subscribe(conn,
+                                                                "org.freedesktop.DBus",
+                                                                "org.freedesktop.DBus",
+                                                                "NameOwnerChanged",
+                                                                "/org/freedesktop/DBus",
+                                                                name.c_str(),
+                                                                G_DBUS_SIGNAL_FLAGS_NONE,
+                                                                name_owner_changed,
+                                                                new RuleData{Ptr(this), name},
+                                                                release_rule_data);
+            }
+
+            // Look up the current owner, unless a NameOwnerChanged
+            // signal has already arrived
+            GVariant *res = g_dbus_connection_call_sync(conn,
+                                                        "org.freedesktop.DBus",
+                                                        "/org/freedesktop/DBus",
+                                                        "org.freedesktop.DBus",
+                                                        "GetNameOwner",
+                                                        g_variant_new("(s)", name.c_str()),
+                                                        G_VARIANT_TYPE("(s)"),
+                                                        G_DBUS_CALL_FLAGS_NONE,
+                                                        -1, NULL, NULL);
+            if (!res)
+            {
+                // The name has no owner yet
+                return;
+            }
+            gchar *owner = nullptr;
+            g_variant_get(res, "(s)", &owner);
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                auto it = names.find(name);
+                if (names.end() != it && !it->second.updated)
+                {
+                    it->second.owner = owner;
+                }
+            }
+            g_free(owner);
+            g_variant_unref(res);
+        }
+
+
+        void unwatch_name(const std::string& name)
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            auto it = names.find(name);
+            if (names.end() == it || --it->second.refs > 0)
+            {
+                return;
+            }
+            g_dbus_connection_signal_unsubscribe(conn, it->second.rule_id);
+            names.erase(it);
+        }
+
+
+        void dispatch(const std::string& rule_intf, const gchar *sender,
+                      const gchar *path, const gchar *interf,
+                      const gchar *member, GVariant *params)
+        {
+            // Keep this router alive even if the callbacks
+            // remove all its subscriptions
+            Ptr keep(this);
+
+            std::string arg0;
+            if (params && g_variant_is_of_type(params, G_VARIANT_TYPE_TUPLE)
+                && g_variant_n_children(params) > 0)
+            {
+                GVariant *first = g_variant_get_child_value(params, 0);
+                if (g_variant_is_of_type(first, G_VARIANT_TYPE_STRING)
+                    || g_variant_is_of_type(first, G_VARIANT_TYPE_OBJECT_PATH))
+                {
+                    arg0 = g_variant_get_string(first, NULL);
+                }
+                g_variant_unref(first);
+            }
+
+            std::vector<guint> ids;
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                auto it = interfaces.find(rule_intf);
+                if (interfaces.end() == it)
+                {
+                    return;
+                }
+
+                std::vector<std::string> senders;
+                if (sender)
+                {
+                    senders.push_back(sender);
+                    for (const auto& n : names)
+                    {
+                        if (n.second.owner == sender)
+                        {
+                            senders.push_back(n.first);
+                        }
+                    }
+                }
+                ids = it->second.table.Match(senders, str(path), str(member), arg0);
+            }
+
+            for (const auto& id : ids)
+            {
+                // A callback may have removed the following subscriptions
+                DBusSignalRouteTable::Route route;
+                {
+                    std::lock_guard<std::mutex> guard(mtx);
+                    auto it = interfaces.find(rule_intf);
+                    if (interfaces.end() == it || !it->second.table.Get(id, route))
+                    {
+                        continue;
+                    }
+                }
+                route.callback(conn, sender, path, interf, member, params,
+                               route.user_data);
+            }
+        }
+
+
+        static void route_signal(GDBusConnection *conn, const gchar *sender,
+                                 const gchar *path, const gchar *interf,
+                                 const gchar *member, GVariant *params,
+                                 gpointer data)
+        {
+            RuleData *rule = (RuleData *) data;
+            rule->router->dispatch(rule->name, sender, path, interf,
+                                   member, params);
+        }
+
+
+        static void name_owner_changed(GDBusConnection *conn,
+                                       const gchar *sender,
+                                       const gchar *path,
+                                       const gchar *interf,
+                                       const gchar *member,
+                                       GVariant *params,
+                                       gpointer data)
+        {
+            RuleData *rule = (RuleData *) data;
+            gchar *name = nullptr;
+            gchar *old_owner = nullptr;
+            gchar *new_owner = nullptr;
+            g_variant_get(params, "(sss)", &name, &old_owner, &new_owner);
+
+            DBusSignalRouter *router = rule->router.get();
+            {
+                std::lock_guard<std::mutex> guard(router->mtx);
+                auto it = router->names.find(rule->name);
+                if (router->names.end() != it)
+                {
+                    it->second.owner = new_owner;
+                    it->second.updated = true;
+                }
+            }
+            g_free(name);
+            g_free(old_owner);
+            g_free(new_owner);
+        }
+
+
+        static void release_rule_data(gpointer data)
+        {
+            delete (RuleData *) data;
+        }
+    };
+};
+
+#endif // OPENVPN3_DBUS_SIGNALROUTER_HPP
@@ -20,10 +20,13 @@
 #ifndef OPENVPN3_DBUS_SIGNALS_HPP
 #define OPENVPN3_DBUS_SIGNALS_HPP
 
+#include <algorithm>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include "connection.hpp"
+#include "signal-router.hpp"
 
 namespace openvpn
 {
@@ -137,16 +140,16 @@ namespace openvpn
 
         void Subscribe(std::string busname, std::string objpath, std::string signal_name)
         {
-            guint signal_id = g_dbus_connection_signal_subscribe(conn,
-                                                           string2C_char(busname),
-                                                           string2C_char(interface),
-                                                           string2C_char(signal_name),
-                                                           string2C_char(objpath),
-                                                           NULL,
-                                                           G_DBUS_SIGNAL_FLAGS_NONE,
-                                                           dbusobject_callback_signal_handler,
-                                                           this,
-                                                           NULL );  // destructor
+            // The signal router shares a single match rule per interface
+            // between all subscriptions on this connection
+            guint signal_id = DBusSignalRouter::Subscribe(conn,
+                                                          string2C_char(busname),
+                                                          string2C_char(interface),
+                                                          string2C_char(signal_name),
+                                                          string2C_char(objpath),
+                                                          NULL,
+                                                          dbusobject_callback_signal_handler,
+                                                          this);
             if (signal_id == 0)
             {
                 std::stringstream err;
@@ -175,12 +178,42 @@ namespace openvpn
         {
             if (subscriptions[signal_name] > 0)
             {
-                g_dbus_connection_signal_unsubscribe(conn, subscriptions[signal_name]);
+                DBusSignalRouter::Unsubscribe(subscriptions[signal_name]);
                 subscriptions[signal_name] = 0;
             }
         }
 
 
+        /**
+         *  Moves all the active subscriptions to another connection, such
+         *  as a peer-to-peer link replacing the bus.  The subscriptions
+         *  are renewed for the object path given to the constructor.
+         *
+         * @param newconn   GDBusConnection to subscribe on
+         * @param busname   Bus name of the sender on the new connection,
+         *                  empty on peer-to-peer links
+         */
+        void MoveSubscriptions(GDBusConnection *newconn,
+                               const std::string& busname)
+        {
+            std::vector<std::string> signals;
+            for (const auto& sub : subscriptions)
+            {
+                if (sub.second > 0)
+                {
+                    signals.push_back(sub.first);
+                }
+            }
+            Cleanup();
+            conn = newconn;
+            bus_name = busname;
+            for (const auto& signame : signals)
+            {
+                Subscribe(signame);
+            }
+        }
+
+
         std::string GetBusName()
         {
             return bus_name;
@@ -202,7 +235,7 @@ namespace openvpn
             {
                 if (sub.second > 0)
                 {
-                    g_dbus_connection_signal_unsubscribe(conn, sub.second);
+                    DBusSignalRouter::Unsubscribe(sub.second);
                 }
                 subscriptions[sub.first] = 0;
             }
@@ -226,8 +259,9 @@ namespace openvpn
                                                         gpointer this_ptr)
         {
             class DBusSignalSubscription *obj = (class DBusSignalSubscription *) this_ptr;
+            // Signals arriving on a peer-to-peer link have no sender
             obj->callback_signal_handler(conn,
-                                         std::string(sender),
+                                         C_char2string(sender),
                                          std::string(obj_path),
                                          std::string(intf_name),
                                          std::string(sign_name),
@@ -255,7 +289,9 @@ namespace openvpn
                            std::string objpath) :
             conn(dbuscon.GetConnection()),
             interface(interf),
-            object_path(objpath)
+            object_path(objpath),
+            peer_conn(nullptr),
+            peer_bus_broadcast(false)
         {
             if (!busname.empty())
             {
@@ -271,7 +307,9 @@ namespace openvpn
                            std::string objpath) :
             conn(con),
             interface(interf),
-            object_path(objpath)
+            object_path(objpath),
+            peer_conn(nullptr),
+            peer_bus_broadcast(false)
         {
             if (!busname.empty())
             {
@@ -281,12 +319,82 @@ namespace openvpn
         }
 
 
+        ~DBusSignalProducer()
+        {
+            SetPeerConnection(nullptr);
+        }
+
+
+        /**
+         *  Sends all signals without an explicit destination over a
+         *  peer-to-peer link as well.  Signals to the target bus names
+         *  are still sent over the bus.
+         *
+         * @param peer           GDBusConnection to the peer.  If nullptr,
+         *                       the link is no longer used.
+         * @param bus_broadcast  If true, signals are still broadcast on
+         *                       the bus when no target bus names are set
+         */
+        void SetPeerConnection(GDBusConnection *peer, bool bus_broadcast = false)
+        {
+            if (peer)
+            {
+                g_object_ref(peer);
+            }
+            GDBusConnection *old = nullptr;
+            {
+                std::lock_guard<std::mutex> guard(peer_mtx);
+                old = peer_conn;
+                peer_conn = peer;
+                peer_bus_broadcast = bus_broadcast;
+            }
+            if (old)
+            {
+                g_object_unref(old);
+            }
+        }
+
+
         void AddTargetBusName(const std::string busn)
         {
             target_bus_names.push_back(busn);
         }
 
 
+        /**
+         *  Removes a single target bus name
+         *
+         * @param busn  Bus name to stop sending signals to
+         */
+        void RemoveTargetBusName(const std::string busn)
+        {
+            target_bus_names.erase(std::remove(target_bus_names.begin(),
+                                               target_bus_names.end(),
+                                               busn),
+                                   target_bus_names.end());
+        }
+
+
+        /**
+         *  Checks if signals are sent to specific bus names.  If not,
+         *  signals are broadcast.
+         */
+        bool HasTargetBusNames() const
+        {
+            return !target_bus_names.empty();
+        }
+
+
+        /**
+         *  Removes all the target bus names.  Until a new target is
+         *  added, signals are broadcast.
+         */
+        void ClearTargetBusNames()
+        {
+            target_bus_names.clear();
+        }
+
+
         void Send(const std::string busn,
                          const std::string interf,
                          const std::string objpath,
@@ -294,7 +402,32 @@ namespace openvpn
                          GVariant *params)
         {
             g_variant_ref_sink(params);  // This method must own this object
-            if (!busn.empty() || 0 == target_bus_names.size())
+
+            GDBusConnection *peer = nullptr;
+            bool bus_broadcast = false;
+            if (busn.empty())
+            {
+                std::lock_guard<std::mutex> guard(peer_mtx);
+                if (peer_conn)
+                {
+                    peer = (GDBusConnection *) g_object_ref(peer_conn);
+                }
+                bus_broadcast = peer_bus_broadcast;
+            }
+            if (peer)
+            {
+                // A closed link is detected by the owner of the link;
+                // the signal is just lost until the link is replaced
+                g_dbus_connection_emit_signal(peer, NULL,
+                                              string2C_char(objpath),
+                                              string2C_char(interf),
+                                              signal_name.c_str(),
+                                              params, NULL);
+                g_object_unref(peer);
+            }
+
+            if (!busn.empty()
+                || (0 == target_bus_names.size() && (!peer || bus_broadcast)))
             {
                 send_signal(busn, interf, objpath, signal_name, params);
             }
@@ -306,6 +439,24 @@ namespace openvpn
             g_variant_unref(params);  // Now params can be released and freed
         }
 
+        /**
+         *  Sends a signal to a single bus name only.  Neither the target
+         *  bus names nor a peer-to-peer link are used.
+         *
+         * @param busn         Bus name of the signal recipient
+         * @param signal_name  Name of the signal
+         * @param params       GVariant object with the signal arguments
+         */
+        void SendTo(const std::string busn,
+                    const std::string signal_name,
+                    GVariant *params)
+        {
+            g_variant_ref_sink(params);
+            send_signal(busn, interface, object_path, signal_name, params);
+            g_variant_unref(params);
+        }
+
+
         void Send(const std::string busn,
                   const std::string interf,
                   const std::string signal_name,
@@ -346,6 +497,12 @@ namespace openvpn
 
 
     protected:
+        const std::string& GetSignalObjectPath() const
+        {
+            return object_path;
+        }
+
+
         void validate_params()
         {
             if (interface.empty()) {
@@ -364,6 +521,9 @@ namespace openvpn
         std::string interface;
         std::string object_path;
         std::string signal_name;
+        std::mutex peer_mtx;
+        GDBusConnection *peer_conn;
+        bool peer_bus_broadcast;
 
         void send_signal(const std::string busn,
                          const std::string interf,
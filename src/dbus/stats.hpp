@@ -0,0 +1,576 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   stats.hpp
+ *
+ * @brief  Call counters and latency histograms of the D-Bus method and
+ *         property handlers of a process, collected by DBusObject.
+ *
+ *         Each thread records into its own set of counters, so recording
+ *         a call needs neither locks nor atomic read-modify-write
+ *         operations.  The counters of all threads are only summed up
+ *         when the statistics are retrieved via the net.openvpn.v3.debug
+ *         D-Bus interface.
+ *
+ *         The collection can be disabled by setting the
+ *         OPENVPN3_DBUS_STATS environment variable to 0.  The handlers
+ *         are then called without reading the clock at all.
+ */
+
+#ifndef OPENVPN3_DBUS_STATS_HPP
+#define OPENVPN3_DBUS_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gio/gio.h>
+
+#include "constants.hpp"
+
+namespace openvpn
+{
+    /**
+     *  Bucket layout of the latency histograms.  The values are in
+     *  microseconds.  Each power of two range is split into SUB_COUNT
+     *  linear buckets, which keeps the relative error below 25% over
+     *  the whole range from 1 microsecond to about 35 minutes.  Larger
+     *  values end up in the last bucket.
+     */
+    class DBusLatencyHistogram
+    {
+    public:
+        static const unsigned int SUB_BITS = 2;
+        static const unsigned int SUB_COUNT = 1 << SUB_BITS;
+        static const unsigned int MAX_EXP = 31;
+        static const unsigned int BUCKETS = SUB_COUNT
+                                            + (MAX_EXP - SUB_BITS + 1) * SUB_COUNT;
+
+        /**
+         *  A non-empty histogram bucket, as (upper bound, count) pair
+         */
+        typedef std::vector<std::pair<uint64_t, uint64_t>> Buckets;
+
+
+        static unsigned int Index(uint64_t usec)
+        {
+            if (usec < SUB_COUNT)
+            {
+                return usec;
+            }
+            unsigned int exp = 63 - __builtin_clzll(usec);
+            if (exp > MAX_EXP)
+            {
+                return BUCKETS - 1;
+            }
+            return SUB_COUNT + (exp - SUB_BITS) * SUB_COUNT
+                   + ((usec >> (exp - SUB_BITS)) & (SUB_COUNT - 1));
+        }
+
+
+        /**
+         *  Returns the largest value stored in a bucket
+         */
+        static uint64_t UpperBound(unsigned int idx)
+        {
+            if (idx < SUB_COUNT)
+            {
+                return idx;
+            }
+            unsigned int exp = (idx - SUB_COUNT) / SUB_COUNT + SUB_BITS;
+            uint64_t sub = (idx - SUB_COUNT) % SUB_COUNT;
+            uint64_t width = uint64_t(1) << (exp - SUB_BITS);
+            return ((SUB_COUNT + sub) * width) + width - 1;
+        }
+
+
+        /**
+         *  Estimates a percentile from a histogram
+         *
+         * @param buckets   Non-empty buckets, ordered by the upper bound
+         * @param fraction  The percentile, as a fraction between 0 and 1
+         *
+         * @return Returns the upper bound of the bucket the percentile
+         *         falls into, in microseconds.  0 for an empty histogram.
+         */
+        static uint64_t Percentile(const Buckets& buckets, double fraction)
+        {
+            uint64_t total = 0;
+            for (const auto& b : buckets)
+            {
+                total += b.second;
+            }
+            if (0 == total)
+            {
+                return 0;
+            }
+
+            uint64_t rank = (uint64_t) (fraction * total + 0.5);
+            rank = std::max<uint64_t>(rank, 1);
+            uint64_t seen = 0;
+            for (const auto& b : buckets)
+            {
+                seen += b.second;
+                if (seen >= rank)
+                {
+                    return b.first;
+                }
+            }
+            return buckets.back().first;
+        }
+    };
+
+
+
+    /**
+     *  Call statistics of all D-Bus handlers in this process
+     */
+    class DBusCallStats
+    {
+    public:
+        /**
+         *  Kind of D-Bus operation being handled
+         */
+        enum class Kind : char {
+            METHOD = 'M',
+            GET_PROPERTY = 'G',
+            SET_PROPERTY = 'S'
+        };
+
+
+        /**
+         *  Totals of a single handler over all threads
+         */
+        struct Entry
+        {
+            std::string interface;
+            std::string member;
+            Kind kind;
+            uint64_t calls;
+            uint64_t errors;
+            uint64_t total_usec;
+            DBusLatencyHistogram::Buckets buckets;
+        };
+
+
+        class Timer;
+
+
+        /**
+         *  Checks if the statistics are collected.  This is decided once,
+         *  from the OPENVPN3_DBUS_STATS environment variable.
+         */
+        static bool Enabled()
+        {
+            static const bool enabled = []()
+                {
+                    const char *env = std::getenv("OPENVPN3_DBUS_STATS");
+                    return !(env && 0 == std::strcmp(env, "0"));
+                }();
+            return enabled;
+        }
+
+
+        /**
+         *  Records that the D-Bus call being handled by the calling thread
+         *  returns an error to the caller.  This is called by the helpers
+         *  returning errors, such as DBusException::SetDBusError().
+         */
+        static void MarkError()
+        {
+            ++thread_error_marks();
+        }
+
+
+        /**
+         *  Sums up the counters of all threads
+         *
+         * @return Returns a std::vector<Entry> with the handlers called
+         *         so far, in the order they were first called.
+         */
+        static std::vector<Entry> Snapshot()
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg.mtx);
+
+            std::vector<Entry> ret;
+            for (size_t id = 0; id < reg.names.size(); ++id)
+            {
+                Entry e;
+                e.interface = reg.names[id].interface;
+                e.member = reg.names[id].member;
+                e.kind = reg.names[id].kind;
+                e.calls = 0;
+                e.errors = 0;
+                e.total_usec = 0;
+                std::array<uint64_t, DBusLatencyHistogram::BUCKETS> sum = {};
+                for (const auto& t : reg.threads)
+                {
+                    const Counters *c = t->slots[id].load(std::memory_order_acquire);
+                    if (!c)
+                    {
+                        continue;
+                    }
+                    e.calls += c->calls.load(std::memory_order_relaxed);
+                    e.errors += c->errors.load(std::memory_order_relaxed);
+                    e.total_usec += c->total_usec.load(std::memory_order_relaxed);
+                    for (unsigned int i = 0; i < DBusLatencyHistogram::BUCKETS; ++i)
+                    {
+                        sum[i] += c->buckets[i].load(std::memory_order_relaxed);
+                    }
+                }
+                for (unsigned int i = 0; i < DBusLatencyHistogram::BUCKETS; ++i)
+                {
+                    if (sum[i] > 0)
+                    {
+                        e.buckets.push_back({DBusLatencyHistogram::UpperBound(i),
+                                             sum[i]});
+                    }
+                }
+                ret.push_back(std::move(e));
+            }
+            return ret;
+        }
+
+
+        /**
+         *  Packs a Snapshot() into the a(sssttta(tt)) format used by the
+         *  net.openvpn.v3.debug interface
+         */
+        static GVariant * SnapshotVariant()
+        {
+            GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("a(sssttta(tt))"));
+            for (const auto& e : Snapshot())
+            {
+                GVariantBuilder *hist = g_variant_builder_new(G_VARIANT_TYPE("a(tt)"));
+                for (const auto& b : e.buckets)
+                {
+                    g_variant_builder_add(hist, "(tt)",
+                                          (guint64) b.first,
+                                          (guint64) b.second);
+                }
+                g_variant_builder_add(bld, "(sssttta(tt))",
+                                      e.interface.c_str(), e.member.c_str(),
+                                      KindName(e.kind),
+                                      (guint64) e.calls,
+                                      (guint64) e.errors,
+                                      (guint64) e.total_usec,
+                                      hist);
+                g_variant_builder_unref(hist);
+            }
+            GVariant *ret = g_variant_builder_end(bld);
+            g_variant_builder_unref(bld);
+            return ret;
+        }
+
+
+        static const char * KindName(Kind kind)
+        {
+            switch (kind)
+            {
+            case Kind::METHOD:
+                return "method";
+            case Kind::GET_PROPERTY:
+                return "get";
+            case Kind::SET_PROPERTY:
+                return "set";
+            }
+            return "unknown";
+        }
+
+
+    private:
+        /**
+         *  Upper limit of distinct handlers which are tracked.  The
+         *  introspection documents limit the number of handlers, so this
+         *  is never reached in practice.
+         */
+        static const size_t MAX_ENTRIES = 1024;
+
+        /**
+         *  Counters of one handler in one thread.  Only the owning thread
+         *  writes to them, so plain loads and stores are sufficient; the
+         *  atomics only make the concurrent reads in Snapshot() safe.
+         */
+        struct Counters
+        {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> errors{0};
+            std::atomic<uint64_t> total_usec{0};
+            std::array<std::atomic<uint64_t>, DBusLatencyHistogram::BUCKETS> buckets{};
+
+            void Record(uint64_t usec, bool failed)
+            {
+                bump(calls, 1);
+                if (failed)
+                {
+                    bump(errors, 1);
+                }
+                bump(total_usec, usec);
+                bump(buckets[DBusLatencyHistogram::Index(usec)], 1);
+            }
+
+            static void bump(std::atomic<uint64_t>& c, uint64_t val)
+            {
+                c.store(c.load(std::memory_order_relaxed) + val,
+                        std::memory_order_relaxed);
+            }
+        };
+
+
+        /**
+         *  The counters of one thread, indexed by handler id.  These
+         *  are kept when the thread exits, so no calls are lost.
+         */
+        struct ThreadCounters
+        {
+            std::array<std::atomic<Counters *>, MAX_ENTRIES> slots{};
+            std::vector<std::unique_ptr<Counters>> owned;
+        };
+
+
+        struct Name
+        {
+            std::string interface;
+            std::string member;
+            Kind kind;
+        };
+
+
+        struct Registry
+        {
+            std::mutex mtx;
+            std::vector<Name> names;
+            std::unordered_map<std::string, size_t> ids;
+            std::vector<std::unique_ptr<ThreadCounters>> threads;
+        };
+
+
+        /**
+         *  The handlers already seen by a thread, to look up the
+         *  counters without taking the registry lock
+         */
+        struct ThreadCache
+        {
+            ThreadCounters *counters = nullptr;
+            std::unordered_map<std::string, Counters *> known;
+            std::string key;
+        };
+
+
+        static Registry& registry()
+        {
+            // Never destroyed, as handlers may run while the
+            // process is exiting
+            static Registry *reg = new Registry;
+            return *reg;
+        }
+
+
+        static unsigned int& thread_error_marks()
+        {
+            static thread_local unsigned int marks = 0;
+            return marks;
+        }
+
+
+        static Counters * lookup(Kind kind, const gchar *interf,
+                                 const gchar *member)
+        {
+            static thread_local ThreadCache cache;
+
+            // The key buffer is reused, so known handlers are looked
+            // up without allocating memory
+            cache.key.assign(1, (char) kind);
+            cache.key.append(interf ? interf : "");
+            cache.key.push_back('\n');
+            cache.key.append(member ? member : "");
+            auto it = cache.known.find(cache.key);
+            if (cache.known.end() != it)
+            {
+                return it->second;
+            }
+
+            Counters *c = register_counters(cache, kind, interf, member);
+            cache.known[cache.key] = c;
+            return c;
+        }
+
+
+        static Counters * register_counters(ThreadCache& cache, Kind kind,
+                                            const gchar *interf,
+                                            const gchar *member)
+        {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> guard(reg.mtx);
+
+            if (!cache.counters)
+            {
+                reg.threads.emplace_back(new ThreadCounters);
+                cache.counters = reg.threads.back().get();
+            }
+
+            size_t id;
+            auto it = reg.ids.find(cache.key);
+            if (reg.ids.end() != it)
+            {
+                id = it->second;
+            }
+            else
+            {
+                if (reg.names.size() >= MAX_ENTRIES)
+                {
+                    return nullptr;
+                }
+                id = reg.names.size();
+                reg.names.push_back({(interf ? interf : ""),
+                                     (member ? member : ""),
+                                     kind});
+                reg.ids[cache.key] = id;
+            }
+
+            Counters *c = new Counters;
+            cache.counters->owned.emplace_back(c);
+            cache.counters->slots[id].store(c, std::memory_order_release);
+            return c;
+        }
+    };
+
+
+
+    /**
+     *  Measures a single call, from construction until Finish()
+     *  is called.  Nothing is measured if the collection is disabled.
+     */
+    class DBusCallStats::Timer
+    {
+    public:
+        Timer(Kind kind, const gchar *interf, const gchar *member)
+            : counters(Enabled() ? lookup(kind, interf, member) : nullptr),
+              errors_marked(thread_error_marks())
+        {
+            if (counters)
+            {
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+
+        /**
+         *  Records the call
+         *
+         * @param failed  Set if the handler is known to have failed.
+         *                Errors returned via MarkError() while the
+         *                call was running are recorded as well.
+         */
+        void Finish(bool failed = false)
+        {
+            if (!counters)
+            {
+                return;
+            }
+            auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+            failed |= (thread_error_marks() != errors_marked);
+            counters->Record((uint64_t) usec, failed);
+            counters = nullptr;
+        }
+
+
+    private:
+        Counters *counters;
+        unsigned int errors_marked;
+        std::chrono::steady_clock::time_point start;
+    };
+
+
+
+    /**
+     *  The net.openvpn.v3.debug interface, which provides the
+     *  DBusCallStats of the process.  DBusObject adds it to the objects
+     *  which call EnableDebugInterface().
+     */
+    class DBusDebugInterface
+    {
+    public:
+        /**
+         *  Returns the parsed introspection data of the interface.  It is
+         *  parsed on the first call and kept for the life time of the
+         *  process.
+         */
+        static GDBusInterfaceInfo * Info()
+        {
+            static GDBusNodeInfo *node = []()
+                {
+                    std::string xml = "<node>"
+                        "  <interface name='" + OpenVPN3DBus_interf_debug + "'>"
+                        "    <method name='FetchDBusStats'>"
+                        "      <arg type='b' name='enabled' direction='out'/>"
+                        "      <arg type='a(sssttta(tt))' name='stats' direction='out'/>"
+                        "    </method>"
+                        "  </interface>"
+                        "</node>";
+                    return g_dbus_node_info_new_for_xml(xml.c_str(), NULL);
+                }();
+            return node->interfaces[0];
+        }
+
+
+        static const GDBusInterfaceVTable * VTable()
+        {
+            static const GDBusInterfaceVTable vtable = {
+                method_call,
+                NULL,
+                NULL
+            };
+            return &vtable;
+        }
+
+
+    private:
+        static void method_call(GDBusConnection *conn,
+                                const gchar *sender,
+                                const gchar *obj_path,
+                                const gchar *intf_name,
+                                const gchar *meth_name,
+                                GVariant *params,
+                                GDBusMethodInvocation *invoc,
+                                gpointer data)
+        {
+            // GDBus only passes on the methods in the introspection data
+            GVariant *stats = DBusCallStats::SnapshotVariant();
+            g_dbus_method_invocation_return_value(invoc,
+                                                  g_variant_new("(b@a(sssttta(tt)))",
+                                                                DBusCallStats::Enabled(),
+                                                                stats));
+        }
+    };
+};
+
+#endif // OPENVPN3_DBUS_STATS_HPP
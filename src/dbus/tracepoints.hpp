@@ -0,0 +1,122 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   tracepoints.hpp
+ *
+ * @brief  USDT static tracepoints in the "openvpn3" provider, which can
+ *         be used by perf, bpftrace and SystemTap.  They are only
+ *         compiled in when configured with --enable-usdt; otherwise the
+ *         macros expand to nothing and their arguments are not evaluated.
+ *
+ *         When compiled in, a tracepoint nobody listens to is a single
+ *         nop instruction, but its arguments are still evaluated; they
+ *         must be cheap to compute.  Strings are passed as C strings.
+ *
+ *         Tracepoints and their arguments:
+ *
+ *          - dbus_method_entry(path, interface, method)
+ *          - dbus_method_return(path, interface, method, usec)
+ *          - log_send(path, group, category, message)
+ *          - log_consume(sender, path, group, category, message)
+ *          - session_new(session_path, config_path, owner_uid)
+ *          - session_registered(session_path, backend_pid, usec)
+ *          - session_destroy(session_path, usec)
+ *          - backend_start(first_argument, pid, usec)
+ *          - config_import(config_path, name, usec)
+ *          - config_fetch(config_path, sender, usec)
+ *          - core_event(name, info, error)
+ *
+ *         usec is the duration of the operation in microseconds.  For
+ *         session_registered and session_destroy it is the time since
+ *         the session was created.  core_event fires in the VPN client
+ *         backend process.  See src/tests/bpftrace for examples.
+ */
+
+#ifndef OPENVPN3_DBUS_TRACEPOINTS_HPP
+#define OPENVPN3_DBUS_TRACEPOINTS_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#include "config.h"
+
+#ifdef ENABLE_USDT
+#include <sys/sdt.h>
+
+#define OPENVPN3_TRACE1(name, a1) \
+    DTRACE_PROBE1(openvpn3, name, a1)
+#define OPENVPN3_TRACE2(name, a1, a2) \
+    DTRACE_PROBE2(openvpn3, name, a1, a2)
+#define OPENVPN3_TRACE3(name, a1, a2, a3) \
+    DTRACE_PROBE3(openvpn3, name, a1, a2, a3)
+#define OPENVPN3_TRACE4(name, a1, a2, a3, a4) \
+    DTRACE_PROBE4(openvpn3, name, a1, a2, a3, a4)
+#define OPENVPN3_TRACE5(name, a1, a2, a3, a4, a5) \
+    DTRACE_PROBE5(openvpn3, name, a1, a2, a3, a4, a5)
+
+#else
+
+#define OPENVPN3_TRACE1(name, a1) do {} while (0)
+#define OPENVPN3_TRACE2(name, a1, a2) do {} while (0)
+#define OPENVPN3_TRACE3(name, a1, a2, a3) do {} while (0)
+#define OPENVPN3_TRACE4(name, a1, a2, a3, a4) do {} while (0)
+#define OPENVPN3_TRACE5(name, a1, a2, a3, a4, a5) do {} while (0)
+
+#endif
+
+
+namespace openvpn
+{
+    /**
+     *  Measures the duration reported by a tracepoint.  Without USDT
+     *  support, no time stamps are taken and Elapsed() is always 0.
+     */
+    class TraceTimer
+    {
+    public:
+#ifdef ENABLE_USDT
+        TraceTimer()
+            : start(std::chrono::steady_clock::now())
+        {
+        }
+
+
+        /**
+         *  Returns the time since this object was created, in microseconds
+         */
+        uint64_t Elapsed() const
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+
+    private:
+        std::chrono::steady_clock::time_point start;
+#else
+        uint64_t Elapsed() const
+        {
+            return 0;
+        }
+#endif
+    };
+};
+
+#endif // OPENVPN3_DBUS_TRACEPOINTS_HPP
@@ -23,8 +23,10 @@
 #include <fstream>
 #include <ctime>
 #include <exception>
+#include <mutex>
 
 #include "dbus/signals.hpp"
+#include "dbus/tracepoints.hpp"
 #include "client/statusevent.hpp"
 #include "log-helpers.hpp"
 #include "logevent.hpp"
@@ -207,8 +209,16 @@ namespace openvpn
 
             if( logwr )
             {
+                // The LogWriter is shared by all objects in the service,
+                // which may log from different D-Bus worker threads
+                static std::mutex logwr_mtx;
+                std::lock_guard<std::mutex> guard(logwr_mtx);
                 logwr->Write(logev);
             }
+            OPENVPN3_TRACE4(log_send, GetSignalObjectPath().c_str(),
+                            (unsigned int) logev.group,
+                            (unsigned int) logev.category,
+                            logev.message.c_str());
             Send("Log", g_variant_new("(uus)",
                                       (guint) logev.group,
                                       (guint) logev.category,
@@ -333,6 +343,20 @@ namespace openvpn
         {
         }
 
+
+        /**
+         *  Receives the log events on one connection and proxies them
+         *  on another one, such as from a peer-to-peer link to the bus.
+         */
+        LogConsumerProxy(GDBusConnection *src_conn,
+                         std::string src_interf, std::string src_objpath,
+                         GDBusConnection *dst_conn,
+                         std::string dst_interf, std::string dst_objpath)
+            : LogConsumer(src_conn, src_interf, src_objpath),
+              LogSender(dst_conn, LogGroup::UNDEFINED, dst_interf, dst_objpath)
+        {
+        }
+
         virtual void ConsumeLogEvent(const std::string sender,
                                      const std::string interface,
                                      const std::string object_path,
@@ -69,6 +69,10 @@ public:
                 return;  // Don't do anything if this LogGroup is filtered
             }
         }
+        OPENVPN3_TRACE5(log_consume, sender.c_str(), object_path.c_str(),
+                        (unsigned int) logev.group,
+                        (unsigned int) logev.category,
+                        logev.message.c_str());
 
         // Prepend log lines with the log tag
         logwr->WritePrepend(log_tag + std::string(" "), true);
@@ -96,6 +96,7 @@ public:
         << "    </interface>"
         << "</node>";
         ParseIntrospectionXML(introspection_xml);
+        EnableDebugInterface();
     }
 
     ~LogServiceManager()
@@ -0,0 +1,428 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   autoload-parser.hpp
+ *
+ * @brief  Parsing of .autoload descriptors and their configuration
+ *         profiles, and how the openvpn3 autoload command reacts to the
+ *         StatusChange signals of the sessions it starts.  This does not
+ *         depend on D-Bus, so it can be tested on its own.
+ */
+
+#ifndef OPENVPN3_OVPN3CLI_AUTOLOAD_PARSER_HPP
+#define OPENVPN3_OVPN3CLI_AUTOLOAD_PARSER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <json/json.h>
+
+#include "common/cmdargparser.hpp"
+#include "common/core-extensions.hpp"
+#include "configmgr/overrides.hpp"
+#include "client/statusevent.hpp"
+
+
+/**
+ *  Contains everything parsed from an .autoload descriptor and its
+ *  configuration profile
+ */
+struct AutoloadProfile
+{
+    AutoloadProfile(const std::string& cfgfile, const std::string& alfile)
+        : config_file(cfgfile), autoload_file(alfile)
+    {
+    }
+
+    std::string config_file;
+    std::string autoload_file;
+    std::string name;
+    std::string profile;
+    std::string error;
+    std::vector<std::string> warnings;
+
+    bool autostart = false;
+    bool public_access = false;
+    bool locked_down = false;
+    bool persist_tun = false;
+    std::vector<OverrideValue> overrides;
+    std::map<std::string, std::string> user_auth;
+
+    std::string config_path;
+};
+
+
+/**
+ *  Adds a string override to an autoload profile, if the value is valid
+ *  for the override
+ *
+ * @param prof     AutoloadProfile to add the override to
+ * @param key      std::string with the override name
+ * @param value    std::string with the override value
+ * @param section  std::string with the .autoload setting, used in warnings
+ */
+static void autoload_add_override(AutoloadProfile& prof,
+                                  const std::string& key,
+                                  const std::string& value,
+                                  const std::string& section)
+{
+    const ValidOverride& vo = GetConfigOverride(key);
+    if (!vo.ValidValue(value))
+    {
+        prof.warnings.push_back("Invalid " + section + " value: " + value);
+        return;
+    }
+    prof.overrides.push_back(OverrideValue(vo, value));
+}
+
+
+/**
+ *  Adds a boolean override to an autoload profile
+ *
+ * @param prof     AutoloadProfile to add the override to
+ * @param key      std::string with the override name
+ * @param value    bool with the override value
+ */
+static void autoload_add_override(AutoloadProfile& prof,
+                                  const std::string& key,
+                                  bool value)
+{
+    prof.overrides.push_back(OverrideValue(GetConfigOverride(key), value));
+}
+
+
+/**
+ *  Translates the settings in an .autoload descriptor into configuration
+ *  profile flags and overrides
+ *
+ * @param prof      AutoloadProfile to populate
+ * @param autoload  Json::Value with the parsed .autoload descriptor
+ */
+static void autoload_parse_descriptor(AutoloadProfile& prof,
+                                      const Json::Value& autoload)
+{
+    prof.autostart = autoload.get("autostart", false).asBool();
+
+    const Json::Value& acl = autoload["acl"];
+    if (acl.isObject())
+    {
+        prof.public_access = acl.get("public", false).asBool();
+        prof.locked_down = acl.get("locked-down", false).asBool();
+    }
+
+    const Json::Value& remote = autoload["remote"];
+    if (remote.isObject())
+    {
+        if (remote.isMember("proto-override"))
+        {
+            autoload_add_override(prof, "proto-override",
+                                  remote["proto-override"].asString(),
+                                  "remote:proto-override");
+        }
+        if (remote.isMember("port-override"))
+        {
+            const Json::Value& port = remote["port-override"];
+            autoload_add_override(prof, "port-override",
+                                  (port.isString() ? port.asString()
+                                                   : std::to_string(port.asUInt())),
+                                  "remote:port-override");
+        }
+        if (remote.isMember("compression"))
+        {
+            autoload_add_override(prof, "allow-compression",
+                                  remote["compression"].asString(),
+                                  "remote:compression");
+        }
+    }
+
+    const Json::Value& crypto = autoload["crypto"];
+    if (crypto.isObject())
+    {
+        if (crypto.isMember("client-cert-enabled"))
+        {
+            autoload_add_override(prof, "no-client-cert",
+                                  !crypto["client-cert-enabled"].asBool());
+        }
+        if (crypto.get("force-aes-cbc", false).asBool())
+        {
+            autoload_add_override(prof, "force-cipher-aes-cbc", true);
+        }
+
+        const Json::Value& tls = crypto["tls-params"];
+        if (tls.isObject())
+        {
+            if (tls.isMember("cert-profile"))
+            {
+                autoload_add_override(prof, "tls-cert-profile",
+                                      tls["cert-profile"].asString(),
+                                      "tls-params:cert-profile");
+            }
+            if (tls.isMember("min-version"))
+            {
+                autoload_add_override(prof, "tls-version-min",
+                                      tls["min-version"].asString(),
+                                      "tls-params:min-version");
+            }
+        }
+    }
+
+    const Json::Value& tunnel = autoload["tunnel"];
+    if (tunnel.isObject())
+    {
+        if (tunnel.get("persist", false).asBool())
+        {
+            prof.persist_tun = true;
+        }
+        if (tunnel.isMember("ipv6"))
+        {
+            autoload_add_override(prof, "ipv6", tunnel["ipv6"].asString(),
+                                  "tunnel:ipv6");
+        }
+        if (tunnel.isMember("dns-fallback"))
+        {
+            if ("google" == tunnel["dns-fallback"].asString())
+            {
+                autoload_add_override(prof, "dns-fallback-google", true);
+            }
+            else
+            {
+                prof.warnings.push_back("Invalid tunnel:dns-fallback value: "
+                                        + tunnel["dns-fallback"].asString());
+            }
+        }
+    }
+
+    const Json::Value& userauth = autoload["user-auth"];
+    if (userauth.isObject())
+    {
+        for (const auto& varname : userauth.getMemberNames())
+        {
+            if (userauth[varname].isString())
+            {
+                prof.user_auth[varname] = userauth[varname].asString();
+            }
+        }
+    }
+}
+
+
+/**
+ *  Parses an .autoload descriptor and its configuration profile.  Any
+ *  errors are stored in the AutoloadProfile object.
+ *
+ * @param prof  AutoloadProfile to populate
+ */
+static void autoload_parse_profile(AutoloadProfile& prof)
+{
+    try
+    {
+        std::ifstream alfile(prof.autoload_file);
+        Json::Value autoload;
+        alfile >> autoload;
+        autoload_parse_descriptor(prof, autoload);
+
+        ProfileMerge pm(prof.config_file, "", "",
+                        ProfileMerge::FOLLOW_FULL,
+                        ProfileParseLimits::MAX_LINE_SIZE,
+                        ProfileParseLimits::MAX_PROFILE_SIZE);
+        if (pm.status() != ProfileMerge::MERGE_SUCCESS)
+        {
+            prof.error = pm.error();
+            return;
+        }
+        prof.profile = pm.profile_content();
+
+        // --persist-tun is not processed by the OpenVPN 3 Core library,
+        // it is handled by a configuration profile property
+        OptionList::Limits limits("profile is too large",
+                                  ProfileParseLimits::MAX_PROFILE_SIZE,
+                                  ProfileParseLimits::OPT_OVERHEAD,
+                                  ProfileParseLimits::TERM_OVERHEAD,
+                                  ProfileParseLimits::MAX_LINE_SIZE,
+                                  ProfileParseLimits::MAX_DIRECTIVE_SIZE);
+        OptionList opts;
+        opts.parse_from_config(prof.profile, &limits);
+        opts.update_map();
+        if (opts.exists("persist-tun"))
+        {
+            prof.persist_tun = true;
+        }
+    }
+    catch (std::exception& excp)
+    {
+        prof.error = excp.what();
+    }
+}
+
+
+/**
+ *  Finds all .ovpn and .conf configuration profiles in a directory
+ *  which are accompanied by an .autoload file with the same base name
+ *
+ * @param dir  std::string with the directory to process
+ *
+ * @return Returns a std::vector with an AutoloadProfile for each profile
+ *         found, sorted by the configuration file name
+ */
+static std::vector<AutoloadProfile> autoload_find_profiles(const std::string& dir)
+{
+    DIR *dirp = opendir(dir.c_str());
+    if (!dirp)
+    {
+        throw CommandException("autoload",
+                               "Could not open directory '" + dir + "': "
+                               + std::string(strerror(errno)));
+    }
+
+    std::vector<AutoloadProfile> ret;
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dirp)))
+    {
+        std::string fname(entry->d_name);
+        for (const std::string ext : {".ovpn", ".conf"})
+        {
+            if (fname.size() <= ext.size()
+                || 0 != fname.compare(fname.size() - ext.size(), ext.size(), ext))
+            {
+                continue;
+            }
+            std::string base = fname.substr(0, fname.size() - ext.size());
+
+            struct stat st;
+            std::string alfile = dir + "/" + base + ".autoload";
+            if (0 == stat(alfile.c_str(), &st) && S_ISREG(st.st_mode))
+            {
+                ret.push_back(AutoloadProfile(dir + "/" + fname, alfile));
+                ret.back().name = fname;
+            }
+        }
+    }
+    closedir(dirp);
+
+    std::sort(ret.begin(), ret.end(),
+              [](const AutoloadProfile& a, const AutoloadProfile& b)
+              {
+                  return a.config_file < b.config_file;
+              });
+    return ret;
+}
+
+
+/**
+ *  Parses all the autoload profiles, using one worker thread per CPU core
+ *
+ * @param profiles  std::vector of AutoloadProfile objects to parse
+ */
+static void autoload_parse_all(std::vector<AutoloadProfile>& profiles)
+{
+    unsigned int workers = std::max(1U, std::thread::hardware_concurrency());
+    workers = std::min(workers, (unsigned int) profiles.size());
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < workers; i++)
+    {
+        threads.push_back(std::thread([&profiles, &next]()
+                                      {
+                                          size_t idx;
+                                          while ((idx = next++) < profiles.size())
+                                          {
+                                              autoload_parse_profile(profiles[idx]);
+                                          }
+                                      }));
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+
+/**
+ *  What the autoload command does with a session when a StatusChange
+ *  signal arrives for it
+ */
+enum class AutoloadStep
+{
+    IGNORE,         //< Nothing to do, keep waiting
+    CONNECT,        //< The backend is ready, request the connection
+    PROVIDE_INPUT,  //< User input is needed before connecting again
+    CONNECTED,      //< The session is connected
+    FAILED          //< The session failed and must be disconnected
+};
+
+
+/**
+ *  Decides the next step for a session being started by the autoload
+ *  command, based on a StatusChange signal from that session
+ *
+ * @param status  StatusEvent with the reported status
+ * @param reason  std::string which will contain the failure reason when
+ *                AutoloadStep::FAILED is returned
+ *
+ * @return Returns the AutoloadStep to take
+ */
+static AutoloadStep autoload_status_step(const StatusEvent& status,
+                                         std::string& reason)
+{
+    if (StatusMajor::CONNECTION != status.major)
+    {
+        if (StatusMinor::PROC_KILLED == status.minor)
+        {
+            reason = "Backend process died";
+            return AutoloadStep::FAILED;
+        }
+        return AutoloadStep::IGNORE;
+    }
+
+    switch (status.minor)
+    {
+    case StatusMinor::CFG_OK:
+        return AutoloadStep::CONNECT;
+
+    case StatusMinor::CFG_REQUIRE_USER:
+        return AutoloadStep::PROVIDE_INPUT;
+
+    case StatusMinor::CONN_CONNECTED:
+        return AutoloadStep::CONNECTED;
+
+    case StatusMinor::CFG_ERROR:
+    case StatusMinor::CONN_FAILED:
+    case StatusMinor::CONN_AUTH_FAILED:
+    case StatusMinor::CONN_DISCONNECTED:
+        reason = StatusMinor_str[(unsigned int) status.minor]
+                 + (status.message.empty() ? "" : ": " + status.message);
+        return AutoloadStep::FAILED;
+
+    default:
+        return AutoloadStep::IGNORE;
+    }
+}
+
+#endif // OPENVPN3_OVPN3CLI_AUTOLOAD_PARSER_HPP
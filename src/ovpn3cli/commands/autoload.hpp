@@ -0,0 +1,558 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   autoload.hpp
+ *
+ * @brief  Command to import and start configuration profiles described
+ *         by .autoload files.
+ *
+ *         All the .autoload descriptors and their configuration profiles
+ *         are parsed in parallel before being imported.  The sessions to
+ *         automatically start are started with a bounded number of
+ *         sessions being set up at the same time, and their progress is
+ *         tracked via the StatusChange signals from the session manager.
+ *         See doxygen/openvpn3-autoload.md for the .autoload file format.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+
+#include "common/cmdargparser.hpp"
+#include "../autoload-parser.hpp"
+#include "../arghelpers.hpp"
+
+
+/**
+ *  Imports a parsed autoload profile into the configuration manager and
+ *  sets the configuration profile flags and overrides
+ *
+ * @param dbus     DBus connection to use
+ * @param confmgr  OpenVPN3ConfigurationProxy to the configuration manager
+ * @param prof     AutoloadProfile to import
+ */
+static void autoload_import(DBus& dbus,
+                            OpenVPN3ConfigurationProxy& confmgr,
+                            AutoloadProfile& prof)
+{
+    prof.config_path = confmgr.Import(prof.name, prof.profile, false, false);
+
+    OpenVPN3ConfigurationProxy cfgprx(dbus, prof.config_path);
+    if (prof.public_access)
+    {
+        cfgprx.SetPublicAccess(true);
+    }
+    if (prof.locked_down)
+    {
+        cfgprx.SetLockedDown(true);
+    }
+    if (prof.persist_tun)
+    {
+        cfgprx.SetPersistTun(true);
+    }
+    for (const auto& ov : prof.overrides)
+    {
+        if (OverrideType::boolean == ov.override.type)
+        {
+            cfgprx.SetOverride(ov.override, ov.boolValue);
+        }
+        else
+        {
+            cfgprx.SetOverride(ov.override, ov.strValue);
+        }
+    }
+}
+
+
+/**
+ *  Starts VPN sessions for a list of imported autoload profiles.  At most
+ *  max_parallel sessions are being set up at the same time; a new session
+ *  is started each time a session is connected or has failed.  The
+ *  progress is tracked via the StatusChange signals sent by the session
+ *  manager.
+ */
+class AutoloadSessionStarter : public DBusSignalSubscription
+{
+public:
+    /**
+     * @param dbus          DBus connection to use
+     * @param max_parallel  Maximum number of sessions being set up at once
+     * @param timeout       Seconds to wait for each session to connect
+     */
+    AutoloadSessionStarter(DBus& dbus, unsigned int max_parallel,
+                           unsigned int timeout)
+        : DBusSignalSubscription(dbus, OpenVPN3DBus_name_sessions,
+                                 OpenVPN3DBus_interf_sessions, ""),
+          dbus(dbus),
+          sessmgr(dbus, OpenVPN3DBus_rootp_sessions),
+          max_parallel(std::max(1U, max_parallel)),
+          timeout(timeout),
+          main_loop(nullptr),
+          next_profile(0),
+          connected(0),
+          failed(0)
+    {
+    }
+
+
+    ~AutoloadSessionStarter()
+    {
+        Cleanup();
+    }
+
+
+    /**
+     *  Starts all the sessions and waits until all of them have
+     *  connected or failed.
+     *
+     * @param start  std::vector of AutoloadProfile pointers to start
+     *
+     * @return Returns the number of sessions which failed to connect
+     */
+    unsigned int Run(std::vector<AutoloadProfile *> start)
+    {
+        profiles = start;
+        if (profiles.empty())
+        {
+            return 0;
+        }
+
+        Subscribe("StatusChange");
+        main_loop = g_main_loop_new(NULL, FALSE);
+        guint sigint_src = g_unix_signal_add(SIGINT, stop_handler, main_loop);
+        guint sigterm_src = g_unix_signal_add(SIGTERM, stop_handler, main_loop);
+
+        start_sessions();
+        if (!sessions.empty())
+        {
+            g_main_loop_run(main_loop);
+        }
+        g_source_remove(sigint_src);
+        g_source_remove(sigterm_src);
+        g_main_loop_unref(main_loop);
+        main_loop = nullptr;
+        Cleanup();
+
+        // Sessions still pending were interrupted
+        failed += sessions.size() + (profiles.size() - next_profile);
+        sessions.clear();
+        return failed;
+    }
+
+
+    void callback_signal_handler(GDBusConnection *connection,
+                                 const std::string sender_name,
+                                 const std::string object_path,
+                                 const std::string interface_name,
+                                 const std::string signal_name,
+                                 GVariant *parameters)
+    {
+        auto it = sessions.find(object_path);
+        if (sessions.end() == it || "StatusChange" != signal_name)
+        {
+            return;
+        }
+        process_status(*(it->second), StatusEvent(parameters));
+    }
+
+
+private:
+    struct SessionState
+    {
+        AutoloadProfile *profile = nullptr;
+        std::string path;
+        std::unique_ptr<OpenVPN3SessionProxy> proxy;
+        std::chrono::steady_clock::time_point started;
+        bool connect_sent = false;
+        guint timeout_src = 0;
+        AutoloadSessionStarter *starter = nullptr;
+    };
+
+    DBus& dbus;
+    OpenVPN3SessionProxy sessmgr;
+    unsigned int max_parallel;
+    unsigned int timeout;
+    GMainLoop *main_loop;
+    std::vector<AutoloadProfile *> profiles;
+    size_t next_profile;
+    std::map<std::string, std::unique_ptr<SessionState>> sessions;
+    unsigned int connected;
+    unsigned int failed;
+
+
+    /**
+     *  Takes the next step for a session, based on its status
+     *
+     * @param sess    SessionState of the session
+     * @param status  StatusEvent with the status of the session
+     */
+    void process_status(SessionState& sess, const StatusEvent& status)
+    {
+        std::string reason;
+        switch (autoload_status_step(status, reason))
+        {
+        case AutoloadStep::CONNECT:
+            try_connect(sess);
+            break;
+
+        case AutoloadStep::PROVIDE_INPUT:
+            // More input is needed before the connection can continue
+            sess.connect_sent = false;
+            try_connect(sess);
+            break;
+
+        case AutoloadStep::CONNECTED:
+            session_done(sess, true, "");
+            break;
+
+        case AutoloadStep::FAILED:
+            session_done(sess, false, reason);
+            break;
+
+        case AutoloadStep::IGNORE:
+            break;
+        }
+    }
+
+
+    /**
+     *  Starts new sessions until the concurrency window is full
+     */
+    void start_sessions()
+    {
+        while (sessions.size() < max_parallel
+               && next_profile < profiles.size())
+        {
+            AutoloadProfile *prof = profiles[next_profile++];
+            try
+            {
+                std::unique_ptr<SessionState> sess(new SessionState);
+                sess->profile = prof;
+                sess->started = std::chrono::steady_clock::now();
+                sess->path = sessmgr.NewTunnel(prof->config_path);
+                sess->proxy.reset(new OpenVPN3SessionProxy(dbus, sess->path));
+                // StatusChange signals are only sent to subscribers
+                sess->proxy->LogForward(true);
+                sess->starter = this;
+                if (timeout > 0)
+                {
+                    sess->timeout_src = g_timeout_add_seconds(timeout,
+                                                              session_timeout,
+                                                              sess.get());
+                }
+                SessionState *s = sess.get();
+                sessions[sess->path] = std::move(sess);
+
+                // Status changes sent before LogForward was enabled are
+                // lost, so start out with the current status
+                StatusEvent status;
+                try
+                {
+                    status = s->proxy->GetLastStatus();
+                }
+                catch (DBusException&)
+                {
+                    // No status changes have been sent yet
+                }
+                std::string reason;
+                if (AutoloadStep::IGNORE == autoload_status_step(status, reason))
+                {
+                    // The backend process may already be ready, otherwise
+                    // the CFG_OK status change will trigger the connection
+                    try_connect(*s);
+                }
+                else
+                {
+                    process_status(*s, status);
+                }
+            }
+            catch (DBusException& excp)
+            {
+                std::cout << "Failed to start \"" << prof->name << "\": "
+                          << excp.getRawError() << std::endl;
+                failed++;
+            }
+        }
+
+        if (sessions.empty() && main_loop)
+        {
+            g_main_loop_quit(main_loop);
+        }
+    }
+
+
+    /**
+     *  Requests the backend process to connect, if it is ready.  If user
+     *  credentials are needed, they are provided from the user-auth
+     *  section of the .autoload descriptor.
+     *
+     * @param sess  SessionState of the session to connect
+     */
+    void try_connect(SessionState& sess)
+    {
+        if (sess.connect_sent)
+        {
+            return;
+        }
+
+        for (unsigned int attempts = 3; attempts > 0; --attempts)
+        {
+            try
+            {
+                sess.proxy->Ready();
+                sess.proxy->Connect();
+                sess.connect_sent = true;
+                return;
+            }
+            catch (ReadyException& excp)
+            {
+                std::string err;
+                if (!provide_credentials(sess, err))
+                {
+                    session_done(sess, false, err);
+                    return;
+                }
+            }
+            catch (NotReadyException&)
+            {
+                // Wait for the backend process to signal it is ready
+                return;
+            }
+            catch (DBusException& excp)
+            {
+                session_done(sess, false, excp.getRawError());
+                return;
+            }
+        }
+        session_done(sess, false, "Backend process is not ready");
+    }
+
+
+    /**
+     *  Provides the credentials requested by the backend process
+     *
+     * @param sess  SessionState of the session requesting credentials
+     * @param err   std::string which will contain an error message on failure
+     *
+     * @return Returns true if all the requested credentials were provided
+     */
+    bool provide_credentials(SessionState& sess, std::string& err)
+    {
+        for (auto& type_group : sess.proxy->QueueCheckTypeGroup())
+        {
+            ClientAttentionType type;
+            ClientAttentionGroup group;
+            std::tie(type, group) = type_group;
+
+            if (ClientAttentionType::CREDENTIALS != type)
+            {
+                continue;
+            }
+
+            std::vector<struct RequiresSlot> reqslots;
+            sess.proxy->QueueFetchAll(reqslots, type, group);
+            for (auto& r : reqslots)
+            {
+                auto ua = sess.profile->user_auth.find(r.name);
+                if (sess.profile->user_auth.end() == ua)
+                {
+                    err = "The .autoload file is lacking details for \""
+                          + r.name + "\"";
+                    return false;
+                }
+                r.value = ua->second;
+                sess.proxy->ProvideResponse(r);
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     *  Reports the result of a session and starts the next session
+     *
+     * @param sess     SessionState of the session which has completed
+     * @param success  true if the session connected
+     * @param reason   std::string with the failure reason
+     */
+    void session_done(SessionState& sess, bool success,
+                      const std::string& reason)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()
+                                                - sess.started;
+        if (success)
+        {
+            std::cout << "Auto-started \"" << sess.profile->name << "\": "
+                      << sess.path << " (connected in "
+                      << std::fixed << std::setprecision(3) << elapsed.count()
+                      << " seconds)" << std::endl;
+            connected++;
+        }
+        else
+        {
+            std::cout << "WARNING: \"" << sess.profile->name
+                      << "\" was not auto-started: " << reason << std::endl;
+            try
+            {
+                sess.proxy->Disconnect();
+            }
+            catch (DBusException&)
+            {
+                // The session may already be gone
+            }
+            failed++;
+        }
+
+        if (sess.timeout_src > 0)
+        {
+            g_source_remove(sess.timeout_src);
+        }
+        std::string path(sess.path);
+        sessions.erase(path);  // sess is no longer valid
+        start_sessions();
+    }
+
+
+    static gboolean session_timeout(gpointer data)
+    {
+        SessionState *sess = (SessionState *) data;
+        sess->timeout_src = 0;
+        sess->starter->session_done(*sess, false, "Connection timed out");
+        return G_SOURCE_REMOVE;
+    }
+};
+
+
+/**
+ *  openvpn3 autoload command
+ *
+ *  Imports all configuration profiles in a directory which is accompanied
+ *  by an .autoload file and starts the sessions flagged for autostart.
+ *
+ * @param args  ParsedArgs object containing all related options and arguments
+ * @return Returns the exit code which will be returned to the calling shell
+ */
+static int cmd_autoload(ParsedArgs args)
+{
+    if (!args.Present("directory"))
+    {
+        throw CommandException("autoload", "Missing required --directory option");
+    }
+
+    unsigned int max_parallel = 4;
+    unsigned int timeout = 60;
+    try
+    {
+        if (args.Present("max-parallel"))
+        {
+            max_parallel = std::stoul(args.GetValue("max-parallel", 0));
+        }
+        if (args.Present("timeout"))
+        {
+            timeout = std::stoul(args.GetValue("timeout", 0));
+        }
+    }
+    catch (std::exception& excp)
+    {
+        throw CommandException("autoload", "Invalid numeric argument: "
+                               + std::string(excp.what()));
+    }
+
+    auto tstart = std::chrono::steady_clock::now();
+
+    std::vector<AutoloadProfile> profiles = autoload_find_profiles(args.GetValue("directory", 0));
+    autoload_parse_all(profiles);
+
+    try
+    {
+        DBus dbus(G_BUS_TYPE_SYSTEM);
+        dbus.Connect();
+        OpenVPN3ConfigurationProxy confmgr(dbus, OpenVPN3DBus_rootp_configuration);
+
+        std::vector<AutoloadProfile *> autostart;
+        for (auto& prof : profiles)
+        {
+            for (const auto& w : prof.warnings)
+            {
+                std::cout << "WARNING: " << prof.autoload_file << ": "
+                          << w << std::endl;
+            }
+            if (!prof.error.empty())
+            {
+                std::cout << "Could not parse \"" << prof.config_file
+                          << "\": " << prof.error << std::endl;
+                continue;
+            }
+
+            autoload_import(dbus, confmgr, prof);
+            std::cout << "Configuration \"" << prof.name << "\" imported: "
+                      << prof.config_path << std::endl;
+
+            if (prof.autostart)
+            {
+                if (args.Present("ignore-autostart"))
+                {
+                    std::cout << "Auto-start of \"" << prof.name
+                              << "\" was ignored." << std::endl;
+                }
+                else
+                {
+                    autostart.push_back(&prof);
+                }
+            }
+        }
+
+        AutoloadSessionStarter starter(dbus, max_parallel, timeout);
+        unsigned int failed = starter.Run(autostart);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()
+                                                - tstart;
+        std::cout << (autostart.size() - failed) << " of "
+                  << autostart.size() << " sessions connected, "
+                  << profiles.size() << " profiles processed in "
+                  << std::fixed << std::setprecision(3) << elapsed.count()
+                  << " seconds" << std::endl;
+        return (failed > 0 ? 3 : 0);
+    }
+    catch (DBusException& excp)
+    {
+        throw CommandException("autoload", excp.getRawError());
+    }
+}
+
+
+void RegisterCommands_autoload(Commands& ovpn3)
+{
+    auto cmd = ovpn3.AddCommand("autoload",
+                                "Import and start configurations described "
+                                "by .autoload files",
+                                cmd_autoload);
+    cmd->AddOption("directory", 'd', "DIR", true,
+                   "Directory with the configuration profiles to process");
+    cmd->AddOption("ignore-autostart",
+                   "Do not automatically start configurations");
+    cmd->AddOption("max-parallel", "NUM", true,
+                   "Maximum number of sessions being started at the same "
+                   "time (default: 4)");
+    cmd->AddOption("timeout", "SECONDS", true,
+                   "How long to wait for each session to connect, "
+                   "0 disables the timeout (default: 60)");
+}
@@ -185,6 +185,8 @@ static int cmd_configs_list(ParsedArgs args)
             continue;
         }
         OpenVPN3ConfigurationProxy cprx(G_BUS_TYPE_SYSTEM, cfg);
+        // Retrieve all the properties listed below in a single call
+        cprx.EnablePropertyCacheAll(std::chrono::seconds(10));
 
         if (!first)
         {
@@ -246,6 +248,22 @@ static int cmd_config_manage_show(OpenVPN3ConfigurationProxy& conf,
                   << std::setw(32) << "     Persistent tunnel: "
                   << (conf.GetPersistTun() ? "Yes" : "No") << std::endl;
 
+        OpenVPN3ConfigurationEval eval = conf.GetEvaluation();
+        std::cout << std::setw(32) << "                 Valid: "
+                  << (eval.valid ? "Yes" : "No - " + eval.message) << std::endl
+                  << std::setw(32) << "  Requires credentials: "
+                  << (eval.autologin ? "No" : "Yes") << std::endl;
+        if (!eval.static_challenge.empty())
+        {
+            std::cout << std::setw(32) << "      Static challenge: "
+                      << eval.static_challenge << std::endl;
+        }
+        for (const auto& remote : eval.remotes)
+        {
+            std::cout << std::setw(32) << "                Remote: "
+                      << remote << std::endl;
+        }
+
         std::cout << std::endl << "  Overrides: ";
         auto overrides = conf.GetOverrides();
         if (overrides.empty() && !showall)
@@ -262,7 +280,7 @@ static int cmd_config_manage_show(OpenVPN3ConfigurationProxy& conf,
             std::string value = "(not set)";
             for (auto & ov: overrides)
             {
-                if (ov.override.key == vo.key)
+                if (ov.override.id == vo.id)
                 {
                     if (OverrideType::boolean == ov.override.type)
                         value = ov.boolValue ? "true" : "false";
@@ -394,6 +412,12 @@ static int cmd_config_manage(ParsedArgs args)
                 else if (OverrideType::string == vo.type)
                 {
                     std::string value = args.GetValue(vo.key, 0);
+                    if (!vo.ValidValue(value))
+                    {
+                        throw CommandException("config-manage",
+                                               "Invalid value '" + value
+                                               + "' for --" + vo.key);
+                    }
                     conf.SetOverride(vo, value);
                     std::cout << "Set override '" + vo.key + "' to '" + value +"'"
                               << std::endl;
@@ -0,0 +1,325 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   debug.hpp
+ *
+ * @brief  Commands showing internal details of the OpenVPN 3 services,
+ *         meant for troubleshooting
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "dbus/core.hpp"
+#include "dbus/stats.hpp"
+
+using namespace openvpn;
+
+
+/**
+ *  Services providing the net.openvpn.v3.debug interface
+ */
+struct DebugService
+{
+    std::string name;
+    std::string busname;
+    std::string path;
+};
+
+static const std::vector<DebugService> debug_services = {
+    {"configmgr", OpenVPN3DBus_name_configuration, OpenVPN3DBus_rootp_configuration},
+    {"sessionmgr", OpenVPN3DBus_name_sessions, OpenVPN3DBus_rootp_sessions},
+    {"backends", OpenVPN3DBus_name_backends, OpenVPN3DBus_rootp_backends},
+    {"log", OpenVPN3DBus_name_log, OpenVPN3DBus_rootp_log}
+};
+
+
+/**
+ *  Provides the service names for command line completion
+ */
+std::string arghelper_debug_services()
+{
+    std::string ret;
+    for (const auto& s : debug_services)
+    {
+        ret += s.name + " ";
+    }
+    return ret;
+}
+
+
+std::string arghelper_debug_stats_sort()
+{
+    return "calls errors total p99";
+}
+
+
+/**
+ *  Retrieves the D-Bus call statistics of a service.  The service is not
+ *  started if it is not running.
+ *
+ * @param conn     GDBusConnection to the system bus
+ * @param svc      DebugService to query
+ * @param enabled  Set to true if the service collects the statistics
+ *
+ * @return Returns a std::vector<DBusCallStats::Entry> with the handlers
+ *         the service has run.  A DBusException is thrown on errors.
+ */
+static std::vector<DBusCallStats::Entry> fetch_dbus_stats(GDBusConnection *conn,
+                                                          const DebugService& svc,
+                                                          bool& enabled)
+{
+    GError *error = nullptr;
+    GVariant *res = g_dbus_connection_call_sync(conn,
+                                                svc.busname.c_str(),
+                                                svc.path.c_str(),
+                                                OpenVPN3DBus_interf_debug.c_str(),
+                                                "FetchDBusStats",
+                                                NULL,
+                                                G_VARIANT_TYPE("(ba(sssttta(tt)))"),
+                                                G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                                -1, NULL, &error);
+    if (!res)
+    {
+        std::string err(error ? error->message : "Unspecified error");
+        if (error)
+        {
+            g_error_free(error);
+        }
+        THROW_DBUSEXCEPTION("debug-stats", err);
+    }
+
+    gboolean en = false;
+    GVariantIter *entries = nullptr;
+    g_variant_get(res, "(ba(sssttta(tt)))", &en, &entries);
+    enabled = en;
+
+    std::vector<DBusCallStats::Entry> ret;
+    gchar *interf = nullptr;
+    gchar *member = nullptr;
+    gchar *kind = nullptr;
+    guint64 calls = 0;
+    guint64 errors = 0;
+    guint64 total = 0;
+    GVariantIter *hist = nullptr;
+    while (g_variant_iter_next(entries, "(sssttta(tt))", &interf, &member,
+                               &kind, &calls, &errors, &total, &hist))
+    {
+        DBusCallStats::Entry e;
+        e.interface = interf;
+        e.member = member;
+        e.kind = ("get" == std::string(kind) ? DBusCallStats::Kind::GET_PROPERTY
+                  : ("set" == std::string(kind) ? DBusCallStats::Kind::SET_PROPERTY
+                     : DBusCallStats::Kind::METHOD));
+        e.calls = calls;
+        e.errors = errors;
+        e.total_usec = total;
+
+        guint64 upper = 0;
+        guint64 count = 0;
+        while (g_variant_iter_next(hist, "(tt)", &upper, &count))
+        {
+            e.buckets.push_back({upper, count});
+        }
+        g_variant_iter_free(hist);
+        g_free(interf);
+        g_free(member);
+        g_free(kind);
+        ret.push_back(std::move(e));
+    }
+    g_variant_iter_free(entries);
+    g_variant_unref(res);
+    return ret;
+}
+
+
+/**
+ *  Formats a duration given in microseconds as milliseconds
+ */
+static std::string debug_stats_msec(double usec)
+{
+    std::stringstream s;
+    s << std::fixed << std::setprecision(3) << (usec / 1000.0);
+    return s.str();
+}
+
+
+/**
+ *  Shows the D-Bus call statistics of the running OpenVPN 3 services
+ *
+ * @param args  ParsedArgs object containing all related options and arguments
+ * @return Returns the exit code which will be returned to the calling shell
+ */
+static int cmd_debug_stats(ParsedArgs args)
+{
+    std::string only = (args.Present("service")
+                        ? args.GetValue("service", 0) : "");
+    if (!only.empty()
+        && debug_services.end() == std::find_if(debug_services.begin(),
+                                                debug_services.end(),
+                                                [&only](const DebugService& s)
+                                                {
+                                                    return s.name == only;
+                                                }))
+    {
+        throw CommandException("debug-stats", "Unknown service: " + only);
+    }
+
+    std::string sort = (args.Present("sort")
+                        ? args.GetValue("sort", 0) : "total");
+    std::function<uint64_t(const DBusCallStats::Entry&)> sort_key;
+    if ("calls" == sort)
+    {
+        sort_key = [](const DBusCallStats::Entry& e) { return e.calls; };
+    }
+    else if ("errors" == sort)
+    {
+        sort_key = [](const DBusCallStats::Entry& e) { return e.errors; };
+    }
+    else if ("total" == sort)
+    {
+        sort_key = [](const DBusCallStats::Entry& e) { return e.total_usec; };
+    }
+    else if ("p99" == sort)
+    {
+        sort_key = [](const DBusCallStats::Entry& e)
+            {
+                return DBusLatencyHistogram::Percentile(e.buckets, 0.99);
+            };
+    }
+    else
+    {
+        throw CommandException("debug-stats", "Invalid --sort value: " + sort);
+    }
+
+    DBus dbus(G_BUS_TYPE_SYSTEM);
+    dbus.Connect();
+
+    bool first = true;
+    for (const auto& svc : debug_services)
+    {
+        if (!only.empty() && svc.name != only)
+        {
+            continue;
+        }
+
+        if (!first)
+        {
+            std::cout << std::endl;
+        }
+        first = false;
+        std::cout << "Service: " << svc.busname << std::endl;
+
+        std::vector<DBusCallStats::Entry> stats;
+        bool enabled = false;
+        try
+        {
+            stats = fetch_dbus_stats(dbus.GetConnection(), svc, enabled);
+        }
+        catch (DBusException& excp)
+        {
+            std::cout << "    Not available: " << excp.getRawError()
+                      << std::endl;
+            continue;
+        }
+        if (!enabled)
+        {
+            std::cout << "    Statistics are disabled (OPENVPN3_DBUS_STATS=0)"
+                      << std::endl;
+            continue;
+        }
+        if (stats.empty())
+        {
+            std::cout << "    No D-Bus calls handled yet" << std::endl;
+            continue;
+        }
+
+        std::stable_sort(stats.begin(), stats.end(),
+                         [&sort_key](const DBusCallStats::Entry& a,
+                                     const DBusCallStats::Entry& b)
+                         {
+                             return sort_key(a) > sort_key(b);
+                         });
+
+        std::cout << std::setfill(' ') << std::left
+                  << std::setw(44) << "Handler" << std::right
+                  << std::setw(9) << "Calls"
+                  << std::setw(7) << "Errors"
+                  << std::setw(10) << "Mean ms"
+                  << std::setw(10) << "p50 ms"
+                  << std::setw(10) << "p99 ms"
+                  << std::setw(10) << "Max ms" << std::endl;
+        std::cout << std::setw(100) << std::setfill('-') << "-"
+                  << std::setfill(' ') << std::endl;
+        for (const auto& e : stats)
+        {
+            std::string intf = e.interface;
+            if (0 == intf.find("net.openvpn.v3."))
+            {
+                intf = intf.substr(15);
+            }
+            std::string name = intf + "." + e.member;
+            if (DBusCallStats::Kind::METHOD != e.kind)
+            {
+                name += std::string(" [") + DBusCallStats::KindName(e.kind) + "]";
+            }
+
+            std::cout << std::left << std::setw(44) << name << std::right
+                      << std::setw(9) << e.calls
+                      << std::setw(7) << e.errors
+                      << std::setw(10)
+                      << debug_stats_msec(e.calls > 0
+                                          ? (double) e.total_usec / e.calls : 0)
+                      << std::setw(10)
+                      << debug_stats_msec(DBusLatencyHistogram::Percentile(e.buckets, 0.5))
+                      << std::setw(10)
+                      << debug_stats_msec(DBusLatencyHistogram::Percentile(e.buckets, 0.99))
+                      << std::setw(10)
+                      << debug_stats_msec(e.buckets.empty() ? 0 : e.buckets.back().first)
+                      << std::endl;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ *  Declare all the supported commands and their options and arguments.
+ *
+ *  This function should only be called once by the main openvpn3 program,
+ *  which sends a reference to the Commands argument parser which is used
+ *  for this registration process
+ *
+ * @param ovpn3  Commands object where to register all the commands, options
+ *               and arguments.
+ */
+void RegisterCommands_debug(Commands& ovpn3)
+{
+    auto cmd = ovpn3.AddCommand("debug-stats",
+                                "Show D-Bus call statistics of the OpenVPN 3 services",
+                                cmd_debug_stats);
+    cmd->AddOption("service", "NAME", true,
+                   "Only show the statistics of this service",
+                   arghelper_debug_services);
+    cmd->AddOption("sort", "KEY", true,
+                   "Sort by calls, errors, total or p99 (default: total)",
+                   arghelper_debug_stats_sort);
+}
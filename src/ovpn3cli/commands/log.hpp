@@ -93,7 +93,6 @@ static int cmd_log_listen(ParsedArgs args)
 
     Logger::Ptr session_log;
     Logger::Ptr config_log;
-    bool log_flag_reset = false;
     std::string session_path = "";
     DBus dbuscon(G_BUS_TYPE_SYSTEM);
     dbuscon.Connect();
@@ -102,17 +101,11 @@ static int cmd_log_listen(ParsedArgs args)
     {
         session_path = args.GetValue("session-path", 0);
 
-        // Check if the session manager will forward log events for this
-        // session.  If not, we must enable it - and if we do this, we
-        // track that we modified this setting.
-        OpenVPN3SessionProxy sesprx(G_BUS_TYPE_SYSTEM, session_path);
+        // Ask the session manager to forward the log events of this
+        // session to us.  This stops when we disconnect from the bus.
+        OpenVPN3SessionProxy sesprx(dbuscon, session_path);
         sesprx.Ping();
-
-        if (!sesprx.GetReceiveLogEvents())
-        {
-            sesprx.SetReceiveLogEvents(true);
-            log_flag_reset = true;
-        }
+        sesprx.LogForward(true);
         // Setup a Logger object for the provided session path
         session_log.reset(new Logger(dbuscon.GetConnection(),
                                      OpenVPN3DBus_interf_sessions,
@@ -153,12 +146,17 @@ static int cmd_log_listen(ParsedArgs args)
     // Start the main loop.  This will exit on SIGINT or SIGTERM signals only
     g_main_loop_run(main_loop);
 
-    // If we enabled the receive_log_events property in a session object,
-    // disable it again when we exit.
-    if (!session_path.empty() && log_flag_reset)
+    if (!session_path.empty())
     {
-        OpenVPN3SessionProxy sesprx(G_BUS_TYPE_SYSTEM, session_path);
-        sesprx.SetReceiveLogEvents(false);
+        try
+        {
+            OpenVPN3SessionProxy sesprx(dbuscon, session_path);
+            sesprx.LogForward(false);
+        }
+        catch (DBusException&)
+        {
+            // The session may be gone already
+        }
     }
 
     // Clean-up and shut down.
@@ -35,12 +35,24 @@
  * @param session_path  std::string containing the D-Bus session path
  * @return Returns the statistics as the ConnectionStats type.
  */
-static ConnectionStats fetch_stats(std::string session_path)
+static ConnectionStats fetch_stats(std::string session_path,
+                                   ConnectionStats *timing = nullptr)
 {
     try
     {
         OpenVPN3SessionProxy session(G_BUS_TYPE_SYSTEM, session_path);
         session.Ping();
+        if (timing)
+        {
+            try
+            {
+                *timing = session.GetConnectionTiming();
+            }
+            catch (DBusException&)
+            {
+                // Not provided by older session managers
+            }
+        }
         return session.GetConnectionStats();
     }
     catch (DBusException& err)
@@ -81,14 +93,47 @@ std::string statistics_plain(ConnectionStats& stats)
 }
 
 
+/**
+ *  Converts the connection setup timing into a plain-text string
+ *
+ * @param timing  ConnectionStats object with the phase durations in
+ *                microseconds
+ * @return Returns std::string with the timing pre-formatted as text/plain
+ */
+static std::string timing_plain(ConnectionStats& timing)
+{
+    if (timing.size() < 1)
+    {
+        return "";
+    }
+
+    std::stringstream out;
+    out << "Connection setup time (ms):" << std::endl;
+    for (auto& sd : timing)
+    {
+        out << "     "
+            << sd.key
+            << std::setw(20-sd.key.size()) << std::setfill('.') << "."
+            << std::setw(12) << std::setfill('.')
+            << std::fixed << std::setprecision(1) << (sd.value / 1000.0)
+            << std::endl;
+    }
+    out << std::endl;
+    return out.str();
+}
+
+
 /**
  *  Similiar to statistics_plain(), but returns a JSON string blob with the
  *  statistics data
  *
- * @param stats  The ConnectionStats object returned by fetch_stats()
+ * @param stats   The ConnectionStats object returned by fetch_stats()
+ * @param timing  The connection setup timing, added as a
+ *                "connection_timing" object with microsecond values
  * @return Returns std::string with the statistics pre-formatted as JSON
  *  */
-static std::string statistics_json(ConnectionStats& stats)
+static std::string statistics_json(ConnectionStats& stats,
+                                   ConnectionStats& timing)
 {
     Json::Value outdata;
 
@@ -96,6 +141,10 @@ static std::string statistics_json(ConnectionStats& stats)
     {
         outdata[sd.key] = (Json::Value::Int64) sd.value;
     }
+    for (auto& sd : timing)
+    {
+        outdata["connection_timing"][sd.key] = (Json::Value::Int64) sd.value;
+    }
     std::stringstream res;
     res << outdata;
     res << std::endl;
@@ -120,10 +169,17 @@ static int cmd_session_stats(ParsedArgs args)
     }
     try
     {
-        ConnectionStats stats = fetch_stats(args.GetValue("path", 0));
+        ConnectionStats timing;
+        ConnectionStats stats = fetch_stats(args.GetValue("path", 0), &timing);
 
-        std::cout << (args.Present("json") ? statistics_json(stats)
-                                           : statistics_plain(stats));
+        if (args.Present("json"))
+        {
+            std::cout << statistics_json(stats, timing);
+        }
+        else
+        {
+            std::cout << statistics_plain(stats) << timing_plain(timing);
+        }
         return 0;
     }
     catch (...)
@@ -188,9 +244,9 @@ static int cmd_session_start(ParsedArgs args)
 
         std::string sessionpath = sessmgr.NewTunnel(cfgpath);
 
-        sleep(1);  // Allow session to be established (FIXME: Signals?)
         std::cout << "Session path: " << sessionpath << std::endl;
         OpenVPN3SessionProxy session(G_BUS_TYPE_SYSTEM, sessionpath);
+        OpenVPN3SessionStatusWatch status_watch(session);
 
         unsigned int loops = 10;
         while (loops > 0)
@@ -199,49 +255,51 @@ static int cmd_session_start(ParsedArgs args)
             try
             {
                 session.Ready();  // If not, an exception will be thrown
+
+                // Only the status changes caused by this Connect()
+                // call are of interest
+                status_watch.Discard();
                 session.Connect();
 
-                // Allow approx 30 seconds to establish connection; one loop
-                // will take about 1.3 seconds.
-                unsigned int attempts = 23;
+                // Allow approx 30 seconds to establish connection
                 StatusEvent s;
-                while (attempts > 0)
+                bool done = status_watch.Wait(
+                                [](const StatusEvent& st)
+                                {
+                                    return (StatusMajor::CONNECTION == st.major
+                                            && (StatusMinor::CONN_CONNECTED == st.minor
+                                                || StatusMinor::CONN_DISCONNECTED == st.minor
+                                                || StatusMinor::CONN_FAILED == st.minor
+                                                || StatusMinor::CONN_AUTH_FAILED == st.minor
+                                                || StatusMinor::CFG_ERROR == st.minor
+                                                || StatusMinor::CFG_REQUIRE_USER == st.minor))
+                                           || StatusMinor::PROC_KILLED == st.minor;
+                                },
+                                std::chrono::seconds(30), s);
+
+                if (done && s.minor == StatusMinor::CONN_CONNECTED)
                 {
-                    attempts--;
-                    usleep(300000);  // sleep 0.3 seconds - avg setup time
-                    s = session.GetLastStatus();
-                    if (s.minor == StatusMinor::CONN_CONNECTED)
-                    {
-                        std::cout << "Connected" << std::endl;
-                        return 0;
-                    }
-                    else if (s.minor == StatusMinor::CONN_DISCONNECTED)
-                    {
-                        attempts = 0;
-                        break;
-                    }
-                    else if (s.minor == StatusMinor::CFG_REQUIRE_USER)
-                    {
-                        break;
-                    }
-                    sleep(1);  // If not yet connected, wait for 1 second
+                    std::cout << "Connected" << std::endl;
+                    return 0;
+                }
+                else if (done && s.minor == StatusMinor::CFG_REQUIRE_USER)
+                {
+                    // More input is needed, which Ready() will report
+                    continue;
                 }
 
-                if (attempts < 1)
+                // FIXME: Look into using exceptions here, catch more
+                // fine grained connection issues from the backend
+                std::cout << "Failed to connect "
+                          << "[" << StatusMajor_str[(unsigned int)s.major]
+                          << " / " << StatusMinor_str[(unsigned int)s.minor]
+                          << "]" << std::endl;
+                if (!s.message.empty())
                 {
-                    // FIXME: Look into using exceptions here, catch more
-                    // fine grained connection issues from the backend
-                    std::cout << "Failed to connect "
-                              << "[" << StatusMajor_str[(unsigned int)s.major]
-                              << " / " << StatusMinor_str[(unsigned int)s.minor]
-                              << "]" << std::endl;
-                    if (!s.message.empty())
-                    {
-                        std::cout << s.message << std::endl;
-                    }
-                    session.Disconnect();
-                    return 3;
+                    std::cout << s.message << std::endl;
                 }
+                session.Disconnect();
+                return 3;
             }
             catch (ReadyException& err)
             {
@@ -277,11 +335,25 @@ static int cmd_session_start(ParsedArgs args)
                     }
                 }
             }
+            catch (NotReadyException&)
+            {
+                // The backend process has not completed its start-up
+                // yet; it reports CFG_OK when it is ready to connect
+                StatusEvent s;
+                status_watch.Wait(
+                    [](const StatusEvent& st)
+                    {
+                        return StatusMajor::CONNECTION == st.major
+                               && (StatusMinor::CFG_OK == st.minor
+                                   || StatusMinor::CFG_REQUIRE_USER == st.minor
+                                   || StatusMinor::CFG_ERROR == st.minor);
+                    },
+                    std::chrono::seconds(5), s);
+            }
             catch (DBusException& err)
             {
                 std::stringstream errm;
-                errm << "Failed to start new session: "
-                     << err.getRawError();
+                errm << "Failed to start new session: " << err.getRawError();
                 throw CommandException("session-start", errm.str());
             }
         }
@@ -320,6 +392,8 @@ static int cmd_session_list(ParsedArgs args)
             continue;
         }
         OpenVPN3SessionProxy sprx(G_BUS_TYPE_SYSTEM, sessp);
+        // Retrieve all the properties listed below in a single call
+        sprx.EnablePropertyCacheAll(std::chrono::seconds(10));
 
         if (first)
         {
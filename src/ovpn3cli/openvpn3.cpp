@@ -42,6 +42,8 @@
 #include "commands/config.hpp"
 #include "commands/session.hpp"
 #include "commands/log.hpp"
+#include "commands/autoload.hpp"
+#include "commands/debug.hpp"
 
 
 /**
@@ -72,6 +74,8 @@ int main(int argc, char **argv)
     RegisterCommands_config(openvpn3);
     RegisterCommands_session(openvpn3);
     RegisterCommands_log(openvpn3);
+    RegisterCommands_autoload(openvpn3);
+    RegisterCommands_debug(openvpn3);
 
     try
     {
@@ -280,7 +280,7 @@ class Session(object):
     #
     def LogCallback(self, cbfnc):
         self.__session_intf.connect_to_signal('Log', cbfnc)
-        self.SetProperty('receive_log_events', True)
+        self.__session_intf.LogForward(True)
 
 
     ##
@@ -292,6 +292,7 @@ class Session(object):
     #
     def StatusChangeCallback(self, cbfnc):
         self.__session_intf.connect_to_signal('StatusChange', cbfnc)
+        self.__session_intf.LogForward(True)
 
 
     ##
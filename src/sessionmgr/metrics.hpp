@@ -0,0 +1,490 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   metrics.hpp
+ *
+ * @brief  Session manager metrics in the Prometheus text exposition format
+ *
+ *         The session manager collects a few latency histograms of its
+ *         own and renders them, together with the D-Bus handler latencies
+ *         recorded by DBusCallStats and the state of all sessions, as a
+ *         single text document.  This document is available via the
+ *         FetchMetrics D-Bus method and, optionally, via a local Unix
+ *         socket which can be scraped over plain HTTP.
+ */
+
+#ifndef OPENVPN3_SESSIONMGR_METRICS_HPP
+#define OPENVPN3_SESSIONMGR_METRICS_HPP
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gio/gio.h>
+#include <gio/gunixsocketaddress.h>
+
+#include <openvpn/common/rc.hpp>
+
+#include "dbus/core.hpp"
+#include "dbus/stats.hpp"
+
+using namespace openvpn;
+
+
+/**
+ *  Simple helper rendering metrics in the Prometheus text format
+ */
+class MetricsWriter
+{
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Labels;
+
+
+    /**
+     *  Starts a new metric family
+     *
+     * @param name  Metric name
+     * @param type  Metric type; counter, gauge or histogram
+     * @param help  Short description of the metric
+     */
+    void Family(const std::string& name, const std::string& type,
+                const std::string& help)
+    {
+        out << "# HELP " << name << " " << help << "\n"
+            << "# TYPE " << name << " " << type << "\n";
+    }
+
+
+    /**
+     *  Adds a sample to the current metric family
+     *
+     * @param name    Metric name, including any _bucket/_sum/_count suffix
+     * @param labels  Labels of this sample
+     * @param value   Sample value
+     */
+    template <typename T>
+    void Sample(const std::string& name, const Labels& labels, T value)
+    {
+        out << name;
+        if (!labels.empty())
+        {
+            out << "{";
+            bool first = true;
+            for (const auto& l : labels)
+            {
+                out << (first ? "" : ",") << l.first << "=\""
+                    << escape(l.second) << "\"";
+                first = false;
+            }
+            out << "}";
+        }
+        out << " " << value << "\n";
+    }
+
+
+    std::string str() const
+    {
+        return out.str();
+    }
+
+
+private:
+    std::stringstream out;
+
+
+    static std::string escape(const std::string& val)
+    {
+        std::string ret;
+        for (const char c : val)
+        {
+            switch (c)
+            {
+            case '\\':
+                ret += "\\\\";
+                break;
+            case '"':
+                ret += "\\\"";
+                break;
+            case '\n':
+                ret += "\\n";
+                break;
+            default:
+                ret += c;
+            }
+        }
+        return ret;
+    }
+};
+
+
+
+/**
+ *  Cumulative histogram with fixed bucket boundaries
+ */
+class MetricsHistogram
+{
+public:
+    MetricsHistogram(const std::vector<double>& bounds)
+        : bounds(bounds),
+          buckets(bounds.size(), 0),
+          count(0),
+          sum(0.0)
+    {
+    }
+
+
+    void Observe(double value)
+    {
+        for (size_t i = 0; i < bounds.size(); ++i)
+        {
+            if (value <= bounds[i])
+            {
+                ++buckets[i];
+            }
+        }
+        ++count;
+        sum += value;
+    }
+
+
+    /**
+     *  Adds the samples of this histogram to a metric family
+     *
+     * @param w       MetricsWriter to write to
+     * @param name    Base name of the metric family
+     * @param labels  Labels identifying this histogram in the family
+     */
+    void Write(MetricsWriter& w, const std::string& name,
+               const MetricsWriter::Labels& labels) const
+    {
+        for (size_t i = 0; i < bounds.size(); ++i)
+        {
+            MetricsWriter::Labels bl(labels);
+            std::stringstream le;
+            le << bounds[i];
+            bl.push_back({"le", le.str()});
+            w.Sample(name + "_bucket", bl, buckets[i]);
+        }
+        MetricsWriter::Labels inf(labels);
+        inf.push_back({"le", "+Inf"});
+        w.Sample(name + "_bucket", inf, count);
+        w.Sample(name + "_sum", labels, sum);
+        w.Sample(name + "_count", labels, count);
+    }
+
+
+private:
+    std::vector<double> bounds;
+    std::vector<uint64_t> buckets;
+    uint64_t count;
+    double sum;
+};
+
+
+
+/**
+ *  Snapshot of the state of a single session
+ */
+struct SessionMetrics
+{
+    std::string path;
+    uid_t owner;
+    bool registered;
+    pid_t backend_pid;
+    StatusMajor status_major;
+    StatusMinor status_minor;
+    unsigned int reconnects;
+    std::time_t connected_since;  /**< 0 when not connected */
+    std::map<std::string, int64_t> statistics;
+};
+
+
+
+/**
+ *  Metrics collected by the session manager itself.  A single instance
+ *  is shared between the SessionManagerObject and all SessionObjects.
+ */
+class SessionManagerMetrics : public RC<thread_safe_refcount>
+{
+public:
+    typedef RCPtr<SessionManagerMetrics> Ptr;
+
+    SessionManagerMetrics()
+        : spawn_latency({0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30})
+    {
+    }
+
+
+    /**
+     *  Records the time it took from requesting a new backend process
+     *  until it completed the registration with the session manager
+     *
+     * @param duration  Time spent starting the backend
+     */
+    void ObserveSpawn(std::chrono::steady_clock::duration duration)
+    {
+        spawn_latency.Observe(seconds(duration));
+    }
+
+
+    /**
+     *  Records the time spent in a phase of establishing a connection
+     *
+     * @param phase  Connection phase name, as reported by the backend
+     * @param usec   Time spent in this phase, in microseconds
+     */
+    void ObserveConnectPhase(const std::string& phase, int64_t usec)
+    {
+        auto it = connect_phases.find(phase);
+        if (connect_phases.end() == it)
+        {
+            it = connect_phases.insert({phase, MetricsHistogram(
+                        {0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60})}).first;
+        }
+        it->second.Observe(usec / 1000000.0);
+    }
+
+
+    void Write(MetricsWriter& w) const
+    {
+        w.Family("openvpn3_sessionmgr_backend_start_seconds", "histogram",
+                 "Time from starting a backend process until it registered");
+        spawn_latency.Write(w, "openvpn3_sessionmgr_backend_start_seconds", {});
+
+        write_handler_latency(w);
+
+        w.Family("openvpn3_session_connect_phase_seconds", "histogram",
+                 "Time spent in each phase of establishing connections");
+        for (const auto& p : connect_phases)
+        {
+            p.second.Write(w, "openvpn3_session_connect_phase_seconds",
+                           {{"phase", p.first}});
+        }
+    }
+
+
+private:
+    MetricsHistogram spawn_latency;
+    std::map<std::string, MetricsHistogram> connect_phases;
+
+
+    /**
+     *  Renders the D-Bus handler latencies recorded by DBusCallStats.
+     *  Its fine grained buckets are folded into coarser buckets; a call
+     *  is only counted in a bucket if the whole DBusCallStats bucket it
+     *  was recorded in lies below the bucket boundary.
+     */
+    static void write_handler_latency(MetricsWriter& w)
+    {
+        static const std::vector<double> bounds = {0.0005, 0.001, 0.0025,
+                                                   0.005, 0.01, 0.025,
+                                                   0.05, 0.1, 0.25, 0.5,
+                                                   1, 5};
+        const std::string name = "openvpn3_sessionmgr_dbus_handler_seconds";
+
+        w.Family(name, "histogram", "Time spent handling D-Bus calls");
+        for (const auto& e : DBusCallStats::Snapshot())
+        {
+            MetricsWriter::Labels labels = {{"interface", e.interface},
+                                            {"member", e.member},
+                                            {"kind", DBusCallStats::KindName(e.kind)}};
+            for (const double bound : bounds)
+            {
+                uint64_t count = 0;
+                for (const auto& b : e.buckets)
+                {
+                    if (b.first <= bound * 1000000)
+                    {
+                        count += b.second;
+                    }
+                }
+                MetricsWriter::Labels bl(labels);
+                std::stringstream le;
+                le << bound;
+                bl.push_back({"le", le.str()});
+                w.Sample(name + "_bucket", bl, count);
+            }
+            MetricsWriter::Labels inf(labels);
+            inf.push_back({"le", "+Inf"});
+            w.Sample(name + "_bucket", inf, e.calls);
+            w.Sample(name + "_sum", labels, e.total_usec / 1000000.0);
+            w.Sample(name + "_count", labels, e.calls);
+        }
+    }
+
+
+    static double seconds(std::chrono::steady_clock::duration d)
+    {
+        return std::chrono::duration<double>(d).count();
+    }
+};
+
+
+
+/**
+ *  Serves the metrics on a local Unix socket.  Each connection gets the
+ *  current metrics document as a minimal HTTP/1.0 response, which is
+ *  understood both by HTTP clients and Prometheus scrapers capable of
+ *  using Unix sockets.
+ */
+class MetricsSocket
+{
+public:
+    typedef std::function<std::string()> Generator;
+
+
+    /**
+     *  Starts listening on a Unix socket.  The socket is created with its
+     *  final permissions; only the service account and its group may
+     *  read the metrics.  This changes the process umask while binding,
+     *  so it must be called before any other threads are started.
+     *
+     * @param path       File system path of the socket.  An existing
+     *                   socket file is replaced, any other kind of file
+     *                   is refused.
+     * @param generator  Function returning the current metrics document
+     */
+    MetricsSocket(const std::string& path, Generator generator)
+        : path(path),
+          generator(generator),
+          service(nullptr)
+    {
+        struct stat st;
+        if (0 == lstat(path.c_str(), &st))
+        {
+            if (!S_ISSOCK(st.st_mode))
+            {
+                THROW_DBUSEXCEPTION("MetricsSocket",
+                                    path + " exists and is not a socket");
+            }
+            unlink(path.c_str());
+        }
+        else if (ENOENT != errno)
+        {
+            THROW_DBUSEXCEPTION("MetricsSocket",
+                                "Could not check " + path + ": "
+                                + std::string(strerror(errno)));
+        }
+
+        service = g_socket_service_new();
+        GSocketAddress *addr = g_unix_socket_address_new(path.c_str());
+        GError *error = nullptr;
+        mode_t old_umask = umask(0117);
+        gboolean ok = g_socket_listener_add_address(G_SOCKET_LISTENER(service),
+                                                    addr,
+                                                    G_SOCKET_TYPE_STREAM,
+                                                    G_SOCKET_PROTOCOL_DEFAULT,
+                                                    NULL, NULL, &error);
+        umask(old_umask);
+        g_object_unref(addr);
+        if (!ok)
+        {
+            std::string err(error->message);
+            g_error_free(error);
+            g_object_unref(service);
+            THROW_DBUSEXCEPTION("MetricsSocket",
+                                "Could not listen on " + path + ": " + err);
+        }
+
+        g_signal_connect(service, "incoming", G_CALLBACK(incoming), this);
+        g_socket_service_start(service);
+    }
+
+
+    ~MetricsSocket()
+    {
+        g_socket_service_stop(service);
+        g_socket_listener_close(G_SOCKET_LISTENER(service));
+        g_object_unref(service);
+        unlink(path.c_str());
+    }
+
+
+private:
+    struct Request
+    {
+        GSocketConnection *conn;
+        std::string response;
+        char buffer[1024];
+    };
+
+    std::string path;
+    Generator generator;
+    GSocketService *service;
+
+
+    static gboolean incoming(GSocketService *service,
+                             GSocketConnection *conn,
+                             GObject *source, gpointer this_ptr)
+    {
+        MetricsSocket *obj = (MetricsSocket *) this_ptr;
+
+        Request *req = new Request;
+        req->conn = (GSocketConnection *) g_object_ref(conn);
+
+        std::string body = obj->generator();
+        req->response = "HTTP/1.0 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                        "\r\n" + body;
+
+        // Consume the request before responding; its content is ignored
+        g_input_stream_read_async(g_io_stream_get_input_stream(G_IO_STREAM(conn)),
+                                  req->buffer, sizeof(req->buffer),
+                                  G_PRIORITY_DEFAULT, NULL,
+                                  request_read, req);
+        return TRUE;
+    }
+
+
+    static void request_read(GObject *source, GAsyncResult *res, gpointer req_ptr)
+    {
+        Request *req = (Request *) req_ptr;
+        (void) g_input_stream_read_finish(G_INPUT_STREAM(source), res, NULL);
+
+        g_output_stream_write_all_async(g_io_stream_get_output_stream(G_IO_STREAM(req->conn)),
+                                        req->response.data(),
+                                        req->response.size(),
+                                        G_PRIORITY_DEFAULT, NULL,
+                                        response_written, req);
+    }
+
+
+    static void response_written(GObject *source, GAsyncResult *res, gpointer req_ptr)
+    {
+        Request *req = (Request *) req_ptr;
+        (void) g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), res,
+                                                NULL, NULL);
+        g_io_stream_close(G_IO_STREAM(req->conn), NULL, NULL);
+        g_object_unref(req->conn);
+        delete req;
+    }
+};
+
+#endif // OPENVPN3_SESSIONMGR_METRICS_HPP
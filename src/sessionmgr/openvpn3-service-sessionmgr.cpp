@@ -98,12 +98,39 @@ static int session_manager(ParsedArgs args)
     }
     sessmgr.SetManagerLogLevel(log_level);
 
+    if (args.Present("metrics-socket"))
+    {
+        sessmgr.SetMetricsSocket(args.GetValue("metrics-socket", 0));
+    }
+
+    if (args.Present("state-file"))
+    {
+        sessmgr.SetStateFile(args.GetValue("state-file", 0));
+    }
+
+    double reconnect_rate = 0;
+    unsigned int reconnect_burst = 5;
+    unsigned int reconnect_jitter = 1000;
+    if (args.Present("reconnect-rate"))
+    {
+        reconnect_rate = std::atof(args.GetValue("reconnect-rate", 0).c_str());
+    }
+    if (args.Present("reconnect-burst"))
+    {
+        reconnect_burst = std::atoi(args.GetValue("reconnect-burst", 0).c_str());
+    }
+    if (args.Present("reconnect-jitter"))
+    {
+        reconnect_jitter = std::atoi(args.GetValue("reconnect-jitter", 0).c_str());
+    }
+    sessmgr.SetReconnectPolicy(reconnect_rate, reconnect_burst,
+                               reconnect_jitter);
+
     IdleCheck::Ptr idle_exit;
     if (idle_wait_min > 0)
     {
         idle_exit.reset(new IdleCheck(main_loop,
                                       std::chrono::minutes(idle_wait_min)));
-        idle_exit->SetPollTime(std::chrono::seconds(30));
         sessmgr.EnableIdleCheck(idle_exit);
     }
     sessmgr.Setup();
@@ -123,7 +150,6 @@ static int session_manager(ParsedArgs args)
     if (idle_wait_min > 0)
     {
         idle_exit->Disable();
-        idle_exit->Join();
     }
 
     return 0;
@@ -146,6 +172,21 @@ int main(int argc, char **argv)
     argparser.AddOption("idle-exit", "MINUTES", true,
                         "How long to wait before exiting if being idle. "
                         "0 disables it (Default: 3 minutes)");
+    argparser.AddOption("metrics-socket", "PATH", true,
+                        "Provide session metrics in the Prometheus text "
+                        "format on a Unix socket at PATH");
+    argparser.AddOption("state-file", "FILE", true,
+                        "Record the running sessions in FILE and take them "
+                        "over again when restarted");
+    argparser.AddOption("reconnect-rate", "RATE", true,
+                        "Reconnects admitted per second across all sessions. "
+                        "0 disables reconnect coordination (Default: 0)");
+    argparser.AddOption("reconnect-burst", "NUM", true,
+                        "Reconnects admitted at once before queuing "
+                        "(Default: 5)");
+    argparser.AddOption("reconnect-jitter", "MSECS", true,
+                        "Maximum random delay before a queued reconnect "
+                        "is resumed (Default: 1000)");
 
     try
     {
@@ -29,6 +29,10 @@
 #ifndef OPENVPN3_DBUS_PROXY_SESSION_HPP
 #define OPENVPN3_DBUS_PROXY_SESSION_HPP
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <iostream>
 
 #include "dbus/core.hpp"
@@ -71,6 +75,28 @@ public:
 #define THROW_READYEXCEPTION(fault_data) throw ReadyException(fault_data, __FILE__, __LINE__, __FUNCTION__)
 
 
+/**
+ * This exception is thrown when the OpenVPN3SessionProxy::Ready() call
+ * indicates the VPN backend client process has not completed its
+ * start-up yet.
+ */
+class NotReadyException : public DBusException
+{
+public:
+    NotReadyException(const std::string& err, const char *filen,
+                      const unsigned int linenum, const char *fn) noexcept
+        : DBusException("NotReadyException", err, filen, linenum, fn)
+    {
+    }
+
+
+    virtual ~NotReadyException() throw()
+    {
+    }
+};
+#define THROW_NOTREADYEXCEPTION(fault_data) throw NotReadyException(fault_data, __FILE__, __LINE__, __FUNCTION__)
+
+
 /**
  *  Client proxy implementation interacting with a
  *  SessionObject in the session manager over D-Bus
@@ -254,7 +280,9 @@ public:
     /**
      *  Checks if the VPN backend process has all it needs to start connecting
      *  to a VPN server.  If it needs more information from the front-end, a
-     *  ReadyException will be thrown with more details.
+     *  ReadyException will be thrown with more details.  If the backend
+     *  process has not completed its start-up yet, a NotReadyException
+     *  is thrown.
      */
     void Ready()
     {
@@ -270,6 +298,10 @@ public:
             {
                 THROW_READYEXCEPTION(excp.getRawError());
             }
+            if (e.find("net.openvpn.v3.sessions.error.notready:") != std::string::npos)
+            {
+                THROW_NOTREADYEXCEPTION(excp.getRawError());
+            }
             // Otherwise, just rethrow the DBusException
             throw;
         }
@@ -344,6 +376,26 @@ public:
     }
 
 
+    /**
+     *  Ask the session manager to send the Log and StatusChange signals
+     *  of this session to this D-Bus connection.  The session manager
+     *  stops sending them when disabled again or when this connection
+     *  is closed.
+     *
+     * @param enable  If true, the signals will be sent to the caller
+     */
+    void LogForward(bool enable)
+    {
+        GVariant *res = Call("LogForward", g_variant_new("(b)", enable));
+        if (NULL == res)
+        {
+            THROW_DBUSEXCEPTION("OpenVPN3SessionProxy",
+                                "LogForward() call failed");
+        }
+        g_variant_unref(res);
+    }
+
+
     /**
      *  Get the log verbosity of the log messages being proxied
      *
@@ -410,6 +462,33 @@ public:
     }
 
 
+    /**
+     * Retrieves the time spent in each phase of establishing the last
+     * connection, in microseconds.  This is the 'connection_timing'
+     * session object property.
+     *
+     * @return Returns a ConnectionStats array with the phase names and
+     *         their durations.  It is empty until a connection has been
+     *         established.
+     */
+    ConnectionStats GetConnectionTiming()
+    {
+        GVariant *timing = GetProperty("connection_timing");
+        GVariantIter iter;
+        g_variant_iter_init(&iter, timing);
+
+        ConnectionStats ret;
+        gchar *key = nullptr;
+        gint64 val = 0;
+        while (g_variant_iter_loop(&iter, "{sx}", &key, &val))
+        {
+            ret.push_back(ConnectionStatDetails(std::string(key), val));
+        }
+        g_variant_unref(timing);
+        return ret;
+    }
+
+
     /**
      *  Manipulate the public-access flag.  When public-access is set to
      *  true, everyone have access to this session regardless of how the
@@ -532,4 +611,208 @@ private:
 
 };
 
+
+
+/**
+ *  Tracks the StatusChange signals of a session, so a front-end can wait
+ *  for the session to reach a certain state instead of polling it.  The
+ *  session manager only sends these signals to front-ends which have
+ *  requested them via LogForward, which is enabled while this object
+ *  exists.  If LogForward is not available, such as with an older
+ *  session manager or a D-Bus policy not allowing it, the status is
+ *  polled instead while waiting.
+ *
+ *  The signals are processed in a private DBusWaitContext, so this
+ *  does not need a running main loop.  Objects of this class must be
+ *  used and destroyed on the thread which created them.
+ */
+class OpenVPN3SessionStatusWatch
+{
+public:
+    typedef std::function<bool(const StatusEvent&)> Condition;
+
+    /**
+     * @param session  OpenVPN3SessionProxy of the session to watch.  It
+     *                 must exist as long as this object.
+     */
+    OpenVPN3SessionStatusWatch(OpenVPN3SessionProxy& session)
+        : session(session),
+          subscr(0),
+          polling(false)
+    {
+        subscr = DBusSignalRouter::Subscribe(session.GetConnection(),
+                                             OpenVPN3DBus_name_sessions.c_str(),
+                                             OpenVPN3DBus_interf_sessions.c_str(),
+                                             "StatusChange",
+                                             session.GetObjectPath().c_str(),
+                                             NULL,
+                                             status_change,
+                                             this);
+        try
+        {
+            session.LogForward(true);
+        }
+        catch (DBusException&)
+        {
+            polling = true;
+        }
+        catch (DBusProxyAccessDeniedException&)
+        {
+            polling = true;
+        }
+
+        // The status may have changed before the subscription was
+        // in place, so start out with the current status
+        poll_status();
+    }
+
+
+    ~OpenVPN3SessionStatusWatch()
+    {
+        DBusSignalRouter::Unsubscribe(subscr);
+        if (polling)
+        {
+            return;
+        }
+        try
+        {
+            session.LogForward(false);
+        }
+        catch (DBusException&)
+        {
+            // The session may be gone already
+        }
+    }
+
+    OpenVPN3SessionStatusWatch(const OpenVPN3SessionStatusWatch&) = delete;
+    OpenVPN3SessionStatusWatch& operator=(const OpenVPN3SessionStatusWatch&) = delete;
+
+
+    /**
+     *  Waits until the session reports a status matching a condition.
+     *  Status changes received so far are checked first, in the order
+     *  they were received; the ones checked are discarded.
+     *
+     * @param until    Condition function, returning true for the
+     *                 status to wait for
+     * @param timeout  std::chrono::milliseconds how long to wait
+     * @param status   StatusEvent which will contain the matching status.
+     *                 If the timeout expired, it contains the last
+     *                 status received, if any.
+     *
+     * @return Returns true if a matching status was received, false if
+     *         the timeout expired first.
+     */
+    bool Wait(Condition until, std::chrono::milliseconds timeout,
+              StatusEvent& status)
+    {
+        auto check = [&]()
+                     {
+                         while (!pending.empty())
+                         {
+                             status = pending.front();
+                             pending.pop_front();
+                             if (until(status))
+                             {
+                                 return true;
+                             }
+                         }
+                         return false;
+                     };
+        if (!polling)
+        {
+            return waitctx.Wait(check, timeout);
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0)
+            {
+                return check();
+            }
+            if (waitctx.Wait(check, std::min(left, poll_interval)))
+            {
+                return true;
+            }
+            poll_status();
+        }
+    }
+
+
+    /**
+     *  Discards all the status changes received so far.  Any status
+     *  change sent before the last method call to the session manager
+     *  returned is discarded as well.
+     */
+    void Discard()
+    {
+        waitctx.Flush();
+        if (polling)
+        {
+            poll_status();
+        }
+        pending.clear();
+    }
+
+
+    /**
+     *  Checks if the status is polled, as LogForward could not be used
+     *
+     * @return Returns true if the status is polled
+     */
+    bool IsPolling() const
+    {
+        return polling;
+    }
+
+
+private:
+    const std::chrono::milliseconds poll_interval{250};
+
+    OpenVPN3SessionProxy& session;
+    DBusWaitContext waitctx;
+    guint subscr;
+    bool polling;
+    StatusEvent last_polled;
+    std::deque<StatusEvent> pending;
+
+
+    /**
+     *  Queues the current status of the session, unless it is the same
+     *  as the last time it was retrieved
+     */
+    void poll_status()
+    {
+        try
+        {
+            StatusEvent s = session.GetLastStatus();
+            if (s != last_polled)
+            {
+                last_polled = s;
+                pending.push_back(s);
+            }
+        }
+        catch (DBusException&)
+        {
+            // No status changes have been sent yet
+        }
+    }
+
+
+    static void status_change(GDBusConnection *conn,
+                              const gchar *sender,
+                              const gchar *obj_path,
+                              const gchar *intf_name,
+                              const gchar *signal_name,
+                              GVariant *params,
+                              gpointer this_ptr)
+    {
+        OpenVPN3SessionStatusWatch *watch = (OpenVPN3SessionStatusWatch *) this_ptr;
+        watch->pending.push_back(StatusEvent(params));
+    }
+};
+
 #endif // OPENVPN3_DBUS_PROXY_CONFIG_HPP
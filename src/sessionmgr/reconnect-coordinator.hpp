@@ -0,0 +1,250 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   reconnect-coordinator.hpp
+ *
+ * @brief  Spreads out reconnects of many sessions over time
+ *
+ *         When the network goes down, all VPN sessions start reconnecting
+ *         at the same time.  The session manager asks this coordinator
+ *         for permission whenever a session reports it is reconnecting.
+ *         Reconnects are admitted through a token bucket.  When the
+ *         bucket is empty, the session is paused and queued; queued
+ *         sessions are resumed in priority order, with a random delay
+ *         added to avoid synchronised handshakes.
+ */
+
+#ifndef OPENVPN3_SESSIONMGR_RECONNECT_COORDINATOR_HPP
+#define OPENVPN3_SESSIONMGR_RECONNECT_COORDINATOR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+
+#include <glib.h>
+
+#include <openvpn/common/rc.hpp>
+
+#include "sessionmgr/metrics.hpp"
+
+using namespace openvpn;
+
+/**
+ *  Seconds after an admitted reconnect during which further reconnect
+ *  attempts of the same session are not queued again
+ */
+#define RECONNECT_ADMIT_WINDOW 30
+
+
+class ReconnectCoordinator : public RC<thread_safe_refcount>
+{
+public:
+    typedef RCPtr<ReconnectCoordinator> Ptr;
+
+    /**
+     *  Called when a queued reconnect is admitted
+     */
+    typedef std::function<void()> AdmitCallback;
+
+
+    /**
+     * @param rate       Reconnects admitted per second, on average
+     * @param burst      Reconnects which may be admitted at once
+     * @param jitter_ms  Upper limit of the random delay added before
+     *                   resuming a queued session, in milliseconds
+     */
+    ReconnectCoordinator(double rate, unsigned int burst,
+                         unsigned int jitter_ms)
+        : rate(rate),
+          burst(std::max(burst, 1u)),
+          jitter_ms(jitter_ms),
+          tokens(std::max(burst, 1u)),
+          last_refill(std::chrono::steady_clock::now()),
+          timer(0),
+          requested(0),
+          admitted_direct(0),
+          admitted_queued(0),
+          cancelled(0)
+    {
+    }
+
+
+    ~ReconnectCoordinator()
+    {
+        if (timer > 0)
+        {
+            g_source_remove(timer);
+        }
+    }
+
+
+    /**
+     *  Asks for permission to reconnect a session
+     *
+     * @param session   Session object path
+     * @param priority  Higher values are admitted first from the queue
+     * @param admit     Called when a queued reconnect is admitted
+     *
+     * @return Returns true if the reconnect may proceed right away.  If
+     *         false, the session has been queued and the caller must
+     *         hold the reconnect until the admit callback is called.
+     */
+    bool Request(const std::string& session, unsigned int priority,
+                 AdmitCallback admit)
+    {
+        ++requested;
+        refill();
+        if (queue.empty() && tokens >= 1.0)
+        {
+            tokens -= 1.0;
+            ++admitted_direct;
+            return true;
+        }
+
+        // Keep the queue sorted by priority, FIFO within a priority
+        auto it = queue.begin();
+        while (queue.end() != it && it->priority >= priority)
+        {
+            ++it;
+        }
+        queue.insert(it, {session, priority, admit});
+        schedule();
+        return false;
+    }
+
+
+    /**
+     *  Removes a session from the queue, if it is queued
+     *
+     * @param session  Session object path
+     */
+    void Cancel(const std::string& session)
+    {
+        for (auto it = queue.begin(); it != queue.end(); ++it)
+        {
+            if (it->session == session)
+            {
+                queue.erase(it);
+                ++cancelled;
+                return;
+            }
+        }
+    }
+
+
+    /**
+     *  Adds the coordinator counters to a metrics document
+     */
+    void Write(MetricsWriter& w) const
+    {
+        w.Family("openvpn3_sessionmgr_reconnects_requested_total", "counter",
+                 "Reconnects reported by sessions");
+        w.Sample("openvpn3_sessionmgr_reconnects_requested_total", {}, requested);
+        w.Family("openvpn3_sessionmgr_reconnects_admitted_total", "counter",
+                 "Reconnects admitted, directly or after being queued");
+        w.Sample("openvpn3_sessionmgr_reconnects_admitted_total",
+                 {{"path", "direct"}}, admitted_direct);
+        w.Sample("openvpn3_sessionmgr_reconnects_admitted_total",
+                 {{"path", "queued"}}, admitted_queued);
+        w.Family("openvpn3_sessionmgr_reconnects_cancelled_total", "counter",
+                 "Queued reconnects dropped before being admitted");
+        w.Sample("openvpn3_sessionmgr_reconnects_cancelled_total", {}, cancelled);
+        w.Family("openvpn3_sessionmgr_reconnects_queued", "gauge",
+                 "Sessions waiting to reconnect");
+        w.Sample("openvpn3_sessionmgr_reconnects_queued", {}, queue.size());
+    }
+
+
+private:
+    struct Pending
+    {
+        std::string session;
+        unsigned int priority;
+        AdmitCallback admit;
+    };
+
+    double rate;
+    unsigned int burst;
+    unsigned int jitter_ms;
+    double tokens;
+    std::chrono::steady_clock::time_point last_refill;
+    std::list<Pending> queue;
+    guint timer;
+
+    uint64_t requested;
+    uint64_t admitted_direct;
+    uint64_t admitted_queued;
+    uint64_t cancelled;
+
+
+    void refill()
+    {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - last_refill).count();
+        tokens = std::min((double) burst, tokens + elapsed * rate);
+        last_refill = now;
+    }
+
+
+    /**
+     *  Arms the timer for the next queued reconnect.  It fires when the
+     *  next token is available, plus a random delay.
+     */
+    void schedule()
+    {
+        if (timer > 0 || queue.empty())
+        {
+            return;
+        }
+        guint wait_ms = 0;
+        if (tokens < 1.0)
+        {
+            wait_ms = (guint) ((1.0 - tokens) / rate * 1000.0) + 1;
+        }
+        if (jitter_ms > 0)
+        {
+            wait_ms += g_random_int_range(0, jitter_ms + 1);
+        }
+        timer = g_timeout_add(wait_ms, admit_next, this);
+    }
+
+
+    static gboolean admit_next(gpointer this_ptr)
+    {
+        ReconnectCoordinator *obj = (ReconnectCoordinator *) this_ptr;
+        obj->timer = 0;
+        obj->refill();
+        if (!obj->queue.empty() && obj->tokens >= 1.0)
+        {
+            obj->tokens -= 1.0;
+            ++obj->admitted_queued;
+            Pending next = obj->queue.front();
+            obj->queue.pop_front();
+            next.admit();
+        }
+        obj->schedule();
+        return G_SOURCE_REMOVE;
+    }
+};
+
+#endif // OPENVPN3_SESSIONMGR_RECONNECT_COORDINATOR_HPP
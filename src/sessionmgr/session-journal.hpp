@@ -0,0 +1,376 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   session-journal.hpp
+ *
+ * @brief  Keeps a record of the running sessions on disk, so a restarted
+ *         session manager can take over the VPN backend client processes
+ *         which are still running.
+ *
+ *         The journal is a JSON document, rewritten atomically shortly
+ *         after sessions change.  Changes arriving close together are
+ *         written at once, from the main loop.  It contains the backend
+ *         tokens, so it is only readable by the session manager user.
+ */
+
+#ifndef OPENVPN3_SESSIONMGR_SESSION_JOURNAL_HPP
+#define OPENVPN3_SESSIONMGR_SESSION_JOURNAL_HPP
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <json/json.h>
+
+#include <openvpn/common/rc.hpp>
+
+#include "dbus/core.hpp"
+
+using namespace openvpn;
+
+
+/**
+ *  Everything needed to restore a SessionObject tied to a running
+ *  VPN backend client process
+ */
+struct SessionJournalEntry
+{
+    std::string session_path;
+    std::string config_path;
+    uid_t owner = 0;
+    std::vector<uid_t> acl;
+    bool public_access = false;
+    std::time_t session_created = 0;
+    std::string backend_busname;
+    std::string backend_path;
+    std::string backend_token;
+    pid_t backend_pid = 0;
+    bool restrict_log_access = true;
+    bool receive_log_events = false;
+    unsigned int log_verbosity = 4;
+    unsigned int reconnect_priority = 0;
+};
+
+
+
+class SessionJournal : public RC<thread_unsafe_refcount>
+{
+public:
+    typedef RCPtr<SessionJournal> Ptr;
+    typedef std::function<void(const std::string& msg)> ErrorCallback;
+
+    /**
+     * @param filename  Path to the journal file
+     */
+    SessionJournal(const std::string& filename)
+        : filename(filename),
+          write_timer(0)
+    {
+    }
+
+
+    ~SessionJournal()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (0 == write_timer)
+        {
+            return;
+        }
+        g_source_remove(write_timer);
+        write_timer = 0;
+        try
+        {
+            write();
+        }
+        catch (DBusException&)
+        {
+            // Nobody is left to report this to
+        }
+    }
+
+
+    /**
+     *  Reads the journal file.  A missing file is the same as an
+     *  empty journal.
+     *
+     * @return Returns a std::vector with all the recorded sessions
+     */
+    std::vector<SessionJournalEntry> Load()
+    {
+        std::vector<SessionJournalEntry> ret;
+        std::ifstream f(filename);
+        if (!f.is_open())
+        {
+            return ret;
+        }
+
+        Json::Value data;
+        try
+        {
+            f >> data;
+        }
+        catch (const std::exception& excp)
+        {
+            THROW_DBUSEXCEPTION("SessionJournal",
+                                "Could not parse " + filename + ": "
+                                + std::string(excp.what()));
+        }
+
+        for (const auto& s : data["sessions"])
+        {
+            SessionJournalEntry e;
+            e.session_path = s["session_path"].asString();
+            e.config_path = s["config_path"].asString();
+            e.owner = s["owner"].asUInt();
+            for (const auto& uid : s["acl"])
+            {
+                e.acl.push_back(uid.asUInt());
+            }
+            e.public_access = s["public_access"].asBool();
+            e.session_created = s["session_created"].asInt64();
+            e.backend_busname = s["backend_busname"].asString();
+            e.backend_path = s["backend_path"].asString();
+            e.backend_token = s["backend_token"].asString();
+            e.backend_pid = s["backend_pid"].asInt();
+            e.restrict_log_access = s["restrict_log_access"].asBool();
+            e.receive_log_events = s["receive_log_events"].asBool();
+            e.log_verbosity = s["log_verbosity"].asUInt();
+            e.reconnect_priority = s["reconnect_priority"].asUInt();
+            if (e.session_path.empty() || e.backend_busname.empty()
+                || e.backend_token.empty())
+            {
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> guard(mtx);
+                sessions[e.session_path] = e;
+            }
+            ret.push_back(e);
+        }
+        return ret;
+    }
+
+
+    /**
+     *  Adds or updates a session.  The journal is rewritten shortly after.
+     *
+     * @param entry  SessionJournalEntry describing the session
+     */
+    void Store(const SessionJournalEntry& entry)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        sessions[entry.session_path] = entry;
+        schedule_write();
+    }
+
+
+    /**
+     *  Removes a session.  The journal is rewritten shortly after.
+     *
+     * @param session_path  D-Bus object path of the session
+     */
+    void Remove(const std::string& session_path)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (sessions.erase(session_path) > 0)
+        {
+            schedule_write();
+        }
+    }
+
+
+    /**
+     *  Sets the function called with an error message when writing the
+     *  journal fails
+     *
+     * @param cb  ErrorCallback to call, or nullptr to remove it
+     */
+    void SetErrorCallback(ErrorCallback cb)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        on_error = cb;
+    }
+
+
+    /**
+     *  Writes pending changes to the journal right away
+     */
+    void Flush()
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (0 == write_timer)
+        {
+            return;
+        }
+        g_source_remove(write_timer);
+        write_timer = 0;
+        write_reporting_errors();
+    }
+
+
+private:
+    /**
+     *  How long changes are collected before the journal is written,
+     *  in milliseconds
+     */
+    static const guint write_delay = 250;
+
+    std::string filename;
+    ErrorCallback on_error;
+    std::mutex mtx;
+    std::map<std::string, SessionJournalEntry> sessions;
+    guint write_timer;
+
+
+    /**
+     *  Arms the timer writing the journal, unless it is already armed.
+     *  The caller must hold mtx.
+     */
+    void schedule_write()
+    {
+        if (0 == write_timer)
+        {
+            write_timer = g_timeout_add(write_delay, _cb_write, this);
+        }
+    }
+
+
+    static gboolean _cb_write(gpointer this_ptr)
+    {
+        SessionJournal *self = (SessionJournal *) this_ptr;
+        std::lock_guard<std::mutex> guard(self->mtx);
+        self->write_timer = 0;
+        self->write_reporting_errors();
+        return G_SOURCE_REMOVE;
+    }
+
+
+    /**
+     *  Writes the journal, passing errors to the error callback.  The
+     *  caller must hold mtx.
+     */
+    void write_reporting_errors()
+    {
+        try
+        {
+            write();
+        }
+        catch (DBusException& excp)
+        {
+            if (on_error)
+            {
+                on_error(excp.what());
+            }
+        }
+    }
+
+
+    /**
+     *  Writes the journal to a temporary file which then replaces the
+     *  journal file, so a crash never leaves a partial journal behind.
+     *  The temporary file is always created anew and never followed
+     *  if it is a symlink.  The caller must hold mtx.
+     */
+    void write()
+    {
+        Json::Value data;
+        data["sessions"] = Json::Value(Json::arrayValue);
+        for (const auto& item : sessions)
+        {
+            const SessionJournalEntry& e = item.second;
+            Json::Value s;
+            s["session_path"] = e.session_path;
+            s["config_path"] = e.config_path;
+            s["owner"] = (Json::Value::UInt) e.owner;
+            s["acl"] = Json::Value(Json::arrayValue);
+            for (const auto& uid : e.acl)
+            {
+                s["acl"].append((Json::Value::UInt) uid);
+            }
+            s["public_access"] = e.public_access;
+            s["session_created"] = (Json::Value::Int64) e.session_created;
+            s["backend_busname"] = e.backend_busname;
+            s["backend_path"] = e.backend_path;
+            s["backend_token"] = e.backend_token;
+            s["backend_pid"] = (Json::Value::Int) e.backend_pid;
+            s["restrict_log_access"] = e.restrict_log_access;
+            s["receive_log_events"] = e.receive_log_events;
+            s["log_verbosity"] = e.log_verbosity;
+            s["reconnect_priority"] = e.reconnect_priority;
+            data["sessions"].append(s);
+        }
+        std::stringstream out;
+        out << data;
+        std::string buf = out.str();
+
+        // A left-over file from an earlier crash would make O_EXCL fail
+        std::string tmpname = filename + ".tmp";
+        if (unlink(tmpname.c_str()) < 0 && ENOENT != errno)
+        {
+            THROW_DBUSEXCEPTION("SessionJournal",
+                                "Could not remove " + tmpname + ": "
+                                + std::string(strerror(errno)));
+        }
+        int fd = open(tmpname.c_str(),
+                      O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+                      0600);
+        if (fd < 0)
+        {
+            THROW_DBUSEXCEPTION("SessionJournal",
+                                "Could not open " + tmpname + ": "
+                                + std::string(strerror(errno)));
+        }
+        bool ok = (::write(fd, buf.c_str(), buf.size()) == (ssize_t) buf.size()
+                   && 0 == fsync(fd));
+        int err = errno;
+        if (!ok)
+        {
+            close(fd);
+            unlink(tmpname.c_str());
+            THROW_DBUSEXCEPTION("SessionJournal",
+                                "Could not write " + tmpname + ": "
+                                + std::string(strerror(err)));
+        }
+        close(fd);
+        if (rename(tmpname.c_str(), filename.c_str()) < 0)
+        {
+            err = errno;
+            unlink(tmpname.c_str());
+            THROW_DBUSEXCEPTION("SessionJournal",
+                                "Could not replace " + filename + ": "
+                                + std::string(strerror(err)));
+        }
+    }
+};
+
+#endif // OPENVPN3_SESSIONMGR_SESSION_JOURNAL_HPP
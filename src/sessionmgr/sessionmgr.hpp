@@ -36,6 +36,11 @@
 #include <cstring>
 #include <functional>
 #include <ctime>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include <gio/gunixfdlist.h>
 
 #include <openvpn/common/likely.hpp>
 #include <openvpn/log/logsimple.hpp>
@@ -45,10 +50,18 @@
 #include "common/utils.hpp"
 #include "dbus/core.hpp"
 #include "dbus/connection-creds.hpp"
+#include "dbus/dispatch.hpp"
 #include "dbus/path.hpp"
+#include "dbus/peer-link.hpp"
+#include "dbus/tracepoints.hpp"
 #include "log/dbus-log.hpp"
 #include "log/logwriter.hpp"
 #include "client/statusevent.hpp"
+#include "client/process-watcher.hpp"
+#include "client/stats-page.hpp"
+#include "sessionmgr/metrics.hpp"
+#include "sessionmgr/reconnect-coordinator.hpp"
+#include "sessionmgr/session-journal.hpp"
 #include "ovpn3cli/lookup.hpp"
 
 using namespace openvpn;
@@ -163,12 +176,39 @@ private:
 };
 
 
+/**
+ *  Bus names of the front-ends which have called LogForward on a session.
+ *  This is kept apart from the target bus names of the signal producer,
+ *  where an empty list means the signals are broadcast.  Here, an empty
+ *  set means nothing is forwarded.
+ */
+class SessionForwardTargets
+{
+public:
+    void AddForwardTarget(const std::string& busname)
+    {
+        forward_targets.insert(busname);
+    }
+
+
+    void RemoveForwardTarget(const std::string& busname)
+    {
+        forward_targets.erase(busname);
+    }
+
+
+protected:
+    std::set<std::string> forward_targets;
+};
+
+
 /**
  *  Handler for session log events.  This will be enabled when a session
  *  is configured to proxy log messages from the VPN client backend to a
  *  front-end.
  */
-class SessionLogEvent : public LogConsumerProxy
+class SessionLogEvent : public LogConsumerProxy,
+                        public SessionForwardTargets
 {
 public:
     /**
@@ -184,15 +224,27 @@ public:
      * @param be_obj_path        Backend D-Bus object path where the log
      *                           event signals are sent
      * @param sigproxy_obj_path  Destinaion D-Bus path for the signal
+     * @param signal_broadcast   If true, log events are always proxied as
+     *                           broadcast signals.  Otherwise they are only
+     *                           sent to the target bus names and the
+     *                           forward targets, if any.
+     * @param backend_link       Peer-to-peer link to the backend.  If set,
+     *                           the log events are received on this link
+     *                           while the proxied signals are sent via conn.
      */
     SessionLogEvent(GDBusConnection *conn,
                     std::string bus_name,
                     std::string interface,
                     std::string be_obj_path,
-                    std::string sigproxy_obj_path)
-        : LogConsumerProxy(conn, interface, be_obj_path,
+                    std::string sigproxy_obj_path,
+                    bool signal_broadcast,
+                    GDBusConnection *backend_link = nullptr)
+        : LogConsumerProxy((backend_link ? backend_link : conn),
+                           interface, be_obj_path,
+                           conn,
                            OpenVPN3DBus_interf_sessions, sigproxy_obj_path),
-           last_logev()
+           last_logev(),
+           signal_broadcast(signal_broadcast)
     {
     }
 
@@ -248,8 +300,68 @@ public:
         LogSender::SetLogLevel(loglev);
     }
 
+
+    /**
+     *  Sets a function to be called each time a new log event has
+     *  been saved as the last log event
+     *
+     * @param cb  std::function to call, nullptr disables it
+     */
+    void SetLastLogCallback(std::function<void()> cb)
+    {
+        last_log_cb = std::move(cb);
+    }
+
+
+protected:
+    /**
+     *  The last log event is always kept, but it is only proxied when
+     *  someone has asked for it via LogForward
+     */
+    void process_log_event(const std::string sender,
+                           const std::string interface,
+                           const std::string object_path,
+                           GVariant *params) override
+    {
+        guint group;
+        guint catg;
+        gchar *msg;
+        g_variant_get (params, "(uus)", &group, &catg, &msg);
+        ConsumeLogEvent(sender, interface, object_path,
+                        LogEvent((LogGroup) group, (LogCategory) catg,
+                                 std::string(msg)));
+        g_free(msg);
+        if (last_log_cb)
+        {
+            last_log_cb();
+        }
+
+        if (signal_broadcast)
+        {
+            ProxyLog(params);
+            return;
+        }
+
+        // The target bus names only contain the log service, when
+        // receive_log_events is enabled.
+        if (HasTargetBusNames())
+        {
+            ProxyLog(params);
+        }
+        if (!forward_targets.empty() && LogSender::LogFilterAllow(catg))
+        {
+            for (const auto& target : forward_targets)
+            {
+                SendTo(target, "Log", params);
+            }
+        }
+    }
+
+
 private:
     LogEvent last_logev;
+    bool signal_broadcast;
+    std::function<void()> last_log_cb;
 };
 
 
@@ -260,7 +372,8 @@ private:
  *  processes subscribed to these signals.
  */
 class SessionStatusChange : public DBusSignalSubscription,
-                            public DBusSignalProducer
+                            public DBusSignalProducer,
+                            public SessionForwardTargets
 {
 public:
     /**
@@ -277,15 +390,29 @@ public:
      * @param sigproxy_obj_path  D-Bus object path which will be used when
      *                           the session manager sends the proxied
      *                           StatusChange signal
+     * @param signal_broadcast   If true, StatusChange signals are always
+     *                           proxied as broadcast signals.  Otherwise
+     *                           they are only sent to the forward targets,
+     *                           if any.
+     * @param backend_link       Peer-to-peer link to the backend.  If set,
+     *                           the signals are received on this link
+     *                           instead of conn, where they are proxied.
      */
     SessionStatusChange(GDBusConnection *conn,
                         std::string bus_name,
                         std::string interface,
                         std::string be_obj_path,
-                        std::string sigproxy_obj_path)
-        : DBusSignalSubscription(conn, bus_name, interface, be_obj_path, "StatusChange"),
+                        std::string sigproxy_obj_path,
+                        bool signal_broadcast,
+                        GDBusConnection *backend_link = nullptr)
+        : DBusSignalSubscription((backend_link ? backend_link : conn),
+                                 (backend_link ? "" : bus_name),
+                                 interface, be_obj_path, "StatusChange"),
           DBusSignalProducer(conn, "", OpenVPN3DBus_interf_sessions, sigproxy_obj_path),
-          last_status()
+          signal_broadcast(signal_broadcast),
+          last_status(),
+          reconnects(0),
+          connected_since(0)
     {
     }
 
@@ -317,8 +444,19 @@ public:
 
     void ProxyStatus(GVariant *status)
     {
+        g_variant_ref_sink(status);
         StatusEvent s(status);
 
+        if (StatusMajor::CONNECTION == s.major)
+        {
+            if (StatusMinor::CONN_RECONNECTING == s.minor)
+            {
+                ++reconnects;
+            }
+            connected_since = (StatusMinor::CONN_CONNECTED == s.minor
+                               ? std::time(nullptr) : 0);
+        }
+
         // If the last status received was CONNECTION:CONN_AUTH_FAILED,
         // preserve this status message
         if (!(StatusMajor::CONNECTION == last_status.major
@@ -327,8 +465,20 @@ public:
             last_status = s;
         }
 
-        // Proxy this mesage via DBusSignalProducer
-        Send("StatusChange", status);
+        // Proxy this mesage via DBusSignalProducer, unless nobody
+        // has asked for it
+        if (signal_broadcast)
+        {
+            Send("StatusChange", status);
+        }
+        else
+        {
+            for (const auto& target : forward_targets)
+            {
+                SendTo(target, "StatusChange", status);
+            }
+        }
+        g_variant_unref(status);
     }
 
 
@@ -369,8 +519,90 @@ public:
         return last_status == chk;
     }
 
+
+    /**
+     *  Checks if the backend has reported the session as completed
+     *
+     * @return Returns true if the last status is a final connection status
+     */
+    bool SessionCompleted()
+    {
+        return StatusMajor::CONNECTION == last_status.major
+               && (StatusMinor::CONN_DONE == last_status.minor
+                   || StatusMinor::CONN_AUTH_FAILED == last_status.minor
+                   || StatusMinor::CONN_FAILED == last_status.minor
+                   || StatusMinor::CONN_DISCONNECTED == last_status.minor);
+    }
+
+
+    /**
+     *  Called when the backend process has disappeared from the bus.
+     *  Unless the backend already reported the session as completed,
+     *  a PROC_KILLED status change is issued on its behalf.
+     *
+     * @param reason  std::string describing why the backend stopped
+     */
+    void BackendVanished(const std::string& reason)
+    {
+        if (SessionCompleted())
+        {
+            return;
+        }
+        ProxyStatus(g_variant_new("(uus)",
+                                  (guint) StatusMajor::SESSION,
+                                  (guint) StatusMinor::PROC_KILLED,
+                                  reason.c_str()));
+    }
+
+    /**
+     *  Sets the last status without proxying it.  Used when taking over
+     *  a backend process which has been running for a while.
+     *
+     * @param status  GVariant (uus) status tuple
+     */
+    void SetLastStatus(GVariant *status)
+    {
+        last_status = StatusEvent(status);
+        connected_since = (StatusMajor::CONNECTION == last_status.major
+                           && StatusMinor::CONN_CONNECTED == last_status.minor
+                           ? std::time(nullptr) : 0);
+    }
+
+
+    /**
+     *  Retrieve the last status, which may be empty
+     */
+    const StatusEvent& GetLastStatus() const
+    {
+        return last_status;
+    }
+
+
+    /**
+     *  Retrieve the number of reconnects reported by the backend
+     */
+    unsigned int GetReconnects() const
+    {
+        return reconnects;
+    }
+
+
+    /**
+     *  Retrieve when the connection was established
+     *
+     * @return Returns the time of the last CONN_CONNECTED status, or 0 if
+     *         the connection is not currently established
+     */
+    std::time_t GetConnectedSince() const
+    {
+        return connected_since;
+    }
+
 private:
+    bool signal_broadcast;
     StatusEvent last_status;
+    unsigned int reconnects;
+    std::time_t connected_since;
 };
 
 
@@ -399,6 +631,10 @@ public:
      * @param manager_log_level Default log level, used by the session manager
      * @param logwr    Pointer to LogWriter object; can be nullptr to
      *                 disablefile log.
+     * @param reconnects ReconnectCoordinator admitting reconnects of this
+     *                 session.  If empty, reconnects are not coordinated.
+     * @param journal  SessionJournal recording this session.  If empty, the
+     *                 session cannot be restored after a restart.
      *
      */
     SessionObject(GDBusConnection *dbuscon,
@@ -406,77 +642,17 @@ public:
                   uid_t owner,
                   std::string objpath, std::string cfg_path,
                   unsigned int manager_log_level, LogWriter *logwr,
-                  bool signal_broadcast)
-        : DBusObject(objpath),
-          DBusSignalSubscription(dbuscon, "", OpenVPN3DBus_interf_backends, ""),
-          DBusCredentials(dbuscon, owner),
-          SessionManagerSignals(dbuscon, objpath, manager_log_level, logwr,
-                                signal_broadcast),
-          remove_callback(remove_callback),
-          be_proxy(nullptr),
-          restrict_log_access(true),
-          recv_log_events(false),
-          session_created(std::time(nullptr)),
-          config_path(cfg_path),
-          sig_statuschg(nullptr),
-          sig_logevent(nullptr),
-          backend_token(""),
-          backend_pid(0),
-          be_conn(nullptr),
-          registered(false),
-          selfdestruct_complete(false)
+                  bool signal_broadcast,
+                  SessionManagerMetrics::Ptr metrics,
+                  ReconnectCoordinator::Ptr reconnects,
+                  SessionJournal::Ptr journal)
+        : SessionObject(dbuscon, remove_callback, owner, objpath, cfg_path,
+                        manager_log_level, logwr, signal_broadcast,
+                        metrics, reconnects, journal, std::time(nullptr))
     {
-        // Only for the initialization of this object, use the manager's
-        // log level.  Once the object is registered with a backend, it
-        // will switch to the default session log level.
-        SetLogLevel(manager_log_level);
         Subscribe("RegistrationRequest");
-        RequiresQueue dummyqueue;  // Only used to get introspection data
-
-        // Register configuration the configuration object
-        std::stringstream introspection_xml;
-        introspection_xml << "<node name='" << objpath << "'>"
-                          << "    <interface name='" << OpenVPN3DBus_interf_sessions << "'>"
-                          << "        <method name='Connect'/>"
-                          << "        <method name='Pause'>"
-                          << "            <arg type='s' name='reason' direction='in'/>"
-                          << "        </method>"
-                          << "        <method name='Resume'/>"
-                          << "        <method name='Restart'/>"
-                          << "        <method name='Disconnect'/>"
-                          << "        <method name='Ready'/>"
-                          << "        <method name='AccessGrant'>"
-                          << "            <arg direction='in' type='u' name='uid'/>"
-                          << "        </method>"
-                          << "        <method name='AccessRevoke'>"
-                          << "            <arg direction='in' type='u' name='uid'/>"
-                          << "        </method>"
-                          << dummyqueue.IntrospectionMethods("UserInputQueueGetTypeGroup",
-                                                             "UserInputQueueFetch",
-                                                             "UserInputQueueCheck",
-                                                             "UserInputProvide")
-                          << "        <signal name='AttentionRequired'>"
-                          << "            <arg type='u' name='type' direction='out'/>"
-                          << "            <arg type='u' name='group' direction='out'/>"
-                          << "            <arg type='s' name='message' direction='out'/>"
-                          << "        </signal>"
-                          << GetStatusChangeIntrospection()
-                          << GetLogIntrospection()
-                          << "        <property type='u' name='owner' access='read'/>"
-                          << "        <property type='t' name='session_created' access='read'/>"
-                          << "        <property type='au' name='acl' access='read'/>"
-                          << "        <property type='b' name='public_access' access='readwrite'/>"
-                          << "        <property type='(uus)' name='status' access='read'/>"
-                          << "        <property type='a{sv}' name='last_log' access='read'/>"
-                          << "        <property type='a{sx}' name='statistics' access='read'/>"
-                          << "        <property type='o' name='config_path' access='read'/>"
-                          << "        <property type='u' name='backend_pid' access='read'/>"
-                          << "        <property type='b' name='restrict_log_access' access='readwrite'/>"
-                          << "        <property type='b' name='receive_log_events' access='readwrite'/>"
-                          << "        <property type='u' name='log_verbosity' access='readwrite'/>"
-                          << "    </interface>"
-                          << "</node>";
-        ParseIntrospectionXML(introspection_xml);
+        OPENVPN3_TRACE3(session_new, objpath.c_str(), cfg_path.c_str(),
+                        (unsigned int) owner);
 
         try
         {
@@ -511,11 +687,10 @@ public:
             return;
         }
 
-        // The PID value we get here is just a temporary.  This is the
-        // PID returned by openvpn3-service-backendstart.  This will again
-        // start the openvpn3-service-client process, which will fork() once
-        // to be completely independent.  When this last fork() happens,
-        // the backend will report back its final PID.
+        // The PID value we get here is the PID of the
+        // openvpn3-service-client process started by
+        // openvpn3-service-backendstart, which tracks this process and
+        // can report why it exited.
         StatusChange(StatusMajor::SESSION, StatusMinor::PROC_STARTED,
                              "session_path=" + GetObjectPath()
                              + ", backend_pid=" + std::to_string(backend_pid));
@@ -528,8 +703,85 @@ public:
         LogVerb1(msg.str());
     }
 
+
+    /**
+     *  Constructor restoring a SessionObject recorded in the session
+     *  journal.  The VPN client backend process is expected to be still
+     *  running; it is taken over without disturbing the connection.
+     *
+     *  If the backend process cannot be reached or does not accept the
+     *  backend token, IsRegistered() returns false and the object must
+     *  be deleted without being registered on the D-Bus.
+     *
+     * @param dbuscon  D-Bus connection this object is tied to
+     * @param entry    SessionJournalEntry describing the session
+     *
+     *  See the other constructor for the remaining arguments.
+     */
+    SessionObject(GDBusConnection *dbuscon,
+                  std::function<void()> remove_callback,
+                  const SessionJournalEntry& entry,
+                  unsigned int manager_log_level, LogWriter *logwr,
+                  bool signal_broadcast,
+                  SessionManagerMetrics::Ptr metrics,
+                  ReconnectCoordinator::Ptr reconnects,
+                  SessionJournal::Ptr journal)
+        : SessionObject(dbuscon, remove_callback, entry.owner,
+                        entry.session_path, entry.config_path,
+                        manager_log_level, logwr, signal_broadcast,
+                        metrics, reconnects, journal, entry.session_created)
+    {
+        backend_token = entry.backend_token;
+        backend_pid = entry.backend_pid;
+        be_conn = dbuscon;
+        be_busname = entry.backend_busname;
+        be_path = entry.backend_path;
+        restrict_log_access = entry.restrict_log_access;
+        reconnect_priority = entry.reconnect_priority;
+        SetPublicAccess(entry.public_access);
+        for (const auto& uid : entry.acl)
+        {
+            GrantAccess(uid);
+        }
+
+        try
+        {
+            reattach_backend();
+        }
+        catch (DBusException& excp)
+        {
+            LogWarn("Could not restore session " + GetObjectPath()
+                    + ": " + std::string(excp.what()));
+            return;
+        }
+
+        SetLogLevel(entry.log_verbosity);
+        if (entry.receive_log_events)
+        {
+            recv_log_events = true;
+            enable_log_events(entry.log_verbosity);
+        }
+        update_journal();
+        LogVerb1("Session restored, backend_pid=" + std::to_string(backend_pid));
+    }
+
+
     ~SessionObject()
     {
+        if (be_watch > 0)
+        {
+            g_bus_unwatch_name(be_watch);
+        }
+        cancel_exit_reason();
+        cancel_connection_timing();
+        cancel_reconnect();
+        clear_forward_subscribers();
+        close_statistics_page();
+        if (connection_timing)
+        {
+            g_variant_unref(connection_timing);
+        }
+
         if (sig_statuschg)
         {
             delete sig_statuschg;
@@ -544,13 +796,82 @@ public:
         {
             delete be_proxy;
         }
+        close_backend_link();
+        if (registered)
+        {
+            remove_from_journal();
+        }
         LogVerb1("Session is closing");
         StatusChange(StatusMajor::SESSION, StatusMinor::SESS_REMOVED);
+        OPENVPN3_TRACE2(session_destroy, GetObjectPath().c_str(),
+                        trace_session_age());
         remove_callback();
         IdleCheck_RefDec();
     }
 
 
+    /**
+     *  Checks if the backend process has completed its registration
+     */
+    bool IsRegistered() const
+    {
+        return registered;
+    }
+
+
+    /**
+     *  Collects the current state of this session for the metrics
+     *  exporter.  This does not call the backend process.
+     *
+     * @return Returns a SessionMetrics object
+     */
+    SessionMetrics GetMetrics()
+    {
+        SessionMetrics m;
+        m.path = GetObjectPath();
+        GVariant *owner = GetOwner();
+        m.owner = g_variant_get_uint32(owner);
+        g_variant_unref(owner);
+        m.registered = registered;
+        m.backend_pid = backend_pid;
+        m.status_major = StatusMajor::UNSET;
+        m.status_minor = StatusMinor::UNSET;
+        m.reconnects = 0;
+        m.connected_since = 0;
+        if (sig_statuschg)
+        {
+            const StatusEvent& st = sig_statuschg->GetLastStatus();
+            m.status_major = st.major;
+            m.status_minor = st.minor;
+            m.reconnects = sig_statuschg->GetReconnects();
+            m.connected_since = sig_statuschg->GetConnectedSince();
+        }
+
+        if (registered)
+        {
+            try
+            {
+                GVariant *stats = get_statistics();
+                GVariantIter *it = nullptr;
+                g_variant_get(stats, "a{sx}", &it);
+                gchar *key = nullptr;
+                gint64 val = 0;
+                while (g_variant_iter_loop(it, "{sx}", &key, &val))
+                {
+                    m.statistics[key] = val;
+                }
+                g_variant_iter_free(it);
+                g_variant_unref(stats);
+            }
+            catch (DBusException&)
+            {
+                // No statistics available yet
+            }
+        }
+        return m;
+    }
+
+
     /**
      *  Callback method called each time signals we have subscribed to
      *  occurs.  For the SessionObject, we care about these signals:
@@ -609,11 +930,10 @@ public:
 
             try
             {
-                Subscribe(sender_name, be_path, "AttentionRequired");
-                Subscribe(sender_name, be_path, "StatusChange");
                 register_backend();
                 Unsubscribe("RegistrationRequest");
                 SetLogLevel(default_session_log_level);
+                PropertyChanged("log_verbosity");
                 LogVerb2("Backend VPN client process registered");
             }
             catch (DBusException& err)
@@ -629,6 +949,31 @@ public:
         {
             StatusEvent status(params);
 
+            // The status property value is decided by SessionStatusChange,
+            // which may not have processed this signal yet.  Clients
+            // need to retrieve the new value themselves.
+            PropertyChanged("status");
+
+            if (StatusMajor::CONNECTION == status.major
+                && StatusMinor::CONN_CONNECTED == status.minor)
+            {
+                fetch_connection_timing();
+                reconnect_admitted = std::chrono::steady_clock::time_point();
+            }
+
+            if (StatusMajor::CONNECTION == status.major
+                && StatusMinor::CONN_RECONNECTING == status.minor)
+            {
+                coordinate_reconnect();
+            }
+            else if (StatusMajor::CONNECTION == status.major
+                     && StatusMinor::CONN_DISCONNECTING == status.minor)
+            {
+                // This includes connection timeouts, which ends
+                // the session in the backend
+                cancel_reconnect();
+            }
+
             if (StatusMajor::CONNECTION == status.major
                 && (StatusMinor::CONN_FAILED == status.minor
                     || StatusMinor::CONN_AUTH_FAILED == status.minor))
@@ -660,7 +1005,8 @@ public:
      *  process after an access control check has been performed.  Many of the
      *  calls can be accessed by the owner or designated user IDs, and the
      *  most sensitive methods are only accessible to the owner of this
-     *  session.
+     *  session.  The methods and their access levels are listed in
+     *  session_methods().
      *
      * @param conn       D-Bus connection where the method call occurred
      * @param sender     D-Bus bus name of the sender of the method call
@@ -672,13 +1018,13 @@ public:
      * @param invoc      GDBusMethodInvocation where the response/result of
      *                   the method call will be returned.
      */
-    void callback_method_call(GDBusConnection *conn,
-                              const std::string sender,
-                              const std::string obj_path,
-                              const std::string intf_name,
-                              const std::string method_name,
-                              GVariant *params,
-                              GDBusMethodInvocation *invoc)
+    void callback_method_dispatch(GDBusConnection *conn,
+                                  const gchar *sender,
+                                  const gchar *obj_path,
+                                  const gchar *intf_name,
+                                  const gchar *method_name,
+                                  GVariant *params,
+                                  GDBusMethodInvocation *invoc)
     {
         bool ping = false;
 
@@ -715,189 +1061,65 @@ public:
                 << ", requester:  " << lookup_username(GetUID(sender));
             Debug(msg.str());
 
-            if ("Connect" == method_name)
+            if (!session_methods().Dispatch(this, conn, sender, method_name,
+                                            params, invoc))
             {
-                CheckACL(sender);
-                be_proxy->Call("Connect");
-                LogVerb2("Starting connection");
-            }
-            else if ("Restart" == method_name)
-            {
-                CheckACL(sender, true);
-                be_proxy->Call("Restart");
-                LogVerb2("Restarting connection");
-            }
-            else if ("Pause" == method_name)
-            {
-                CheckACL(sender, true);
-                // FIXME: Should check that params contains only the expected formatting
-                be_proxy->Call("Pause", params);
-                LogVerb2("Pausing connection");
-            }
-            else if ("Resume"  == method_name)
-            {
-                CheckACL(sender, true);
-                be_proxy->Call("Resume");
-                LogVerb2("Resuming connection");
-            }
-            else if ("Disconnect" == method_name)
-            {
-                CheckACL(sender, true);
-                LogVerb2("Disconnecting connection");
-                shutdown(false, true);
+                std::string errmsg = "No method named " + std::string(method_name)
+                                     + " is available";
+                GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.sessions.error",
+                                                              errmsg.c_str());
+                g_dbus_method_invocation_return_gerror(invoc, err);
+                g_error_free(err);
+                LogWarn(errmsg);
             }
-            else if ("Ready" == method_name)
+        }
+        catch (DBusException& dberr)
+        {
+            bool do_selfdestruct = false;
+            std::string errname = "net.openvpn.v3.sessions.error";
+            std::string errmsg;
+
+            Debug("Exception [callback_method_call(" + std::string(method_name)
+                  + ")]: " + dberr.getRawError());
+
+            if (!registered && 0 == g_strcmp0(method_name, "Disconnect"))
             {
+                //
+                // This is a special case handling.  If a backend VPN client
+                // process has not registered and a front-end wants to
+                // shutdown this session, this needs to be handled specially.
+                //
+                // This can happen if the VPN client process dies before
+                // starting the registration process.  In this case, we
+                // will not have a valid be_proxy object to the backend,
+                // so any kind of attempt to communicate with the (possibly
+                // dead) backend will just completely fail.  So we just aim
+                // for the selfdestruct.
+                //
+                // In regards to the front-end caller, this is also not
+                // strictly an error. The caller wants to get rid of this
+                // lingering session object by calling the Disconnect method.
+                // So we do not return any error, but just ensure this
+                // session is cleaned up properly.
+                //
                 try
                 {
-                    CheckACL(sender);
-                    be_proxy->Call("Ready");
+                    LogCritical("Forced session shutdown before backend registration");
+                    do_selfdestruct = true;
                 }
                 catch (DBusException& dberr)
                 {
-                    GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.sessions.error",
-                                                                  dberr.what());
-                    g_dbus_method_invocation_return_gerror(invoc, err);
-                    g_error_free(err);
-                    return;
                 }
+                StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED,
+                             "Backend process did not complete registration");
+                g_dbus_method_invocation_return_value(invoc, NULL);
+            }
+            else if (!registered)
+            {
+                errname = "net.openvpn.v3.sessions.error.notready";
+                errmsg = "Backend VPN process is not ready";
             }
-            else if ("UserInputQueueGetTypeGroup" == method_name)
-            {
-                CheckACL(sender);
-                try
-                {
-                    GVariant *res = be_proxy->Call("UserInputQueueGetTypeGroup", params);
-                    g_dbus_method_invocation_return_value(invoc, res);
-                    g_variant_unref(res);
-                }
-                catch (RequiresQueueException& excp)
-                {
-                    excp.GenerateDBusError(invoc);
-                }
-                return;
-            }
-            else if ("UserInputQueueFetch" == method_name)
-            {
-                CheckACL(sender);
-                try
-                {
-                    GVariant *res = be_proxy->Call("UserInputQueueFetch", params);
-                    g_dbus_method_invocation_return_value(invoc, res);
-                    g_variant_unref(res);
-                }
-                catch (RequiresQueueException& excp)
-                {
-                    excp.GenerateDBusError(invoc);
-                }
-                return;
-            }
-            else if ("UserInputQueueCheck" == method_name)
-            {
-                CheckACL(sender);
-                GVariant *res = be_proxy->Call("UserInputQueueCheck", params);
-                g_dbus_method_invocation_return_value(invoc, res);
-                g_variant_unref(res);
-                return;
-            }
-            else if ("UserInputProvide" == method_name)
-            {
-                CheckACL(sender);
-                try
-                {
-                    GVariant *res = be_proxy->Call("UserInputProvide", params);
-                    g_dbus_method_invocation_return_value(invoc, res);
-                    g_variant_unref(res);
-                }
-                catch (RequiresQueueException& excp)
-                {
-                    // Convert this exception into an error sent back
-                    // to the requester as a D-Bus error instead.
-                    excp.GenerateDBusError(invoc);
-                }
-                return;
-            }
-            else if ("AccessGrant" == method_name)
-            {
-                CheckOwnerAccess(sender);
-
-                uid_t uid = -1;
-                g_variant_get(params, "(u)", &uid);
-                GrantAccess(uid);
-                g_dbus_method_invocation_return_value(invoc, NULL);
-
-                LogInfo("Access granted to UID " + std::to_string(uid));
-                return;
-            }
-            else if ("AccessRevoke" == method_name)
-            {
-                CheckOwnerAccess(sender);
-
-                uid_t uid = -1;
-                g_variant_get(params, "(u)", &uid);
-                RevokeAccess(uid);
-                g_dbus_method_invocation_return_value(invoc, NULL);
-
-                LogInfo("Access revoked for UID " + std::to_string(uid));
-                return;
-            }
-            else
-            {
-                std::string errmsg = "No method named" + method_name + " is available";
-                GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.sessions.error",
-                                                              errmsg.c_str());
-                g_dbus_method_invocation_return_gerror(invoc, err);
-                g_error_free(err);
-                LogWarn(errmsg);
-                return;
-            }
-            g_dbus_method_invocation_return_value(invoc, NULL);
-        }
-        catch (DBusException& dberr)
-        {
-            bool do_selfdestruct = false;
-            std::string errmsg;
-
-            Debug("Exception [callback_method_call("+ method_name + ")]: "
-                  + dberr.getRawError());
-
-            if (!registered && "Disconnect" == method_name)
-            {
-                //
-                // This is a special case handling.  If a backend VPN client
-                // process has not registered and a front-end wants to
-                // shutdown this session, this needs to be handled specially.
-                //
-                // This can happen if the VPN client process dies before
-                // starting the registration process.  In this case, we
-                // will not have a valid be_proxy object to the backend,
-                // so any kind of attempt to communicate with the (possibly
-                // dead) backend will just completely fail.  So we just aim
-                // for the selfdestruct.
-                //
-                // In regards to the front-end caller, this is also not
-                // strictly an error. The caller wants to get rid of this
-                // lingering session object by calling the Disconnect method.
-                // So we do not return any error, but just ensure this
-                // session is cleaned up properly.
-                //
-                try
-                {
-                    LogCritical("Forced session shutdown before backend registration");
-                    do_selfdestruct = true;
-                }
-                catch (DBusException& dberr)
-                {
-                }
-                StatusChange(StatusMajor::SESSION, StatusMinor::PROC_KILLED,
-                             "Backend process did not complete registration");
-                g_dbus_method_invocation_return_value(invoc, NULL);
-            }
-            else if (!registered)
-            {
-                errmsg = "Backend VPN process is not ready";
-            }
-            else if (!ping)
+            else if (!ping)
             {
                 try
                 {
@@ -926,8 +1148,8 @@ public:
 
             if (!errmsg.empty())
             {
-                GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.sessions.error",
-                                                          errmsg.c_str());
+                GError *err = g_dbus_error_new_for_dbus_error(errname.c_str(),
+                                                              errmsg.c_str());
                 g_dbus_method_invocation_return_gerror(invoc, err);
                 g_error_free(err);
             }
@@ -950,7 +1172,9 @@ public:
      *   being read.
      *
      *   Only the 'owner' is accessible by anyone, otherwise it must either
-     *   be the session owner or UIDs granted access to this session.
+     *   be the session owner or UIDs granted access to this session.  The
+     *   properties and their access levels are listed in
+     *   session_properties().
      *
      * @param conn           D-Bus connection this event occurred on
      * @param sender         D-Bus bus name of the requester
@@ -964,12 +1188,12 @@ public:
      *          returned and the error must be returned via a GError
      *          object.
      */
-    GVariant * callback_get_property(GDBusConnection *conn,
-                                     const std::string sender,
-                                     const std::string obj_path,
-                                     const std::string intf_name,
-                                     const std::string property_name,
-                                     GError **error)
+    GVariant * callback_property_dispatch(GDBusConnection *conn,
+                                          const gchar *sender,
+                                          const gchar *obj_path,
+                                          const gchar *intf_name,
+                                          const gchar *property_name,
+                                          GError **error)
     {
         if (!registered)
         {
@@ -979,14 +1203,11 @@ public:
                         "Session not active");
             return NULL;
         }
-        if ("owner" == property_name)
-        {
-            return GetOwner();
-        }
 
         try
         {
-            CheckACL(sender);
+            return session_properties().Get(this, sender, property_name,
+                                             error);
         }
         catch (DBusCredentialsException& excp)
         {
@@ -994,116 +1215,13 @@ public:
             excp.SetDBusError(error, G_IO_ERROR, G_IO_ERROR_FAILED);
             return NULL;
         }
-
-
-        /*
-          std::cout << "[SessionObject] get_property(): "
-                  << "sender=" << sender
-                  << ", object_path=" << obj_path
-                  << ", interface=" << intf_name
-                  << ", property=" << property_name
-                  << std::endl;
-        */
-        GVariant *ret = NULL;
-        if ("restrict_log_access" == property_name)
-        {
-            ret = g_variant_new_boolean (restrict_log_access);
-        }
-        else if ("receive_log_events" == property_name)
-        {
-            ret = g_variant_new_boolean (recv_log_events);
-        }
-        else if ("last_log" == property_name)
-        {
-            if (nullptr != sig_logevent) {
-                ret = sig_logevent->GetLastLogEntry();
-                if (NULL == ret)
-                {
-                    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY,
-                                "No data have been logged yet");
-                }
-            } else {
-                g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY,
-                            "Logging not enabled");
-            }
-        }
-        else if ("session_created" == property_name)
-        {
-            ret = g_variant_new_uint64(session_created);
-        }
-        else if ("status" == property_name)
-        {
-            try
-            {
-                be_proxy->Ping();
-                ret = NULL;
-                if (nullptr != sig_statuschg)
-                {
-                    update_last_status();
-                    ret = sig_statuschg->GetLastStatusChange();
-                }
-                if (NULL == ret)
-                {
-                    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY,
-                                "No status changes have been logged yet");
-                }
-            }
-            catch (DBusException& excp)
-            {
-                g_set_error(error, G_DBUS_ERROR, G_IO_ERROR_FAILED,
-                            "Failed retrieving connection status");
-                ret = NULL;
-            }
-        }
-        else if ("statistics" == property_name)
-        {
-            try
-            {
-                be_proxy->Ping();
-                ret = be_proxy->GetProperty("statistics");
-            }
-            catch (DBusException& exp)
-            {
-                g_set_error(error, G_DBUS_ERROR, G_IO_ERROR_FAILED,
-                            "Failed retrieving connection statistics");
-                ret = NULL;
-            }
-        }
-        else if ("config_path" == property_name)
-        {
-            ret = g_variant_new_string (config_path.c_str());
-        }
-        else if ("backend_pid" == property_name)
-        {
-            ret = g_variant_new_uint32 (backend_pid);
-        }
-        else if ("log_verbosity" == property_name)
-        {
-            ret = g_variant_new_uint32 (GetLogLevel());
-        }
-        else if ("public_access" == property_name)
-        {
-            ret = GetPublicAccess();
-        }
-        else if ("acl" == property_name)
-        {
-            ret = GetAccessList();
-        }
-        else
-        {
-            g_set_error(error,
-                        G_IO_ERROR,
-                        G_IO_ERROR_FAILED,
-                        "Unknown property");
-        }
-
-        return ret;
     };
 
 
     /**
      *  Callback method which is used each time a SessionObject property
-     *  is being modified over the D-Bus.
+     *  is being modified over the D-Bus.  The properties which can be
+     *  modified and their access levels are listed in session_properties().
      *
      * @param conn           D-Bus connection this event occurred on
      * @param sender         D-Bus bus name of the requester
@@ -1117,22 +1235,14 @@ public:
      *         D-Bus library to issue the required PropertiesChanged signal.
      *         If an error occurres, the DBusPropertyException is thrown.
      */
-    GVariantBuilder * callback_set_property(GDBusConnection *conn,
-                                            const std::string sender,
-                                            const std::string obj_path,
-                                            const std::string intf_name,
-                                            const std::string property_name,
-                                            GVariant *value,
-                                            GError **error)
+    GVariantBuilder * callback_set_property_dispatch(GDBusConnection *conn,
+                                                     const gchar *sender,
+                                                     const gchar *obj_path,
+                                                     const gchar *intf_name,
+                                                     const gchar *property_name,
+                                                     GVariant *value,
+                                                     GError **error)
     {
-        /*
-          std::cout << "[SessionObject] set_property(): "
-                  << "sender=" << sender
-                  << ", object_path=" << obj_path
-                  << ", interface=" << intf_name
-                  << ", property=" << property_name
-                  << std::endl;
-        */
         if (!registered)
         {
             g_set_error(error,
@@ -1142,18 +1252,10 @@ public:
             return NULL;
         }
 
+        GVariantBuilder *ret = NULL;
         try
         {
-            if (!restrict_log_access
-                && ("receive_log_events" == property_name
-                    || "log_verbosity" == property_name))
-            {
-                CheckACL(sender);
-            }
-            else
-            {
-                CheckOwnerAccess(sender);
-            }
+            ret = session_properties().Set(this, sender, property_name, value);
         }
         catch (DBusCredentialsException& excp)
         {
@@ -1162,66 +1264,19 @@ public:
                                         obj_path, intf_name, property_name,
                                         excp.getUserError());
         }
-
-        try
-        {
-            if (("restrict_log_access" == property_name) && be_conn)
-            {
-                restrict_log_access = g_variant_get_boolean(value);
-                return build_set_property_response(property_name,
-                                                   restrict_log_access);
-            }
-            else if (("receive_log_events" == property_name) && be_conn)
-            {
-                recv_log_events = g_variant_get_boolean(value);
-                if (recv_log_events && nullptr == sig_logevent)
-                {
-                    // Subscribe to log signals
-                    sig_logevent = new SessionLogEvent(
-                                    be_conn,
-                                    be_busname,
-                                    OpenVPN3DBus_interf_backends,
-                                    be_path,
-                                    GetObjectPath());
-                    sig_logevent->SetLogLevel(default_session_log_level);
-                }
-                else if (!recv_log_events && nullptr != sig_logevent)
-                {
-                    delete sig_logevent;
-                    sig_logevent = nullptr;
-                }
-                return build_set_property_response(property_name, recv_log_events);
-            }
-            else if (("log_verbosity" == property_name) && be_conn && sig_logevent)
-            {
-                unsigned int log_verb = g_variant_get_uint32(value);
-                sig_logevent->SetLogLevel(log_verb);
-                SetLogLevel(log_verb);
-
-                // FIXME: Proxy log level to the OpenVPN3 Core client
-                return build_set_property_response(property_name,
-                                                   (guint32) log_verb);
-            }
-            else if (("public_access" == property_name) && conn)
-            {
-                bool acl_public = g_variant_get_boolean(value);
-                SetPublicAccess(acl_public);
-                LogInfo("Public access set to "
-                         + (acl_public ? std::string("true") :
-                                         std::string("false"))
-                         + " by uid " + std::to_string(GetUID(sender)));
-                return build_set_property_response(property_name, acl_public);
-            }
-        }
         catch (DBusException& excp)
         {
             throw DBusPropertyException(G_IO_ERROR, G_IO_ERROR_FAILED,
                                         obj_path, intf_name, property_name,
                                         excp.what());
         }
-        throw DBusPropertyException(G_IO_ERROR, G_IO_ERROR_FAILED,
-                                    obj_path, intf_name, property_name,
-                                    "Invalid property");
+        if (NULL == ret)
+        {
+            throw DBusPropertyException(G_IO_ERROR, G_IO_ERROR_FAILED,
+                                        obj_path, intf_name, property_name,
+                                        "Invalid property");
+        }
+        return ret;
     }
 
 
@@ -1231,6 +1286,17 @@ public:
      */
     void callback_destructor ()
     {
+        if (be_watch > 0)
+        {
+            g_bus_unwatch_name(be_watch);
+            be_watch = 0;
+        }
+        cancel_exit_reason();
+        cancel_connection_timing();
+        cancel_reconnect();
+        clear_forward_subscribers();
+        close_statistics_page();
+
         if( nullptr != sig_statuschg)
         {
             delete sig_statuschg;
@@ -1242,156 +1308,1628 @@ public:
             delete sig_logevent;
             sig_logevent = nullptr;
         }
+        unsubscribe_backend_link();
     };
 
 
-private:
-    unsigned int default_session_log_level = 4; // LogCategory::INFO messages
-    std::function<void()> remove_callback;
-    DBusProxy *be_proxy;
-    bool restrict_log_access;
-    bool recv_log_events;
-    std::time_t session_created;
-    std::string config_path;
-    SessionStatusChange *sig_statuschg;
-    SessionLogEvent *sig_logevent;
-    std::string backend_token;
-    pid_t backend_pid;
-    GDBusConnection *be_conn;
-    std::string be_busname;
-    std::string be_path;
-    bool registered;
-    bool selfdestruct_complete;
-    std::mutex selfdestruct_guard;
+private:
+    unsigned int default_session_log_level = 4; // LogCategory::INFO messages
+    std::function<void()> remove_callback;
+    SessionManagerMetrics::Ptr metrics;
+    ReconnectCoordinator::Ptr reconnects;
+    unsigned int reconnect_priority;
+    bool reconnect_queued;
+    GCancellable *reconnect_pause_cancel;
+    std::chrono::steady_clock::time_point reconnect_admitted;
+    SessionJournal::Ptr journal;
+    std::chrono::steady_clock::time_point backend_started;
+    DBusProxy *be_proxy;
+    bool restrict_log_access;
+    bool recv_log_events;
+    std::time_t session_created;
+    std::string config_path;
+    SessionStatusChange *sig_statuschg;
+    SessionLogEvent *sig_logevent;
+    std::map<std::string, guint> forward_subscribers;
+    std::string backend_token;
+    pid_t backend_pid;
+    GDBusConnection *be_conn;
+    GDBusConnection *be_link;
+    GCancellable *be_link_cancel;
+    std::vector<guint> be_link_subscr;
+    std::string be_busname;
+    std::string be_path;
+    guint be_watch;
+    GCancellable *be_exit_cancel;
+    GCancellable *be_timing_cancel;
+    GVariant *connection_timing;
+    int stats_page_fd;
+    std::unique_ptr<StatsPageReader> stats_page;
+    bool registered;
+    bool selfdestruct_complete;
+    std::mutex selfdestruct_guard;
+
+
+    /**
+     *  D-Bus methods of a session and the access level they require.
+     *  Methods which may be used by root as well can be used by the
+     *  backend start service to manage sessions.
+     */
+    static const DBusMethodTable<SessionObject>& session_methods()
+    {
+        static const DBusMethodTable<SessionObject> methods =
+            DBusMethodTable<SessionObject>()
+            .Add("Connect", DBusAccess::ACL, &SessionObject::method_connect)
+            .Add("Restart", DBusAccess::ACL_ROOT, &SessionObject::method_restart)
+            .Add("Pause", DBusAccess::ACL_ROOT, &SessionObject::method_pause)
+            .Add("Resume", DBusAccess::ACL_ROOT, &SessionObject::method_resume)
+            .Add("Disconnect", DBusAccess::ACL_ROOT, &SessionObject::method_disconnect)
+            .Add("Ready", DBusAccess::ACL, &SessionObject::method_ready)
+            .Add("UserInputQueueGetTypeGroup", DBusAccess::ACL,
+                 &SessionObject::method_user_input_queue)
+            .Add("UserInputQueueFetch", DBusAccess::ACL,
+                 &SessionObject::method_user_input_queue)
+            .Add("UserInputQueueCheck", DBusAccess::ACL,
+                 &SessionObject::method_user_input_queue)
+            .Add("UserInputProvide", DBusAccess::ACL,
+                 &SessionObject::method_user_input_queue)
+            .Add("AccessGrant", DBusAccess::OWNER, &SessionObject::method_access_grant)
+            .Add("AccessRevoke", DBusAccess::OWNER, &SessionObject::method_access_revoke)
+            .Add("GetStatisticsPage", DBusAccess::ACL,
+                 &SessionObject::method_get_statistics_page)
+            .Add("LogForward", DBusAccess::ACL_ROOT, &SessionObject::method_log_forward);
+        return methods;
+    }
+
+
+    void method_connect(GDBusConnection *conn, const gchar *sender,
+                        GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        be_proxy->Call("Connect");
+        LogVerb2("Starting connection");
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    void method_restart(GDBusConnection *conn, const gchar *sender,
+                        GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        be_proxy->Call("Restart");
+        LogVerb2("Restarting connection");
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    void method_pause(GDBusConnection *conn, const gchar *sender,
+                      GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        // An explicit pause overrides a queued reconnect
+        cancel_reconnect();
+        // FIXME: Should check that params contains only the expected formatting
+        be_proxy->Call("Pause", params);
+        LogVerb2("Pausing connection");
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    void method_resume(GDBusConnection *conn, const gchar *sender,
+                       GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        cancel_reconnect();
+        be_proxy->Call("Resume");
+        LogVerb2("Resuming connection");
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    void method_disconnect(GDBusConnection *conn, const gchar *sender,
+                           GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        LogVerb2("Disconnecting connection");
+        shutdown(false, true);
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    void method_ready(GDBusConnection *conn, const gchar *sender,
+                      GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        try
+        {
+            be_proxy->Call("Ready");
+        }
+        catch (DBusException& dberr)
+        {
+            GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.sessions.error",
+                                                          dberr.what());
+            g_dbus_method_invocation_return_gerror(invoc, err);
+            g_error_free(err);
+            return;
+        }
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    /**
+     *  The user input queue methods are proxied as-is to the backend
+     */
+    void method_user_input_queue(GDBusConnection *conn, const gchar *sender,
+                                 GVariant *params,
+                                 GDBusMethodInvocation *invoc)
+    {
+        try
+        {
+            GVariant *res = be_proxy->Call(g_dbus_method_invocation_get_method_name(invoc),
+                                           params);
+            g_dbus_method_invocation_return_value(invoc, res);
+            g_variant_unref(res);
+        }
+        catch (RequiresQueueException& excp)
+        {
+            // Convert this exception into an error sent back
+            // to the requester as a D-Bus error instead.
+            excp.GenerateDBusError(invoc);
+        }
+    }
+
+
+    void method_access_grant(GDBusConnection *conn, const gchar *sender,
+                             GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        uid_t uid = -1;
+        g_variant_get(params, "(u)", &uid);
+        GrantAccess(uid);
+        PropertyChanged("acl");
+        update_journal();
+        g_dbus_method_invocation_return_value(invoc, NULL);
+
+        LogInfo("Access granted to UID " + std::to_string(uid));
+    }
+
+
+    void method_access_revoke(GDBusConnection *conn, const gchar *sender,
+                              GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        uid_t uid = -1;
+        g_variant_get(params, "(u)", &uid);
+        RevokeAccess(uid);
+        PropertyChanged("acl");
+        update_journal();
+        g_dbus_method_invocation_return_value(invoc, NULL);
+
+        LogInfo("Access revoked for UID " + std::to_string(uid));
+    }
+
+
+    void method_get_statistics_page(GDBusConnection *conn,
+                                    const gchar *sender,
+                                    GVariant *params,
+                                    GDBusMethodInvocation *invoc)
+    {
+        // Monitoring tools with access to this session can map
+        // the statistics page themselves and sample it without
+        // any further D-Bus calls
+        return_statistics_page(invoc);
+    }
+
+
+    void method_log_forward(GDBusConnection *conn, const gchar *sender,
+                            GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        // Front-ends must ask for the Log and StatusChange
+        // signals of this session; they are not sent otherwise
+        gboolean enable = false;
+        g_variant_get(params, "(b)", &enable);
+        if (enable)
+        {
+            add_forward_subscriber(sender);
+        }
+        else
+        {
+            remove_forward_subscriber(sender);
+        }
+        g_dbus_method_invocation_return_value(invoc, NULL);
+    }
+
+
+    /**
+     *  D-Bus properties of a session, and the access level required to
+     *  read and modify them.  Who may modify receive_log_events and
+     *  log_verbosity depends on restrict_log_access; their setters do
+     *  the access check.
+     */
+    static const DBusPropertyTable<SessionObject>& session_properties()
+    {
+        static const DBusPropertyTable<SessionObject> properties =
+            DBusPropertyTable<SessionObject>()
+            .Add("owner", DBusAccess::ANY, &SessionObject::property_owner)
+            .Add("restrict_log_access", DBusAccess::ACL,
+                 &SessionObject::property_restrict_log_access,
+                 DBusAccess::OWNER, &SessionObject::set_restrict_log_access)
+            .Add("receive_log_events", DBusAccess::ACL,
+                 &SessionObject::property_receive_log_events,
+                 DBusAccess::ANY, &SessionObject::set_receive_log_events)
+            .Add("last_log", DBusAccess::ACL, &SessionObject::property_last_log)
+            .Add("session_created", DBusAccess::ACL,
+                 &SessionObject::property_session_created)
+            .Add("status", DBusAccess::ACL, &SessionObject::property_status)
+            .Add("statistics", DBusAccess::ACL, &SessionObject::property_statistics)
+            .Add("connection_timing", DBusAccess::ACL,
+                 &SessionObject::property_connection_timing)
+            .Add("config_path", DBusAccess::ACL, &SessionObject::property_config_path)
+            .Add("backend_pid", DBusAccess::ACL, &SessionObject::property_backend_pid)
+            .Add("log_verbosity", DBusAccess::ACL,
+                 &SessionObject::property_log_verbosity,
+                 DBusAccess::ANY, &SessionObject::set_log_verbosity)
+            .Add("reconnect_priority", DBusAccess::ACL,
+                 &SessionObject::property_reconnect_priority,
+                 DBusAccess::OWNER, &SessionObject::set_reconnect_priority)
+            .Add("public_access", DBusAccess::ACL,
+                 &SessionObject::property_public_access,
+                 DBusAccess::OWNER, &SessionObject::set_public_access)
+            .Add("acl", DBusAccess::ACL, &SessionObject::property_acl);
+        return properties;
+    }
+
+
+    GVariant * property_owner(GError **error)
+    {
+        return GetOwner();
+    }
+
+
+    GVariant * property_restrict_log_access(GError **error)
+    {
+        return g_variant_new_boolean(restrict_log_access);
+    }
+
+
+    GVariant * property_receive_log_events(GError **error)
+    {
+        return g_variant_new_boolean(recv_log_events);
+    }
+
+
+    GVariant * property_last_log(GError **error)
+    {
+        if (nullptr == sig_logevent)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY,
+                        "Logging not enabled");
+            return NULL;
+        }
+        GVariant *ret = sig_logevent->GetLastLogEntry();
+        if (NULL == ret)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY,
+                        "No data have been logged yet");
+        }
+        return ret;
+    }
+
+
+    GVariant * property_session_created(GError **error)
+    {
+        return g_variant_new_uint64(session_created);
+    }
+
+
+    GVariant * property_status(GError **error)
+    {
+        // The status is tracked from the StatusChange signals
+        // of the backend, no need to ask the backend process
+        GVariant *ret = NULL;
+        if (nullptr != sig_statuschg)
+        {
+            ret = sig_statuschg->GetLastStatusChange();
+        }
+        if (NULL == ret)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY,
+                        "No status changes have been logged yet");
+        }
+        return ret;
+    }
+
+
+    GVariant * property_statistics(GError **error)
+    {
+        try
+        {
+            return get_statistics();
+        }
+        catch (DBusException& exp)
+        {
+            g_set_error(error, G_DBUS_ERROR, G_IO_ERROR_FAILED,
+                        "Failed retrieving connection statistics");
+            return NULL;
+        }
+    }
+
+
+    GVariant * property_connection_timing(GError **error)
+    {
+        // Retrieved from the backend once the connection is
+        // established, see fetch_connection_timing()
+        return (connection_timing ? g_variant_ref(connection_timing)
+                : g_variant_new_array(G_VARIANT_TYPE("{sx}"), NULL, 0));
+    }
+
+
+    GVariant * property_config_path(GError **error)
+    {
+        return g_variant_new_string(config_path.c_str());
+    }
+
+
+    GVariant * property_backend_pid(GError **error)
+    {
+        return g_variant_new_uint32(backend_pid);
+    }
+
+
+    GVariant * property_log_verbosity(GError **error)
+    {
+        return g_variant_new_uint32(GetLogLevel());
+    }
+
+
+    GVariant * property_reconnect_priority(GError **error)
+    {
+        return g_variant_new_uint32(reconnect_priority);
+    }
+
+
+    GVariant * property_public_access(GError **error)
+    {
+        return GetPublicAccess();
+    }
+
+
+    GVariant * property_acl(GError **error)
+    {
+        return GetAccessList();
+    }
+
+
+    /**
+     *  Unless restrict_log_access is set, users granted access to the
+     *  session may change the log settings as well
+     */
+    void check_log_access(const gchar *sender)
+    {
+        if (!restrict_log_access)
+        {
+            CheckACL(sender);
+        }
+        else
+        {
+            CheckOwnerAccess(sender);
+        }
+    }
+
+
+    GVariantBuilder * set_restrict_log_access(const gchar *sender,
+                                              GVariant *value)
+    {
+        if (!be_conn)
+        {
+            return NULL;
+        }
+        restrict_log_access = g_variant_get_boolean(value);
+        update_journal();
+        return build_set_property_response("restrict_log_access",
+                                           restrict_log_access);
+    }
+
+
+    GVariantBuilder * set_receive_log_events(const gchar *sender,
+                                             GVariant *value)
+    {
+        check_log_access(sender);
+        if (!be_conn)
+        {
+            return NULL;
+        }
+        recv_log_events = g_variant_get_boolean(value);
+        if (recv_log_events && nullptr == sig_logevent)
+        {
+            enable_log_events(default_session_log_level);
+        }
+        else if (!recv_log_events && nullptr != sig_logevent
+                 && forward_subscribers.empty())
+        {
+            delete sig_logevent;
+            sig_logevent = nullptr;
+        }
+        else if (nullptr != sig_logevent)
+        {
+            set_log_service_target(recv_log_events);
+        }
+        update_journal();
+        return build_set_property_response("receive_log_events",
+                                           recv_log_events);
+    }
+
+
+    GVariantBuilder * set_log_verbosity(const gchar *sender, GVariant *value)
+    {
+        check_log_access(sender);
+        if (!be_conn || !sig_logevent)
+        {
+            return NULL;
+        }
+        unsigned int log_verb = g_variant_get_uint32(value);
+        sig_logevent->SetLogLevel(log_verb);
+        SetLogLevel(log_verb);
+        update_journal();
+
+        // FIXME: Proxy log level to the OpenVPN3 Core client
+        return build_set_property_response("log_verbosity",
+                                           (guint32) log_verb);
+    }
+
+
+    GVariantBuilder * set_public_access(const gchar *sender, GVariant *value)
+    {
+        bool acl_public = g_variant_get_boolean(value);
+        SetPublicAccess(acl_public);
+        LogInfo("Public access set to "
+                 + (acl_public ? std::string("true") :
+                                 std::string("false"))
+                 + " by uid " + std::to_string(GetUID(sender)));
+        update_journal();
+        return build_set_property_response("public_access", acl_public);
+    }
+
+
+    GVariantBuilder * set_reconnect_priority(const gchar *sender,
+                                             GVariant *value)
+    {
+        reconnect_priority = g_variant_get_uint32(value);
+        update_journal();
+        return build_set_property_response("reconnect_priority",
+                                           (guint32) reconnect_priority);
+    }
+
+
+    /**
+     *  Initialization shared by the public constructors
+     */
+    SessionObject(GDBusConnection *dbuscon,
+                  std::function<void()> remove_callback,
+                  uid_t owner,
+                  std::string objpath, std::string cfg_path,
+                  unsigned int manager_log_level, LogWriter *logwr,
+                  bool signal_broadcast,
+                  SessionManagerMetrics::Ptr metrics,
+                  ReconnectCoordinator::Ptr reconnects,
+                  SessionJournal::Ptr journal,
+                  std::time_t created)
+        : DBusObject(objpath),
+          DBusSignalSubscription(dbuscon, "", OpenVPN3DBus_interf_backends, ""),
+          DBusCredentials(dbuscon, owner),
+          SessionManagerSignals(dbuscon, objpath, manager_log_level, logwr,
+                                signal_broadcast),
+          remove_callback(remove_callback),
+          metrics(metrics),
+          reconnects(reconnects),
+          reconnect_priority(0),
+          reconnect_queued(false),
+          reconnect_pause_cancel(nullptr),
+          journal(journal),
+          backend_started(std::chrono::steady_clock::now()),
+          be_proxy(nullptr),
+          restrict_log_access(true),
+          recv_log_events(false),
+          session_created(created),
+          config_path(cfg_path),
+          sig_statuschg(nullptr),
+          sig_logevent(nullptr),
+          backend_token(""),
+          backend_pid(0),
+          be_conn(nullptr),
+          be_link(nullptr),
+          be_link_cancel(nullptr),
+          be_watch(0),
+          be_exit_cancel(nullptr),
+          be_timing_cancel(nullptr),
+          connection_timing(nullptr),
+          stats_page_fd(-1),
+          registered(false),
+          selfdestruct_complete(false)
+    {
+        // Only for the initialization of this object, use the manager's
+        // log level.  Once the object is registered with a backend, it
+        // will switch to the default session log level.
+        SetLogLevel(manager_log_level);
+
+        // All session properties are restricted by the access control
+        // list, so PropertiesChanged signals must not carry the values
+        SetPropertiesChangedInvalidateOnly(true);
+
+        // The introspection document is the same for all sessions
+        SetSharedIntrospection("SessionObject", [this]()
+            {
+                RequiresQueue dummyqueue;  // Only used to get introspection data
+                std::stringstream introspection_xml;
+                introspection_xml << "<node>"
+                                  << "    <interface name='" << OpenVPN3DBus_interf_sessions << "'>"
+                                  << "        <method name='Connect'/>"
+                                  << "        <method name='Pause'>"
+                                  << "            <arg type='s' name='reason' direction='in'/>"
+                                  << "        </method>"
+                                  << "        <method name='Resume'/>"
+                                  << "        <method name='Restart'/>"
+                                  << "        <method name='Disconnect'/>"
+                                  << "        <method name='Ready'/>"
+                                  << "        <method name='AccessGrant'>"
+                                  << "            <arg direction='in' type='u' name='uid'/>"
+                                  << "        </method>"
+                                  << "        <method name='AccessRevoke'>"
+                                  << "            <arg direction='in' type='u' name='uid'/>"
+                                  << "        </method>"
+                                  << "        <method name='GetStatisticsPage'>"
+                                  << "            <arg direction='out' type='h' name='page_fd'/>"
+                                  << "        </method>"
+                                  << "        <method name='LogForward'>"
+                                  << "            <arg direction='in' type='b' name='enable'/>"
+                                  << "        </method>"
+                                  << dummyqueue.IntrospectionMethods("UserInputQueueGetTypeGroup",
+                                                                     "UserInputQueueFetch",
+                                                                     "UserInputQueueCheck",
+                                                                     "UserInputProvide")
+                                  << "        <signal name='AttentionRequired'>"
+                                  << "            <arg type='u' name='type' direction='out'/>"
+                                  << "            <arg type='u' name='group' direction='out'/>"
+                                  << "            <arg type='s' name='message' direction='out'/>"
+                                  << "        </signal>"
+                                  << GetStatusChangeIntrospection()
+                                  << GetLogIntrospection()
+                                  << "        <property type='u' name='owner' access='read'/>"
+                                  << "        <property type='t' name='session_created' access='read'/>"
+                                  << "        <property type='au' name='acl' access='read'/>"
+                                  << "        <property type='b' name='public_access' access='readwrite'/>"
+                                  << "        <property type='(uus)' name='status' access='read'/>"
+                                  << "        <property type='a{sv}' name='last_log' access='read'/>"
+                                  << "        <property type='a{sx}' name='statistics' access='read'/>"
+                                  << "        <property type='a{sx}' name='connection_timing' access='read'/>"
+                                  << "        <property type='o' name='config_path' access='read'/>"
+                                  << "        <property type='u' name='backend_pid' access='read'/>"
+                                  << "        <property type='b' name='restrict_log_access' access='readwrite'/>"
+                                  << "        <property type='b' name='receive_log_events' access='readwrite'/>"
+                                  << "        <property type='u' name='log_verbosity' access='readwrite'/>"
+                                  << "        <property type='u' name='reconnect_priority' access='readwrite'/>"
+                                  << "    </interface>"
+                                  << "</node>";
+                return introspection_xml.str();
+            });
+    }
+
+
+    /**
+     *  Prepares the D-Bus proxy, the signal subscriptions and the bus name
+     *  watch towards the VPN client backend process.  If the backend
+     *  accepts a peer-to-peer link, all the traffic between this session
+     *  and the backend moves to that link once it is up; only the bus
+     *  name watch remains on the system bus.
+     */
+    void connect_backend()
+    {
+        be_proxy = new_backend_proxy();
+        ping_backend();
+
+        // Setup signal listeneres from the backend process
+        subscribe_backend_signals();
+        sig_statuschg = new SessionStatusChange(be_conn,
+                                                be_busname,
+                                                OpenVPN3DBus_interf_backends,
+                                                be_path,
+                                                GetObjectPath(),
+                                                GetSignalBroadcast(),
+                                                be_link);
+        apply_forward_targets(sig_statuschg);
+        if (!forward_subscribers.empty() && nullptr == sig_logevent)
+        {
+            enable_log_events(GetLogLevel());
+        }
+
+        // Get notified if the backend process disappears, instead
+        // of checking if it is alive on each property read
+        be_watch = g_bus_watch_name_on_connection(be_conn,
+                                                  be_busname.c_str(),
+                                                  G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                  NULL,
+                                                  backend_vanished,
+                                                  this, NULL);
+        open_backend_link();
+    }
+
+
+    /**
+     *  Creates a DBusProxy to the backend process, on the backend link
+     *  when available
+     */
+    DBusProxy * new_backend_proxy()
+    {
+        DBusProxy *proxy = nullptr;
+        if (be_link)
+        {
+            proxy = new DBusProxy(be_link,
+                                  "",
+                                  OpenVPN3DBus_interf_backends,
+                                  be_path);
+        }
+        else
+        {
+            proxy = new DBusProxy(G_BUS_TYPE_SYSTEM,
+                                  be_busname,
+                                  OpenVPN3DBus_interf_backends,
+                                  be_path);
+        }
+        // Don't try to auto start backend services over D-Bus,
+        // The backend service should exists _before_ we try to
+        // communicate with it.
+        proxy->SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
+        proxy->EnablePropertyCache({"statistics"});
+        return proxy;
+    }
+
+
+    /**
+     *  Starts opening a peer-to-peer link to the backend process.  Until
+     *  the link is up, and with backends not supporting it, the backend
+     *  is reached via the system bus.
+     */
+    void open_backend_link()
+    {
+        be_link_cancel = g_cancellable_new();
+        try
+        {
+            DBusPeerLink::Open(be_conn, be_busname, be_path,
+                               OpenVPN3DBus_interf_backends,
+                               "OpenPeerLink",
+                               be_link_cancel,
+                               5000,
+                               [this](GDBusConnection *link,
+                                      const std::string& error)
+                               {
+                                   backend_link_ready(link, error);
+                               });
+        }
+        catch (DBusException& excp)
+        {
+            Debug("Backend link not available, using the system bus: "
+                  + std::string(excp.what()));
+            cancel_backend_link();
+        }
+    }
+
+
+    /**
+     *  Moves the proxy and the signal subscriptions towards the backend
+     *  to the new backend link.  Messages on the link are not processed
+     *  before this has returned, so no signals are lost while moving.
+     */
+    void backend_link_ready(GDBusConnection *link, const std::string& error)
+    {
+        g_object_unref(be_link_cancel);
+        be_link_cancel = nullptr;
+        if (!link)
+        {
+            Debug("Backend link not available, using the system bus: "
+                  + error);
+            return;
+        }
+        be_link = link;
+
+        for (const char *signame : {"AttentionRequired", "StatusChange"})
+        {
+            Unsubscribe(signame);
+        }
+        subscribe_backend_signals();
+        sig_statuschg->MoveSubscriptions(be_link, "");
+        if (sig_logevent)
+        {
+            sig_logevent->MoveSubscriptions(be_link, "");
+        }
+
+        DBusProxy *proxy = new_backend_proxy();
+        delete be_proxy;
+        be_proxy = proxy;
+        Debug("Backend link established");
+    }
+
+
+    void cancel_backend_link()
+    {
+        if (be_link_cancel)
+        {
+            g_cancellable_cancel(be_link_cancel);
+            g_object_unref(be_link_cancel);
+            be_link_cancel = nullptr;
+        }
+    }
+
+
+    /**
+     *  Subscribes to the AttentionRequired and StatusChange signals from
+     *  the backend process, on the backend link when available
+     */
+    void subscribe_backend_signals()
+    {
+        for (const char *signame : {"AttentionRequired", "StatusChange"})
+        {
+            if (!be_link)
+            {
+                Subscribe(be_busname, be_path, signame);
+                continue;
+            }
+
+            // Signals on the link have no sender, and
+            // only the backend can send them
+            guint id = DBusSignalRouter::Subscribe(be_link,
+                                                   NULL,
+                                                   OpenVPN3DBus_interf_backends.c_str(),
+                                                   signame,
+                                                   be_path.c_str(),
+                                                   NULL,
+                                                   dbusobject_callback_signal_handler,
+                                                   static_cast<DBusSignalSubscription *>(this));
+            if (0 == id)
+            {
+                THROW_DBUSEXCEPTION("SessionObject",
+                                    "Failed to subscribe to the backend "
+                                    + std::string(signame) + " signal");
+            }
+            be_link_subscr.push_back(id);
+        }
+    }
+
+
+    void unsubscribe_backend_link()
+    {
+        for (const auto& id : be_link_subscr)
+        {
+            DBusSignalRouter::Unsubscribe(id);
+        }
+        be_link_subscr.clear();
+    }
+
+
+    /**
+     *  Closes the backend link.  The backend will then send its signals
+     *  via the system bus again.
+     */
+    void close_backend_link()
+    {
+        cancel_backend_link();
+        if (!be_link)
+        {
+            return;
+        }
+        unsubscribe_backend_link();
+        g_dbus_connection_close_sync(be_link, NULL, NULL);
+        g_object_unref(be_link);
+        be_link = nullptr;
+    }
+
+
+    /**
+     *  Connection and destination bus name to use for calls to the
+     *  backend process not going via be_proxy
+     */
+    GDBusConnection * backend_conn() const
+    {
+        return (be_link ? be_link : be_conn);
+    }
+
+
+    const gchar * backend_dest() const
+    {
+        return (be_link ? NULL : be_busname.c_str());
+    }
+
+
+    /**
+     *  Returns the time since this object was created, in microseconds.
+     *  Used by the session tracepoints.
+     */
+    uint64_t trace_session_age() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - backend_started).count();
+    }
+
+
+    /**
+     *  Ties the VPN client backend process to this SessionObject.  Once that
+     *  is done, it calls the RegistrationConfirmation method in the backend
+     *  process where it confirms the backend token and provides the
+     *  VPN configuration D-Bus object path to the backend.
+     */
+    void register_backend()
+    {
+        try
+        {
+            connect_backend();
+
+            GVariant *res_g = be_proxy->Call("RegistrationConfirmation",
+                                             g_variant_new("(so)",
+                                                           backend_token.c_str(),
+                                                           config_path.c_str()));
+            if (NULL == res_g) {
+                THROW_DBUSEXCEPTION("SessionObject",
+                                    "Failed to extract the result of the "
+                                    "RegistrationConfirmation response");
+            }
+            g_variant_get(res_g, "(b)", &registered);
+            if (!registered)
+            {
+                // FIXME: Find a way to gracefully handle failed registration
+                return;
+            }
+            Debug("New session registered: " + GetObjectPath());
+            OPENVPN3_TRACE3(session_registered, GetObjectPath().c_str(),
+                            (int) backend_pid, trace_session_age());
+            metrics->ObserveSpawn(std::chrono::steady_clock::now() - backend_started);
+            open_statistics_page();
+            StatusChange(StatusMajor::SESSION, StatusMinor::SESS_NEW,
+                         "session_path=" + GetObjectPath()
+                         + " backend_busname=" + be_busname
+                         + " backend_path=" + be_path);
+            registered = true;
+            update_journal();
+        }
+        catch (DBusException& err)
+        {
+            THROW_DBUSEXCEPTION("SessionObject", err.what());
+        }
+    }
+
+
+    /**
+     *  Takes over a VPN client backend process recorded in the session
+     *  journal.  The backend verifies the backend token and redirects
+     *  its signals to this session manager.  The current status is
+     *  retrieved from the backend, as the StatusChange signals sent while
+     *  no session manager was running have been lost.
+     */
+    void reattach_backend()
+    {
+        connect_backend();
+
+        GVariant *res_g = be_proxy->Call("Reattach",
+                                         g_variant_new("(s)",
+                                                       backend_token.c_str()));
+        if (NULL == res_g)
+        {
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "Failed to extract the result of the "
+                                "Reattach response");
+        }
+        gboolean accepted = false;
+        g_variant_get(res_g, "(b)", &accepted);
+        g_variant_unref(res_g);
+        if (!accepted)
+        {
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "Backend did not accept the session token");
+        }
+        registered = true;
+
+        try
+        {
+            GVariant *status = be_proxy->GetProperty("status");
+            sig_statuschg->SetLastStatus(status);
+            g_variant_unref(status);
+        }
+        catch (DBusException&)
+        {
+            // The backend has not reported any status yet
+        }
+        open_statistics_page();
+    }
+
+
+    /**
+     *  Records the current state of this session in the session journal
+     */
+    void update_journal()
+    {
+        if (!journal || !registered)
+        {
+            return;
+        }
+
+        SessionJournalEntry e;
+        e.session_path = GetObjectPath();
+        e.config_path = config_path;
+        e.owner = GetOwnerUID();
+        e.acl = GetAccessListUIDs();
+        e.public_access = IsPublicAccess();
+        e.session_created = session_created;
+        e.backend_busname = be_busname;
+        e.backend_path = be_path;
+        e.backend_token = backend_token;
+        e.backend_pid = backend_pid;
+        e.restrict_log_access = restrict_log_access;
+        e.receive_log_events = recv_log_events;
+        e.log_verbosity = GetLogLevel();
+        e.reconnect_priority = reconnect_priority;
+        journal->Store(e);
+    }
+
+
+    void remove_from_journal()
+    {
+        if (!journal)
+        {
+            return;
+        }
+        journal->Remove(GetObjectPath());
+    }
+
+
+    /**
+     *  Starts proxying Log signals from the backend process
+     *
+     * @param log_level  Log level of the proxied Log signals
+     */
+    void enable_log_events(unsigned int log_level)
+    {
+        sig_logevent = new SessionLogEvent(be_conn,
+                                           be_busname,
+                                           OpenVPN3DBus_interf_backends,
+                                           be_path,
+                                           GetObjectPath(),
+                                           GetSignalBroadcast(),
+                                           be_link);
+        sig_logevent->SetLogLevel(log_level);
+        sig_logevent->SetLastLogCallback([this]()
+                                         {
+                                             PropertyChanged("last_log");
+                                         });
+        apply_forward_targets(sig_logevent);
+        set_log_service_target(recv_log_events);
+    }
+
+
+    /**
+     *  Unless signals are broadcast, the log service only receives the
+     *  proxied Log signals when receive_log_events is enabled
+     */
+    void set_log_service_target(bool enable)
+    {
+        if (GetSignalBroadcast() || nullptr == sig_logevent)
+        {
+            return;
+        }
+        try
+        {
+            DBusConnectionCreds credsprx(DBusSignalSubscription::GetConnection());
+            std::string logsrv = credsprx.GetUniqueBusID(OpenVPN3DBus_name_log);
+            sig_logevent->RemoveTargetBusName(logsrv);
+            if (enable)
+            {
+                sig_logevent->AddTargetBusName(logsrv);
+            }
+        }
+        catch (DBusException& excp)
+        {
+            LogWarn("Could not look up the log service: "
+                    + std::string(excp.what()));
+        }
+    }
+
+
+    /**
+     *  Starts sending the Log and StatusChange signals of this session
+     *  to a front-end which has called LogForward.  This lasts until
+     *  LogForward is called again to disable it, or the front-end
+     *  disconnects from the bus.
+     *
+     * @param busname  Unique bus name of the front-end
+     */
+    void add_forward_subscriber(const std::string& busname)
+    {
+        if (forward_subscribers.end() != forward_subscribers.find(busname))
+        {
+            return;
+        }
+        forward_subscribers[busname] =
+            g_bus_watch_name_on_connection(DBusSignalSubscription::GetConnection(),
+                                           busname.c_str(),
+                                           G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                           NULL,
+                                           forward_subscriber_vanished,
+                                           this, NULL);
+        if (sig_statuschg)
+        {
+            sig_statuschg->AddForwardTarget(busname);
+        }
+        if (sig_logevent)
+        {
+            sig_logevent->AddForwardTarget(busname);
+        }
+        if (be_conn && nullptr == sig_logevent)
+        {
+            // If the backend is not connected yet, this is done
+            // in connect_backend()
+            enable_log_events(GetLogLevel());
+        }
+        Debug("Forwarding signals to " + busname);
+    }
+
+
+    /**
+     *  Stops sending signals to a front-end.  When the last front-end
+     *  is gone, the backend log events are no longer processed unless
+     *  receive_log_events is set.
+     *
+     * @param busname  Unique bus name of the front-end
+     */
+    void remove_forward_subscriber(const std::string& busname)
+    {
+        auto it = forward_subscribers.find(busname);
+        if (forward_subscribers.end() == it)
+        {
+            return;
+        }
+        g_bus_unwatch_name(it->second);
+        forward_subscribers.erase(it);
+
+        if (sig_statuschg)
+        {
+            sig_statuschg->RemoveForwardTarget(busname);
+        }
+        if (sig_logevent)
+        {
+            sig_logevent->RemoveForwardTarget(busname);
+        }
+        if (forward_subscribers.empty() && !recv_log_events
+            && nullptr != sig_logevent)
+        {
+            delete sig_logevent;
+            sig_logevent = nullptr;
+        }
+        Debug("Stopped forwarding signals to " + busname);
+    }
+
+
+    void clear_forward_subscribers()
+    {
+        for (const auto& sub : forward_subscribers)
+        {
+            g_bus_unwatch_name(sub.second);
+        }
+        forward_subscribers.clear();
+    }
+
+
+    /**
+     *  Directs a newly created signal proxy to the current subscribers
+     */
+    void apply_forward_targets(SessionForwardTargets *proxy)
+    {
+        for (const auto& sub : forward_subscribers)
+        {
+            proxy->AddForwardTarget(sub.first);
+        }
+    }
+
+
+    static void forward_subscriber_vanished(GDBusConnection *conn,
+                                            const gchar *name,
+                                            gpointer this_ptr)
+    {
+        SessionObject *obj = (SessionObject *) this_ptr;
+        obj->remove_forward_subscriber(std::string(name));
+    }
+
+
+    /**
+     * Simple ping-pong game between this SessionObject and its VPN client
+     * backend.  If the backend does not respond, we treat it as dead and will
+     * start to clean-up this session.
+     *
+     * @return  Returns True if the backend process is alive, otherwise False.
+     */
+    bool ping_backend()
+    {
+        if (nullptr == be_proxy)
+        {
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "No backend proxy connection established, "
+                                "cannot ping backend");
+        }
+
+        GVariant *res_g = NULL;
+        try {
+            // This Ping() is the BackendClientObject responding,
+            // which ensures the VPN client process is initialized
+            res_g = be_proxy->Call("Ping");
+        }
+        catch (DBusException &dbserr)
+        {
+            res_g = NULL;
+            Debug(be_busname, be_path, backend_pid, std::string(dbserr.what()));
+        }
+        if (NULL == res_g)
+        {
+            THROW_DBUSEXCEPTION("SessionObject",
+                                "VPN backend process unavailable, "
+                                "does not respond to internal Ping()");
+        }
+
+        bool ret = false;
+        g_variant_get(res_g, "(b)", &ret);
+        g_variant_unref(res_g);
+        return ret;
+    }
+
+
+    /**
+     *  Called by GDBus when the bus name of the backend process is no
+     *  longer present on the bus.
+     *
+     * @param conn      GDBusConnection where the name was watched
+     * @param name      C string with the bus name which vanished
+     * @param this_ptr  Pointer to the SessionObject owning the watch
+     */
+    static void backend_vanished(GDBusConnection *conn, const gchar *name,
+                                 gpointer this_ptr)
+    {
+        SessionObject *obj = (SessionObject *) this_ptr;
+        if (nullptr == obj->sig_statuschg
+            || obj->sig_statuschg->SessionCompleted()
+            || obj->be_exit_cancel)
+        {
+            return;
+        }
+
+        // Ask the backend starter why the process stopped.  The response
+        // is delayed until the backend process has been reaped.
+        obj->be_exit_cancel = g_cancellable_new();
+        g_dbus_connection_call(conn,
+                               OpenVPN3DBus_name_backends.c_str(),
+                               OpenVPN3DBus_rootp_backends.c_str(),
+                               OpenVPN3DBus_interf_backends.c_str(),
+                               "GetExitReason",
+                               g_variant_new("(u)", (guint) obj->backend_pid),
+                               G_VARIANT_TYPE("(iib)"),
+                               G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                               5000,
+                               obj->be_exit_cancel,
+                               backend_exit_reason,
+                               obj);
+    }
+
+
+    static void backend_exit_reason(GObject *source, GAsyncResult *result,
+                                    gpointer this_ptr)
+    {
+        GError *error = NULL;
+        GVariant *res = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                      result, &error);
+        if (!res && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            // The session object is gone
+            g_error_free(error);
+            return;
+        }
+
+        SessionObject *obj = (SessionObject *) this_ptr;
+        std::string reason = "Backend process died";
+        if (res)
+        {
+            ProcessExitReason exit_reason;
+            gboolean core_dumped = false;
+            g_variant_get(res, "(iib)", &exit_reason.exit_code,
+                          &exit_reason.signal, &core_dumped);
+            exit_reason.core_dumped = core_dumped;
+            g_variant_unref(res);
+            reason += ", " + exit_reason.str();
+        }
+        else
+        {
+            g_error_free(error);
+        }
+        obj->cancel_exit_reason();
+
+        if (nullptr == obj->sig_statuschg)
+        {
+            return;
+        }
+        obj->LogError(reason);
+        obj->sig_statuschg->BackendVanished(reason);
+        obj->PropertyChanged("status");
+    }
+
+
+    /**
+     *  Retrieves the shared memory statistics page from the backend
+     *  process.  If this fails, the statistics are provided via the
+     *  property cache instead.
+     */
+    void open_statistics_page()
+    {
+        GError *error = nullptr;
+        GUnixFDList *fdlist = nullptr;
+        GVariant *res = g_dbus_connection_call_with_unix_fd_list_sync(backend_conn(),
+                                                                      backend_dest(),
+                                                                      be_path.c_str(),
+                                                                      OpenVPN3DBus_interf_backends.c_str(),
+                                                                      "GetStatisticsPage",
+                                                                      NULL,
+                                                                      G_VARIANT_TYPE("(h)"),
+                                                                      G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                                                                      -1,
+                                                                      NULL,
+                                                                      &fdlist,
+                                                                      NULL,
+                                                                      &error);
+        if (!res)
+        {
+            Debug("Statistics page not available: "
+                  + std::string(error->message));
+            g_error_free(error);
+            return;
+        }
+
+        gint idx = -1;
+        g_variant_get(res, "(h)", &idx);
+        g_variant_unref(res);
+        stats_page_fd = (fdlist ? g_unix_fd_list_get(fdlist, idx, &error) : -1);
+        if (fdlist)
+        {
+            g_object_unref(fdlist);
+        }
+        if (stats_page_fd < 0)
+        {
+            if (error)
+            {
+                Debug("Statistics page not received: "
+                      + std::string(error->message));
+                g_error_free(error);
+            }
+            return;
+        }
+
+        try
+        {
+            stats_page.reset(new StatsPageReader(stats_page_fd));
+        }
+        catch (DBusException& excp)
+        {
+            LogWarn("Invalid statistics page from backend: "
+                    + std::string(excp.what()));
+            close_statistics_page();
+        }
+    }
+
+
+    void close_statistics_page()
+    {
+        stats_page.reset();
+        if (stats_page_fd >= 0)
+        {
+            close(stats_page_fd);
+            stats_page_fd = -1;
+        }
+    }
+
+
+    /**
+     *  Retrieves the connection statistics without calling the backend
+     *
+     * @return Returns a GVariant object with an a{sx} dictionary
+     */
+    GVariant * get_statistics()
+    {
+        if (stats_page)
+        {
+            // Read directly from the backend statistics page
+            try
+            {
+                return read_statistics_page();
+            }
+            catch (DBusException& excp)
+            {
+                LogWarn("Statistics page unusable, falling back to the "
+                        "backend: " + std::string(excp.what()));
+                close_statistics_page();
+            }
+        }
+        if (!be_proxy)
+        {
+            THROW_DBUSEXCEPTION("SessionObject", "Backend not registered");
+        }
+        // Served from the property cache, which is updated
+        // by the PropertiesChanged signals from the backend
+        return be_proxy->GetProperty("statistics");
+    }
+
+
+    /**
+     *  Builds the statistics property from the statistics page.  Only
+     *  counters with a value are included, like the backend does.
+     *
+     * @return Returns a GVariant object with an a{sx} dictionary
+     */
+    GVariant * read_statistics_page()
+    {
+        static std::vector<std::string> names;
+        if (names.empty())
+        {
+            // The counter layout is the same for all backends
+            names = stats_page->GetNames();
+        }
+
+        std::vector<int64_t> values;
+        uint64_t updated = 0;
+        stats_page->Read(values, updated);
+
+        GVariantBuilder *b = g_variant_builder_new(G_VARIANT_TYPE("a{sx}"));
+        for (size_t i = 0; i < values.size() && i < names.size(); ++i)
+        {
+            if (values[i])
+            {
+                g_variant_builder_add(b, "{sx}", names[i].c_str(),
+                                      (gint64) values[i]);
+            }
+        }
+        GVariant *ret = g_variant_builder_end(b);
+        g_variant_builder_unref(b);
+        return ret;
+    }
+
+
+    /**
+     *  Completes a GetStatisticsPage() method call with a new read-only
+     *  file descriptor to the backend statistics page.
+     *
+     * @param invoc  GDBusMethodInvocation to respond to
+     */
+    void return_statistics_page(GDBusMethodInvocation *invoc)
+    {
+        if (stats_page_fd < 0)
+        {
+            GError *err = g_dbus_error_new_for_dbus_error("net.openvpn.v3.sessions.error",
+                                                          "Statistics page not available");
+            g_dbus_method_invocation_return_gerror(invoc, err);
+            g_error_free(err);
+            return;
+        }
+
+        GUnixFDList *fdlist = g_unix_fd_list_new();
+        GError *error = nullptr;
+        gint idx = g_unix_fd_list_append(fdlist, stats_page_fd, &error);
+        if (idx < 0)
+        {
+            g_object_unref(fdlist);
+            g_dbus_method_invocation_return_gerror(invoc, error);
+            g_error_free(error);
+            return;
+        }
+        g_dbus_method_invocation_return_value_with_unix_fd_list(invoc,
+                                                                g_variant_new("(h)", idx),
+                                                                fdlist);
+        g_object_unref(fdlist);
+    }
 
 
     /**
-     *  Ties the VPN client backend process to this SessionObject.  Once that
-     *  is done, it calls the RegistrationConfirmation method in the backend
-     *  process where it confirms the backend token and provides the
-     *  VPN configuration D-Bus object path to the backend.
+     *  Retrieves the connection setup timing from the backend once the
+     *  connection has been established.  The backend records this before
+     *  signalling CONN_CONNECTED, so it is complete at this point.
      */
-    void register_backend()
+    void fetch_connection_timing()
     {
-        try
+        if (!be_conn || be_timing_cancel)
         {
-            be_proxy = new DBusProxy(G_BUS_TYPE_SYSTEM,
-                                     be_busname,
-                                     OpenVPN3DBus_interf_backends,
-                                     be_path);
-            // Don't try to auto start backend services over D-Bus,
-            // The backend service should exists _before_ we try to
-            // communicate with it.
-            be_proxy->SetGDBusCallFlags(G_DBUS_CALL_FLAGS_NO_AUTO_START);
-            ping_backend();
-
-            // Setup signal listeneres from the backend process
-            // FIXME: Verify how this is related to the subscrition in the caller function
-            sig_statuschg = new SessionStatusChange(be_conn,
-                                                    be_busname,
-                                                    OpenVPN3DBus_interf_backends,
-                                                    be_path,
-                                                    GetObjectPath());
+            return;
+        }
+        be_timing_cancel = g_cancellable_new();
+        g_dbus_connection_call(backend_conn(),
+                               backend_dest(),
+                               be_path.c_str(),
+                               "org.freedesktop.DBus.Properties",
+                               "Get",
+                               g_variant_new("(ss)",
+                                             OpenVPN3DBus_interf_backends.c_str(),
+                                             "connection_timing"),
+                               G_VARIANT_TYPE("(v)"),
+                               G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                               5000,
+                               be_timing_cancel,
+                               connection_timing_received,
+                               this);
+    }
 
-            GVariant *res_g = be_proxy->Call("RegistrationConfirmation",
-                                             g_variant_new("(so)",
-                                                           backend_token.c_str(),
-                                                           config_path.c_str()));
-            if (NULL == res_g) {
-                THROW_DBUSEXCEPTION("SessionObject",
-                                    "Failed to extract the result of the "
-                                    "RegistrationConfirmation response");
-            }
-            g_variant_get(res_g, "(b)", &registered);
-            if (!registered)
+
+    static void connection_timing_received(GObject *source, GAsyncResult *res,
+                                           gpointer this_ptr)
+    {
+        GError *error = nullptr;
+        GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                      res, &error);
+        if (!ret)
+        {
+            if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
             {
-                // FIXME: Find a way to gracefully handle failed registration
-                return;
+                SessionObject *obj = (SessionObject *) this_ptr;
+                obj->cancel_connection_timing();
+                obj->Debug("Could not retrieve connection timing: "
+                           + std::string(error->message));
             }
-            Debug("New session registered: " + GetObjectPath());
-            StatusChange(StatusMajor::SESSION, StatusMinor::SESS_NEW,
-                         "session_path=" + GetObjectPath()
-                         + " backend_busname=" + be_busname
-                         + " backend_path=" + be_path);
-            registered = true;
+            g_error_free(error);
+            return;
         }
-        catch (DBusException& err)
+
+        SessionObject *obj = (SessionObject *) this_ptr;
+        obj->cancel_connection_timing();
+
+        GVariant *timing = nullptr;
+        g_variant_get(ret, "(v)", &timing);
+        g_variant_unref(ret);
+        if (obj->connection_timing)
         {
-            THROW_DBUSEXCEPTION("SessionObject", err.what());
+            g_variant_unref(obj->connection_timing);
+        }
+        obj->connection_timing = timing;
+
+        GVariantIter iter;
+        gchar *phase = nullptr;
+        gint64 usec = 0;
+        g_variant_iter_init(&iter, timing);
+        while (g_variant_iter_loop(&iter, "{sx}", &phase, &usec))
+        {
+            obj->metrics->ObserveConnectPhase(phase, usec);
+        }
+        obj->PropertyChanged("connection_timing");
+    }
+
+
+    void cancel_connection_timing()
+    {
+        if (be_timing_cancel)
+        {
+            g_cancellable_cancel(be_timing_cancel);
+            g_object_unref(be_timing_cancel);
+            be_timing_cancel = nullptr;
         }
     }
 
 
     /**
-     * Simple ping-pong game between this SessionObject and its VPN client
-     * backend.  If the backend does not respond, we treat it as dead and will
-     * start to clean-up this session.
+     *  Asks the ReconnectCoordinator for permission to proceed with a
+     *  reconnect reported by the backend.  If the reconnect is not
+     *  admitted right away, the backend is paused until it is.
      *
-     * @return  Returns True if the backend process is alive, otherwise False.
+     *  The core library reports CONN_RECONNECTING for each attempt.  Once
+     *  admitted, the following attempts are not coordinated again until
+     *  RECONNECT_ADMIT_WINDOW has passed or the session has connected.
      */
-    bool ping_backend()
+    void coordinate_reconnect()
     {
-        if (nullptr == be_proxy)
+        if (!reconnects || reconnect_queued || !be_proxy)
         {
-            THROW_DBUSEXCEPTION("SessionObject",
-                                "No backend proxy connection established, "
-                                "cannot ping backend");
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::steady_clock::time_point() != reconnect_admitted
+            && now - reconnect_admitted < std::chrono::seconds(RECONNECT_ADMIT_WINDOW))
+        {
+            return;
         }
 
-        GVariant *res_g = NULL;
-        try {
-            // This Ping() is the BackendClientObject responding,
-            // which ensures the VPN client process is initialized
-            res_g = be_proxy->Call("Ping");
+        if (reconnects->Request(GetObjectPath(), reconnect_priority,
+                                [this]() { resume_reconnect(); }))
+        {
+            reconnect_admitted = now;
+            return;
         }
-        catch (DBusException &dbserr)
+
+        // This runs from the StatusChange signal handler, so the backend
+        // is paused without waiting for it to respond
+        reconnect_queued = true;
+        reconnect_pause_cancel = g_cancellable_new();
+        g_dbus_connection_call(backend_conn(),
+                               backend_dest(),
+                               be_path.c_str(),
+                               OpenVPN3DBus_interf_backends.c_str(),
+                               "Pause",
+                               g_variant_new("(s)", "Reconnect queued by the session manager"),
+                               NULL,
+                               G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                               5000,
+                               reconnect_pause_cancel,
+                               reconnect_paused,
+                               this);
+        LogVerb1("Reconnect queued");
+    }
+
+
+    static void reconnect_paused(GObject *source, GAsyncResult *res,
+                                 gpointer this_ptr)
+    {
+        GError *error = nullptr;
+        GVariant *ret = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                      res, &error);
+        if (ret)
         {
-            res_g = NULL;
-            Debug(be_busname, be_path, backend_pid, std::string(dbserr.what()));
+            g_variant_unref(ret);
         }
-        if (NULL == res_g)
+        if (error && g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
         {
-            THROW_DBUSEXCEPTION("SessionObject",
-                                "VPN backend process unavailable, "
-                                "does not respond to internal Ping()");
+            g_error_free(error);
+            return;
         }
 
-        bool ret = false;
-        g_variant_get(res_g, "(b)", &ret);
-        g_variant_unref(res_g);
-        return ret;
+        SessionObject *obj = (SessionObject *) this_ptr;
+        g_object_unref(obj->reconnect_pause_cancel);
+        obj->reconnect_pause_cancel = nullptr;
+        if (error)
+        {
+            // The backend may have moved on already; let it continue
+            obj->cancel_reconnect();
+            obj->Debug("Could not pause the backend: "
+                       + std::string(error->message));
+            g_error_free(error);
+        }
     }
 
 
     /**
-     * Fetches the last backend status and compares to what we have
-     * registered.  If there is a mismatch, we might have missed a signal -
-     * so register it and send it again.
+     *  Called by the ReconnectCoordinator when a queued reconnect is admitted
      */
-    void update_last_status()
+    void resume_reconnect()
     {
-        if (!sig_statuschg)
-        {
-            return;
-        }
+        reconnect_queued = false;
+        reconnect_admitted = std::chrono::steady_clock::now();
+
+        // Sent on the same connection as the Pause call, so the backend
+        // receives it after the Pause even if that is still pending
+        g_dbus_connection_call(backend_conn(),
+                               backend_dest(),
+                               be_path.c_str(),
+                               OpenVPN3DBus_interf_backends.c_str(),
+                               "Resume",
+                               NULL,
+                               NULL,
+                               G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                               -1,
+                               NULL,
+                               NULL,
+                               NULL);
+        LogVerb1("Reconnect admitted");
+    }
 
-        try
+
+    void cancel_reconnect()
+    {
+        if (reconnect_pause_cancel)
         {
-            GVariant *be_status = nullptr;
-            be_status = be_proxy->GetProperty("status");
-            if (!sig_statuschg->CompareStatus(be_status))
-            {
-                sig_statuschg->ProxyStatus(be_status);
-            }
+            g_cancellable_cancel(reconnect_pause_cancel);
+            g_object_unref(reconnect_pause_cancel);
+            reconnect_pause_cancel = nullptr;
         }
-        catch (DBusException& excp)
+        if (reconnects && reconnect_queued)
         {
-            // Ignore these failures for now.  It most commonly means
-            // the backend process has closed/shut-down - this is scenario
-            // is handled elsewhere in the call chain.
+            reconnects->Cancel(GetObjectPath());
+        }
+        reconnect_queued = false;
+    }
 
-            // TODO: Consider to set the local status to PROC_KILLED or
-            // something similar.
+
+    void cancel_exit_reason()
+    {
+        if (be_exit_cancel)
+        {
+            g_cancellable_cancel(be_exit_cancel);
+            g_object_unref(be_exit_cancel);
+            be_exit_cancel = nullptr;
         }
     }
 
@@ -1506,7 +3044,8 @@ public:
           SessionManagerSignals(dbuscon, objpath, manager_log_level, logwr,
                                 signal_broadcast),
           dbuscon(dbuscon),
-          creds(dbuscon)
+          creds(dbuscon),
+          metrics(new SessionManagerMetrics())
     {
         std::stringstream introspection_xml;
         introspection_xml << "<node name='" << objpath << "'>"
@@ -1518,11 +3057,16 @@ public:
                           << "        <method name='FetchAvailableSessions'>"
                           << "          <arg type='ao' name='paths' direction='out'/>"
                           << "        </method>"
+                          << "        <method name='FetchMetrics'>"
+                          << "          <arg type='s' name='metrics' direction='out'/>"
+                          << "        </method>"
                           << "        <property type='s' name='version' access='read'/>"
+                          << "        <property type='b' name='idle' access='read'/>"
                           << GetLogIntrospection()
                           << "    </interface>"
                           << "</node>";
         ParseIntrospectionXML(introspection_xml);
+        EnableDebugInterface();
 
         Debug("SessionManagerObject registered on '" + OpenVPN3DBus_interf_sessions + "': "
                       + objpath);
@@ -1531,6 +3075,12 @@ public:
     ~SessionManagerObject()
     {
         LogInfo("Shutting down");
+        if (journal)
+        {
+            // The sessions may still hold on to the journal
+            journal->Flush();
+            journal->SetErrorCallback(nullptr);
+        }
         RemoveObject(dbuscon);
     }
 
@@ -1585,11 +3135,17 @@ public:
                                                        config_path,
                                                        GetLogLevel(),
                                                        logwr,
-                                                       GetSignalBroadcast());
+                                                       GetSignalBroadcast(),
+                                                       metrics,
+                                                       reconnects,
+                                                       journal);
             IdleCheck_RefInc();
             session->IdleCheck_Register(IdleCheck_Get());
             session->RegisterObject(conn);
-            session_objects[sesspath] = session;
+            {
+                std::lock_guard<std::mutex> guard(session_objects_mtx);
+                session_objects[sesspath] = session;
+            }
 
             // Return the path to the new session object object to the caller
             // The backend object will remind "hidden" for the end-user
@@ -1599,6 +3155,7 @@ public:
         {
             // Build up an array of object paths to available session objects
             GVariantBuilder *bld = g_variant_builder_new(G_VARIANT_TYPE("ao"));
+            std::lock_guard<std::mutex> guard(session_objects_mtx);
             for (auto& item : session_objects)
             {
                 try {
@@ -1626,9 +3183,216 @@ public:
             g_variant_builder_unref(bld);
             g_variant_builder_unref(ret);
         }
+        else if ("FetchMetrics" == method_name)
+        {
+            // Only sessions the caller has access to are included
+            std::string m = GenerateMetrics(sender);
+            g_dbus_method_invocation_return_value(invoc,
+                                                  g_variant_new("(s)", m.c_str()));
+        }
     };
 
 
+    /**
+     *  Enables coordinated reconnects for sessions created from now on
+     *
+     * @param coord  ReconnectCoordinator shared by all the sessions
+     */
+    void SetReconnectCoordinator(ReconnectCoordinator::Ptr coord)
+    {
+        reconnects = coord;
+    }
+
+
+    /**
+     *  Enables the session journal, recording all sessions created from
+     *  now on.
+     *
+     * @param jrnl  SessionJournal to use
+     */
+    void SetSessionJournal(SessionJournal::Ptr jrnl)
+    {
+        journal = jrnl;
+        journal->SetErrorCallback([this](const std::string& msg)
+                                  {
+                                      LogWarn(msg);
+                                  });
+    }
+
+
+    /**
+     *  Restores the sessions recorded in the session journal by a previous
+     *  instance of the session manager.  Each session is tied to its
+     *  backend process again, which continues running without
+     *  reconnecting.  Sessions whose backend process is gone are dropped
+     *  from the journal.
+     */
+    void RestoreSessions()
+    {
+        if (!journal)
+        {
+            return;
+        }
+
+        std::vector<SessionJournalEntry> entries;
+        try
+        {
+            entries = journal->Load();
+        }
+        catch (DBusException& excp)
+        {
+            LogError(excp.what());
+            return;
+        }
+
+        for (const auto& entry : entries)
+        {
+            std::string sesspath = entry.session_path;
+            auto callback = [self=Ptr(this), sesspath](void)
+                            {
+                                self->remove_session_object(sesspath);
+                            };
+            SessionObject *session = new SessionObject(dbuscon,
+                                                       callback,
+                                                       entry,
+                                                       GetLogLevel(),
+                                                       logwr,
+                                                       GetSignalBroadcast(),
+                                                       metrics,
+                                                       reconnects,
+                                                       journal);
+            if (!session->IsRegistered())
+            {
+                delete session;
+                journal->Remove(sesspath);
+                continue;
+            }
+            IdleCheck_RefInc();
+            session->IdleCheck_Register(IdleCheck_Get());
+            session->RegisterObject(dbuscon);
+            {
+                std::lock_guard<std::mutex> guard(session_objects_mtx);
+                session_objects[sesspath] = session;
+            }
+            LogInfo("Restored session " + sesspath);
+        }
+    }
+
+
+    /**
+     *  Renders the metrics of the session manager and its sessions in
+     *  the Prometheus text exposition format.  This does not involve
+     *  any calls to the backend processes.
+     *
+     * @param sender  D-Bus bus name of the requester; only sessions this
+     *                requester can access are included.  If empty, all
+     *                sessions are included.
+     *
+     * @return Returns a std::string with the metrics document
+     */
+    std::string GenerateMetrics(const std::string& sender)
+    {
+        std::vector<SessionMetrics> sessions;
+        unsigned int pending = 0;
+        std::unique_lock<std::mutex> lock(session_objects_mtx);
+        size_t session_count = session_objects.size();
+        for (auto& item : session_objects)
+        {
+            if (!item.second->IsRegistered())
+            {
+                ++pending;
+            }
+            if (!sender.empty())
+            {
+                try
+                {
+                    item.second->CheckACL(sender);
+                }
+                catch (DBusCredentialsException& excp)
+                {
+                    continue;
+                }
+            }
+            sessions.push_back(item.second->GetMetrics());
+        }
+        lock.unlock();
+
+        MetricsWriter w;
+        w.Family("openvpn3_sessionmgr_sessions", "gauge",
+                 "Number of VPN sessions");
+        w.Sample("openvpn3_sessionmgr_sessions", {}, session_count);
+        w.Family("openvpn3_sessionmgr_pending_registrations", "gauge",
+                 "Sessions waiting for their backend process to register");
+        w.Sample("openvpn3_sessionmgr_pending_registrations", {}, pending);
+        metrics->Write(w);
+        if (reconnects)
+        {
+            reconnects->Write(w);
+        }
+
+        std::time_t now = std::time(nullptr);
+        w.Family("openvpn3_session_info", "gauge",
+                 "Session details, the value is always 1");
+        for (const auto& sm : sessions)
+        {
+            w.Sample("openvpn3_session_info",
+                     {{"session", sm.path},
+                      {"owner", std::to_string(sm.owner)},
+                      {"backend_pid", std::to_string(sm.backend_pid)},
+                      {"registered", sm.registered ? "1" : "0"}},
+                     1);
+        }
+        w.Family("openvpn3_session_status_major", "gauge",
+                 "StatusMajor code of the last session status");
+        for (const auto& sm : sessions)
+        {
+            w.Sample("openvpn3_session_status_major", {{"session", sm.path}},
+                     (unsigned int) sm.status_major);
+        }
+        w.Family("openvpn3_session_status_minor", "gauge",
+                 "StatusMinor code of the last session status");
+        for (const auto& sm : sessions)
+        {
+            w.Sample("openvpn3_session_status_minor", {{"session", sm.path}},
+                     (unsigned int) sm.status_minor);
+        }
+        w.Family("openvpn3_session_reconnects_total", "counter",
+                 "Number of reconnects of the session");
+        for (const auto& sm : sessions)
+        {
+            w.Sample("openvpn3_session_reconnects_total", {{"session", sm.path}},
+                     sm.reconnects);
+        }
+        w.Family("openvpn3_session_connected_seconds", "gauge",
+                 "Time since the connection was established, 0 if not connected");
+        for (const auto& sm : sessions)
+        {
+            w.Sample("openvpn3_session_connected_seconds", {{"session", sm.path}},
+                     (sm.connected_since > 0 ? now - sm.connected_since : 0));
+        }
+
+        // Metric name, statistics counter prefix, description
+        const std::vector<std::array<std::string, 3>> counters = {{
+            {{"openvpn3_session_bytes_total", "BYTES", "Bytes transferred by the session"}},
+            {{"openvpn3_session_packets_total", "PACKETS", "Packets transferred by the session"}}
+        }};
+        for (const auto& c : counters)
+        {
+            w.Family(c[0], "counter", c[2]);
+            for (const auto& sm : sessions)
+            {
+                auto in = sm.statistics.find(c[1] + "_IN");
+                auto out = sm.statistics.find(c[1] + "_OUT");
+                w.Sample(c[0], {{"session", sm.path}, {"direction", "in"}},
+                         (sm.statistics.end() == in ? 0 : in->second));
+                w.Sample(c[0], {{"session", sm.path}, {"direction", "out"}},
+                         (sm.statistics.end() == out ? 0 : out->second));
+            }
+        }
+        return w.str();
+    }
+
+
     /**
      *  Callback which is used each time a SessionManagerObject D-Bus
      *  property is being read.
@@ -1661,6 +3425,10 @@ public:
         {
             ret = g_variant_new_string(package_version);
         }
+        else if ("idle" == property_name)
+        {
+            ret = g_variant_new_boolean(IdleCheck_IsIdle());
+        }
         else
         {
             g_set_error (error,
@@ -1704,10 +3472,20 @@ public:
 private:
     GDBusConnection *dbuscon;
     DBusConnectionCreds creds;
+    SessionManagerMetrics::Ptr metrics;
+    ReconnectCoordinator::Ptr reconnects;
+    SessionJournal::Ptr journal;
+
+    /**
+     *  Protects session_objects, which is modified by the session
+     *  objects as well when they are removed
+     */
+    std::mutex session_objects_mtx;
     std::map<std::string, SessionObject *> session_objects;
 
     void remove_session_object(const std::string sesspath)
     {
+        std::lock_guard<std::mutex> guard(session_objects_mtx);
         session_objects.erase(sesspath);
     }
 };
@@ -1766,6 +3544,49 @@ public:
     }
 
 
+    /**
+     *  Enables the metrics exporter on a local Unix socket, in addition
+     *  to the FetchMetrics D-Bus method.
+     *
+     * @param path  File system path of the Unix socket
+     */
+    void SetMetricsSocket(const std::string& path)
+    {
+        metrics_socket_path = path;
+    }
+
+
+    /**
+     *  Enables the session journal.  Sessions recorded in it are restored
+     *  when the service starts.
+     *
+     * @param path  File system path of the journal file
+     */
+    void SetStateFile(const std::string& path)
+    {
+        state_file = path;
+    }
+
+
+    /**
+     *  Configures how reconnects of the sessions are spread out over
+     *  time.  See ReconnectCoordinator for details.
+     *
+     * @param rate       Reconnects admitted per second.  0 disables
+     *                   the coordination.
+     * @param burst      Reconnects admitted at once
+     * @param jitter_ms  Maximum random delay before resuming a queued
+     *                   session, in milliseconds
+     */
+    void SetReconnectPolicy(double rate, unsigned int burst,
+                            unsigned int jitter_ms)
+    {
+        reconnect_rate = rate;
+        reconnect_burst = burst;
+        reconnect_jitter = jitter_ms;
+    }
+
+
     /**
      *  This callback is called when the service was successfully registered
      *  on the D-Bus.
@@ -1778,6 +3599,17 @@ public:
                                                 manager_log_level, logwr,
                                                 signal_broadcast));
 
+        if (!state_file.empty())
+        {
+            managobj->SetSessionJournal(new SessionJournal(state_file));
+        }
+        if (reconnect_rate > 0)
+        {
+            managobj->SetReconnectCoordinator(
+                    new ReconnectCoordinator(reconnect_rate, reconnect_burst,
+                                             reconnect_jitter));
+        }
+
         // Register this object to on the D-Bus
         managobj->RegisterObject(GetConnection());
 
@@ -1789,6 +3621,28 @@ public:
         if (nullptr != idle_checker)
         {
             managobj->IdleCheck_Register(idle_checker);
+            managobj->IdleCheck_EnableIdleProperty();
+        }
+
+        // Take over the sessions of a previous session manager instance
+        managobj->RestoreSessions();
+
+        if (!metrics_socket_path.empty())
+        {
+            try
+            {
+                SessionManagerObject *mgr = managobj.get();
+                metrics_socket.reset(new MetricsSocket(metrics_socket_path,
+                                                       [mgr]()
+                                                       {
+                                                           return mgr->GenerateMetrics("");
+                                                       }));
+                managobj->LogVerb1("Metrics available on " + metrics_socket_path);
+            }
+            catch (DBusException& excp)
+            {
+                managobj->LogError(excp.what());
+            }
         }
     };
 
@@ -1829,6 +3683,12 @@ private:
     bool signal_broadcast = true;
     SessionManagerObject::Ptr managobj;
     ProcessSignalProducer * procsig;
+    std::string metrics_socket_path;
+    std::unique_ptr<MetricsSocket> metrics_socket;
+    std::string state_file;
+    double reconnect_rate = 0;
+    unsigned int reconnect_burst = 5;
+    unsigned int reconnect_jitter = 1000;
 };
 
 #endif // OPENVPN3_DBUS_SESSIONMGR_HPP
@@ -0,0 +1,156 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   dbus-stats-selftest.cpp
+ *
+ * @brief  Unit test for the histogram bucket layout and the per-thread
+ *         counters of DBusCallStats.  No D-Bus daemon is needed.
+ */
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dbus/stats.hpp"
+
+using namespace openvpn;
+
+
+static int check(const std::string& test, bool result)
+{
+    std::cout << "-- " << test << " ... "
+              << (result ? "PASSED" : "FAILED") << std::endl;
+    return (result ? 0 : 1);
+}
+
+
+static bool check_buckets()
+{
+    // Every value must be within the bounds of its bucket, and the
+    // buckets must be ordered
+    uint64_t prev_upper = 0;
+    for (unsigned int i = 0; i < DBusLatencyHistogram::BUCKETS; ++i)
+    {
+        uint64_t upper = DBusLatencyHistogram::UpperBound(i);
+        if (i > 0 && upper <= prev_upper)
+        {
+            std::cout << "** ERROR **  Bucket " << i << " is not ordered"
+                      << std::endl;
+            return false;
+        }
+        if (DBusLatencyHistogram::Index(upper) != i
+            || DBusLatencyHistogram::Index(prev_upper + (i > 0 ? 1 : 0)) != i)
+        {
+            std::cout << "** ERROR **  Bucket " << i << " bounds mismatch"
+                      << std::endl;
+            return false;
+        }
+        prev_upper = upper;
+    }
+    return DBusLatencyHistogram::Index(~uint64_t(0)) == DBusLatencyHistogram::BUCKETS - 1;
+}
+
+
+static void worker(unsigned int calls)
+{
+    for (unsigned int i = 0; i < calls; ++i)
+    {
+        DBusCallStats::Timer timer(DBusCallStats::Kind::METHOD,
+                                   "net.openvpn.v3.test", "Call");
+        if (0 == i % 10)
+        {
+            DBusCallStats::MarkError();
+        }
+        timer.Finish();
+    }
+    DBusCallStats::Timer prop(DBusCallStats::Kind::GET_PROPERTY,
+                              "net.openvpn.v3.test", "Call");
+    prop.Finish(true);
+}
+
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    failed += check("Bucket bounds", check_buckets());
+
+    DBusLatencyHistogram::Buckets hist = {{10, 50}, {100, 40}, {1000, 10}};
+    failed += check("Median",
+                    DBusLatencyHistogram::Percentile(hist, 0.5) == 10);
+    failed += check("90th percentile",
+                    DBusLatencyHistogram::Percentile(hist, 0.9) == 100);
+    failed += check("99th percentile",
+                    DBusLatencyHistogram::Percentile(hist, 0.99) == 1000);
+    failed += check("Empty histogram",
+                    DBusLatencyHistogram::Percentile({}, 0.5) == 0);
+
+    if (!DBusCallStats::Enabled())
+    {
+        std::cout << "-- Call counters skipped, OPENVPN3_DBUS_STATS=0"
+                  << std::endl;
+        return (failed > 0 ? 2 : 0);
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back(worker, 1000);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t bucketed = 0;
+    uint64_t prop_calls = 0;
+    for (const auto& e : DBusCallStats::Snapshot())
+    {
+        if (DBusCallStats::Kind::METHOD == e.kind)
+        {
+            calls += e.calls;
+            errors += e.errors;
+            for (const auto& b : e.buckets)
+            {
+                bucketed += b.second;
+            }
+        }
+        else
+        {
+            prop_calls += e.calls;
+            errors += e.errors;
+        }
+    }
+    failed += check("Calls summed over threads", 4000 == calls);
+    failed += check("Histogram matches the call count", 4000 == bucketed);
+    failed += check("Errors counted", 404 == errors);
+    failed += check("Kinds kept apart", 4 == prop_calls);
+
+    if (failed > 0)
+    {
+        std::cout << "** FAILED ** " << failed << " test(s) failed"
+                  << std::endl;
+        return 2;
+    }
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,178 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   dispatch-bench.cpp
+ *
+ * @brief  Measures the cost of finding the handler of a D-Bus method call,
+ *         using the method names of the session and configuration objects.
+ *         It compares the previous approach, copying the strings provided
+ *         by GDBus into std::string objects and walking an if-chain, with
+ *         a DBusMethodTable lookup.  No D-Bus daemon is needed.
+ *
+ *         Usage: dispatch-bench [number of calls per method]
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "dbus/dispatch.hpp"
+
+using namespace openvpn;
+
+
+static const std::vector<const char *> session_methods = {
+    "Connect", "Restart", "Pause", "Resume", "Disconnect", "Ready",
+    "UserInputQueueGetTypeGroup", "UserInputQueueFetch",
+    "UserInputQueueCheck", "UserInputProvide", "AccessGrant",
+    "AccessRevoke", "GetStatisticsPage", "LogForward"
+};
+
+static const std::vector<const char *> config_methods = {
+    "Fetch", "FetchJSON", "SetOption", "SetOverride", "UnsetOverride",
+    "AccessGrant", "AccessRevoke", "Seal", "Remove"
+};
+
+
+class BenchObject
+{
+public:
+    BenchObject(const std::vector<const char *>& names)
+        : calls(0), names(names)
+    {
+        for (const auto& n : names)
+        {
+            table.Add(n, DBusAccess::ANY, &BenchObject::handler);
+        }
+    }
+
+
+    // Mirrors the DBusObject::callback_method_call() signature
+    void chain_dispatch(GDBusConnection *conn,
+                        const std::string sender,
+                        const std::string obj_path,
+                        const std::string intf_name,
+                        const std::string method_name,
+                        GVariant *params,
+                        GDBusMethodInvocation *invoc)
+    {
+        for (const auto& n : names)
+        {
+            if (n == method_name)
+            {
+                handler(conn, sender.c_str(), params, invoc);
+                return;
+            }
+        }
+    }
+
+
+    void table_dispatch(GDBusConnection *conn,
+                        const gchar *sender,
+                        const gchar *obj_path,
+                        const gchar *intf_name,
+                        const gchar *method_name,
+                        GVariant *params,
+                        GDBusMethodInvocation *invoc)
+    {
+        table.Dispatch(this, conn, sender, method_name, params, invoc);
+    }
+
+
+    void CheckACL(const std::string sender, bool allow_root = false)
+    {
+    }
+
+
+    void CheckOwnerAccess(const std::string sender, bool allow_root = false)
+    {
+    }
+
+
+    unsigned long calls;
+
+
+private:
+    const std::vector<const char *>& names;
+    DBusMethodTable<BenchObject> table;
+
+    void handler(GDBusConnection *conn, const gchar *sender,
+                 GVariant *params, GDBusMethodInvocation *invoc)
+    {
+        calls++;
+    }
+};
+
+
+static void run(const std::string& title,
+                const std::vector<const char *>& names, unsigned int count)
+{
+    BenchObject obj(names);
+    const gchar *sender = ":1.4711";
+    const gchar *path = "/net/openvpn/v3/sessions/bench";
+    const gchar *intf = "net.openvpn.v3.sessions";
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        for (const auto& n : names)
+        {
+            obj.chain_dispatch(nullptr, sender, path, intf, n, nullptr, nullptr);
+        }
+    }
+    auto chain = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        for (const auto& n : names)
+        {
+            obj.table_dispatch(nullptr, sender, path, intf, n, nullptr, nullptr);
+        }
+    }
+    auto table = std::chrono::steady_clock::now() - start;
+
+    double total = (double) count * names.size();
+    std::cout << title << " (" << names.size() << " methods, "
+              << obj.calls << " calls)" << std::endl
+              << "    if-chain: "
+              << std::chrono::duration<double, std::nano>(chain).count() / total
+              << " ns per call" << std::endl
+              << "    table:    "
+              << std::chrono::duration<double, std::nano>(table).count() / total
+              << " ns per call" << std::endl;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [number of calls per method]"
+                  << std::endl;
+        return 2;
+    }
+    unsigned int count = (argc > 1 ? std::stoi(argv[1]) : 1000000);
+
+    run("SessionObject", session_methods, count);
+    run("ConfigurationObject", config_methods, count);
+    return 0;
+}
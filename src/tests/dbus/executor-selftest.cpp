@@ -0,0 +1,227 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   executor-selftest.cpp
+ *
+ * @brief  Unit test for DBusExecutor and DBusStrand.  Checks that the
+ *         tasks of each strand run in order and never in parallel, and
+ *         that a closed strand drops its queued tasks.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "dbus/executor.hpp"
+
+
+static const unsigned int strand_count = 8;
+static const unsigned int task_count = 2000;
+
+
+int test_ordering()
+{
+    std::cout << "-- Testing task ordering within strands ... ";
+
+    std::mutex mtx;
+    std::map<unsigned int, std::vector<unsigned int>> seen;
+    std::vector<std::atomic<int>> busy(strand_count);
+    std::atomic<bool> overlap(false);
+    std::atomic<int> running(0);
+    std::atomic<int> max_running(0);
+
+    DBusExecutor::Ptr executor(new DBusExecutor(4));
+    std::vector<DBusStrand::Ptr> strands;
+    for (unsigned int i = 0; i < strand_count; i++)
+    {
+        strands.push_back(executor->NewStrand());
+        busy[i] = 0;
+    }
+
+    for (unsigned int n = 0; n < task_count; n++)
+    {
+        for (unsigned int i = 0; i < strand_count; i++)
+        {
+            strands[i]->Post([&, i, n]()
+                {
+                    if (1 != ++busy[i])
+                    {
+                        overlap = true;
+                    }
+                    int r = ++running;
+                    int m = max_running;
+                    while (r > m && !max_running.compare_exchange_weak(m, r))
+                    {
+                    }
+                    {
+                        std::lock_guard<std::mutex> guard(mtx);
+                        seen[i].push_back(n);
+                    }
+                    --running;
+                    --busy[i];
+                });
+        }
+    }
+    executor->Shutdown();
+
+    if (overlap)
+    {
+        std::cout << "FAILED" << std::endl
+                  << "** ERROR **  Tasks of one strand ran in parallel"
+                  << std::endl;
+        return 1;
+    }
+    for (unsigned int i = 0; i < strand_count; i++)
+    {
+        if (task_count != seen[i].size())
+        {
+            std::cout << "FAILED" << std::endl
+                      << "** ERROR **  Strand " << i << " ran "
+                      << seen[i].size() << " of " << task_count << " tasks"
+                      << std::endl;
+            return 1;
+        }
+        for (unsigned int n = 0; n < task_count; n++)
+        {
+            if (seen[i][n] != n)
+            {
+                std::cout << "FAILED" << std::endl
+                          << "** ERROR **  Strand " << i
+                          << " ran task " << seen[i][n]
+                          << " as task " << n << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::cout << "PASSED (max " << max_running << " tasks in parallel)"
+              << std::endl;
+    return 0;
+}
+
+
+int test_close()
+{
+    std::cout << "-- Testing closed strands ... ";
+
+    DBusExecutor::Ptr executor(new DBusExecutor(1));
+    DBusStrand::Ptr strand = executor->NewStrand();
+    std::atomic<unsigned int> ran(0);
+    std::atomic<bool> started(false);
+
+    std::mutex mtx;
+    std::unique_lock<std::mutex> block(mtx);
+    strand->Post([&]()
+                 {
+                     started = true;
+                     std::lock_guard<std::mutex> wait(mtx);
+                     ++ran;
+                 });
+    strand->Post([&]()
+                 {
+                     ++ran;
+                 });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+
+    // The first task is running; the second one is
+    // queued and must be dropped
+    strand->Close();
+    strand->Post([&]()
+                 {
+                     ++ran;
+                 });
+    block.unlock();
+    executor->Shutdown();
+
+    if (1 != ran)
+    {
+        std::cout << "FAILED" << std::endl
+                  << "** ERROR **  " << ran << " tasks ran, expected 1"
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
+
+
+int test_drain()
+{
+    std::cout << "-- Testing draining strands ... ";
+
+    DBusExecutor::Ptr executor(new DBusExecutor(2));
+    DBusStrand::Ptr strand = executor->NewStrand();
+    std::atomic<bool> started(false);
+    std::atomic<bool> finished(false);
+    std::atomic<unsigned int> ran(0);
+
+    strand->Post([&]()
+                 {
+                     started = true;
+                     std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                     finished = true;
+                 });
+    strand->Post([&]()
+                 {
+                     ++ran;
+                 });
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+
+    // Must wait for the running task, and drop the queued one
+    strand->Drain();
+    bool waited = finished;
+    executor->Shutdown();
+
+    if (!waited || 0 != ran)
+    {
+        std::cout << "FAILED" << std::endl
+                  << "** ERROR **  Drain() "
+                  << (waited ? "ran queued tasks" : "did not wait for the running task")
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "PASSED" << std::endl;
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    failed += test_ordering();
+    failed += test_close();
+    failed += test_drain();
+
+    if (failed > 0)
+    {
+        std::cout << "** FAILED ** " << failed << " test(s) failed"
+                  << std::endl;
+        return 2;
+    }
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}
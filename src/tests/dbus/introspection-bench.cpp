@@ -0,0 +1,172 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   introspection-bench.cpp
+ *
+ * @brief  Compares the cost of creating many DBusObjects which each parse
+ *         their own introspection document against objects sharing a
+ *         cached one.  It reports the time used and the growth of the
+ *         resident memory.  The objects are not registered on the bus,
+ *         so no D-Bus daemon is needed.
+ *
+ *         Usage: introspection-bench [shared|parsed] [number of objects]
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+#include "dbus/core.hpp"
+
+using namespace openvpn;
+
+
+static std::string generate_xml(const std::string& objpath)
+{
+    std::stringstream xml;
+    xml << "<node name='" << objpath << "'>"
+        << "    <interface name='" << OpenVPN3DBus_interf_sessions << "'>";
+    for (int i = 0; i < 20; i++)
+    {
+        xml << "        <method name='Method" << i << "'>"
+            << "            <arg type='s' name='input' direction='in'/>"
+            << "            <arg type='u' name='result' direction='out'/>"
+            << "        </method>";
+    }
+    for (int i = 0; i < 15; i++)
+    {
+        xml << "        <property type='s' name='prop" << i << "' access='read'/>";
+    }
+    xml << "        <signal name='Log'>"
+        << "            <arg type='u' name='group' direction='out'/>"
+        << "            <arg type='u' name='level' direction='out'/>"
+        << "            <arg type='s' name='message' direction='out'/>"
+        << "        </signal>"
+        << "    </interface>"
+        << "</node>";
+    return xml.str();
+}
+
+
+class BenchObject : public DBusObject
+{
+public:
+    BenchObject(const std::string& objpath, bool shared)
+        : DBusObject(objpath)
+    {
+        if (shared)
+        {
+            SetSharedIntrospection("BenchObject", []()
+                {
+                    return generate_xml("/");
+                });
+        }
+        else
+        {
+            ParseIntrospectionXML(generate_xml(objpath));
+        }
+    }
+
+    void callback_method_call(GDBusConnection *conn,
+                              const std::string sender,
+                              const std::string obj_path,
+                              const std::string intf_name,
+                              const std::string meth_name,
+                              GVariant *params,
+                              GDBusMethodInvocation *invoc)
+    {
+    }
+
+    GVariant * callback_get_property(GDBusConnection *conn,
+                                     const std::string sender,
+                                     const std::string obj_path,
+                                     const std::string intf_name,
+                                     const std::string property_name,
+                                     GError **error)
+    {
+        return NULL;
+    }
+
+    GVariantBuilder * callback_set_property(GDBusConnection *conn,
+                                            const std::string sender,
+                                            const std::string obj_path,
+                                            const std::string intf_name,
+                                            const std::string property_name,
+                                            GVariant *value,
+                                            GError **error)
+    {
+        return NULL;
+    }
+};
+
+
+static long resident_kb()
+{
+    std::ifstream statm("/proc/self/statm");
+    long size = 0;
+    long resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [shared|parsed] [number of objects]" << std::endl;
+        return 2;
+    }
+    bool shared = (argc < 2 || std::string(argv[1]) != "parsed");
+    unsigned int count = (argc > 2 ? std::stoi(argv[2]) : 10000);
+
+    std::vector<std::unique_ptr<BenchObject>> objects;
+    objects.reserve(count);
+
+    long rss_start = resident_kb();
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        std::string path = OpenVPN3DBus_rootp_sessions + "/bench"
+                           + std::to_string(i);
+        objects.emplace_back(new BenchObject(path, shared));
+    }
+    auto end = std::chrono::steady_clock::now();
+    long rss_end = resident_kb();
+
+    auto usec = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::cout << (shared ? "Shared" : "Parsed") << " introspection, "
+              << count << " objects" << std::endl
+              << "    Time:     " << usec << " us total, "
+              << std::fixed << std::setprecision(2)
+              << (count > 0 ? (double) usec / count : 0.0)
+              << " us per object" << std::endl
+              << "    Resident: +" << (rss_end - rss_start) << " KiB, "
+              << (count > 0 ? (rss_end - rss_start) * 1024 / count : 0)
+              << " bytes per object" << std::endl;
+    return 0;
+}
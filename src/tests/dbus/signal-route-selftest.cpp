@@ -0,0 +1,142 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   signal-route-selftest.cpp
+ *
+ * @brief  Unit test for DBusSignalRouteTable, which finds the subscribers
+ *         of a signal in the DBusSignalRouter.  No D-Bus daemon is needed.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include "dbus/signal-router.hpp"
+
+using namespace openvpn;
+
+
+static void dummy_callback(GDBusConnection *conn, const gchar *sender,
+                           const gchar *path, const gchar *interf,
+                           const gchar *member, GVariant *params,
+                           gpointer data)
+{
+}
+
+
+static DBusSignalRouteTable::Route route(const std::string& sender,
+                                         const std::string& path,
+                                         const std::string& member,
+                                         const std::string& arg0 = "")
+{
+    DBusSignalRouteTable::Route r;
+    r.sender = sender;
+    r.path = path;
+    r.member = member;
+    r.arg0 = arg0;
+    r.callback = dummy_callback;
+    r.user_data = nullptr;
+    return r;
+}
+
+
+static int check(const std::string& test, const std::vector<guint>& result,
+                 const std::vector<guint>& expect)
+{
+    std::cout << "-- " << test << " ... ";
+    if (result == expect)
+    {
+        std::cout << "PASSED" << std::endl;
+        return 0;
+    }
+
+    std::cout << "FAILED" << std::endl << "** ERROR **  Got [";
+    for (const auto& id : result)
+    {
+        std::cout << " " << id;
+    }
+    std::cout << " ], expected [";
+    for (const auto& id : expect)
+    {
+        std::cout << " " << id;
+    }
+    std::cout << " ]" << std::endl;
+    return 1;
+}
+
+
+int main(int argc, char **argv)
+{
+    const std::string be = ":1.42";
+    const std::string sess = "/net/openvpn/v3/backends/session1";
+
+    DBusSignalRouteTable table;
+    table.Add(1, route(be, sess, "StatusChange"));
+    table.Add(2, route(be, sess, "Log"));
+    table.Add(3, route("", "", "Log"));
+    table.Add(4, route("net.openvpn.v3.log", "", ""));
+    table.Add(5, route("", sess, "", sess));
+    table.Add(6, route("", "", ""));
+
+    int failed = 0;
+    failed += check("Exact match and wildcards",
+                    table.Match({be}, sess, "StatusChange", ""),
+                    {1, 6});
+    failed += check("Several subscribers, in subscription order",
+                    table.Match({be}, sess, "Log", ""),
+                    {2, 3, 6});
+    failed += check("Other sender",
+                    table.Match({":1.43"}, sess, "Log", ""),
+                    {3, 6});
+    failed += check("Well-known sender name",
+                    table.Match({":1.50", "net.openvpn.v3.log"},
+                                "/net/openvpn/v3/log", "ProcessChange", ""),
+                    {4, 6});
+    failed += check("Signal without sender",
+                    table.Match({}, sess, "Log", ""),
+                    {3, 6});
+    failed += check("First argument match",
+                    table.Match({be}, sess, "AttentionRequired", sess),
+                    {5, 6});
+
+    table.Remove(2);
+    table.Remove(6);
+    failed += check("Removed subscriptions",
+                    table.Match({be}, sess, "Log", ""),
+                    {3});
+    table.Remove(1);
+    table.Remove(3);
+    table.Remove(4);
+    table.Remove(5);
+    std::cout << "-- Empty table ... "
+              << (table.Empty() ? "PASSED" : "FAILED") << std::endl;
+    if (!table.Empty())
+    {
+        ++failed;
+    }
+
+    if (failed > 0)
+    {
+        std::cout << "** FAILED ** " << failed << " test(s) failed"
+                  << std::endl;
+        return 2;
+    }
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}
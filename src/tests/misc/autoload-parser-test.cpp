@@ -0,0 +1,203 @@
+//  OpenVPN 3 Linux client -- Next generation OpenVPN client
+//
+//  Copyright (C) 2018         OpenVPN, Inc. <sales@openvpn.net>
+//  Copyright (C) 2018         David Sommerseth <davids@openvpn.net>
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, version 3 of the
+//  License.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+//
+
+/**
+ * @file   autoload-parser-test.cpp
+ *
+ * @brief  Unit tests for the .autoload descriptor parsing and the
+ *         session state handling used by the openvpn3 autoload command
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include <unistd.h>
+
+#include <openvpn/log/logsimple.hpp>
+#include "ovpn3cli/autoload-parser.hpp"
+
+using namespace openvpn;
+
+
+static unsigned int failures = 0;
+
+
+static void check(const std::string& descr, bool result)
+{
+    std::cout << "      " << descr << " ... "
+              << (result ? "PASSED" : "** ERROR **") << std::endl;
+    if (!result)
+    {
+        failures++;
+    }
+}
+
+
+static void write_file(const std::string& fname, const std::string& content)
+{
+    std::ofstream f(fname);
+    f << content;
+}
+
+
+static bool has_override(const AutoloadProfile& prof,
+                         const std::string& key, const std::string& value)
+{
+    for (const auto& ov : prof.overrides)
+    {
+        if (key == ov.override.key
+            && (OverrideType::boolean == ov.override.type
+                ? (value == (ov.boolValue ? "true" : "false"))
+                : (value == ov.strValue)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static void test_profiles(const std::string& dir)
+{
+    std::cout << ">> Profile parsing" << std::endl;
+
+    const std::string profile = "client\n"
+                                "dev tun\n"
+                                "remote vpn.example.org 1194\n";
+    write_file(dir + "/alpha.conf", profile + "persist-tun\n");
+    write_file(dir + "/alpha.autoload",
+               "{\"autostart\": true,"
+               " \"acl\": {\"public\": true},"
+               " \"remote\": {\"proto-override\": \"tcp\","
+               "              \"port-override\": 443,"
+               "              \"compression\": \"maybe\"},"
+               " \"crypto\": {\"client-cert-enabled\": false},"
+               " \"tunnel\": {\"ipv6\": \"no\", \"dns-fallback\": \"other\"},"
+               " \"user-auth\": {\"username\": \"vpnuser\"}}");
+    write_file(dir + "/beta.ovpn", profile);
+    write_file(dir + "/beta.autoload", "{\"autostart\": ");
+    write_file(dir + "/gamma.ovpn", profile);
+    write_file(dir + "/delta.autoload", "{}");
+
+    std::vector<AutoloadProfile> profiles = autoload_find_profiles(dir);
+    check("Only profiles with an .autoload file are found",
+          2 == profiles.size());
+    if (2 != profiles.size())
+    {
+        return;
+    }
+    check("Profiles are sorted by file name",
+          "alpha.conf" == profiles[0].name && "beta.ovpn" == profiles[1].name);
+
+    autoload_parse_all(profiles);
+
+    const AutoloadProfile& alpha = profiles[0];
+    check("Valid profile is parsed", alpha.error.empty()
+          && std::string::npos != alpha.profile.find("vpn.example.org"));
+    check("autostart and acl:public are set",
+          alpha.autostart && alpha.public_access && !alpha.locked_down);
+    check("--persist-tun in the profile is detected", alpha.persist_tun);
+    check("remote:proto-override is added",
+          has_override(alpha, "proto-override", "tcp"));
+    check("Numeric remote:port-override is added",
+          has_override(alpha, "port-override", "443"));
+    check("crypto:client-cert-enabled is inverted",
+          has_override(alpha, "no-client-cert", "true"));
+    check("tunnel:ipv6 is added", has_override(alpha, "ipv6", "no"));
+    check("Invalid values are reported and skipped",
+          2 == alpha.warnings.size()
+          && !has_override(alpha, "allow-compression", "maybe")
+          && !has_override(alpha, "dns-fallback-google", "true"));
+    check("user-auth is collected",
+          1 == alpha.user_auth.size()
+          && "vpnuser" == alpha.user_auth.at("username"));
+
+    check("Broken .autoload file is reported", !profiles[1].error.empty());
+}
+
+
+static void test_status_step(StatusMajor major, StatusMinor minor,
+                             AutoloadStep expect, bool expect_reason)
+{
+    std::string reason;
+    AutoloadStep step = autoload_status_step(StatusEvent(major, minor, "msg"),
+                                             reason);
+    check(StatusMajor_str[(unsigned int) major] + ", "
+          + StatusMinor_str[(unsigned int) minor],
+          expect == step && expect_reason == !reason.empty());
+}
+
+
+static void test_state_machine()
+{
+    std::cout << ">> Session state handling" << std::endl;
+
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CFG_OK,
+                     AutoloadStep::CONNECT, false);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CFG_REQUIRE_USER,
+                     AutoloadStep::PROVIDE_INPUT, false);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTING,
+                     AutoloadStep::IGNORE, false);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CONN_CONNECTED,
+                     AutoloadStep::CONNECTED, false);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CFG_ERROR,
+                     AutoloadStep::FAILED, true);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CONN_FAILED,
+                     AutoloadStep::FAILED, true);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CONN_AUTH_FAILED,
+                     AutoloadStep::FAILED, true);
+    test_status_step(StatusMajor::CONNECTION, StatusMinor::CONN_DISCONNECTED,
+                     AutoloadStep::FAILED, true);
+    test_status_step(StatusMajor::SESSION, StatusMinor::CONN_CONNECTED,
+                     AutoloadStep::IGNORE, false);
+    test_status_step(StatusMajor::PROCESS, StatusMinor::PROC_KILLED,
+                     AutoloadStep::FAILED, true);
+}
+
+
+int main(int argc, char **argv)
+{
+    char dirtmpl[] = "/tmp/autoload-parser-test.XXXXXX";
+    if (!mkdtemp(dirtmpl))
+    {
+        std::cerr << "Could not create a temporary directory" << std::endl;
+        return 2;
+    }
+    std::string dir(dirtmpl);
+
+    test_profiles(dir);
+    test_state_machine();
+
+    for (const std::string f : {"alpha.conf", "alpha.autoload",
+                                "beta.ovpn", "beta.autoload",
+                                "gamma.ovpn", "delta.autoload"})
+    {
+        unlink((dir + "/" + f).c_str());
+    }
+    rmdir(dir.c_str());
+
+    if (failures > 0)
+    {
+        std::cout << "** Result: " << failures << " tests FAILED" << std::endl;
+        return 1;
+    }
+    std::cout << "** Result: All tests passed" << std::endl;
+    return 0;
+}